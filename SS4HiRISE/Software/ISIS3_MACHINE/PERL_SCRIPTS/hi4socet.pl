@@ -11,6 +11,9 @@
 ################################################################################
 
 use File::Copy;
+use FindBin;
+
+require "$FindBin::Bin/hi_subroutines.pl";   # RunStage, IsisKeys
 
 my ($progname) = ($0 =~ m#([^/]+)$#);  # get the name of this program
 
@@ -19,6 +22,8 @@ my ($progname) = ($0 =~ m#([^/]+)$#);  # get the name of this program
 # Location-dependent paths, fix for your system:
 
 $hinoproj_path = "/usgs/cdev/contrib/bin/";
+$hi8bitraw_path = "/usgs/cdev/contrib/bin/";
+$isiskeys_path = "/usgs/cdev/contrib/bin/";
 
 # End of Location-dependent paths
 ################################################################################
@@ -33,7 +38,7 @@ my $usage = "
 **** NOTE: $progname runs under isis version: $isisversion  ****
 **************************************************************************
 
-Command:  $progname fromlist [matchCube]
+Command:  $progname [-rerun] fromlist [matchCube]
 
 Where:
        fromlist = Ascii file containing a list of input balanced HiRISE
@@ -47,6 +52,9 @@ Where:
        noproj, and is held in the output noproj mosaic when fine-tuning 
        placement of the noproj'ed CCDs via hijitreg.  The default is RED5.
 
+       -rerun = Optional, run every stage even if it is up to date in
+       the stage manifest (see below).
+
 Description:
 
        $progname performs ISIS3 processing on HiRISE RED CCDs to create
@@ -54,15 +62,20 @@ Description:
        Specifically, $progname:
 
           1) creates a 32-bit noproj'ed mosaic of the CCDs 
-          2) converts the 32-bit mosaic to 8-bit and reports the stretch
-             pairs used for the conversion to *_STRETCH_PAIRS.lis
-          3) converts the 8-bit image to a raw file (*.raw)
-          4) creates a list file of the Socet Set USGSAstroLineScanner
+          2) converts the 32-bit mosaic to an 8-bit raw file (*.raw) and
+             reports the stretch pairs used for the conversion to
+             *_STRETCH_PAIRS.lis
+          3) creates a list file of the Socet Set USGSAstroLineScanner
              sensor model's keywords and values (*_keywords.lis)
 
        You will need to bring only the *.raw and *_keywords.lis files to
        your Socet Set workstation and run import_pushbroom to do the import.
 
+       Each stage is recorded in <image>_hi4socet.manifest with digests
+       of its inputs, parameters and output files.  When $progname is
+       rerun (e.g., after a failure), stages that are up to date are
+       skipped.
+
        Errors encountered in the processing goes to files:
        \"hi4socet.err\" and \"hinoproj.err\"
 
@@ -162,6 +175,26 @@ NOTICE:
 #                            Photogrammetry group
 #                         3) Added setisis test for dpw-user group
 #           Jun 12 2015 - EHK verified to run under isis3.4.9
+#           Oct 18 2026 - replaced the percent (x2)/getkey/stretch/
+#                         isis2raw runs with hi8bitraw, which makes
+#                         the 8-bit raw image in two reads of the
+#                         mosaic rather than four
+#           Oct 18 2026 - read the CcdId of all input cubes with one
+#                         isiskeys run in place of a getkey run per
+#                         cube
+#           Oct 18 2026 - recorded each stage (hinoproj.pl,
+#                         socetlinescankeywords, hi8bitraw)
+#                         in <image>_hi4socet.manifest with digests of
+#                         its inputs, parameters and outputs; a rerun
+#                         skips the stages that are up to date.  Added
+#                         -rerun, and made the temp file name unique to
+#                         the run.
+#           Oct 19 2026 - IsisKeys is required from hi_subroutines.pl,
+#                         shared with hinoproj.pl and hidata4socet.pl
+#           Oct 19 2026 - the stage cache subroutines are required from
+#                         hi_subroutines.pl.  The hinoproj.pl stage is
+#                         keyed on fromlist and the CCD names, since
+#                         hinoproj.pl rewrites the CCD cubes
 #####################################################################
 
 #--------------------------------------------------------------------
@@ -191,15 +224,6 @@ NOTICE:
         }
      }
 
-#---------------------------------------------------------------------
-# Get this system's $ISISROOT/bin absolute path to be used for running
-# getkey
-# --------------------------------------------------------------------
-
-  $ISISROOT_bin_path = `printenv ISISROOT`;
-  chomp($ISISROOT_bin_path);
-  $ISISROOT_bin_path = $ISISROOT_bin_path . "/bin";
- 
 #---------------------------------------------------------------------
 # Check the argument list
 #---------------------------------------------------------------------
@@ -252,13 +276,18 @@ NOTICE:
 # Make sure '*' character is not at end of file names in fromlist
 #---------------------------------------------------------------------
 
-   if (-e "temp0101010") {unlink "temp0101010";}
-   $cmd = "cp $fromlist temp0101010";
+   $temp_list = "temp$$.lis";
+   $cmd = "cp $fromlist $temp_list";
    system ($cmd);
    unlink $fromlist;
-   $cmd = "cat temp0101010 | sed s/\*// > $fromlist";
+   $cmd = "cat $temp_list | sed s/\*// > $fromlist";
    system ($cmd);
-   unlink "temp0101010";
+   unlink $temp_list;
+
+   open(LST,"<$fromlist");
+   @fromCubes = <LST>;
+   close(LST);
+   chomp(@fromCubes);
 
 #---------------------------------------------------------------------
 # If matchCube was not input by user, set it to RED5
@@ -269,18 +298,12 @@ NOTICE:
 
       $matchCube = " ";
 
-      open(LST,"<$fromlist");
-      while ($input=<LST>)
+      $CcdId = IsisKeys("Instrument/CcdId",@fromCubes);
+
+      foreach $input (@fromCubes)
          {
-         chomp($input);
-
-         $CCD = `$ISISROOT_bin_path/getkey from=$input grpname=Instrument keyword=CcdId`;
-         chomp ($CCD);
-         $len = length($CCD);
-         if($len == 0) { 
-           $cmd = "$ISISROOT_bin_path/getkey from=$input grpname=Instrument keyword=CcdId";
-           ReportErrAndDie("getkey failed on command:\n$cmd");
-         }
+         $CCD = $CcdId->{$input}{"Instrument/CcdId"};
+         if (length($CCD) == 0) {ReportErrAndDie("CcdId not found in $input");}
 
          if ($CCD eq "RED5")
             {
@@ -289,8 +312,6 @@ NOTICE:
          }
       }
 
-   close(LST);
-
 #---------------------------------------------------------------------
 # Following the noproj naming convention, create the noproj'ed mosaic
 # name (needed now to base the output keywords.lis file)
@@ -307,12 +328,27 @@ NOTICE:
 
    $mosCube = $core_name . "mos_hijitreged" . $ext2 . ".noproj.cub";
 
+   $img_name = substr($matchCube,0,$firstdot-5);
+
+#---------------------------------------------------------------------
+# Load the stage manifest of this image.  Each stage below is skipped
+# when its inputs, parameters and outputs are unchanged since it last
+# completed (see RunStage), so a rerun after a failure picks up at the
+# failed stage.
+#---------------------------------------------------------------------
+
+   $manifest = $img_name . "_hi4socet.manifest";
+   LoadManifest();
+
 #---------------------------------------------------------------------
 # Run hinoproj.pl to geneate a mosaic of noproj'ed CCDs
 #---------------------------------------------------------------------
 
+   # (hinoproj.pl rewrites the CCD cubes with spiceinit and spicefit, so
+   # the stage is keyed on the list and the CCD names rather than on the
+   # digests of the cubes)
    $cmd = "$hinoproj_path/hinoproj.pl $fromlist $matchCube";
-   system($cmd) == 0 || ReportErrAndDie("hinoproj.pl failed on command:\n$cmd");
+   RunStage("hinoproj.pl", [$fromlist], [$mosCube], join(" ", $cmd, @fromCubes), $cmd);
 
 #---------------------------------------------------------------------
 # Run socetlinescankeywords to get the SS keyword values
@@ -322,82 +358,23 @@ NOTICE:
    $keyFile = $core_name . "mos_hijitreged_keywords.lis";
 
    $cmd = "socetlinescankeywords from=$mosCube to=$keyFile";
-   system($cmd) == 0 || ReportErrAndDie ("socetlinescankeywords failed on command:\n$cmd");
+   RunStage("socetlinescankeywords", [$mosCube], [$keyFile], $cmd, $cmd);
 
 #---------------------------------------------------------------------
-# Convert noproj'ed mosaic to 8-bit
+# Convert noproj'ed mosaic to an 8-bit raw image for Socet Set,
+# stretching between the values at 0.05% and 99.95% of the mosaic
+# (hi8bitraw takes both percentages from one read of the mosaic and
+# writes the raw image directly)
 #---------------------------------------------------------------------
 
-   $cmd = "percent from=$mosCube to=p0005.temp.txt percentage=0.05";
-   system($cmd) == 0 || ReportErrAndDie("percent failed on command:\n$cmd");
-
-   $cmd = "percent from=$mosCube to=p9995.temp.txt percentage=99.95";
-   system($cmd) == 0 || ReportErrAndDie("percent failed on command:\n$cmd");
-
-   $min = `$ISISROOT_bin_path/getkey from=p0005.temp.txt grpname=Results keyword=Value`;
-   $len = length($min);
-   if($len == 0) {
-     $cmd = "$ISISROOT_bin_path/getkey from=p0005.temp.txt grpname=Results keyword=Value";
-     ReportErrAndDie("getkey failed on command:\n$cmd");
-   }
-   chomp ($min);
-
-   $max = `$ISISROOT_bin_path/getkey from=p9995.temp.txt grpname=Results keyword=Value`;
-   $len = length($max);
-   if($len == 0) { 
-     $cmd = "$ISISROOT_bin_path/getkey from=p9995.temp.txt grpname=Results keyword=Value";
-     ReportErrAndDie("getkey failed on command:\n$cmd");
-   }
-   chomp ($max);
-
-   $ext = index($mosCube,".cub");
-   $core_name = substr($mosCube,0,$ext);
-   $byteCube = $core_name . ".8bit.cub";
-
-   if ($min > 0)
-      {
-      $cmd = "stretch from=$mosCube to=$byteCube+8bit+1:254 pairs=\"0:0 $min:1 $max:254\" lis=1.0 lrs=1.0 his=254 hrs=254";
-      }
-   else
-      {
-      $negmin = $min - 1;
-      $cmd = "stretch from=$mosCube to=$byteCube+8bit+1:254 pairs=\"$negmin:0 $min:1 $max:254\" lis=1.0 lrs=1.0 his=254 hrs=254";
-      }
-   system ($cmd) == 0 || ReportErrAndDie("stretch failed on command:\n$cmd");
-
-   unlink("p0005.temp.txt");
-   unlink("p9995.temp.txt");
-
-#---------------------------------------------------------------------
-#  Create report file for 32-bit to 8-bit stretch pairs
-#---------------------------------------------------------------------
-
-   $img_name = substr($matchCube,0,$firstdot-5);
+   $firstdot = index($mosCube,".");
+   $core_name = substr($mosCube,0,$firstdot);
+   $rawImg = $core_name . ".raw";
 
    $stretch_file = $img_name . "_STRETCH_PAIRS.lis";
 
-   open (STR,">$stretch_file") or die "\n Cannot open $stretch_file\n";
-
-   print STR "image: $mosCube\n";
-
-   if ($min > 0)
-      { print STR "stretch pairs: \"0:0 $min:1 $max:254\"\n"; }
-   else
-      { print STR "stretch pairs: \"$negmin:0 $min:1 $max:254\"\n"; }
-
-   close STR;
-
-#---------------------------------------------------------------------
-# Get raw noproj'ed mosaic for Socet Set
-# and delete temporary translated cube
-#---------------------------------------------------------------------
-
-   $firstdot = index($byteCube,".");
-   $core_name = substr($byteCube,0,$firstdot);
-   $rawImg = $core_name . ".raw";
-
-   $cmd = "isis2raw from=$byteCube to=$rawImg bittype=8bit stretch=none";
-   system($cmd) == 0 || ReportErrAndDie("isis2raw failed on command:\n$cmd");
+   $cmd = "$hi8bitraw_path/hi8bitraw $mosCube $rawImg 0.05 99.95";
+   RunStage("hi8bitraw", [$mosCube], [$rawImg, $stretch_file], $cmd, \&StretchTo8bit);
 
 #---------------------------------------------------------------------
 # Rename print.prt file
@@ -427,6 +404,39 @@ NOTICE:
 
    exit;
 
+##############################################################################
+#  Subroutine StretchTo8bit:  Runs hi8bitraw ($cmd) and writes the stretch
+#                             pairs it used to $stretch_file
+##############################################################################
+sub StretchTo8bit
+    {
+    @stretch = `$cmd`;
+    if ($? != 0)
+       {
+       print @stretch;
+       ReportErrAndDie("hi8bitraw failed on command:\n$cmd");
+       }
+
+    ($min) = map { /^Minimum = (\S+)/ ? $1 : () } @stretch;
+    ($max) = map { /^Maximum = (\S+)/ ? $1 : () } @stretch;
+    if (length($min) == 0 || length($max) == 0)
+       { ReportErrAndDie("hi8bitraw did not report the stretch on command:\n$cmd"); }
+
+    $negmin = $min - 1;
+
+    # report file for 32-bit to 8-bit stretch pairs
+    open (STR,">$stretch_file") or die "\n Cannot open $stretch_file\n";
+
+    print STR "image: $mosCube\n";
+
+    if ($min > 0)
+       { print STR "stretch pairs: \"0:0 $min:1 $max:254\"\n"; }
+    else
+       { print STR "stretch pairs: \"$negmin:0 $min:1 $max:254\"\n"; }
+
+    close STR;
+    }
+
 ##############################################################################
 #  Error Handling Subroutine
 ##############################################################################
@@ -15,12 +15,17 @@ use FileHandle;         # Buffer Flushing
 
 my ($progname) = ($0 =~ m#([^/]+)$#);  # get the name of this program
 
+$isis2geotiff_path = "/usgs/cdev/contrib/bin/";
+
 my $usage = "
-Command:  $progname -ortho <ortho.cub> -dem <dem.cub> -drad <deltaradius.cub> -h
+Command:  $progname -ortho <ortho.cub> -dem <dem.cub> -drad <deltaradius.cub>
+                 [-compress none|deflate|lzw] [-threads n] -h
 where
    ortho = orthoimage (isis2 or isis3 cube)
    dem = digital elevation model (isis2 or isis3 cube)
    drad = delta_radius (isis2 or isis3 cube)
+   compress = compression of the geotiffs (default deflate)
+   threads = number of tiles compressed at once (default all processors)
    h = help 
 
 Description:
@@ -34,6 +39,12 @@ Description:
        extension with .tif.  Also created are tiff world files with the
        .tfw extension.
 
+       ISIS3 cubes in the projections of dem2isis3/ortho2isis3 products
+       (Equirectangular, SimpleCylindrical, PolarStereographic,
+       Sinusoidal) are written by isis2geotiff as tiled, Cloud Optimized
+       geotiffs with internal overviews, in one read of the cube.  Other
+       cubes (e.g., isis2) are converted with gdal_translate.
+
        A report of errors encountered in the processing goes to file:
        \"hi_isis2geotiff.err\".
 
@@ -56,6 +67,12 @@ NOTICE:
 #           Feb  2 2009 - EHK, modified to strip isis version designator
 #                         from output file name
 #           Jul 15 2015 - EHK, updated contact information
+#           Oct 18 2026 - Convert ISIS3 cubes with isis2geotiff (tiled,
+#                         compressed COG with overviews; the delta-radius
+#                         offset is written as geotiff metadata without
+#                         the VRT step), falling back to gdal_translate
+#                         for cubes isis2geotiff does not support.
+#                         Added -compress and -threads.
 #####################################################################
 
 #--------------------------------------------------------------------
@@ -76,12 +93,16 @@ NOTICE:
      }
 
    my $help = '';          # Help option
+   my $compress = "deflate";
+   my $threads = 0;        # 0 = all processors
 
    # Get options
    my $opt     = GetOptions ( "h"        => \$help,
                               "ortho=s"  => \$orthoCub,
                               "dem=s"    => \$demCub,
-                              "drad=s"   => \$dradCub);
+                              "drad=s"   => \$dradCub,
+                              "compress=s" => \$compress,
+                              "threads=i"  => \$threads);
 
    if (!$opt)
      {
@@ -95,6 +116,15 @@ NOTICE:
        exit;
      } 
 
+   if ($compress ne "none" && $compress ne "deflate" && $compress ne "lzw")
+     {
+       print "$usage\n";
+       exit;
+     }
+
+   $isis2geotiff_options = "-tfw -compress $compress";
+   if ($threads > 0) {$isis2geotiff_options .= " -threads $threads";}
+
 #---------------------------------------------------------------------
 # If the "hi_isis2geotiff.err" file exist, delete it
 #---------------------------------------------------------------------
@@ -142,8 +172,11 @@ NOTICE:
        else
          {$orthoTif = $core_name . ".tif";}
 
-       $cmd = "gdal_translate -of Gtiff -co \"tfw=YES\" $orthoCub $orthoTif";
-       system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $orthoCub");
+       if (!IsisToGeotiff($orthoCub, $orthoTif, ""))
+         {
+           $cmd = "gdal_translate -of Gtiff -co \"tfw=YES\" $orthoCub $orthoTif";
+           system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $orthoCub");
+         }
 
        print "completed conversion to geotiff: $orthoTif\n";
      }
@@ -182,8 +215,11 @@ NOTICE:
        else
          {$demTif = $core_name . ".tif";}
 
-       $cmd = "gdal_translate -of Gtiff -co \"tfw=YES\" $demCub $demTif";
-       system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $demCub");
+       if (!IsisToGeotiff($demCub, $demTif, ""))
+         {
+           $cmd = "gdal_translate -of Gtiff -co \"tfw=YES\" $demCub $demTif";
+           system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $demCub");
+         }
        print "completed conversion to geotiff: $demTif\n";
 
      }
@@ -228,37 +264,46 @@ NOTICE:
            $dradTif = $core_name . ".tif";
          }
 
-       $cmd = "gdal_translate -of VRT $dradCub $dradVrt";
-       system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $dradCub");
        #---------------------------------------------------------------
-       #Get number of lines in dradVrt by loading the file into an
-       #array
+       # isis2geotiff writes the radius offset as geotiff metadata; for
+       # other cubes, insert it into a VRT of the cube and translate that
        #---------------------------------------------------------------
 
-       open (IN,$dradVrt) || ReportErrAndDie ("[Error] Problem opening input file: $dradVrt, $!\n");
-       @vrt_lines = <IN>;
-       close IN;
-
-       #---------------------------------------------------------------
-       # Insert Scale and Offset values into the VRT file using pop and
-       # push to add these lines to the array @vrt_lines, and then
-       # outputing the revised array
-       #---------------------------------------------------------------
-
-       $last_line = pop(@vrt_lines);
-       $next2last_line = pop(@vrt_lines);
-       push(@vrt_lines, "    <Scale>1.0</Scale>\n");
-       push(@vrt_lines, "    <Offset>3396000.0</Offset>\n");
-       push(@vrt_lines, $next2last_line);
-       $vrt_nl = push(@vrt_lines, $last_line);  #push returns the size of the
-                                                #array....THIS IS ZERO-BASED!
-
-       open (OUT,">$dradVrt") || ReportErrAndDie ("[Error] Problem opening output file: $dradVrt, $!\n");
-       for ($i=0; $i<=$vrt_nl; $i++)
-           { print OUT $vrt_lines[$i]; }
-
-       $cmd = "gdal_translate -of Gtiff -co \"tfw=YES\" $dradVrt $dradTif";
-       system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $dradVrt");
+       if (!IsisToGeotiff($dradCub, $dradTif, "-offset 3396000.0"))
+         {
+         $cmd = "gdal_translate -of VRT $dradCub $dradVrt";
+         system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $dradCub");
+         #---------------------------------------------------------------
+         #Get number of lines in dradVrt by loading the file into an
+         #array
+         #---------------------------------------------------------------
+
+         open (IN,$dradVrt) || ReportErrAndDie ("[Error] Problem opening input file: $dradVrt, $!\n");
+         @vrt_lines = <IN>;
+         close IN;
+
+         #---------------------------------------------------------------
+         # Insert Scale and Offset values into the VRT file using pop and
+         # push to add these lines to the array @vrt_lines, and then
+         # outputing the revised array
+         #---------------------------------------------------------------
+
+         $last_line = pop(@vrt_lines);
+         $next2last_line = pop(@vrt_lines);
+         push(@vrt_lines, "    <Scale>1.0</Scale>\n");
+         push(@vrt_lines, "    <Offset>3396000.0</Offset>\n");
+         push(@vrt_lines, $next2last_line);
+         $vrt_nl = push(@vrt_lines, $last_line);  #push returns the size of the
+                                                  #array....THIS IS ZERO-BASED!
+
+         open (OUT,">$dradVrt") || ReportErrAndDie ("[Error] Problem opening output file: $dradVrt, $!\n");
+         for ($i=0; $i<=$vrt_nl; $i++)
+             { print OUT $vrt_lines[$i]; }
+         close OUT;
+
+         $cmd = "gdal_translate -of Gtiff -co \"tfw=YES\" $dradVrt $dradTif";
+         system($cmd) == 0 || ReportErrAndDie ("gdal_translate failed on $dradVrt");
+         }
        print "completed conversion to geotiff: $dradTif\n";
      }
 
@@ -290,6 +335,25 @@ NOTICE:
 
    exit;
 
+##############################################################################
+#  Subroutine IsisToGeotiff:  Converts an ISIS3 cube to a geotiff (and tfw)
+#                             with isis2geotiff.  Returns 0 if isis2geotiff
+#                             does not support the cube (not ISIS3, or not
+#                             in one of its projections), 1 when done.
+##############################################################################
+sub IsisToGeotiff #cube, tif, extra isis2geotiff options
+    {
+    my ($cube, $tif, $options) = @_;
+    my $cmd;
+
+    $cmd = "$isis2geotiff_path" . "isis2geotiff $isis2geotiff_options $options $cube $tif";
+    system($cmd);
+    if (($? >> 8) == 2) {return 0;}
+    $? == 0 || ReportErrAndDie ("isis2geotiff failed on $cube");
+
+    return 1;
+    }
+
 ##############################################################################
 #  Error Handling Subroutine
 ##############################################################################
@@ -0,0 +1,176 @@
+################################################################################
+# NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE
+#
+#      This script is not supported by ISIS.
+#      If you have problems please contact the Astrogeology Photogrammetry group
+#      at PlanetaryPhotogrammetry@usgs.gov
+#
+# NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE
+################################################################################
+
+#####################################################################
+#
+#  hi_subroutines.pl:  Subroutines in common with hi4socet.pl,
+#                      hinoproj.pl and hidata4socet.pl, which
+#                      require it from the directory they are run
+#                      from (install it with them).
+#
+#                      The subroutines are in the caller's package
+#                      and use its $isiskeys_path, $manifest, $rerun
+#                      and ReportErrAndDie.
+#
+#  History: Oct 19 2026 - Orig Version, IsisKeys extracted from
+#                         hi4socet.pl, hinoproj.pl and hidata4socet.pl
+#           Oct 19 2026 - Added the stage cache subroutines (RunStage
+#                         etc.) of hi4socet.pl and hidata4socet.pl
+#####################################################################
+
+use Digest::MD5;
+use Time::HiRes;
+
+##############################################################################
+#  Stage cache subroutines:  Each stage of a run is recorded in the
+#  manifest file ($manifest) with a digest of its parameters and of the
+#  contents of its input files, and the digests of its output files.
+#  On a rerun a stage is skipped when its parameters and inputs are
+#  unchanged and its outputs are still as it left them (-rerun runs every
+#  stage).  File digests are kept in the manifest with the size and
+#  modification time of the file, so a file is only read again when it
+#  has changed.  A stage's inputs must be files the stage only reads: a
+#  file it rewrites has a new digest by the next run, and the stage
+#  would never be up to date (key such a stage on the file names in its
+#  parameters instead).
+##############################################################################
+sub LoadManifest
+    {
+    my @fields;
+
+    %stageKey = ();
+    %stageOutputs = ();
+    %fileDigest = ();
+
+    open (MAN,"<$manifest") or return;
+    while (<MAN>)
+       {
+       chomp;
+       @fields = split(/\t/);
+       if ($fields[0] eq "stage")
+          {
+          $stageKey{$fields[1]} = $fields[2];
+          $stageOutputs{$fields[1]} = [@fields[3..$#fields]];
+          }
+       elsif ($fields[0] eq "file")
+          { $fileDigest{$fields[1]} = [@fields[2..4]]; }
+       }
+    close (MAN);
+    }
+
+sub SaveManifest
+    {
+    my $name;
+
+    open (MAN,">$manifest.$$") or ReportErrAndDie("Cannot open $manifest.$$");
+    foreach $name (sort keys %stageKey)
+       { print MAN join("\t","stage",$name,$stageKey{$name},@{$stageOutputs{$name}}) . "\n"; }
+    foreach $name (sort keys %fileDigest)
+       { print MAN join("\t","file",$name,@{$fileDigest{$name}}) . "\n"; }
+    close (MAN);
+    rename ("$manifest.$$",$manifest) or ReportErrAndDie("Cannot write $manifest");
+    }
+
+sub FileDigest #file
+    {
+    my $file = shift;
+    my ($size, $mtime) = (Time::HiRes::stat($file))[7,9];
+    my $md5;
+
+    if (!defined($size)) {return "missing";}
+    $mtime = sprintf("%.6f", $mtime);
+    if (defined($fileDigest{$file}) && $fileDigest{$file}[0] == $size &&
+        $fileDigest{$file}[1] eq $mtime)
+       { return $fileDigest{$file}[2]; }
+
+    open (DIGEST,"<$file") or ReportErrAndDie("Cannot read $file");
+    binmode (DIGEST);
+    $md5 = Digest::MD5->new->addfile(*DIGEST)->hexdigest;
+    close (DIGEST);
+
+    $fileDigest{$file} = [$size, $mtime, $md5];
+    return $md5;
+    }
+
+sub RunStage #name, \@inputs, \@outputs, parameters, command or code
+    {
+    my ($name, $inputs, $outputs, $params, $action) = @_;
+    my ($key, $file, $outputDigests);
+
+    $key = Digest::MD5::md5_hex(join("\n", $name, $params,
+                                     map { "$_=" . FileDigest($_) } @$inputs));
+
+    if (!$rerun && defined($stageKey{$name}) && $stageKey{$name} eq $key)
+       {
+       $outputDigests = join("\t", map { "$_=" . FileDigest($_) } @$outputs);
+       if ($outputDigests eq join("\t",@{$stageOutputs{$name}}))
+          {
+          print "$name is up to date, skipped\n";
+          return;
+          }
+       }
+
+    # forget the stage (and what is known of its outputs) until it
+    # completes again
+    delete $stageKey{$name};
+    delete $stageOutputs{$name};
+    foreach $file (@$outputs) {delete $fileDigest{$file};}
+    SaveManifest();
+
+    if (ref($action) eq "CODE")
+       { &$action(); }
+    else
+       { system($action) == 0 || ReportErrAndDie("$name failed on command:\n$action"); }
+
+    foreach $file (@$outputs)
+       { (-e $file) || ReportErrAndDie("$name did not create $file"); }
+
+    $stageKey{$name} = $key;
+    $stageOutputs{$name} = [map { "$_=" . FileDigest($_) } @$outputs];
+    SaveManifest();
+    }
+
+
+##############################################################################
+#  Subroutine IsisKeys:  Reads the keywords (comma separated [Group/]Keyword
+#                        list) from the labels of the files with one run
+#                        of isiskeys.  Returns a reference to a hash of
+#                        file -> keyword -> value; the value is a reference
+#                        to a list when the keyword is found more than once,
+#                        and undef when it is not found.
+##############################################################################
+sub IsisKeys #keywords files...
+    {
+    my ($keywords, @files) = @_;
+    my ($cmd, @lines, %values, $file, $key, $value);
+    my $unescape = sub { my $s = shift; $s =~ s/\\u([0-9a-fA-F]{4})/chr(hex($1))/ge;
+                         $s =~ s/\\(.)/$1/g; return $s; };
+
+    $cmd = "$isiskeys_path/isiskeys $keywords @files";
+    @lines = `$cmd`;
+    $? == 0 || ReportErrAndDie("isiskeys failed on command:\n$cmd");
+
+    foreach (@lines)
+       {
+       if (/^  "((?:[^"\\]|\\.)*)": \{/) { $file = &$unescape($1); next; }
+       next unless (/^    "((?:[^"\\]|\\.)*)": (.*?),?$/);
+       ($key, $value) = (&$unescape($1), $2);
+       if ($value eq "null")
+          { $values{$file}{$key} = undef; }
+       elsif ($value =~ /^\[/)
+          { $values{$file}{$key} = [map { &$unescape($_) } ($value =~ /"((?:[^"\\]|\\.)*)"/g)]; }
+       else
+          { ($value) = ($value =~ /^"((?:[^"\\]|\\.)*)"/); $values{$file}{$key} = &$unescape($value); }
+       }
+
+    return \%values;
+    }
+
+1;
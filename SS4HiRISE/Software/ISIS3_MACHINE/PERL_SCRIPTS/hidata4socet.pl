@@ -13,6 +13,9 @@
 use File::Copy;
 use File::Basename;
 use Cwd;
+use FindBin;
+
+require "$FindBin::Bin/hi_subroutines.pl";   # RunStage, IsisKeys
 
 my ($progname) = ($0 =~ m#([^/]+)$#);  # get the name of this program
 
@@ -26,6 +29,7 @@ $PEDR_DB_path = "/archive/projects/mola/";
 $pedr2tab_path = "/home/thare/bin/linux/";
 $pedrTAB2SHP_path = "/usgs/cdev/contrib/bin/";
 $isis3arc_dd_path = "/home/thare/bin/";
+$isiskeys_path = "/usgs/cdev/contrib/bin/";
 
 # End of Location-dependent paths
 ################################################################################
@@ -40,12 +44,14 @@ my $usage = "
 **** NOTE: $progname runs under isis version: $isisversion  ****
 **************************************************************************
 
-Command:  $progname project_name noproj_img1 noproj_img2
+Command:  $progname [-rerun] project_name noproj_img1 noproj_img2
 
 Where:
        project_name = Name of SS project
        noproj_img1 = First noproj'ed image of a stereopair
        noproj_img2 = Second noproj'ed image of a stereopair
+       -rerun = Optional, run every stage even if it is up to date in
+       the stage manifest (see below)
 
 Description:
 
@@ -67,6 +73,11 @@ Description:
              be generated (named campt_<noproj_img>.prt) and placed in
              the same directory(ies) that the noproj'ed images are stored in
        
+       Each stage is recorded in <project_name>_hidata4socet.manifest
+       with digests of its inputs, parameters and output files.  When
+       $progname is rerun (e.g., after a failure), stages that are up to
+       date are skipped.
+
        A report of errors encountered in the processing goes to file:
        \"hidata4socet.err\" and \"hidata4socet.prt\".
 
@@ -124,6 +135,33 @@ NOTICE:
 #                         for script portability:
 #                           1) added $PEDR2TABPRM_path
 #                           2) Updated contact to PlanetaryPhotogrammetry
+#           Oct 18 2026 - Read the stats and campt results and the cube
+#                         dimensions with isiskeys (one run per file for
+#                         all keywords) in place of one getkey run per
+#                         keyword.  ographic_mbr/ocentric_mbr campt the
+#                         four corners into one file.
+#           Oct 18 2026 - Replaced ographic_mbr/ocentric_mbr (four campt
+#                         runs each per image) with footprint_mbr, which
+#                         runs campt once per image on a coordinate list
+#                         of the corners and points along each edge, and
+#                         gives both the ographic and ocentric mbr.
+#           Oct 18 2026 - Recorded each stage (footprints, MOLA DEM,
+#                         statistics, campt listings, pedr2tab,
+#                         pedrTAB2SHP) in <project>_hidata4socet.manifest
+#                         with digests of its inputs, parameters and
+#                         outputs; a rerun skips the stages that are up
+#                         to date.  Added -rerun, and made the temp file
+#                         names unique to the run.
+#           Oct 19 2026 - IsisKeys is required from hi_subroutines.pl,
+#                         shared with hi4socet.pl and hinoproj.pl
+#           Oct 19 2026 - The stage cache subroutines are required from
+#                         hi_subroutines.pl.  The mola_dem stage also
+#                         checks for the ascii DEM, and fails when
+#                         isis3arc_dd fails.
+#           Oct 19 2026 - footprint_mbr fails unless campt gives a
+#                         ground point for every image point of the
+#                         list, rather than building the mbr from the
+#                         points it did give.
 #####################################################################
 
 #--------------------------------------------------------------------
@@ -153,15 +191,6 @@ NOTICE:
         }
      }
 
-#---------------------------------------------------------------------
-# Get this system's $ISISROOT/bin absolute path to be used for running
-# getkey
-# --------------------------------------------------------------------
-
-  $ISISROOT_bin_path = `printenv ISISROOT`;
-  chomp($ISISROOT_bin_path);
-  $ISISROOT_bin_path = $ISISROOT_bin_path . "/bin";
-
 #---------------------------------------------------------------------
 # Check the argument list
 #---------------------------------------------------------------------
@@ -229,17 +258,42 @@ NOTICE:
    open (LOG,">$log") or die "\n Cannot open $log\n";
 
 #---------------------------------------------------------------------
-# Determine the ographic and ocentric mbr of the footprint of each image
+# Load the stage manifest of this project.  Each stage below is skipped
+# when its inputs, parameters and outputs are unchanged since it last
+# completed (see RunStage), so a rerun after a failure picks up at the
+# failed stage.
+#---------------------------------------------------------------------
+
+  $manifest = "./" . $project_name . "_hidata4socet.manifest";
+  LoadManifest();
+
+#---------------------------------------------------------------------
+# Determine the ographic and ocentric mbr of the footprint of each image,
+# from points all around the image edges (one campt run per
+# image)
 # Note that the for both the ographic and ocentric mbr, longitudes are
 # +East.  However the ographic mbr is in the +/- 180 degree system,
 # and the ocentric mbr is in the 360 degree system.
 #---------------------------------------------------------------------
 
-  ographic_mbr ($noproj_img1, $ul_lat_og1, $ul_lon_og1, $lr_lat_og1, $lr_lon_og1);
-  ographic_mbr ($noproj_img2, $ul_lat_og2, $ul_lon_og2, $lr_lat_og2, $lr_lon_og2);
+  $footprint_edge_points = 8;
+  $footprint_file = "./" . $project_name . "_footprints.lis";
+
+  RunStage ("footprints", [$noproj_img1, $noproj_img2], [$footprint_file],
+            "footprint_edge_points=$footprint_edge_points", \&WriteFootprints);
+
+  open (FOOT,"<$footprint_file") or ReportErrAndDie ("Cannot open $footprint_file");
+  while (<FOOT>)
+     {
+     ($mbr_name, @mbr_values) = split;
+     $mbr{$mbr_name} = [@mbr_values];
+     }
+  close (FOOT);
 
-  ocentric_mbr ($noproj_img1, $ul_lat_oc1, $ul_lon_oc1, $lr_lat_oc1, $lr_lon_oc1);
-  ocentric_mbr ($noproj_img2, $ul_lat_oc2, $ul_lon_oc2, $lr_lat_oc2, $lr_lon_oc2);
+  ($ul_lat_og1, $ul_lon_og1, $lr_lat_og1, $lr_lon_og1) = @{$mbr{og1}};
+  ($ul_lat_oc1, $ul_lon_oc1, $lr_lat_oc1, $lr_lon_oc1) = @{$mbr{oc1}};
+  ($ul_lat_og2, $ul_lon_og2, $lr_lat_og2, $lr_lon_og2) = @{$mbr{og2}};
+  ($ul_lat_oc2, $ul_lon_oc2, $lr_lat_oc2, $lr_lon_oc2) = @{$mbr{oc2}};
 
 #---------------------------------------------------------------------
 # Now determine the ographic and ocentric mbr of the stereocoverage
@@ -260,7 +314,7 @@ NOTICE:
 # stereocoverage mbr
 #---------------------------------------------------------------------
 
-   $mola_map = "./mola.map";
+   $mola_map = "./mola$$.map";
 
   #///////////////////////////////////////////////////////////////////
   # pad mbr range of ographic stereocoverage by .5 degrees, and round 
@@ -277,106 +331,18 @@ NOTICE:
    else
      { $mola_cub = "$MOLA_DB_path/mola_128ppd_south_simp_88lat.isis3.cub"; }
 
-   $cmd = "maptemplate map=$mola_map projection=simplecylindrical clon=0.0 targopt=user targetname=mars lattype=planetographic londom=180 rngopt=user minlat=$minlat maxlat=$maxlat minlon=$minlon maxlon=$maxlon resopt=ppd resolution=256";
-   system($cmd) == 0 || ReportErrAndDie ("maptemplate failed on command:\n$cmd");
-
-   $cmd = "map2map from=$mola_cub map=$mola_map to=$project_mola_cub+BandSequential pixres=map defaultrange=map interp=bilinear";
-   system($cmd) == 0 || ReportErrAndDie ("map2map failed on command:\n$cmd");
-
-   $cmd = "$isis3arc_dd_path/isis3arc_dd $project_mola_cub $project_mola_asc";
-   system($cmd);
-
-   unlink ($mola_map);
+   # (the MOLA database cube is named in the parameters rather than
+   # digested as an input; it does not change, and is GBs)
+   RunStage ("mola_dem", [], [$project_mola_cub, $project_mola_asc],
+             "$mola_cub $minlat $maxlat $minlon $maxlon", \&MolaDEM);
 
 #---------------------------------------------------------------------
 # Generate the <project_name>_SS_statistics.lis file
 #---------------------------------------------------------------------
 
-  $temp_pvl = "./temp_stats.pvl";
-
-  #/////////////////////////////////////////////////////////////////////
-  # Calculate the SS reference point at the center of the ographic
-  # stereo converage.  Round the values to the nearest tenth of a degree
-  # (i.e., 6 minutes)
-  #/////////////////////////////////////////////////////////////////////
-
-  $SS_ref_lat = $lr_lat_stereo_og + ($ul_lat_stereo_og-$lr_lat_stereo_og)/2;
-  $SS_ref_lon = $lr_lon_stereo_og + ($ul_lon_stereo_og-$lr_lon_stereo_og)/2;
-
-  $sign = 1;
-  if ($SS_ref_lat < 0) {$sign = -1;}
-  $SS_ref_lat = (int(($SS_ref_lat + $sign*0.05) * 10))/10;
-  $sign = 1;
-  if ($SS_ref_lon < 0) {$sign = -1;}
-  $SS_ref_lon = (int(($SS_ref_lon + $sign*0.05) * 10))/10;
-
-  #/////////////////////////////////////////////////////////////////////////
-  # Convert decimal degrees to DMS format for Socet Set
-  # (Note there is no need to calculate seconds since we rounded to .1 deg)
-  #/////////////////////////////////////////////////////////////////////////
-
-  dd2dm ($SS_ref_lat, $SS_ref_lat_deg, $SS_ref_lat_min);
-  dd2dm ($SS_ref_lon, $SS_ref_lon_deg, $SS_ref_lon_min);
-
-  #////////////////////////////////////////////////////////////////////////////
-  # Because $project_mola_cub is well beyond the extents of the stereocoverage
-  # mbr, extract a subarea of $project_mola_cub corresponding to the
-  # stereocoverage mbr with a pad of 0.1 degrees (call the new cube $temp_mola.)
-  # Get the elevation range from $temp_mola and round to the nearest
-  # 100 meters.  If $temp_mola is 'flat', add 100 meters to $maxZ
-  #////////////////////////////////////////////////////////////////////////////
-
-  $temp_mola = "temp_mola.cub";
-  $temp_map = "temp.map";
-
-  pad_range (0.1, $ul_lat_stereo_og, $ul_lon_stereo_og, $lr_lat_stereo_og,
-             $lr_lon_stereo_og, $minlat, $maxlat, $minlon, $maxlon);
-
-   $cmd = "maptemplate map=$temp_map projection=simplecylindrical clon=0.0 targopt=user targetname=mars lattype=planetographic londom=180 rngopt=user minlat=$minlat maxlat=$maxlat minlon=$minlon maxlon=$maxlon resopt=ppd resolution=256";
-   system($cmd) == 0 || ReportErrAndDie ("maptemplate failed on command:\n$cmd");
-
-   $cmd = "map2map from=$project_mola_cub map=$temp_map to=$temp_mola pixres=map defaultrange=map interp=bilinear";
-   system($cmd) == 0 || ReportErrAndDie ("map2map failed on command:\n$cmd");
-
-  $cmd = "stats from=$temp_mola to=$temp_pvl";
-  system($cmd) == 0 || ReportErrAndDie ("stats failed on command:\n$cmd");
-
-  $minZ = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=Results keyword=Minimum`;
-  $maxZ = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=Results keyword=Maximum`;
-  chomp($minZ);
-  chomp($maxZ);
-
-  $minZ = int($minZ/100 + 0.5) * 100;
-  $maxZ = int($maxZ/100 + 0.5) * 100;
-
-  if ($minZ == $maxZ) {$maxZ = $maxZ + 100;}
-
-  #/////////////////////////////////////
-  # Now write to the SS statistics file
-  #/////////////////////////////////////
-
-  open (STATS,">$project_stats") or die "\n Cannot open $project_stats\n";
-
-  print STATS "SOCET Set project: $project_name\n\n";
-
-  if ($SS_ref_lat_min > 9)
-    {print STATS "Geographic reference point:  Latitude  = $SS_ref_lat_deg\:$SS_ref_lat_min\:00.0\n";}
-  else
-    {print STATS "Geographic reference point:  Latitude  = $SS_ref_lat_deg\:0$SS_ref_lat_min\:00.0\n";}
-
-  if ($SS_ref_lon_min > 9)
-    {print STATS "                             Longitude = $SS_ref_lon_deg\:$SS_ref_lon_min\:00.000\n\n";}
-  else
-    {print STATS "                             Longitude = $SS_ref_lon_deg\:0$SS_ref_lon_min\:00.000\n\n";}
-
-  print STATS "Minimum Elevation: $minZ\n";
-  print STATS "Maximum Elevation: $maxZ\n";
-
-  close (STATS);
-
-  unlink ($temp_pvl);
-  unlink ($temp_mola);
-  unlink ($temp_map);
+  RunStage ("statistics", [$project_mola_cub], [$project_stats],
+             "$ul_lat_stereo_og $ul_lon_stereo_og $lr_lat_stereo_og $lr_lon_stereo_og",
+             \&ProjectStatistics);
 
 #---------------------------------------------------------------------
 # Now generate the campt statistics files for each input image
@@ -389,14 +355,14 @@ NOTICE:
   $img_name = substr($basename,0,15);
   $campt_name = $img_dir . "/campt_" . $img_name . ".prt";
   $cmd = "campt from=$noproj_img1 to=$campt_name append=no";
-  system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
+  RunStage ("campt $noproj_img1", [$noproj_img1], [$campt_name], $cmd, $cmd);
 
   $img_dir = dirname($noproj_img2);
   $basename = basename($noproj_img2,@suffixlist);
   $img_name = substr($basename,0,15);
   $campt_name = $img_dir . "/campt_" . $img_name . ".prt";
   $cmd = "campt from=$noproj_img2 to=$campt_name append=no";
-  system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
+  RunStage ("campt $noproj_img2", [$noproj_img2], [$campt_name], $cmd, $cmd);
 
 #---------------------------------------------------------------------
 # We are done with all isis processing, so rename print.prt file
@@ -447,15 +413,26 @@ NOTICE:
 
   close (OUT);
 
-  chdir $project_mola_track_dir;
+  #///////////////////////////////////////////////////////////////////
+  # run pedr2tab and pedrTAB2SHP_og.pl in $project_mola_track_dir
+  # (the PEDR database is named in the parameters rather than digested
+  # as an input)
+  #///////////////////////////////////////////////////////////////////
+
+  $pedr_tab = "$project_mola_track_dir/$pedr_tab_file";
+  $pedr_shp = "$project_mola_track_dir/" . $project_name . "Z.shp";
 
   $cmd = "$pedr2tab_path/pedr2tab.PCLINUX $PEDR_DB_path/mola_files.txt";
-  system($cmd) == 0 || ReportErrAndDie ("pedr2tab.PCLINUX failed on command:\n$cmd");
+  RunStage ("pedr2tab", [$project_mola_pedr], [$pedr_tab], $cmd,
+            sub { chdir $project_mola_track_dir;
+                  system($cmd) == 0 || ReportErrAndDie ("pedr2tab.PCLINUX failed on command:\n$cmd");
+                  chdir $cwd; });
 
   $cmd = "$pedrTAB2SHP_path/pedrTAB2SHP_og.pl $pedr_tab_file 2";
-  system($cmd) == 0 || ReportErrAndDie ("pedrTAB2SHP_og.pl failed on command:\n$cmd");
-
-  chdir $cwd;
+  RunStage ("pedrTAB2SHP_og.pl", [$pedr_tab], [$pedr_shp], $cmd,
+            sub { chdir $project_mola_track_dir;
+                  system($cmd) == 0 || ReportErrAndDie ("pedrTAB2SHP_og.pl failed on command:\n$cmd");
+                  chdir $cwd; });
 
 #---------------------------------------------------------------------
 # Close the LOG file.
@@ -480,122 +457,208 @@ NOTICE:
    exit;
 
 ##############################################################################
-#  Subroutine ographic_mbr:  Determines the ul and lr footprint coordinates
-#                            (i.e., mbr) of an input cube in ogrphic
-#                            coordinates, in the -180 to 180 degree lon domain 
+#  Subroutine WriteFootprints:  Writes the ographic and ocentric mbr of the
+#                               footprints of both images to $footprint_file
 ##############################################################################
-sub ographic_mbr #cube ul_lat ul_lon lr_lat lr_lon
-                 #@_[0] $_[1]  $_[2]  $_[3]  $_[4]
+sub WriteFootprints
    {
+     footprint_mbr ($noproj_img1, @og1[0..3], @oc1[0..3]);
+     footprint_mbr ($noproj_img2, @og2[0..3], @oc2[0..3]);
+
+     open (FOOT,">$footprint_file") or ReportErrAndDie ("Cannot open $footprint_file");
+     print FOOT "og1 @og1\n";
+     print FOOT "oc1 @oc1\n";
+     print FOOT "og2 @og2\n";
+     print FOOT "oc2 @oc2\n";
+     close (FOOT);
+   }
 
-     $ns = `$ISISROOT_bin_path/getkey from=@_[0] grpname=Dimensions keyword=Samples`;
-     $nl = `$ISISROOT_bin_path/getkey from=@_[0] grpname=Dimensions keyword=Lines`;
-     chomp($ns);
-     chomp($n1);
+##############################################################################
+#  Subroutine MolaDEM:  Extracts the MOLA DEM of the project ($project_mola_cub
+#                       and $project_mola_asc) from $mola_cub, for the
+#                       $minlat/$maxlat/$minlon/$maxlon range
+##############################################################################
+sub MolaDEM
+   {
+   $cmd = "maptemplate map=$mola_map projection=simplecylindrical clon=0.0 targopt=user targetname=mars lattype=planetographic londom=180 rngopt=user minlat=$minlat maxlat=$maxlat minlon=$minlon maxlon=$maxlon resopt=ppd resolution=256";
+   system($cmd) == 0 || ReportErrAndDie ("maptemplate failed on command:\n$cmd");
 
-     $temp_pvl = "./temp_og.pvl";
+   $cmd = "map2map from=$mola_cub map=$mola_map to=$project_mola_cub+BandSequential pixres=map defaultrange=map interp=bilinear";
+   system($cmd) == 0 || ReportErrAndDie ("map2map failed on command:\n$cmd");
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=1 line=1";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $ul_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetographicLatitude`;
-     $ul_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast180Longitude`;
-     chomp ($ul_lat);
-     chomp ($ul_lon);
+   $cmd = "$isis3arc_dd_path/isis3arc_dd $project_mola_cub $project_mola_asc";
+   system($cmd) == 0 || ReportErrAndDie ("isis3arc_dd failed on command:\n$cmd");
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=$ns line=1";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $ur_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetographicLatitude`;
-     $ur_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast180Longitude`;
-     chomp($ur_lat);
-     chomp($ur_lon);
+   unlink ($mola_map);
+   }
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=1 line=$nl";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $ll_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetographicLatitude`;
-     $ll_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast180Longitude`;
-     chomp($ll_lat);
-     chomp($ll_lon);
+##############################################################################
+#  Subroutine ProjectStatistics:  Writes the SS reference point and Z-range
+#                                 of the ographic stereocoverage to
+#                                 $project_stats
+##############################################################################
+sub ProjectStatistics
+  {
+  $temp_pvl = "./temp_stats$$.pvl";
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=$ns line=$nl";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $lr_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetographicLatitude`;
-     $lr_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast180Longitude`;
-     chomp($lr_lat);
-     chomp($lr_lon);
+  #/////////////////////////////////////////////////////////////////////
+  # Calculate the SS reference point at the center of the ographic
+  # stereo converage.  Round the values to the nearest tenth of a degree
+  # (i.e., 6 minutes)
+  #/////////////////////////////////////////////////////////////////////
 
-     unlink ($temp_pvl);
+  $SS_ref_lat = $lr_lat_stereo_og + ($ul_lat_stereo_og-$lr_lat_stereo_og)/2;
+  $SS_ref_lon = $lr_lon_stereo_og + ($ul_lon_stereo_og-$lr_lon_stereo_og)/2;
 
-     #ul_lat of mbr:
-     $_[1] = max ($ul_lat, $ur_lat, $ll_lat, $lr_lat);
+  $sign = 1;
+  if ($SS_ref_lat < 0) {$sign = -1;}
+  $SS_ref_lat = (int(($SS_ref_lat + $sign*0.05) * 10))/10;
+  $sign = 1;
+  if ($SS_ref_lon < 0) {$sign = -1;}
+  $SS_ref_lon = (int(($SS_ref_lon + $sign*0.05) * 10))/10;
 
-     #ul_lon of mbr:
-     $_[2] = min ($ul_lon, $ur_lon, $ll_lon, $lr_lon);
+  #/////////////////////////////////////////////////////////////////////////
+  # Convert decimal degrees to DMS format for Socet Set
+  # (Note there is no need to calculate seconds since we rounded to .1 deg)
+  #/////////////////////////////////////////////////////////////////////////
+
+  dd2dm ($SS_ref_lat, $SS_ref_lat_deg, $SS_ref_lat_min);
+  dd2dm ($SS_ref_lon, $SS_ref_lon_deg, $SS_ref_lon_min);
 
-     #lr_lat of mbr:
-     $_[3] = min ($ul_lat, $ur_lat, $ll_lat, $lr_lat);
+  #////////////////////////////////////////////////////////////////////////////
+  # Because $project_mola_cub is well beyond the extents of the stereocoverage
+  # mbr, extract a subarea of $project_mola_cub corresponding to the
+  # stereocoverage mbr with a pad of 0.1 degrees (call the new cube $temp_mola.)
+  # Get the elevation range from $temp_mola and round to the nearest
+  # 100 meters.  If $temp_mola is 'flat', add 100 meters to $maxZ
+  #////////////////////////////////////////////////////////////////////////////
 
-     #lr_lon of mbr:
-     $_[4] = max ($ul_lon, $ur_lon, $ll_lon, $lr_lon);
+  $temp_mola = "temp_mola$$.cub";
+  $temp_map = "temp$$.map";
 
-   }
+  pad_range (0.1, $ul_lat_stereo_og, $ul_lon_stereo_og, $lr_lat_stereo_og,
+             $lr_lon_stereo_og, $minlat, $maxlat, $minlon, $maxlon);
 
-##############################################################################
-#  Subroutine ocentric_mbr:  Determines the ul and lr footprint coordinates
-#                            (i.e., mbr) of an input cube in ocentric
-#                            coordinates, and the 0 to 360 degree lon domain 
-##############################################################################
-sub ocentric_mbr #cube ul_lat ul_lon lr_lat lr_lon
-                 #@_[0] $_[1]  $_[2]  $_[3]  $_[4]
-   {
+   $cmd = "maptemplate map=$temp_map projection=simplecylindrical clon=0.0 targopt=user targetname=mars lattype=planetographic londom=180 rngopt=user minlat=$minlat maxlat=$maxlat minlon=$minlon maxlon=$maxlon resopt=ppd resolution=256";
+   system($cmd) == 0 || ReportErrAndDie ("maptemplate failed on command:\n$cmd");
 
-     $ns = `$ISISROOT_bin_path/getkey from=@_[0] grpname=Dimensions keyword=Samples`;
-     $nl = `$ISISROOT_bin_path/getkey from=@_[0] grpname=Dimensions keyword=Lines`;
-     chomp($ns);
-     chomp($n1);
+   $cmd = "map2map from=$project_mola_cub map=$temp_map to=$temp_mola pixres=map defaultrange=map interp=bilinear";
+   system($cmd) == 0 || ReportErrAndDie ("map2map failed on command:\n$cmd");
 
-     $temp_pvl = "./temp_oc.pvl";
+  $cmd = "stats from=$temp_mola to=$temp_pvl";
+  system($cmd) == 0 || ReportErrAndDie ("stats failed on command:\n$cmd");
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=1 line=1";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $ul_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetocentricLatitude`;
-     $ul_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast360Longitude`;
-     chomp ($ul_lat);
-     chomp ($ul_lon);
+  $stats = IsisKeys("Results/Minimum,Results/Maximum",$temp_pvl);
+  $minZ = $stats->{$temp_pvl}{"Results/Minimum"};
+  $maxZ = $stats->{$temp_pvl}{"Results/Maximum"};
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=$ns line=1";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $ur_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetocentricLatitude`;
-     $ur_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast360Longitude`;
-     chomp($ur_lat);
-     chomp($ur_lon);
+  $minZ = int($minZ/100 + 0.5) * 100;
+  $maxZ = int($maxZ/100 + 0.5) * 100;
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=1 line=$nl";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $ll_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetocentricLatitude`;
-     $ll_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast360Longitude`;
-     chomp($ll_lat);
-     chomp($ll_lon);
+  if ($minZ == $maxZ) {$maxZ = $maxZ + 100;}
 
-     $cmd = "campt from=@_[0] to=$temp_pvl append=no sample=$ns line=$nl";
-     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
-     $lr_lat = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PlanetocentricLatitude`;
-     $lr_lon = `$ISISROOT_bin_path/getkey from=$temp_pvl grpname=GroundPoint keyword=PositiveEast360Longitude`;
-     chomp($lr_lat);
-     chomp($lr_lon);
+  #/////////////////////////////////////
+  # Now write to the SS statistics file
+  #/////////////////////////////////////
 
-     unlink ($temp_pvl);
+  open (STATS,">$project_stats") or die "\n Cannot open $project_stats\n";
+
+  print STATS "SOCET Set project: $project_name\n\n";
+
+  if ($SS_ref_lat_min > 9)
+    {print STATS "Geographic reference point:  Latitude  = $SS_ref_lat_deg\:$SS_ref_lat_min\:00.0\n";}
+  else
+    {print STATS "Geographic reference point:  Latitude  = $SS_ref_lat_deg\:0$SS_ref_lat_min\:00.0\n";}
+
+  if ($SS_ref_lon_min > 9)
+    {print STATS "                             Longitude = $SS_ref_lon_deg\:$SS_ref_lon_min\:00.000\n\n";}
+  else
+    {print STATS "                             Longitude = $SS_ref_lon_deg\:0$SS_ref_lon_min\:00.000\n\n";}
+
+  print STATS "Minimum Elevation: $minZ\n";
+  print STATS "Maximum Elevation: $maxZ\n";
+
+  close (STATS);
+
+  unlink ($temp_pvl);
+  unlink ($temp_mola);
+  unlink ($temp_map);
+  }
 
-     #ul_lat of mbr:
-     $_[1] = max ($ul_lat, $ur_lat, $ll_lat, $lr_lat);
+##############################################################################
+#  Subroutine footprint_mbr:  Determines the ul and lr footprint coordinates
+#                             (i.e., mbr) of an input cube in both ographic
+#                             coordinates, in the -180 to 180 degree lon
+#                             domain, and ocentric coordinates, in the 0
+#                             to 360 degree lon domain.  campt is run once
+#                             (one camera model initialization) on a list
+#                             of image points: the corners and
+#                             $footprint_edge_points points along each
+#                             edge.  Dies if any of the points has no
+#                             ground point (e.g. off the target).
+##############################################################################
+sub footprint_mbr #cube og_ul_lat og_ul_lon og_lr_lat og_lr_lon
+                  #     oc_ul_lat oc_ul_lon oc_lr_lat oc_lr_lon
+                  #@_[0] $_[1]  $_[2]  $_[3]  $_[4]  $_[5]  $_[6]  $_[7]  $_[8]
+   {
 
-     #ul_lon of mbr:
-     $_[2] = min ($ul_lon, $ur_lon, $ll_lon, $lr_lon);
+     $dims = IsisKeys("Dimensions/Samples,Dimensions/Lines",@_[0]);
+     $ns = $dims->{@_[0]}{"Dimensions/Samples"};
+     $nl = $dims->{@_[0]}{"Dimensions/Lines"};
 
-     #lr_lat of mbr:
-     $_[3] = min ($ul_lat, $ur_lat, $ll_lat, $lr_lat);
+     $temp_pvl = "./temp_footprint$$.pvl";
+     $temp_coords = "./temp_footprint$$.lis";
+
+     # image points around the edge of the image, corners included
+     open (COORDS,">$temp_coords") or ReportErrAndDie ("Cannot open $temp_coords");
+     $n = $footprint_edge_points + 1;
+     for ($i=0; $i<$n; $i++)
+        {
+        $samp = 1 + ($ns-1)*$i/$n;
+        $line = 1 + ($nl-1)*$i/$n;
+        print COORDS "$samp,1\n";
+        print COORDS "$ns,$line\n";
+        print COORDS (1 + $ns - $samp) . ",$nl\n";
+        print COORDS "1," . (1 + $nl - $line) . "\n";
+        }
+     close (COORDS);
 
-     #lr_lon of mbr:
-     $_[4] = max ($ul_lon, $ur_lon, $ll_lon, $lr_lon);
+     $cmd = "campt from=@_[0] to=$temp_pvl append=no usecoordlist=yes coordlist=$temp_coords coordtype=image";
+     system($cmd) == 0 || ReportErrAndDie ("campt failed on command:\n$cmd");
+
+     $points = IsisKeys("GroundPoint/PlanetographicLatitude,GroundPoint/PositiveEast180Longitude," .
+                        "GroundPoint/PlanetocentricLatitude,GroundPoint/PositiveEast360Longitude",
+                        $temp_pvl);
+     # every point of the list must have a ground point: an mbr of only
+     # some of them could be smaller than the footprint
+     @og_lat = @{$points->{$temp_pvl}{"GroundPoint/PlanetographicLatitude"}};
+     @og_lon = @{$points->{$temp_pvl}{"GroundPoint/PositiveEast180Longitude"}};
+     @oc_lat = @{$points->{$temp_pvl}{"GroundPoint/PlanetocentricLatitude"}};
+     @oc_lon = @{$points->{$temp_pvl}{"GroundPoint/PositiveEast360Longitude"}};
+     $missing = 4*$n - scalar(grep { /^[-+]?[\d.]+([eE][-+]?\d+)?$/ } @og_lat);
+     foreach $values (\@og_lon, \@oc_lat, \@oc_lon)
+        {
+        $m = 4*$n - scalar(grep { /^[-+]?[\d.]+([eE][-+]?\d+)?$/ } @$values);
+        if ($m > $missing) {$missing = $m;}
+        }
+     if ($missing > 0)
+        { ReportErrAndDie ("campt gave no ground point for $missing of the " . 4*$n .
+                           " footprint points of @_[0] (see $temp_pvl)"); }
+
+     unlink ($temp_pvl);
+     unlink ($temp_coords);
+
+     #ographic mbr: ul_lat, ul_lon, lr_lat, lr_lon
+     $_[1] = max (@og_lat);
+     $_[2] = min (@og_lon);
+     $_[3] = min (@og_lat);
+     $_[4] = max (@og_lon);
+
+     #ocentric mbr: ul_lat, ul_lon, lr_lat, lr_lon
+     $_[5] = max (@oc_lat);
+     $_[6] = min (@oc_lon);
+     $_[7] = min (@oc_lat);
+     $_[8] = max (@oc_lon);
    }
 
 ##############################################################################
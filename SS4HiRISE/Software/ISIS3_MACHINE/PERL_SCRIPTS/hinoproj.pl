@@ -10,6 +10,11 @@
 # NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE NOTICE
 ################################################################################
 
+use POSIX ();
+use FindBin;
+
+require "$FindBin::Bin/hi_subroutines.pl";   # IsisKeys
+
 my ($progname) = ($0 =~ m#([^/]+)$#);  # get the name of this program
 
 $email = "PlanetaryPhotogrammetry\@usgs.gov";
@@ -22,7 +27,7 @@ my $usage = "
 **** NOTE: $progname runs under isis version: $isisversion  ****
 **************************************************************************
 
-Command:  $progname fromlist [matchCube]
+Command:  $progname [-maxjobs=N] fromlist [matchCube]
 
 Where:
        fromlist = Ascii file containing a list of input balanced HiRISE
@@ -41,6 +46,11 @@ Where:
        noproj, and is held in the output noproj mosaic when fine-tuning 
        placement of the noproj'ed CCDs via hijitreg.  The default is RED5.
 
+       -maxjobs=N = Optional number of CCDs (spiceinit/spicefit/noproj)
+       and CCD pairs (hijitreg) to process at the same time.  The
+       default is the number of processors.  -maxjobs=1 processes them
+       one after another.
+
 
 Description:
 
@@ -52,6 +62,10 @@ Description:
        of hijitreg are applied when mosaicking the indivdual CCDs to
        reconstruct the image - with the match cube held.
 
+       The CCDs are noproj'ed concurrently, and hijitreg is run on
+       each pair of adjacent RED CCDs as soon as both are noproj'ed.
+       The RED CCDs are then mosaicked by hinoprojmos in a single pass.
+
        Errors encountered in the processing goes to file: \"hinoproj.err\"
 
 **************************************************************************
@@ -121,6 +135,20 @@ NOTICE:
 #                         1) Verified to run under isis3.4.7
 #                         2) Update contact information to Planetary
 #                            Photogrammetry group
+#           Oct 18 2026 - Run the spiceinit/spicefit/noproj chains of
+#                         the CCDs and the hijitreg CCD pairs as
+#                         concurrent jobs (up to -maxjobs at a time),
+#                         each pair starting once both of its CCDs are
+#                         noproj'ed.
+#           Oct 18 2026 - Mosaic the noproj'ed RED CCDs with a single
+#                         hinoprojmos run in place of one handmos run
+#                         per CCD, so the mosaic cube is written once.
+#           Oct 18 2026 - Read the CcdId of all input cubes with one
+#                         isiskeys run in place of a getkey run per
+#                         cube.
+#           Oct 18 2026 - Made the temp file names unique to the run.
+#           Oct 19 2026 - IsisKeys is required from hi_subroutines.pl,
+#                         shared with hi4socet.pl and hidata4socet.pl
 #####################################################################
 
 #---------------------------------------------------------------------
@@ -131,13 +159,23 @@ NOTICE:
    $| = 1;
 
 #---------------------------------------------------------------------
-# Get this system's $ISISROOT/bin absolute path to be used for running
-# getkey
-# --------------------------------------------------------------------
+# Location-dependent paths of hinoprojmos and isiskeys
+#---------------------------------------------------------------------
 
-  $ISISROOT_bin_path = `printenv ISISROOT`;
-  chomp($ISISROOT_bin_path);
-  $ISISROOT_bin_path = $ISISROOT_bin_path . "/bin";
+  $hinoprojmos_path = "/usgs/cdev/contrib/bin/";
+  $isiskeys_path = "/usgs/cdev/contrib/bin/";
+
+#---------------------------------------------------------------------
+# Number of CCD/pair jobs to run at once: -maxjobs=N, or one per
+# processor
+#---------------------------------------------------------------------
+
+  if (!defined($maxjobs) || $maxjobs < 1)
+     {
+     $maxjobs = `getconf _NPROCESSORS_ONLN 2>/dev/null`;
+     chomp($maxjobs);
+     if ($maxjobs < 1) {$maxjobs = 1;}
+     }
 
 #---------------------------------------------------------------------
 # Check the argument list
@@ -191,13 +229,26 @@ NOTICE:
 # Make sure '*' character is not at end of file names in fromlist
 #---------------------------------------------------------------------
 
-   if (-e "temp0101010") {unlink "temp0101010";}
-   $cmd = "cp $fromlist temp0101010";
+   $temp_list = "temp$$.lis";
+   $cmd = "cp $fromlist $temp_list";
    system ($cmd);
    unlink $fromlist;
-   $cmd = "cat temp0101010 | sed s/\*// > $fromlist";
+   $cmd = "cat $temp_list | sed s/\*// > $fromlist";
    system ($cmd);
-   unlink "temp0101010";
+   unlink $temp_list;
+
+#---------------------------------------------------------------------
+# Get the CcdId of all input cubes (and the matchCube) in one run of
+# isiskeys
+#---------------------------------------------------------------------
+
+   open(LST,"<$fromlist");
+   @fromCubes = <LST>;
+   close(LST);
+   chomp(@fromCubes);
+   if ($#ARGV == 1) {push(@fromCubes,$matchCube);}
+
+   $CcdId = IsisKeys("Instrument/CcdId",@fromCubes);
 
 #---------------------------------------------------------------------
 # If matchCube was not input by user, set it to RED5
@@ -214,13 +265,8 @@ NOTICE:
          $input=<LST>;
          chomp($input);
 
-         $CCD = `$ISISROOT_bin_path/getkey from=$input grpname=Instrument keyword=CcdId`;
-         chomp ($CCD);
-         $len = length($CCD);
-         if($len == 0) { 
-           $cmd = "$ISISROOT_bin_path/getkey from=$input grpname=Instrument keyword=CcdId";
-           ReportErrAndDie("getkey failed on command:\n$cmd"); 
-         }
+         $CCD = $CcdId->{$input}{"Instrument/CcdId"};
+         if (length($CCD) == 0) {ReportErrAndDie("CcdId not found in $input");}
 
          if ($CCD eq "RED5")
             {
@@ -231,13 +277,9 @@ NOTICE:
       }
    else
       {
-      $CCD = `$ISISROOT_bin_path/getkey from=$matchCube grpname=Instrument keyword=CcdId`;
-      chomp ($CCD);
+      $CCD = $CcdId->{$matchCube}{"Instrument/CcdId"};
       $len = length($CCD);
-      if($len == 0) {
-        $cmd = "$ISISROOT_bin_path/getkey from=$matchCube grpname=Instrument keyword=CcdId";
-        ReportErrAndDie("getkey failed on command:\n$cmd"); 
-      }
+      if ($len == 0) {ReportErrAndDie("CcdId not found in $matchCube");}
 
       $len--;
       $matchCubeCCD = substr($CCD,$len,1);
@@ -266,13 +308,8 @@ NOTICE:
       {
       chomp($input);
 
-      $CCD = `$ISISROOT_bin_path/getkey from=$input grpname=Instrument keyword=CcdId`;
-      chomp ($CCD);
-      $len = length($CCD);
-      if($len == 0) { 
-        $cmd = "$ISISROOT_bin_path/getkey from=$input grpname=Instrument keyword=CcdId";
-        ReportErrAndDie("getkey failed on command:\n$cmd"); 
-      }
+      $CCD = $CcdId->{$input}{"Instrument/CcdId"};
+      if (length($CCD) == 0) {ReportErrAndDie("CcdId not found in $input");}
 
       $filter = substr($CCD,0,2);
       if ($filter eq "RE")
@@ -304,6 +341,13 @@ NOTICE:
    $cmd = "spicefit FROM=$matchCube";
    system($cmd) == 0 || ReportErrAndDie("spicefit failed on command:\n$cmd");
 
+   # The spiceinit/spicefit/noproj chain of each CCD is one job; the CCDs
+   # are independent of each other once the matchCube has its SPICE, so
+   # they are run concurrently by RunJobs below.
+
+   @jobs = ();
+   %noprojJob = ();
+
    open(LST,"<$fromlist");
    while ($input=<LST>)
       {
@@ -318,6 +362,7 @@ NOTICE:
       $noprojCube = $core_name . ".noproj.cub";
       print NOPROJLST "$noprojCube\n";
 
+      @cmds = ();
       if ($input eq $matchCube)
          {
          # We already ran spiceinit and spicefit, just need to save
@@ -326,28 +371,30 @@ NOTICE:
          }
       else
          {
-         $cmd = "spiceinit FROM=$input attach=yes";
-         system($cmd) == 0 || ReportErrAndDie("spiceinit failed on command:\n$cmd");
-
-         $cmd = "spicefit FROM=$input";
-         system($cmd) == 0 || ReportErrAndDie("spiceinit failed on command:\n$cmd");
+         push(@cmds,"spiceinit FROM=$input attach=yes");
+         push(@cmds,"spicefit FROM=$input");
          }
 
       $source="frommatch";
-      $cmd = "noproj from=$input match=$matchCube to=$noprojCube source=$source interp=bilinear";
-      system($cmd) == 0 || ReportErrAndDie("noproj failed on command:\n$cmd");
+      push(@cmds,"noproj from=$input match=$matchCube to=$noprojCube source=$source interp=bilinear");
+
+      push(@jobs, {name => "noproj $input", cmds => [@cmds], deps => []});
+      $noprojJob{$noprojCube} = "noproj $input";
       }
 
    close(LST);
 
 #---------------------------------------------------------------------
 # Run Hijigreg on adjacent noproj'ed CCDs to calculate line/samp
-# translations to be applied during mosaic
+# translations to be applied during mosaic.  Each pair is started as
+# soon as the noproj jobs of its two CCDs are done, and its offsets are
+# collected when it finishes.
 #---------------------------------------------------------------------
 
    # Intialize LineTranslation and SampleTranslation arrays (for RED CCDs)
    @LT=(0,0,0,0,0,0,0,0,0,0);
    @ST=(0,0,0,0,0,0,0,0,0,0);
+   @pairJobs = ();
 
    # Split noproj'ed cubes naming convention between core_name (minus
    # the actual CCD#) and the series of extensions.
@@ -364,35 +411,26 @@ NOTICE:
 
       $flat = "flat.f" . $fromCCD . "m" . $matchCCD . ".txt";
 
-      $cmd = "hijitreg from=$from match=$match flatfile=$flat";
-      system($cmd) == 0 || ReportErrAndDie("hijitreg failed on command:\n$cmd");
-
-      $avgSampOffset = `grep \"Average Sample Offset\" $flat | awk '{print \$5}'`;
-      $avgLineOffset = `grep \"Average Line Offset\" $flat | awk '{print \$5}'`;
-      chomp ($avgSampOffset);
-      chomp ($avgLineOffset);
-
-      #fill Line and sample translation arrays with (rounded) integer values
-      #of the offsets calculated by hijitreg
-      if ($fromCCD < $matchCubeCCD)
-         {
-         @ST[$fromCCD] = sprintf("%.0f",$avgSampOffset);
-         @LT[$fromCCD] = sprintf("%.0f",$avgLineOffset);
-         }
-      else
-         {
-         @ST[$matchCCD] = sprintf("%.0f",$avgSampOffset);
-         @LT[$matchCCD] = sprintf("%.0f",$avgLineOffset);
-         }
+      @deps = ();
+      if (exists $noprojJob{$from}) {push(@deps,$noprojJob{$from});}
+      if (exists $noprojJob{$match}) {push(@deps,$noprojJob{$match});}
 
-###      unlink ($flat);
+      push(@pairJobs, {name => "hijitreg $flat",
+                       cmds => ["hijitreg from=$from match=$match flatfile=$flat"],
+                       deps => [@deps],
+                       done => \&CollectOffsets,
+                       args => [$fromCCD, $matchCCD, $flat]});
       }
 
+   # pairs go ahead of waiting noproj jobs once they are ready
+   RunJobs(@pairJobs, @jobs);
+
 #---------------------------------------------------------------------
-# Mosaic the noproj'ed RED CCDs starting with the matchCCD and filling
-# to the left, then filling to the right of the matchCCD...applying
-# line and sample translations, and deleting individual noproj'ed
-# CCDs along the way.
+# Mosaic the noproj'ed RED CCDs onto the matchCCD, filling to the left,
+# then to the right of the matchCCD...applying line and sample
+# translations.  hinoprojmos places all of the CCDs in one pass over
+# the mosaic (same result as handmos priority=beneath run on each CCD
+# in turn), then the individual noproj'ed CCDs are deleted.
 #---------------------------------------------------------------------
 
    # Remove .cub from series of extensions, then generate mosaic name
@@ -402,10 +440,15 @@ NOTICE:
 
    # rename the noproj'ed matchCube to mosCube so as to maintain label
    # info (and skip the need to run getkey for number of lines and samps
-   # when creating an output cube via handmos)
+   # when creating the output cube)
    rename ($matchCubeNoproj,$mosCube);
 
-   # Now mosaic CCDs from matchCCD to MinRedCCD
+   # List the CCDs in mosaic priority order with their placement:
+   # matchCCD to MinRedCCD, then matchCCD to MaxRedCCD
+   $mosList = "hinoprojmos$$.lis";
+   open (MOSLIST,">$mosList") or ReportErrAndDie("Cannot open $mosList");
+   @mosFrom = ();
+
    $SSM = 1;
    $SLM = 1;
    for ($fromCCD=$matchCubeCCD-1; $fromCCD>=$MinRedCCD; $fromCCD--)
@@ -413,13 +456,10 @@ NOTICE:
       $from= $core_name . $fromCCD . $ext;
       $SSM = $SSM + @ST[$fromCCD];
       $SLM = $SLM + @LT[$fromCCD];
-      $cmd = "handmos from=$from mosaic=$mosCube outsample=$SSM outline=$SLM outband=1 priority=beneath";
-      system($cmd) == 0 || ReportErrAndDie("handmos failed on command:\n$cmd");
-
-      unlink ($from);
+      print MOSLIST "$from $SSM $SLM\n";
+      push (@mosFrom, $from);
       }
 
-   # Now mosaic CCDs from matchCCD to MaxRedCCD
    $SSM = 1;
    $SLM = 1;
    for ($fromCCD=$matchCubeCCD+1; $fromCCD<=$MaxRedCCD; $fromCCD++)
@@ -427,11 +467,16 @@ NOTICE:
       $from= $core_name . $fromCCD . $ext;
       $SSM = $SSM - @ST[$fromCCD];
       $SLM = $SLM - @LT[$fromCCD];
-      $cmd = "handmos from=$from mosaic=$mosCube outsample=$SSM outline=$SLM outband=1 priority=beneath";
-      system($cmd) == 0 || ReportErrAndDie("handmos failed on command:\n$cmd");
-
-      unlink ($from);
+      print MOSLIST "$from $SSM $SLM\n";
+      push (@mosFrom, $from);
       }
+   close (MOSLIST);
+
+   $cmd = "$hinoprojmos_path" . "hinoprojmos $mosCube $mosList";
+   system($cmd) == 0 || ReportErrAndDie("hinoprojmos failed on command:\n$cmd");
+
+   unlink (@mosFrom);
+   unlink ($mosList);
 
 #---------------------------------------------------------------------
 # Rename print.prt file
@@ -461,6 +506,131 @@ NOTICE:
 
    exit;
 
+##############################################################################
+#  Job runner
+#
+#  RunJobs runs a list of jobs, each a hash of
+#     name => unique job name
+#     cmds => commands run one after the other
+#     deps => names of the jobs that must finish first
+#     done => optional subroutine called with @{args} when the job finishes
+#  with up to $maxjobs jobs at a time (forked children).  Jobs are started
+#  in list order as their dependencies finish.  If a command fails, the
+#  running jobs are stopped and the failed command is reported.
+##############################################################################
+sub RunJobs
+    {
+    my @pending = @_;
+    my %running = ();     # pid -> job
+    my %finished = ();    # job name -> 1
+    my ($job, $pid, $i, $ready, $dep, $failed, $nfinished);
+    my $total = scalar(@pending);
+
+    $nfinished = 0;
+    while (@pending || %running)
+       {
+       # start every job that is ready, up to $maxjobs
+       for ($i = 0; $i <= $#pending && scalar(keys %running) < $maxjobs; )
+          {
+          $job = $pending[$i];
+          $ready = 1;
+          foreach $dep (@{$job->{deps}})
+             {
+             if (!$finished{$dep}) {$ready = 0; last;}
+             }
+          if (!$ready) {$i++; next;}
+
+          splice(@pending,$i,1);
+          $pid = fork();
+          if (!defined($pid))
+             {
+             StopJobs(\%running);
+             ReportErrAndDie("unable to start job: $job->{name}");
+             }
+          if ($pid == 0)
+             {
+             # child: run the commands, exit with the number of the one
+             # that failed
+             for ($i = 0; $i <= $#{$job->{cmds}}; $i++)
+                {
+                if (system($job->{cmds}[$i]) != 0) {POSIX::_exit($i+1);}
+                }
+             POSIX::_exit(0);
+             }
+          $running{$pid} = $job;
+          print "Started $job->{name}\n";
+          }
+
+       if (!%running)
+          {
+          ReportErrAndDie("jobs can not be started, missing dependencies: " .
+                          join(", ", map {$_->{name}} @pending));
+          }
+
+       # wait for any job to finish
+       $pid = wait();
+       next if (!exists $running{$pid});
+       $job = $running{$pid};
+       delete $running{$pid};
+
+       if ($? != 0)
+          {
+          $failed = ($? >> 8) - 1;
+          StopJobs(\%running);
+          if ($failed >= 0 && $failed <= $#{$job->{cmds}})
+             {
+             $cmd = $job->{cmds}[$failed];
+             ($prog) = split(' ',$cmd);
+             ReportErrAndDie("$prog failed on command:\n$cmd");
+             }
+          ReportErrAndDie("$job->{name} failed");
+          }
+
+       $finished{$job->{name}} = 1;
+       $nfinished++;
+       print "Finished $job->{name} ($nfinished of $total)\n";
+       if (defined($job->{done})) {&{$job->{done}}(@{$job->{args}});}
+       }
+    }
+
+sub StopJobs
+    {
+    my $running = shift;
+    my $pid;
+
+    foreach $pid (keys %$running) {kill('TERM',$pid);}
+    foreach $pid (keys %$running) {waitpid($pid,0);}
+    }
+
+##############################################################################
+#  Collect the hijitreg offsets of a CCD pair
+##############################################################################
+sub CollectOffsets
+    {
+    my ($fromCCD, $matchCCD, $flat) = @_;
+    my ($avgSampOffset, $avgLineOffset);
+
+    $avgSampOffset = `grep \"Average Sample Offset\" $flat | awk '{print \$5}'`;
+    $avgLineOffset = `grep \"Average Line Offset\" $flat | awk '{print \$5}'`;
+    chomp ($avgSampOffset);
+    chomp ($avgLineOffset);
+
+    #fill Line and sample translation arrays with (rounded) integer values
+    #of the offsets calculated by hijitreg
+    if ($fromCCD < $matchCubeCCD)
+       {
+       @ST[$fromCCD] = sprintf("%.0f",$avgSampOffset);
+       @LT[$fromCCD] = sprintf("%.0f",$avgLineOffset);
+       }
+    else
+       {
+       @ST[$matchCCD] = sprintf("%.0f",$avgSampOffset);
+       @LT[$matchCCD] = sprintf("%.0f",$avgLineOffset);
+       }
+
+###    unlink ($flat);
+    }
+
 ##############################################################################
 #  Error Handling Subroutine
 ##############################################################################
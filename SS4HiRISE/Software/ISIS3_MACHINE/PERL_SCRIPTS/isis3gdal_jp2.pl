@@ -12,7 +12,7 @@
 #
 #_USER  Command line entry options [optional parameters]:
 #
-#   isis3gdal_jp2.pl [-q=75] [-f] [-s=8|16] [-p=rgg] input.cub output.jp2
+#   isis3gdal_jp2.pl [-q=75] [-f] [-s=8|16] [-p=rgg] [-threads=n] input.cub output.jp2
 #
 # Requirements:
 #
@@ -28,6 +28,14 @@
 #       2) -f if 32bit, force image to 16bit in GDAL
 #       3) -s=8|16 Stretch output to 8 or 16bit using isis2raw automatic stretch at 0.5%-99.5%
 #       4) -p=rgg This is for HiRISE Anaglyphs to map band 1,2,2 to rgb.
+#       5) -threads=n number of threads isis2jp2 encodes on (default all processors)
+#
+#      Map projected cubes (Equirectangular, SimpleCylindrical, Sinusoidal,
+#      PolarStereographic) are written by isis2jp2, which reads the tiles of
+#      the cube directly, stretches them on the fly and encodes the JPEG2000
+#      code-blocks on several threads, so no temporary BSQ or stretched copy is
+#      made.  Other cubes, -s=32 and the -of override still go through the
+#      crop/isis2raw copy and gdal_translate.
 #
 #_FILE Input files utilized 
 #	- 
@@ -40,6 +48,9 @@
 #       List of external Perl modules
 #          -none
 #
+#       List of programs that are called:
+#         isis2jp2 - to write the GeoJpeg2000 directly from the cube
+#
 #       List of ISIS programs that are called:
 #         crop -  to convert to a BSQ raw image if needed
 #        or
@@ -50,9 +61,15 @@
 #
 #_HIST
 #       Aug 2005 - Trent Hare - Program rewritten from isis3world.pl
+#       Oct 18 2026 - Write map projected cubes with isis2jp2 (no temporary BSQ or
+#                     stretched copy, multithreaded encoding), falling back to
+#                     crop/isis2raw and gdal_translate. Added -threads.
 #
 #_END
 #########################################################################
+
+$isis2jp2_path = "/usgs/cdev/contrib/bin/";
+
 ######################################################################
 # For help - user can enter this perl script and return
 ######################################################################
@@ -61,11 +78,12 @@
       print " \n\n          *** HELP ***\n\n";
       print "isis3gdal_jp2.pl -  Create GeoJpeg2000 from an ISIS 3 cube\n\n";
       print "Command line: \n";
-      print "  isis3gdal_jp2.pl [-q=1-100] [-f] [-s=8|16] [-p=rgg] input.cub output.jp2\n";
+      print "  isis3gdal_jp2.pl [-q=1-100] [-f] [-s=8|16] [-p=rgg] [-threads=n] input.cub output.jp2\n";
       print "\n    -q ; quality percentage, 1-100, defaults to 100 or lossless";
       print "\n    -f ; optional. if 32bit file, force truncation to 16bit in GDAL";
       print "\n    -s=8|16 ; automatic stretch to 8 or 16bit using linear stretch with range 0.5%-99.5%";
-      print "\n    -p=rgg ; optional. rgg = red,green,green - meant to convert 2band anaglyphs to 3band output\n\n";
+      print "\n    -p=rgg ; optional. rgg = red,green,green - meant to convert 2band anaglyphs to 3band output";
+      print "\n    -threads=n ; optional. number of threads to encode on, defaults to all processors\n\n";
       exit 1;
       }
 
@@ -204,6 +222,51 @@ while (<INIMAGE>) {
 # End of image header loop
 }
 
+####################################################################
+# Write the jpeg2000 straight from the cube with isis2jp2 if it can
+# (exit status 2 if it can't: not map projected in a supported
+# projection, or 32 bit output)
+####################################################################
+  if (!($of)) {
+      $args = "$isis2jp2_path" . "isis2jp2 -q $q";
+      if ($f) {
+        $args .= " -f";
+      }
+      if ($s) {
+        $args .= " -s $s";
+      }
+      if ($p) {
+        $args .= " -p rgg";
+        print "[isis3gdal_jp2.pl-WARNING] Setting anaglyph mode to map bands 1,2,2 to RGB\n";
+      }
+      if ($threads) {
+        $args .= " -threads $threads";
+      }
+      $args .= " $input $output";
+      print "submitting system command: $args\n";
+      system($args);
+      if (($? >> 8) != 2) {
+        $? == 0 or die "system $args failed: $?";
+
+        # projection file, as for the gdal_translate output
+        @ofname = split('\.',$input);
+        $oroot = $ofname[0];
+        if (-e isis3world.pl) {
+          $args = ("./isis3world.pl -p -prj $input");
+        } else { #hope that isis3world.pl is in the environment path
+          $args =   ("isis3world.pl -p -prj $input");
+        }
+        print "submitting system command: $args\n";
+        system($args) == 0
+           or die "system $args failed: $?";
+        unlink("$oroot.aux");
+
+        print " JP2 file generated: $output\n\n";
+        exit 0;
+      }
+      print "[isis3gdal_jp2.pl-WARNING] isis2jp2 can't convert $input, using gdal_translate.\n";
+  }
+
 ####################################################################
 # Generate temporary raw file if needed
 ####################################################################
@@ -22,7 +22,7 @@
 #
 #_USER  Command line entry options [optional parameters]:
 #
-#   isis3world.pl [-bit=8|16] [-r|-g|-t|-c|-j|-p|-P|-gxp] input.cub
+#   isis3world.pl [-bit=8|16] [-r|-g|-t|-c|-j|-p|-P|-gxp] [-maxjobs=N] input.cub|dir [...]
 #
 # Requirements:
 #
@@ -36,6 +36,10 @@
 #       2) To generate an 8-bit ISIS cube file using all defaults:
 #              isis3world.pl input.bsq
 #
+#       3) To generate tif world and projection files for every cube
+#          of an archive directory, 8 cubes at a time:
+#              isis3world.pl -t -prj -maxjobs=8 /archive/dir
+#
 #_DESC Convert an ISIS 3 cube to a GIS header and world files.
 #
 #      Options:
@@ -65,6 +69,10 @@
 #
 #                (-o=input.raw,8|16) an override swtich ISIS file to point at raw file instead of an ISIS file.
 #
+#                (-maxjobs=N) number of cubes processed at once when several
+#                cubes (or directories of *.cub files) are given.
+#                Default: the number of processors
+#
 #             Default:
 #                (-c) Generate an ISIS output cube header (w/georef) file
 #                
@@ -102,6 +110,11 @@
 #       May 18 2016 - T.H. - added support for multiple extensions
 #       Feb 23 2017 - T.H. - Updated Simple Cylindrical to force a sphere since that is what ISIS uses in
 #                                                the projection (for either ographic or ocentric).
+#       Oct 18 2026 - Accept several cubes and directories (all *.cub files) in one run, processing
+#                     up to -maxjobs cubes at a time in forked children.  Stop reading the label at
+#                     the pixel data (StartByte) as well as at Object = Label.
+#       Oct 19 2026 - Print unbuffered while running several cubes, and end the parent with exit
+#                     rather than POSIX::_exit, which dropped its buffered summary.
 
 #FORMAT TILED
 #TILE WIDTH 64
@@ -121,7 +134,7 @@ use Math::Trig;
       print " \n\n          *** HELP ***\n\n";
       print "isis3world.pl -  Create GIS header and world files from an ISIS 3 cube\n\n";
       print "Command line: \n";
-      print "  isis3world.pl [-bit=8|16] [-r|-e|-g|-t|-c|-ji|-J|-p|-P|-gxp] [-o=input.raw,8|16] input.cub\n";
+      print "  isis3world.pl [-bit=8|16] [-r|-e|-g|-t|-c|-ji|-J|-p|-P|-gxp] [-o=input.raw,8|16] [-maxjobs=N] input.cub|dir [...]\n";
       print "    -r = output raw header w/ georefencing (8, 16 bit)\n";
       print "    -gxp = output Socet GXP header no georefencing and GIS worldfile (not used)\n";
       print "    -e = output ERDAS raw header and world file (8, 16, 32 bit)\n";
@@ -135,6 +148,8 @@ use Math::Trig;
       print "    -c = output cub header w/ georef (default) (8, 16 bit)\n";
       print "\n    -prj = create ESRI Well Known Text projection file *.prj\n";
       print "\n    -o = Override input ISIS3 file with raw file and change to 0 skipbytes\n";
+      print "\n    -maxjobs = number of cubes processed at once when several cubes or\n";
+      print "               directories (all *.cub files) are given (default: number of processors)\n";
 
       print "\nExamples:\n";
       print "   Create header for SocetGXP: isis3world.pl -gxp input.cub\n";
@@ -143,12 +158,42 @@ use Math::Trig;
       print "   Create header for 32 bit PCI Aux: isis3world.pl -p input.cub\n";
       print "   Create header for 8 bit PCI Aux with input file override: isis3world.pl -p -o=input.raw,8 input.cub\n";
       print "   Create files for tif: isis3world.pl -t input.cub\n";
-      print "   Apply all defaults:     isis3world.pl input.cub\n\n";
+      print "   Apply all defaults:     isis3world.pl input.cub\n";
+      print "   Create tif world and prj files for a directory: isis3world.pl -t -prj /archive/dir\n\n";
       exit 1;
       }
 
-   $input = $ARGV[0];
-   chomp $input;
+######################################################################
+#  Input cubes: the arguments, with directories standing for all their
+#  *.cub files.  With more than one cube, each is processed by a forked
+#  child (RunCubes returns in the child, with its cube); the parent
+#  waits for them all and exits.
+######################################################################
+
+   @inputs = ();
+   foreach $arg (@ARGV) {
+     chomp $arg;
+     if (-d $arg) {
+       push(@inputs, sort(glob("$arg/*.cub")));
+     } else {
+       push(@inputs, $arg);
+     }
+   }
+
+   if (scalar(@inputs) == 0) {
+     print "[isis3world.pl-ERROR] No cubes found in: @ARGV\n";
+     exit 1;
+   }
+
+   if (scalar(@inputs) > 1) {
+     if ($o) {
+       print "[isis3world.pl-ERROR] The -o override can only be used with one input cube\n";
+       exit 1;
+     }
+     $input = RunCubes(@inputs);
+   } else {
+     $input = $inputs[0];
+   }
 
 ######################################################################
 #  Check input file name for .cub extention
@@ -161,7 +206,10 @@ use Math::Trig;
 
    #  Create the header file from the bil file
    #print "$input";
-   open INIMAGE, $input;
+   if (!open(INIMAGE, $input)) {
+     print "[isis3world.pl-ERROR] Cannot open $input\n";
+     exit 1;
+   }
 
 ######################################################################
 #  Check for filetype if none then default to cube
@@ -439,9 +487,12 @@ while (<INIMAGE>) {
      }
      
      ##############################################################
-     # Find the End
+     # Find the End (of the label, or the start of the pixels)
      ##############################################################
-     if (/Object = Label/) {
+     if (/Object = Label/ || /^End\s*$/) {
+        last;
+     }
+     if (defined($skipbytes) && tell(INIMAGE) >= $skipbytes) {
         last;
      }
 
@@ -956,3 +1007,55 @@ if ($o) {
 
     }
 
+##################################################################
+#  Subroutine RunCubes: forks a child for each cube, up to $maxjobs
+#  at a time.  Returns the cube in the child, which goes on to write
+#  its files; the parent waits for all the children and exits (1 if
+#  any of them failed).
+##################################################################
+sub RunCubes
+{
+   my @cubes = @_;
+   my ($cube, $pid, $running, $failed);
+
+   if (!defined($maxjobs) || $maxjobs < 1) {
+     $maxjobs = `getconf _NPROCESSORS_ONLN 2>/dev/null`;
+     chomp($maxjobs);
+     if ($maxjobs < 1) {$maxjobs = 1;}
+   }
+
+   # flush each print, so no output is left buffered when a child is
+   # forked (the child would print it again)
+   $| = 1;
+
+   $running = 0;
+   $failed = 0;
+   foreach $cube (@cubes) {
+     if ($running >= $maxjobs) {
+       wait();
+       if ($? != 0) {$failed++;}
+       $running--;
+     }
+     $pid = fork();
+     if (!defined($pid)) {
+       print "[isis3world.pl-ERROR] Unable to start a job for $cube\n";
+       $failed++;
+       last;
+     }
+     if ($pid == 0) {
+       return $cube;
+     }
+     $running++;
+   }
+
+   while ($running > 0) {
+     wait();
+     if ($? != 0) {$failed++;}
+     $running--;
+   }
+
+   print "\n Processed ".scalar(@cubes)." cubes";
+   print ", $failed failed" if ($failed);
+   print "\n";
+   exit($failed ? 1 : 0);
+}
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "isiscube.h"
+
+/**************  hi8bitraw.cpp *********************
+*                                                  *
+*  This routine converts the 32-bit noproj'ed      *
+*  mosaic of hi4socet.pl to the 8-bit raw image    *
+*  for import_pushbroom, in place of:              *
+*                                                  *
+*    percent percentage=0.05                       *
+*    percent percentage=99.95                      *
+*    stretch +8bit+1:254 pairs="0:0 min:1 max:254" *
+*            lis=1.0 lrs=1.0 his=254 hrs=254       *
+*    isis2raw bittype=8bit stretch=none            *
+*                                                  *
+*  Pass 1 reads the mosaic once into a histogram   *
+*  of 2^20 bins over the float bit patterns (each  *
+*  bin spans 1/2048 of its value's power of two),  *
+*  from which both percentiles are taken, refined  *
+*  by linear interpolation within their bins and   *
+*  bounded by the exact data minimum/maximum.      *
+*  Pass 2 streams the mosaic to the raw image.     *
+*                                                  *
+*  Stretch (as the stretch/isis2raw runs above):   *
+*    NULL                  -> 0                    *
+*    LIS, LRS, below pairs -> 1                    *
+*    HIS, HRS, above pairs -> 254                  *
+*    otherwise linear through the pairs, rounded,  *
+*    with values under 0.5 going to 0 (LRS)        *
+*  where the first pair is 0:0 if min > 0, else    *
+*  (min-1):0.                                      *
+*                                                  *
+*  The percentiles are printed as:                 *
+*    Minimum = <value at low percent>              *
+*    Maximum = <value at high percent>             *
+*  and the stretch uses the printed values.        *
+*                                                  *
+*  Build: cc -O2 -c isiscube.c                     *
+*         c++ -O2 hi8bitraw.cpp isiscube.o -lm     *
+*                                                  *
+* Oct 2026, original version                       *
+* Oct 2026, the cube reader is isiscube.c          *
+****************************************************/
+
+#define HIST_SHIFT 12                    /* 32 - 20 bits of bin index */
+#define HIST_BINS (1 << (32 - HIST_SHIFT))
+
+#define LRS4_BITS  0xFF7FFFFC
+#define LIS4_BITS  0xFF7FFFFD
+#define HIS4_BITS  0xFF7FFFFE
+#define HRS4_BITS  0xFF7FFFFF
+
+// routines
+int open_real_cube(isis_cube *c, char *file);
+unsigned int float_key(unsigned int bits);
+float key_float(unsigned int key);
+double percentile(unsigned int *hist, long long nvalid, double pct,
+                  float data_min, float data_max);
+unsigned char stretch_pixel(unsigned int bits, double p0, double min, double max);
+
+int main(int argc, char *argv[])
+{
+
+ isis_cube cube;
+ unsigned int *hist, bits, *line_px;
+ unsigned char *out;
+ long long nvalid;
+ double low_pct, high_pct, min, max, p0;
+ float v, data_min, data_max;
+ int line, s;
+ char value[64];
+ FILE *rawfp;
+
+ if (argc != 3 && argc != 5)
+    {
+    printf("\nUsage: hi8bitraw <mosaic>.cub <image>.raw [low_percent high_percent]\n");
+    printf("\n  stretches the 32-bit mosaic to an 8-bit raw image between the\n");
+    printf("  values at low_percent and high_percent (default 0.05 and 99.95)\n\n");
+    exit(1);
+    }
+
+ low_pct = 0.05;
+ high_pct = 99.95;
+ if (argc == 5)
+    {
+    low_pct = atof(argv[3]);
+    high_pct = atof(argv[4]);
+    if (low_pct < 0.0 || high_pct > 100.0 || low_pct >= high_pct)
+       {
+       printf("\nbad percentages %s %s\n",argv[3],argv[4]);
+       exit(1);
+       }
+    }
+
+ if (open_real_cube(&cube, argv[1]) != 0)
+    exit(1);
+
+ hist = (unsigned int *) calloc(HIST_BINS, sizeof(unsigned int));
+ out = (unsigned char *) malloc(cube.samples);
+ line_px = (unsigned int *) malloc((size_t) cube.samples * 4);
+ if (hist == NULL || out == NULL || line_px == NULL)
+    {
+    printf("\nunable to allocate the histogram\n");
+    exit(1);
+    }
+
+ /*****************************************************
+ * Pass 1: histogram of the valid pixels
+ *****************************************************/
+
+ nvalid = 0;
+ data_min = data_max = 0.0f;
+ for (line = 0; line < cube.lines; line++)
+    {
+    host_line(&cube, cube_line(&cube, 0, line), (unsigned char *) line_px);
+
+    for (s = 0; s < cube.samples; s++)
+       {
+       bits = line_px[s];
+       memcpy(&v,&bits,4);
+       if (bits >= NULL4_BITS || v != v)     // special pixel or NaN
+          continue;
+       if (nvalid == 0 || v < data_min) data_min = v;
+       if (nvalid == 0 || v > data_max) data_max = v;
+       hist[float_key(bits) >> HIST_SHIFT]++;
+       nvalid++;
+       }
+    }
+
+ if (nvalid == 0)
+    {
+    printf("\n%s has no valid pixels\n",argv[1]);
+    exit(1);
+    }
+
+ // stretch with the values as printed, so the stretch pairs reported
+ // by hi4socet.pl are the ones used
+ sprintf(value,"%.8g",percentile(hist,nvalid,low_pct,data_min,data_max));
+ min = atof(value);
+ printf("Minimum = %s\n",value);
+ sprintf(value,"%.8g",percentile(hist,nvalid,high_pct,data_min,data_max));
+ max = atof(value);
+ printf("Maximum = %s\n",value);
+
+ if (max <= min)
+    {
+    printf("\n%s: no stretch between %.8g and %.8g\n",argv[1],min,max);
+    exit(1);
+    }
+ p0 = (min > 0.0) ? 0.0 : min - 1.0;
+
+ /*****************************************************
+ * Pass 2: stretch to the raw image
+ *****************************************************/
+
+ rawfp = fopen(argv[2],"wb");
+ if (rawfp == NULL)
+    {
+    printf("\ncan't open output file %s!\n",argv[2]);
+    exit(1);
+    }
+
+ for (line = 0; line < cube.lines; line++)
+    {
+    host_line(&cube, cube_line(&cube, 0, line), (unsigned char *) line_px);
+
+    for (s = 0; s < cube.samples; s++)
+       out[s] = stretch_pixel(line_px[s],p0,min,max);
+
+    if (fwrite(out,1,cube.samples,rawfp) != (size_t) cube.samples)
+       {
+       printf("\nerror writing %s\n",argv[2]);
+       fclose(rawfp);
+       remove(argv[2]);
+       exit(1);
+       }
+    }
+
+ if (fclose(rawfp) != 0)
+    {
+    printf("\nerror writing %s\n",argv[2]);
+    remove(argv[2]);
+    exit(1);
+    }
+ fclose(cube.fp);
+
+ free(hist);
+ free(out);
+ free(line_px);
+
+ return(0);
+
+}
+
+/**************  open_real_cube  *******************
+*                                                  *
+*  Reads the label of the cube (isiscube.c),       *
+*  checks for a single band Real cube, and opens   *
+*  it                                              *
+*                                                  *
+****************************************************/
+int open_real_cube(isis_cube *c, char *file)
+{
+ if (read_cube_label(c, file) != 0)
+    return(-1);
+
+ if (strcmp(c->type,"Real") != 0 || c->base != 0.0 || c->mult != 1.0)
+    {
+    printf("\n%s: a 32-bit (Real) cube is required\n",file);
+    return(-1);
+    }
+
+ return(open_cube(c, (char *) "rb", 1) == 0 ? 0 : -1);
+}
+
+/**************  float keys  ***********************
+*                                                  *
+*  Maps float bit patterns to unsigned keys in     *
+*  the same order as the float values, and back    *
+*                                                  *
+****************************************************/
+unsigned int float_key(unsigned int bits)
+{
+ return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+float key_float(unsigned int key)
+{
+ unsigned int bits;
+ float v;
+
+ bits = (key & 0x80000000) ? (key & 0x7fffffff) : ~key;
+ memcpy(&v,&bits,4);
+ return v;
+}
+
+/**************  percentile  ***********************
+*                                                  *
+*  Value below which pct percent of the valid      *
+*  pixels lie: the bin holding it, interpolated    *
+*  by count between the bin's edges               *
+*                                                  *
+****************************************************/
+double percentile(unsigned int *hist, long long nvalid, double pct,
+                  float data_min, float data_max)
+{
+ double target, cum, lo, hi, value;
+ int i;
+
+ target = pct / 100.0 * (double) nvalid;
+ cum = 0.0;
+ for (i = 0; i < HIST_BINS; i++)
+    {
+    if (hist[i] == 0)
+       continue;
+    if (cum + hist[i] >= target)
+       break;
+    cum += hist[i];
+    }
+ if (i == HIST_BINS)
+    return data_max;
+
+ lo = key_float((unsigned int) i << HIST_SHIFT);
+ hi = key_float(((unsigned int) i << HIST_SHIFT) | ((1 << HIST_SHIFT) - 1));
+ if (lo < data_min) lo = data_min;
+ if (hi > data_max) hi = data_max;
+
+ value = lo + (target - cum) / hist[i] * (hi - lo);
+ if (value < lo) value = lo;
+ if (value > hi) value = hi;
+
+ return value;
+}
+
+/**************  stretch_pixel  ********************
+*                                                  *
+*  8-bit value of a pixel through the pairs        *
+*  p0:0 min:1 max:254                              *
+*                                                  *
+****************************************************/
+unsigned char stretch_pixel(unsigned int bits, double p0, double min, double max)
+{
+ float v;
+ double s;
+
+ if (bits == NULL4_BITS)
+    return 0;
+ if (bits == LRS4_BITS || bits == LIS4_BITS)
+    return 1;
+ if (bits == HIS4_BITS || bits == HRS4_BITS)
+    return 254;
+
+ memcpy(&v,&bits,4);
+ if (v != v)
+    return 0;
+ if (v < p0)
+    return 1;
+ if (v > max)
+    return 254;
+
+ if (v <= min)
+    s = (v - p0) / (min - p0);
+ else
+    s = 1.0 + 253.0 * (v - min) / (max - min);
+
+ if (s < 0.5)
+    return 0;
+ return (unsigned char) (s + 0.5);
+}
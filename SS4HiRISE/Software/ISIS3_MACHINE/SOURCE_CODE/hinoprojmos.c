@@ -0,0 +1,177 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "isiscube.h"
+
+/**************  hinoprojmos.c *********************
+*                                                  *
+*  This routine mosaics the noproj'ed RED CCDs of  *
+*  hinoproj.pl in a single pass, in place of one   *
+*  handmos priority=beneath run per CCD.           *
+*                                                  *
+*  The mosaic cube is the noproj'ed match CCD      *
+*  (renamed by hinoproj.pl), and keeps its size    *
+*  and label.  The placement list gives the other  *
+*  CCD cubes in priority order, one per line:      *
+*                                                  *
+*     <cube> <outsample> <outline>                 *
+*                                                  *
+*  where outsample/outline are the mosaic sample/  *
+*  line of the cube's first pixel, as for handmos. *
+*  A NULL mosaic pixel is filled from the first    *
+*  cube in the list with a valid pixel there, so   *
+*  the result is that of running handmos           *
+*  priority=beneath on the cubes in list order.    *
+*                                                  *
+*  Each cube is read once and the mosaic is        *
+*  rewritten once, a tile row (or for              *
+*  BandSequential cubes, block of lines) at a      *
+*  time.  All cubes must have one band and the     *
+*  same pixel type, byte order, base and           *
+*  multiplier.                                     *
+*                                                  *
+*  Build: cc -O2 hinoprojmos.c isiscube.c -lm      *
+*                                                  *
+* Oct 2026, original version                       *
+* Oct 2026, the cube reader is isiscube.c          *
+****************************************************/
+
+#define LINELENGTH 1024
+#define MAX_CUBES 64
+
+typedef struct {
+   isis_cube c;
+   int outsample, outline;   /* placement in the mosaic, 1-based */
+} placed_cube;
+
+main(int argc,char *argv[])
+{
+
+ isis_cube mos;
+ placed_cube *cubes;
+ int ncubes, i, k, row, nrows, l, line, s, s0, s1, in_line;
+ unsigned char null[4];
+ unsigned char *out, *in;
+ long long filled;
+ char line_buf[LINELENGTH];
+ char file[LINELENGTH];
+ int outsample, outline, psize;
+ FILE *lst;
+
+ if (argc != 3)
+    {
+    printf("\nUsage: hinoprojmos <mosaic>.cub <placement_list>\n");
+    printf("\n  fills the NULL pixels of the mosaic cube (in place) from the\n");
+    printf("  cubes of the placement list, lines of: <cube> <outsample> <outline>\n");
+    printf("  in priority order (as handmos priority=beneath run in list order)\n\n");
+    exit(1);
+    }
+
+ /*****************************************************
+ * Open the mosaic and the cubes of the placement list
+ *****************************************************/
+
+ if (read_cube_label(&mos, argv[1]) != 0 || open_cube(&mos, "r+b", 1) != 0)
+    exit(1);
+
+ cubes = (placed_cube *) calloc(MAX_CUBES, sizeof(placed_cube));
+ lst = fopen(argv[2],"r");
+ if (lst == NULL)
+    {
+    printf("\ncan't open the placement list %s!\n",argv[2]);
+    exit(1);
+    }
+
+ ncubes = 0;
+ while (fgets(line_buf,LINELENGTH,lst) != NULL)
+    {
+    if (sscanf(line_buf,"%s %d %d",file,&outsample,&outline) != 3)
+       continue;
+    if (ncubes == MAX_CUBES)
+       {
+       printf("\nmore than %d cubes in %s\n",MAX_CUBES,argv[2]);
+       exit(1);
+       }
+    if (read_cube_label(&cubes[ncubes].c, file) != 0 ||
+        open_cube(&cubes[ncubes].c, "rb", 1) != 0)
+       exit(1);
+    if (strcmp(cubes[ncubes].c.type,mos.type) != 0 ||
+        strcmp(cubes[ncubes].c.order,mos.order) != 0 ||
+        cubes[ncubes].c.base != mos.base || cubes[ncubes].c.mult != mos.mult)
+       {
+       printf("\n%s: pixel type/byte order/base/multiplier differ from %s\n",
+              file,argv[1]);
+       exit(1);
+       }
+    cubes[ncubes].outsample = outsample;
+    cubes[ncubes].outline = outline;
+    ncubes++;
+    }
+ fclose(lst);
+
+ null_pixel(&mos, null);
+ psize = mos.psize;
+
+ /*****************************************************
+ * A tile row of the mosaic at a time: read it, fill
+ * its NULL pixels from the cubes in priority order,
+ * and write it back
+ *****************************************************/
+
+ filled = 0;
+ nrows = (mos.lines + mos.tile_l - 1) / mos.tile_l;
+ for (row = 0; row < nrows; row++)
+    {
+    if (read_tile_row(&mos, 0, row) != 0)
+       exit(1);
+
+    for (l = 0; l < mos.tile_l; l++)
+       {
+       line = row*mos.tile_l + l;            /* 0-based mosaic line */
+       if (line >= mos.lines)
+          break;
+       out = mos.buf + (long long) l * mos.ntx * mos.tile_s * psize;
+
+       for (k = 0; k < ncubes; k++)
+          {
+          in_line = line - (cubes[k].outline - 1);
+          in = cube_line(&cubes[k].c, 0, in_line);
+          if (in == NULL)
+             continue;
+
+          /* mosaic samples covered by this cube */
+          s0 = cubes[k].outsample - 1;
+          s1 = s0 + cubes[k].c.samples;
+          if (s0 < 0) s0 = 0;
+          if (s1 > mos.samples) s1 = mos.samples;
+
+          for (s = s0; s < s1; s++)
+             {
+             if (memcmp(out + (long long) s*psize, null, psize) != 0)
+                continue;
+             i = s - (cubes[k].outsample - 1);
+             if (memcmp(in + (long long) i*psize, null, psize) == 0)
+                continue;
+             memcpy(out + (long long) s*psize, in + (long long) i*psize, psize);
+             filled++;
+             }
+          }
+       }
+
+    if (write_tile_row(&mos, 0, row) != 0)
+       exit(1);
+    }
+
+ if (fclose(mos.fp) != 0)
+    {
+    printf("\nerror writing %s\n",argv[1]);
+    exit(1);
+    }
+ for (k = 0; k < ncubes; k++)
+    fclose(cubes[k].c.fp);
+
+ printf("\n%s: %lld pixels filled from %d cubes\n",argv[1],filled,ncubes);
+
+ return(0);
+
+}
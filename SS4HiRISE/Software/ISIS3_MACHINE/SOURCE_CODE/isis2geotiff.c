@@ -0,0 +1,993 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "isiscube.h"
+
+/**************  isis2geotiff.c ********************
+*                                                  *
+*  This routine converts a map projected ISIS3     *
+*  cube (DEM, FOM, ortho or delta-radius cube of   *
+*  dem2isis3/ortho2isis3) to a tiled, Cloud        *
+*  Optimized GeoTIFF in a single read of the cube, *
+*  in place of gdal_translate (and the VRT hop of  *
+*  hi_isis2geotiff.pl for delta-radius cubes):     *
+*                                                  *
+*    isis2geotiff [options] in.cub out.tif         *
+*                                                  *
+*    -compress none|deflate|lzw  (default deflate) *
+*    -predictor  horizontal (2) or floating point  *
+*                (3) differencing before           *
+*                compression                       *
+*    -tile n     tile size (default 256)           *
+*    -threads n  tiles compressed at once          *
+*                (OpenMP, default all processors)  *
+*    -nooverviews                                  *
+*    -scale s -offset o                            *
+*                scale/offset of the values        *
+*                (default the cube's Multiplier/   *
+*                Base)                             *
+*    -tfw        also write a tiff world file      *
+*                                                  *
+*  Overviews are reduced 2x2 from the level above  *
+*  (mean of the valid pixels) as the lines are     *
+*  read, down to one tile.  The file is laid out   *
+*  as a COG: header, all IFDs, then the tiles of   *
+*  the smallest overview first and of the full     *
+*  image last.  The tiles are spilled to           *
+*  <out>.tiles while the cube is read and copied   *
+*  into place at the end.  BigTIFF is written when *
+*  the file would pass 4 GB.                       *
+*                                                  *
+*  The georeferencing comes from the Mapping group *
+*  (written by the maptemplate runs of             *
+*  generate_ss2isis_script): Equirectangular and   *
+*  SimpleCylindrical on the sphere ISIS uses for   *
+*  them (local radius at CenterLatitude and        *
+*  EquatorialRadius), Sinusoidal on the            *
+*  EquatorialRadius sphere and PolarStereographic  *
+*  on the ellipsoid.  PositiveWest center          *
+*  longitudes are given +East.  Special pixels     *
+*  are written as the ISIS NULL of the pixel type, *
+*  which is the GDAL_NODATA value.                 *
+*                                                  *
+*  Exits 2 if the input is not an ISIS3 cube or    *
+*  its projection is not one of the above (so the  *
+*  caller can use gdal_translate instead), 1 on    *
+*  any other error.                                *
+*                                                  *
+*  Build: cc -O2 -fopenmp isis2geotiff.c          *
+*            isiscube.c -lz -lm                    *
+*                                                  *
+* Oct 2026, original version                       *
+* Oct 2026, the cube reader and GeoKeys are        *
+*   isiscube.c                                     *
+****************************************************/
+
+#define LINELENGTH 1024
+#define DEFAULT_TILE 256
+#define MAX_LEVELS 16
+#define MAX_TAGS 32
+
+/* TIFF compression codes */
+#define COMPRESS_NONE    1
+#define COMPRESS_LZW     5
+#define COMPRESS_DEFLATE 8
+
+typedef struct {
+   /* output */
+   char file[LINELENGTH];
+   int compress, predictor, tile, nlevels, threads;
+   int psize, bits, format;  /* bytes per pixel, BitsPerSample, SampleFormat */
+   unsigned char nodata[4];  /* NULL of the pixel type, host order */
+   char nodata_str[64];
+   double scale, offset;
+   int big;
+
+   /* levels: 0 = full image, k = 2^k overview */
+   int w[MAX_LEVELS], h[MAX_LEVELS];
+   int ntx[MAX_LEVELS], nty[MAX_LEVELS];
+   unsigned char *band[MAX_LEVELS];   /* one tile row being filled */
+   int nrows[MAX_LEVELS];             /* lines in band */
+   int tile_row[MAX_LEVELS];          /* tile row of band */
+   unsigned char *hold[MAX_LEVELS];   /* line of level k-1 waiting for its pair */
+   int held[MAX_LEVELS];
+   unsigned char *red[MAX_LEVELS];    /* reduced line */
+   unsigned long long *off[MAX_LEVELS], *cnt[MAX_LEVELS];  /* spill offset/size per tile */
+
+   /* spill file */
+   char spill_name[LINELENGTH];
+   FILE *spill;
+   unsigned long long spill_size;
+   unsigned char **tbuf;              /* compressed tile per tile column */
+   long long *tlen;
+   long long tmax;
+} geotiff;
+
+/* routines */
+int setup_levels(geotiff *g, isis_cube *c, int overviews);
+void add_row(geotiff *g, int k, unsigned char *row);
+void reduce_rows(geotiff *g, int k, unsigned char *a, unsigned char *b, unsigned char *out);
+void flush_band(geotiff *g, int k);
+long long encode_tile(geotiff *g, int k, int t, unsigned char *raw, unsigned char *out);
+long long lzw_encode(unsigned char *in, long long n, unsigned char *out);
+int write_geotiff(geotiff *g, isis_cube *c);
+int write_tfw(char *tif, isis_cube *c);
+
+int host_lsb;
+
+main(int argc,char *argv[])
+{
+
+ isis_cube cube;
+ geotiff g;
+ int i, l, ret, overviews, tfw, user_scale, user_offset;
+ unsigned char *in, *row;
+
+ overviews = 1;
+ tfw = 0;
+ user_scale = user_offset = 0;
+ memset(&g,0,sizeof(geotiff));
+ g.compress = COMPRESS_DEFLATE;
+ g.tile = DEFAULT_TILE;
+
+ for (i = 1; i < argc-2; i++)
+    {
+    if (strcmp(argv[i],"-compress") == 0 && i+1 < argc-2)
+       {
+       i++;
+       if (strcmp(argv[i],"none") == 0) g.compress = COMPRESS_NONE;
+       else if (strcmp(argv[i],"deflate") == 0) g.compress = COMPRESS_DEFLATE;
+       else if (strcmp(argv[i],"lzw") == 0) g.compress = COMPRESS_LZW;
+       else break;
+       }
+    else if (strcmp(argv[i],"-predictor") == 0)
+       g.predictor = 1;
+    else if (strcmp(argv[i],"-tile") == 0 && i+1 < argc-2)
+       g.tile = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-threads") == 0 && i+1 < argc-2)
+       g.threads = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-nooverviews") == 0)
+       overviews = 0;
+    else if (strcmp(argv[i],"-scale") == 0 && i+1 < argc-2)
+       {
+       g.scale = atof(argv[++i]);
+       user_scale = 1;
+       }
+    else if (strcmp(argv[i],"-offset") == 0 && i+1 < argc-2)
+       {
+       g.offset = atof(argv[++i]);
+       user_offset = 1;
+       }
+    else if (strcmp(argv[i],"-tfw") == 0)
+       tfw = 1;
+    else
+       break;
+    }
+
+ if (argc < 3 || i != argc-2 || g.tile < 16 || g.tile % 16 != 0)
+    {
+    printf("\nUsage: isis2geotiff [-compress none|deflate|lzw] [-predictor] [-tile n]\n");
+    printf("                    [-threads n] [-nooverviews] [-scale s] [-offset o]\n");
+    printf("                    [-tfw] <input>.cub <output>.tif\n");
+    printf("\n  converts a map projected ISIS3 cube to a tiled Cloud Optimized GeoTIFF\n");
+    printf("  with internal overviews (tile size a multiple of 16)\n\n");
+    exit(1);
+    }
+ strcpy(g.file,argv[argc-1]);
+
+ l = 1;
+ host_lsb = (*(unsigned char *) &l == 1);
+
+#ifdef _OPENMP
+ if (g.threads > 0)
+    omp_set_num_threads(g.threads);
+#endif
+
+ /*****************************************************
+ * Open the cube and check its projection
+ *****************************************************/
+
+ ret = open_map_cube(&cube, argv[argc-2], 1);
+ if (ret != 0)
+    exit(ret);
+
+ if (!user_scale) g.scale = cube.mult;
+ if (!user_offset) g.offset = cube.base;
+
+ if (setup_levels(&g, &cube, overviews) != 0)
+    exit(1);
+
+ /*****************************************************
+ * One pass over the lines of the cube: each line goes
+ * into the tile row of the full image and down the
+ * overview levels; full tile rows are compressed and
+ * spilled as they fill
+ *****************************************************/
+
+ row = (unsigned char *) malloc((long long) cube.samples * cube.psize);
+ if (row == NULL)
+    {
+    printf("\nunable to allocate a line of %s\n",cube.file);
+    exit(1);
+    }
+
+ for (l = 0; l < cube.lines; l++)
+    {
+    in = cube_line(&cube, 0, l);
+    convert_line(&cube, in, row);
+    add_row(&g, 0, row);
+    }
+
+ /* pair up the last odd lines and flush the partial tile rows, from the
+    full image down */
+ for (i = 0; i < g.nlevels; i++)
+    {
+    if (i+1 < g.nlevels && g.held[i+1])
+       {
+       reduce_rows(&g, i+1, g.hold[i+1], g.hold[i+1], g.red[i+1]);
+       g.held[i+1] = 0;
+       add_row(&g, i+1, g.red[i+1]);
+       }
+    if (g.nrows[i] > 0)
+       flush_band(&g, i);
+    }
+ fclose(cube.fp);
+
+ /*****************************************************
+ * Write the IFDs and copy the tiles into place
+ *****************************************************/
+
+ if (write_geotiff(&g, &cube) != 0)
+    {
+    unlink(g.spill_name);
+    exit(1);
+    }
+
+ if (tfw && write_tfw(g.file, &cube) != 0)
+    exit(1);
+
+ printf("\n%s: %d x %d %s, %d overview(s)\n",g.file,cube.samples,cube.lines,
+        cube.type,g.nlevels-1);
+
+ return(0);
+
+}
+
+/**************  setup_levels  *********************
+*                                                  *
+*  Sizes the full image and overview levels (down  *
+*  to one tile) and allocates their buffers        *
+*                                                  *
+****************************************************/
+int setup_levels(geotiff *g, isis_cube *c, int overviews)
+{
+ int k, t, bits;
+ long long rowbytes;
+ unsigned short word;
+ float null4;
+
+ g->psize = c->psize;
+ g->bits = 8 * c->psize;
+ if (c->psize == 4)
+    {
+    g->format = 3;
+    bits = NULL4_BITS;
+    memcpy(g->nodata,&bits,4);
+    memcpy(&null4,&bits,4);
+    sprintf(g->nodata_str,"%.17g",(double) null4);
+    }
+ else if (c->psize == 2)
+    {
+    g->format = 2;
+    word = (unsigned short) NULL2;
+    memcpy(g->nodata,&word,2);
+    sprintf(g->nodata_str,"%d",NULL2);
+    }
+ else
+    {
+    g->format = 1;
+    g->nodata[0] = 0;
+    strcpy(g->nodata_str,"0");
+    }
+
+ g->w[0] = c->samples;
+ g->h[0] = c->lines;
+ g->nlevels = 1;
+ while (overviews && g->nlevels < MAX_LEVELS &&
+        (g->w[g->nlevels-1] > g->tile || g->h[g->nlevels-1] > g->tile))
+    {
+    g->w[g->nlevels] = (g->w[g->nlevels-1] + 1) / 2;
+    g->h[g->nlevels] = (g->h[g->nlevels-1] + 1) / 2;
+    g->nlevels++;
+    }
+
+ for (k = 0; k < g->nlevels; k++)
+    {
+    g->ntx[k] = (g->w[k] + g->tile - 1) / g->tile;
+    g->nty[k] = (g->h[k] + g->tile - 1) / g->tile;
+    rowbytes = (long long) g->ntx[k] * g->tile * g->psize;
+    g->band[k] = (unsigned char *) malloc(rowbytes * g->tile);
+    g->hold[k] = (unsigned char *) malloc((long long) g->w[k > 0 ? k-1 : 0] * g->psize);
+    g->red[k] = (unsigned char *) malloc(rowbytes);
+    g->off[k] = (unsigned long long *) calloc((long long) g->ntx[k]*g->nty[k],
+                                              sizeof(unsigned long long));
+    g->cnt[k] = (unsigned long long *) calloc((long long) g->ntx[k]*g->nty[k],
+                                              sizeof(unsigned long long));
+    if (g->band[k] == NULL || g->hold[k] == NULL || g->red[k] == NULL ||
+        g->off[k] == NULL || g->cnt[k] == NULL)
+       {
+       printf("\nunable to allocate the tile rows of %s\n",g->file);
+       return(-1);
+       }
+    for (t = 0; t < rowbytes * g->tile / g->psize; t++)
+       memcpy(g->band[k] + (long long) t*g->psize, g->nodata, g->psize);
+    }
+
+ /* compressed tiles of a tile row: LZW codes can take up to 12 bits a byte */
+ g->tmax = (long long) g->tile * g->tile * g->psize;
+ g->tmax = g->tmax + g->tmax/2 + 1024;
+ if (compressBound(g->tmax) > g->tmax)
+    g->tmax = compressBound(g->tmax);
+ g->tbuf = (unsigned char **) calloc(g->ntx[0], sizeof(unsigned char *));
+ g->tlen = (long long *) calloc(g->ntx[0], sizeof(long long));
+ for (t = 0; t < g->ntx[0]; t++)
+    {
+    g->tbuf[t] = (unsigned char *) malloc(g->tmax);
+    if (g->tbuf[t] == NULL)
+       {
+       printf("\nunable to allocate the tile buffers of %s\n",g->file);
+       return(-1);
+       }
+    }
+
+ sprintf(g->spill_name,"%s.tiles",g->file);
+ g->spill = fopen(g->spill_name,"w+b");
+ if (g->spill == NULL)
+    {
+    printf("\ncan't open %s!\n",g->spill_name);
+    return(-1);
+    }
+
+ return(0);
+}
+
+/**************  add_row  **************************
+*                                                  *
+*  Adds a line to the tile row of level k,         *
+*  flushing the tile row when it is full, and      *
+*  passes each pair of lines on to level k+1 as    *
+*  one reduced line                                *
+*                                                  *
+****************************************************/
+void add_row(geotiff *g, int k, unsigned char *row)
+{
+ long long rowbytes;
+
+ rowbytes = (long long) g->ntx[k] * g->tile * g->psize;
+ memcpy(g->band[k] + g->nrows[k]*rowbytes, row, (long long) g->w[k]*g->psize);
+ g->nrows[k]++;
+ if (g->nrows[k] == g->tile)
+    flush_band(g, k);
+
+ if (k+1 >= g->nlevels)
+    return;
+
+ if (!g->held[k+1])
+    {
+    memcpy(g->hold[k+1], row, (long long) g->w[k]*g->psize);
+    g->held[k+1] = 1;
+    return;
+    }
+
+ reduce_rows(g, k+1, g->hold[k+1], row, g->red[k+1]);
+ g->held[k+1] = 0;
+ add_row(g, k+1, g->red[k+1]);
+}
+
+/**************  reduce_rows  **********************
+*                                                  *
+*  Line of level k from two lines of level k-1:    *
+*  the mean of the valid pixels of each 2x2 block  *
+*  (NULL if there are none)                        *
+*                                                  *
+****************************************************/
+void reduce_rows(geotiff *g, int k, unsigned char *a, unsigned char *b, unsigned char *out)
+{
+ int s, i, n, win;
+ double sum;
+ float f;
+ short w;
+ unsigned int bits;
+ unsigned char *p[2];
+
+ win = g->w[k-1];
+ p[0] = a;
+ p[1] = b;
+ for (s = 0; s < g->w[k]; s++)
+    {
+    n = 0;
+    sum = 0.0;
+    for (i = 0; i < 4; i++)
+       {
+       if (2*s + (i & 1) >= win)
+          continue;
+       if (g->psize == 4)
+          {
+          memcpy(&bits, p[i >> 1] + (long long) (2*s + (i & 1))*4, 4);
+          if (bits == NULL4_BITS) continue;
+          memcpy(&f,&bits,4);
+          sum += f;
+          }
+       else if (g->psize == 2)
+          {
+          memcpy(&w, p[i >> 1] + (long long) (2*s + (i & 1))*2, 2);
+          if (w == NULL2) continue;
+          sum += w;
+          }
+       else
+          {
+          if (p[i >> 1][2*s + (i & 1)] == 0) continue;
+          sum += p[i >> 1][2*s + (i & 1)];
+          }
+       n++;
+       }
+
+    if (n == 0)
+       memcpy(out + (long long) s*g->psize, g->nodata, g->psize);
+    else if (g->psize == 4)
+       {
+       f = (float) (sum / n);
+       memcpy(out + (long long) s*4,&f,4);
+       }
+    else if (g->psize == 2)
+       {
+       w = (short) floor(sum / n + 0.5);
+       memcpy(out + (long long) s*2,&w,2);
+       }
+    else
+       out[s] = (unsigned char) floor(sum / n + 0.5);
+    }
+}
+
+/**************  flush_band  ***********************
+*                                                  *
+*  Compresses the tiles of the tile row of level k *
+*  (in parallel) and appends them to the spill     *
+*  file                                            *
+*                                                  *
+****************************************************/
+void flush_band(geotiff *g, int k)
+{
+ long long rowbytes, n;
+ int t, err;
+
+ rowbytes = (long long) g->ntx[k] * g->tile * g->psize;
+ err = 0;
+
+#pragma omp parallel for schedule(dynamic)
+ for (t = 0; t < g->ntx[k]; t++)
+    {
+    unsigned char *raw = (unsigned char *) malloc((long long) g->tile*g->tile*g->psize);
+    if (raw == NULL)
+       err = 1;
+    else
+       {
+       g->tlen[t] = encode_tile(g, k, t, raw, g->tbuf[t]);
+       if (g->tlen[t] < 0)
+          err = 1;
+       free(raw);
+       }
+    }
+ if (err)
+    {
+    printf("\nerror compressing the tiles of %s\n",g->file);
+    unlink(g->spill_name);
+    exit(1);
+    }
+
+ for (t = 0; t < g->ntx[k]; t++)
+    {
+    n = (long long) g->tile_row[k]*g->ntx[k] + t;
+    g->off[k][n] = g->spill_size;
+    g->cnt[k][n] = g->tlen[t];
+    if (fwrite(g->tbuf[t],1,g->tlen[t],g->spill) != g->tlen[t])
+       {
+       printf("\nerror writing %s\n",g->spill_name);
+       unlink(g->spill_name);
+       exit(1);
+       }
+    g->spill_size += g->tlen[t];
+    }
+
+ /* back to all NULL for the next tile row */
+ for (n = 0; n < rowbytes * g->tile / g->psize; n++)
+    memcpy(g->band[k] + n*g->psize, g->nodata, g->psize);
+ g->nrows[k] = 0;
+ g->tile_row[k]++;
+}
+
+/**************  encode_tile  **********************
+*                                                  *
+*  Cuts tile t out of the tile row of level k,     *
+*  applies the predictor, puts it in file (Lsb)    *
+*  byte order and compresses it into out.          *
+*  Returns the compressed size, -1 on error.       *
+*                                                  *
+****************************************************/
+long long encode_tile(geotiff *g, int k, int t, unsigned char *raw, unsigned char *out)
+{
+ long long rowbytes, tbytes, n;
+ int l, s, b, ts;
+ unsigned char *p, *row, *fp_row, tmp[4];
+ unsigned short *w;
+ uLongf dlen;
+
+ ts = g->tile;
+ rowbytes = (long long) g->ntx[k] * ts * g->psize;
+ tbytes = (long long) ts * g->psize;
+ n = tbytes * ts;
+
+ for (l = 0; l < ts; l++)
+    memcpy(raw + l*tbytes, g->band[k] + l*rowbytes + t*tbytes, tbytes);
+
+ fp_row = NULL;
+ if (g->predictor && g->compress != COMPRESS_NONE && g->psize == 4)
+    {
+    fp_row = (unsigned char *) malloc(tbytes);
+    if (fp_row == NULL)
+       return(-1);
+    }
+
+ for (l = 0; l < ts; l++)
+    {
+    row = raw + l*tbytes;
+    if (fp_row != NULL)
+       {
+       /* floating point predictor: bytes of the row regrouped most
+          significant first, then differenced */
+       memcpy(fp_row,row,tbytes);
+       for (s = 0; s < ts; s++)
+          for (b = 0; b < 4; b++)
+             row[(host_lsb ? 3-b : b)*ts + s] = fp_row[4*s + b];
+       for (s = (int) tbytes - 1; s > 0; s--)
+          row[s] = (unsigned char) (row[s] - row[s-1]);
+       continue;
+       }
+    if (g->predictor && g->compress != COMPRESS_NONE)
+       {
+       /* horizontal differencing */
+       if (g->psize == 2)
+          {
+          w = (unsigned short *) row;
+          for (s = ts-1; s > 0; s--)
+             w[s] = (unsigned short) (w[s] - w[s-1]);
+          }
+       else
+          for (s = ts-1; s > 0; s--)
+             row[s] = (unsigned char) (row[s] - row[s-1]);
+       }
+    if (!host_lsb && g->psize > 1)
+       for (s = 0; s < ts; s++)
+          {
+          p = row + s*g->psize;
+          for (b = 0; b < g->psize; b++) tmp[b] = p[g->psize-1-b];
+          memcpy(p,tmp,g->psize);
+          }
+    }
+ if (fp_row != NULL)
+    free(fp_row);
+
+ if (g->compress == COMPRESS_NONE)
+    {
+    memcpy(out,raw,n);
+    return(n);
+    }
+ if (g->compress == COMPRESS_LZW)
+    return(lzw_encode(raw, n, out));
+
+ dlen = g->tmax;
+ if (compress2(out, &dlen, raw, n, 6) != Z_OK)
+    return(-1);
+ return((long long) dlen);
+}
+
+/**************  lzw_encode  ***********************
+*                                                  *
+*  TIFF LZW (codes of 9 to 12 bits, most           *
+*  significant bit first, code width bumped one    *
+*  code early as libtiff does)                     *
+*                                                  *
+****************************************************/
+#define LZW_CLEAR 256
+#define LZW_EOI 257
+#define LZW_FIRST 258
+#define LZW_MAX 4095
+#define LZW_HSIZE 9001          /* prime, > 2 x 4096 */
+
+long long lzw_encode(unsigned char *in, long long n, unsigned char *out)
+{
+ int hkey[LZW_HSIZE], hcode[LZW_HSIZE];
+ int ent, c, key, h, free_ent, nbits, maxcode;
+ long long i, op;
+ unsigned long nextdata;
+ int nextbits;
+
+#define PUT_CODE(code) { nextdata = (nextdata << nbits) | (code); nextbits += nbits; \
+                         while (nextbits >= 8) { out[op++] = (unsigned char) (nextdata >> (nextbits-8)); \
+                                                 nextbits -= 8; } \
+                         nextdata &= (1UL << nextbits) - 1; }
+
+ op = 0;
+ nextdata = 0;
+ nextbits = 0;
+ nbits = 9;
+ maxcode = (1 << nbits) - 1;
+ free_ent = LZW_FIRST;
+ for (h = 0; h < LZW_HSIZE; h++) hkey[h] = -1;
+
+ PUT_CODE(LZW_CLEAR);
+ if (n == 0)
+    {
+    PUT_CODE(LZW_EOI);
+    if (nextbits > 0) out[op++] = (unsigned char) (nextdata << (8-nextbits));
+    return(op);
+    }
+
+ ent = in[0];
+ for (i = 1; i < n; i++)
+    {
+    c = in[i];
+    key = (ent << 8) | c;
+    h = key % LZW_HSIZE;
+    while (hkey[h] != -1 && hkey[h] != key)
+       h = (h + 1) % LZW_HSIZE;
+    if (hkey[h] == key)
+       {
+       ent = hcode[h];
+       continue;
+       }
+
+    PUT_CODE(ent);
+    ent = c;
+    hkey[h] = key;
+    hcode[h] = free_ent++;
+    if (free_ent == LZW_MAX-1)
+       {
+       /* table full: clear it and start over at 9 bits */
+       for (h = 0; h < LZW_HSIZE; h++) hkey[h] = -1;
+       free_ent = LZW_FIRST;
+       PUT_CODE(LZW_CLEAR);
+       nbits = 9;
+       maxcode = (1 << nbits) - 1;
+       }
+    else if (free_ent > maxcode)
+       {
+       nbits++;
+       maxcode = (1 << nbits) - 1;
+       }
+    }
+
+ PUT_CODE(ent);
+ free_ent++;
+ if (free_ent == LZW_MAX-1)
+    {
+    PUT_CODE(LZW_CLEAR);
+    nbits = 9;
+    }
+ else if (free_ent > maxcode)
+    nbits++;
+ PUT_CODE(LZW_EOI);
+ if (nextbits > 0)
+    out[op++] = (unsigned char) (nextdata << (8-nextbits));
+
+#undef PUT_CODE
+ return(op);
+}
+
+/**************  IFD output  ***********************
+*                                                  *
+*  An IFD is its tag entries followed by the tag   *
+*  values that don't fit in an entry (4 bytes, or  *
+*  8 for BigTIFF), each on a word boundary         *
+*                                                  *
+****************************************************/
+static int type_size(int type)
+{
+ if (type == T_ASCII) return(1);
+ if (type == T_SHORT) return(2);
+ if (type == T_LONG) return(4);
+ return(8);
+}
+
+static void put_le(unsigned char *p, unsigned long long v, int n)
+{
+ int i;
+
+ for (i = 0; i < n; i++)
+    p[i] = (unsigned char) (v >> (8*i));
+}
+
+static void put_value(unsigned char *p, tiff_tag *t, long long i)
+{
+ unsigned long long bits;
+
+ if (t->type == T_ASCII)
+    p[0] = ((char *) t->data)[i];
+ else if (t->type == T_SHORT)
+    put_le(p, ((unsigned short *) t->data)[i], 2);
+ else if (t->type == T_DOUBLE)
+    {
+    memcpy(&bits, &((double *) t->data)[i], 8);
+    put_le(p, bits, 8);
+    }
+ else
+    put_le(p, ((unsigned long long *) t->data)[i], type_size(t->type));
+}
+
+static long long ifd_size(tiff_tag *tags, int ntags, int big)
+{
+ long long size, n;
+ int i;
+
+ size = big ? 8 + 20*ntags + 8 : 2 + 12*ntags + 4;
+ for (i = 0; i < ntags; i++)
+    {
+    n = tags[i].count * type_size(tags[i].type);
+    if (n > (big ? 8 : 4))
+       size += n + (n & 1);
+    }
+ return(size);
+}
+
+static unsigned char *build_ifd(tiff_tag *tags, int ntags, int big,
+                                unsigned long long pos, unsigned long long next,
+                                long long *size)
+{
+ unsigned char *buf, *e;
+ long long ext, n, j;
+ int i, isz;
+
+ *size = ifd_size(tags, ntags, big);
+ buf = (unsigned char *) calloc(*size, 1);
+ if (buf == NULL)
+    return(NULL);
+
+ isz = big ? 8 : 4;
+ put_le(buf, ntags, big ? 8 : 2);
+ e = buf + (big ? 8 : 2);
+ ext = (big ? 8 + 20*ntags + 8 : 2 + 12*ntags + 4);
+ for (i = 0; i < ntags; i++, e += (big ? 20 : 12))
+    {
+    put_le(e, tags[i].tag, 2);
+    put_le(e+2, tags[i].type, 2);
+    put_le(e+4, tags[i].count, big ? 8 : 4);
+    n = tags[i].count * type_size(tags[i].type);
+    if (n <= isz)
+       {
+       for (j = 0; j < tags[i].count; j++)
+          put_value(e + 4 + isz + j*type_size(tags[i].type), &tags[i], j);
+       continue;
+       }
+    put_le(e + 4 + isz, pos + ext, isz);
+    for (j = 0; j < tags[i].count; j++)
+       put_value(buf + ext + j*type_size(tags[i].type), &tags[i], j);
+    ext += n + (n & 1);
+    }
+ put_le(buf + (big ? 8 + 20*ntags : 2 + 12*ntags), next, isz);
+
+ return(buf);
+}
+
+/**************  write_geotiff  ********************
+*                                                  *
+*  Writes the header, the IFDs of the full image   *
+*  and the overviews, and the tiles (smallest      *
+*  overview first) copied from the spill file      *
+*                                                  *
+****************************************************/
+int write_geotiff(geotiff *g, isis_cube *c)
+{
+ static unsigned short bits_s[1], compress_s[1], photo_s[1], spp_s[1],
+                       planar_s[1], pred_s[1], format_s[1];
+ static unsigned long long subfile_l[1], w_l[MAX_LEVELS], h_l[MAX_LEVELS], tile_l[1];
+ tiff_tag tags[MAX_LEVELS][MAX_TAGS];
+ int ntags[MAX_LEVELS];
+ unsigned short keys[4*MAX_GEOKEYS+4];
+ double dbl[MAX_GEOKEYS];
+ char ascii[LINELENGTH], metadata[LINELENGTH], layout[LINELENGTH], ghost[LINELENGTH];
+ unsigned long long *toff[MAX_LEVELS], ifd_pos[MAX_LEVELS+1], data;
+ unsigned char *buf, header[16];
+ long long size, nt, j, ghost_len;
+ int k, n;
+ FILE *fp;
+
+ bits_s[0] = g->bits;
+ compress_s[0] = g->compress;
+ photo_s[0] = 1;                     /* min-is-black */
+ spp_s[0] = 1;
+ planar_s[0] = 1;
+ pred_s[0] = (g->psize == 4) ? 3 : 2;
+ format_s[0] = g->format;
+ subfile_l[0] = 1;                   /* reduced resolution image */
+ tile_l[0] = g->tile;
+
+ metadata[0] = '\0';
+ if (g->scale != 1.0 || g->offset != 0.0)
+    sprintf(metadata,"<GDALMetadata>\n"
+            "  <Item name=\"OFFSET\" sample=\"0\" role=\"offset\">%.17g</Item>\n"
+            "  <Item name=\"SCALE\" sample=\"0\" role=\"scale\">%.17g</Item>\n"
+            "</GDALMetadata>\n",g->offset,g->scale);
+
+ /* what a COG reader may rely on, ahead of the first IFD (as GDAL does) */
+ sprintf(layout,"LAYOUT=IFDS_BEFORE_DATA\nBLOCK_ORDER=ROW_MAJOR\n"
+         "KNOWN_INCOMPATIBLE_EDITION=NO\n");
+ sprintf(ghost,"GDAL_STRUCTURAL_METADATA_SIZE=%06d bytes\n%s",(int) strlen(layout),layout);
+ ghost_len = strlen(ghost);
+
+#define TAG(k,t,ty,n,d) { tags[k][ntags[k]].tag = t; tags[k][ntags[k]].type = ty; \
+                          tags[k][ntags[k]].count = n; tags[k][ntags[k]].data = d; ntags[k]++; }
+
+ for (k = 0; k < g->nlevels; k++)
+    {
+    nt = (long long) g->ntx[k] * g->nty[k];
+    toff[k] = (unsigned long long *) calloc(nt, sizeof(unsigned long long));
+    if (toff[k] == NULL)
+       {
+       printf("\nunable to allocate the tile offsets of %s\n",g->file);
+       return(-1);
+       }
+    w_l[k] = g->w[k];
+    h_l[k] = g->h[k];
+    ntags[k] = 0;
+    if (k > 0)
+       TAG(k, 254, T_LONG, 1, subfile_l);
+    TAG(k, 256, T_LONG, 1, &w_l[k]);
+    TAG(k, 257, T_LONG, 1, &h_l[k]);
+    TAG(k, 258, T_SHORT, 1, bits_s);
+    TAG(k, 259, T_SHORT, 1, compress_s);
+    TAG(k, 262, T_SHORT, 1, photo_s);
+    TAG(k, 277, T_SHORT, 1, spp_s);
+    TAG(k, 284, T_SHORT, 1, planar_s);
+    if (g->predictor && g->compress != COMPRESS_NONE)
+       TAG(k, 317, T_SHORT, 1, pred_s);
+    TAG(k, 322, T_LONG, 1, tile_l);
+    TAG(k, 323, T_LONG, 1, tile_l);
+    TAG(k, 324, T_LONG, nt, toff[k]);
+    TAG(k, 325, T_LONG, nt, g->cnt[k]);
+    TAG(k, 339, T_SHORT, 1, format_s);
+    if (k == 0)
+       {
+       ntags[0] = geo_tags(c, tags[0], ntags[0], keys, dbl, ascii);
+       if (metadata[0])
+          TAG(0, 42112, T_ASCII, (long long) strlen(metadata)+1, metadata);
+       }
+    TAG(k, 42113, T_ASCII, (long long) strlen(g->nodata_str)+1, g->nodata_str);
+    }
+#undef TAG
+
+ /* classic TIFF unless the file would pass 4 GB */
+ for (g->big = 0; g->big < 2; g->big++)
+    {
+    for (k = 0; k < g->nlevels; k++)
+       for (n = 0; n < ntags[k]; n++)
+          if (tags[k][n].tag == 324 || tags[k][n].tag == 325)
+             tags[k][n].type = g->big ? T_LONG8 : T_LONG;
+
+    ifd_pos[0] = (g->big ? 16 : 8) + ghost_len;
+    for (k = 0; k < g->nlevels; k++)
+       ifd_pos[k+1] = ifd_pos[k] + ifd_size(tags[k], ntags[k], g->big);
+    if (g->big || ifd_pos[g->nlevels] + g->spill_size < 0xFFFFFFFFULL)
+       break;
+    }
+
+ data = ifd_pos[g->nlevels];
+ for (k = g->nlevels-1; k >= 0; k--)
+    {
+    nt = (long long) g->ntx[k] * g->nty[k];
+    for (j = 0; j < nt; j++)
+       {
+       toff[k][j] = data;
+       data += g->cnt[k][j];
+       }
+    }
+
+ fp = fopen(g->file,"wb");
+ if (fp == NULL)
+    {
+    printf("\ncan't open the output file %s!\n",g->file);
+    return(-1);
+    }
+
+ header[0] = header[1] = 'I';
+ if (g->big)
+    {
+    put_le(header+2, 43, 2);
+    put_le(header+4, 8, 2);
+    put_le(header+6, 0, 2);
+    put_le(header+8, ifd_pos[0], 8);
+    }
+ else
+    {
+    put_le(header+2, 42, 2);
+    put_le(header+4, ifd_pos[0], 4);
+    }
+ fwrite(header,1,g->big ? 16 : 8,fp);
+ fwrite(ghost,1,ghost_len,fp);
+
+ for (k = 0; k < g->nlevels; k++)
+    {
+    buf = build_ifd(tags[k], ntags[k], g->big, ifd_pos[k],
+                    (k+1 < g->nlevels) ? ifd_pos[k+1] : 0, &size);
+    if (buf == NULL || fwrite(buf,1,size,fp) != size)
+       {
+       printf("\nerror writing %s\n",g->file);
+       return(-1);
+       }
+    free(buf);
+    }
+
+ /* tiles, smallest overview first */
+ buf = (unsigned char *) malloc(g->tmax);
+ for (k = g->nlevels-1; k >= 0; k--)
+    {
+    nt = (long long) g->ntx[k] * g->nty[k];
+    for (j = 0; j < nt; j++)
+       {
+       if (fseeko(g->spill, g->off[k][j], SEEK_SET) != 0 ||
+           fread(buf,1,g->cnt[k][j],g->spill) != g->cnt[k][j] ||
+           fwrite(buf,1,g->cnt[k][j],fp) != g->cnt[k][j])
+          {
+          printf("\nerror copying the tiles to %s\n",g->file);
+          return(-1);
+          }
+       }
+    }
+ free(buf);
+
+ fclose(g->spill);
+ unlink(g->spill_name);
+ if (fclose(fp) != 0)
+    {
+    printf("\nerror writing %s\n",g->file);
+    return(-1);
+    }
+
+ return(0);
+}
+
+/**************  write_tfw  ************************
+*                                                  *
+*  Tiff world file: pixel size and the center of   *
+*  the upper left pixel                            *
+*                                                  *
+****************************************************/
+int write_tfw(char *tif, isis_cube *c)
+{
+ char tfw[LINELENGTH];
+ char *ext;
+ FILE *fp;
+
+ strcpy(tfw,tif);
+ ext = strrchr(tfw,'.');
+ if (ext != NULL && strchr(ext,'/') == NULL)
+    *ext = '\0';
+ strcat(tfw,".tfw");
+
+ fp = fopen(tfw,"w");
+ if (fp == NULL)
+    {
+    printf("\ncan't open the world file %s!\n",tfw);
+    return(-1);
+    }
+ fprintf(fp,"%.10f\n0.0000000000\n0.0000000000\n%.10f\n%.10f\n%.10f\n",
+         c->res, -c->res, c->ulx + c->res/2.0, c->uly - c->res/2.0);
+ fclose(fp);
+
+ return(0);
+}
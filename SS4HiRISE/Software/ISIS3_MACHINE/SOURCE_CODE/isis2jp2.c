@@ -0,0 +1,865 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <openjpeg.h>
+#include "isiscube.h"
+
+/**************  isis2jp2.c ************************
+*                                                  *
+*  This routine converts a map projected ISIS3     *
+*  cube to a GeoJPEG2000 file, reading the tiles   *
+*  of the cube directly, in place of the crop (or  *
+*  isis2raw stretch) copy and gdal_translate JP2KAK*
+*  run of isis3gdal_jp2.pl:                        *
+*                                                  *
+*    isis2jp2 [options] in.cub out.jp2             *
+*                                                  *
+*    -q n        quality, percent of the size of   *
+*                the uncompressed image (1-100,    *
+*                default 100 = lossless), as the   *
+*                JP2KAK quality option             *
+*    -f          Real cube truncated to 16 bit     *
+*    -s 8|16     linear stretch of the 0.5% to     *
+*                99.5% range of each band to 8     *
+*                bit (1-255) or 16 bit             *
+*                (-32767-32767), NULL to 0 or      *
+*                -32768, as isis2raw does          *
+*    -p rgg      bands 1,2,2 as RGB (HiRISE        *
+*                anaglyphs)                        *
+*    -tile n     JPEG2000 tile size (default 512)  *
+*    -threads n  code-blocks encoded at once       *
+*                (default all processors)          *
+*                                                  *
+*  The stretch percentages come from a histogram   *
+*  of each band made in a first read of the cube   *
+*  (exact for 8 and 16 bit cubes, 2^20 bins for    *
+*  Real cubes); the second read stretches the      *
+*  lines as they go into the JPEG2000 tiles, which *
+*  are encoded one at a time by OpenJPEG (2.5 or   *
+*  later, for the multithreaded encoder), so no    *
+*  temporary copy of the cube is made.             *
+*                                                  *
+*  The codestream is written in a JP2 file with a  *
+*  GeoJP2 box (a 1x1 GeoTIFF holding the           *
+*  georeferencing of the Mapping group, as in      *
+*  isis2geotiff).  The NULL value of each band is  *
+*  written to <out>.aux.xml, as gdal_translate     *
+*  -a_nodata did.                                  *
+*                                                  *
+*  Exits 2 if the input is not an ISIS3 cube, its  *
+*  projection is not supported (Equirectangular,   *
+*  SimpleCylindrical, Sinusoidal and               *
+*  PolarStereographic are) or the output would be  *
+*  32 bit (so the caller can use gdal_translate    *
+*  instead), 1 on any other error.                 *
+*                                                  *
+*  Build: cc -O2 isis2jp2.c isiscube.c -lopenjp2  *
+*            -lm                                   *
+*                                                  *
+* Oct 2026, original version                       *
+* Oct 2026, the cube reader and GeoKeys are        *
+*   isiscube.c                                     *
+****************************************************/
+
+#define LINELENGTH 1024
+#define DEFAULT_TILE 512
+#define MAX_BANDS 16
+#define MAX_TAGS 32
+#define MAX_RESOLUTIONS 6
+#define HIST_BINS (1 << 20)
+
+typedef struct {
+   int ncomps;
+   int band[MAX_BANDS];      /* cube band of each component */
+   int stretch;              /* 0, 8 or 16 */
+   int truncate;             /* Real to 16 bit */
+   int osize, sgnd;          /* bytes per output sample, signed */
+   int nodata;
+   double dmin[MAX_BANDS], dmax[MAX_BANDS];   /* stretch range */
+} jp2_output;
+
+typedef struct {
+   FILE *fp;
+   long long base;           /* file offset of the codestream */
+} jp2_stream;
+
+/* routines */
+int band_stretch(isis_cube *c, jp2_output *o, unsigned char *line);
+void output_line(isis_cube *c, jp2_output *o, int comp, unsigned char *in,
+                 unsigned char *out);
+int encode_jp2(isis_cube *c, jp2_output *o, char *file, int quality, int tile,
+               int threads, long long base);
+int write_jp2_header(isis_cube *c, jp2_output *o, FILE *fp);
+int write_aux(char *jp2, jp2_output *o);
+
+int host_lsb;
+
+main(int argc,char *argv[])
+{
+
+ isis_cube cube;
+ jp2_output o;
+ int i, l, ret, quality, tile, threads, rgg;
+ long long base;
+ unsigned char *row;
+ FILE *fp;
+
+ memset(&o,0,sizeof(jp2_output));
+ quality = 100;
+ tile = DEFAULT_TILE;
+ threads = 0;
+ rgg = 0;
+
+ for (i = 1; i < argc-2; i++)
+    {
+    if (strcmp(argv[i],"-q") == 0 && i+1 < argc-2)
+       quality = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-f") == 0)
+       o.truncate = 1;
+    else if (strcmp(argv[i],"-s") == 0 && i+1 < argc-2)
+       o.stretch = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-p") == 0 && i+1 < argc-2)
+       {
+       if (strcmp(argv[++i],"rgg") != 0)
+          break;
+       rgg = 1;
+       }
+    else if (strcmp(argv[i],"-tile") == 0 && i+1 < argc-2)
+       tile = atoi(argv[++i]);
+    else if (strcmp(argv[i],"-threads") == 0 && i+1 < argc-2)
+       threads = atoi(argv[++i]);
+    else
+       break;
+    }
+
+ if (argc < 3 || i != argc-2 || quality < 1 || quality > 100 || tile < 64 ||
+     (o.stretch != 0 && o.stretch != 8 && o.stretch != 16 && o.stretch != 32) ||
+     (o.stretch && o.truncate))
+    {
+    printf("\nUsage: isis2jp2 [-q 1-100] [-f | -s 8|16] [-p rgg] [-tile n] [-threads n]\n");
+    printf("                <input>.cub <output>.jp2\n");
+    printf("\n  converts a map projected ISIS3 cube to a GeoJPEG2000 file\n");
+    printf("  (tile size at least 64)\n\n");
+    exit(1);
+    }
+
+ if (o.stretch == 32)
+    {
+    printf("\n32 bit JPEG2000 output is not supported\n");
+    exit(2);
+    }
+
+ l = 1;
+ host_lsb = (*(unsigned char *) &l == 1);
+
+ if (threads <= 0)
+    threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+ /*****************************************************
+ * Open the cube and set up the output components
+ *****************************************************/
+
+ ret = open_map_cube(&cube, argv[argc-2], MAX_BANDS);
+ if (ret != 0)
+    exit(ret);
+
+ if (rgg)
+    {
+    if (cube.bands < 2)
+       {
+       printf("\n%s: -p rgg needs a cube of 2 bands\n",cube.file);
+       exit(1);
+       }
+    o.ncomps = 3;
+    o.band[0] = 0;
+    o.band[1] = o.band[2] = 1;
+    }
+ else
+    {
+    o.ncomps = cube.bands;
+    for (i = 0; i < o.ncomps; i++)
+       o.band[i] = i;
+    }
+
+ if (o.stretch == 8)
+    {
+    o.osize = 1;
+    o.nodata = 0;
+    }
+ else if (o.stretch == 16 || cube.psize == 2 || o.truncate)
+    {
+    o.osize = 2;
+    o.sgnd = 1;
+    o.nodata = NULL2;
+    }
+ else if (cube.psize == 1)
+    {
+    o.osize = 1;
+    o.nodata = 0;
+    }
+ else
+    {
+    printf("\n%s: Real cubes need -f or -s 8|16\n",cube.file);
+    exit(1);
+    }
+
+ row = (unsigned char *) malloc((long long) cube.samples * 4);
+ if (row == NULL)
+    {
+    printf("\nunable to allocate a line of %s\n",cube.file);
+    exit(1);
+    }
+
+ /*****************************************************
+ * First read: the stretch range of each band
+ *****************************************************/
+
+ if (o.stretch && band_stretch(&cube, &o, row) != 0)
+    exit(1);
+
+ /*****************************************************
+ * JP2 boxes up to the codestream, then the codestream
+ * tile by tile
+ *****************************************************/
+
+ fp = fopen(argv[argc-1],"wb");
+ if (fp == NULL)
+    {
+    printf("\ncan't open the output file %s!\n",argv[argc-1]);
+    exit(1);
+    }
+ if (write_jp2_header(&cube, &o, fp) != 0)
+    {
+    fclose(fp);
+    unlink(argv[argc-1]);
+    exit(1);
+    }
+ base = ftello(fp);
+ fclose(fp);
+
+ if (encode_jp2(&cube, &o, argv[argc-1], quality, tile, threads, base) != 0)
+    {
+    unlink(argv[argc-1]);
+    exit(1);
+    }
+ fclose(cube.fp);
+
+ if (write_aux(argv[argc-1], &o) != 0)
+    exit(1);
+
+ printf("\n%s: %d x %d, %d component(s) of %d bit%s\n",argv[argc-1],
+        cube.samples,cube.lines,o.ncomps,8*o.osize,
+        quality == 100 ? ", lossless" : "");
+
+ return(0);
+
+}
+
+/**************  band_stretch  *********************
+*                                                  *
+*  Histograms the valid pixels of each band and    *
+*  sets the stretch range to its 0.5% and 99.5%    *
+*  values.  A Real pixel goes in the bin of the    *
+*  top 20 bits of its (order preserving) float     *
+*  bits, and the percentages are interpolated      *
+*  within the bin.                                 *
+*                                                  *
+****************************************************/
+static unsigned int float_key(unsigned int bits)
+{
+ return((bits & 0x80000000) ? ~bits : bits | 0x80000000);
+}
+
+static double key_value(unsigned int key)
+{
+ unsigned int bits;
+ float f;
+
+ bits = (key & 0x80000000) ? key & 0x7FFFFFFF : ~key;
+ memcpy(&f,&bits,4);
+ return((double) f);
+}
+
+static double percent(isis_cube *c, long long *hist, long long n, double pct)
+{
+ long long target, cum;
+ int k;
+
+ target = (long long) ceil(n * pct / 100.0);
+ if (target < 1) target = 1;
+ cum = 0;
+ for (k = 0; k < HIST_BINS; k++)
+    {
+    if (hist[k] == 0 || cum + hist[k] < target)
+       {
+       cum += hist[k];
+       continue;
+       }
+    if (c->psize == 1)
+       return((double) k);
+    if (c->psize == 2)
+       return((double) (k - 32768));
+    return(key_value((unsigned int) k << 12) +
+           (key_value(((unsigned int) (k+1) << 12) - 1) -
+            key_value((unsigned int) k << 12)) * (target - cum) / hist[k]);
+    }
+ return(0.0);
+}
+
+int band_stretch(isis_cube *c, jp2_output *o, unsigned char *line)
+{
+ long long *hist, n;
+ unsigned int bits;
+ short word;
+ int b, l, s, k;
+
+ hist = (long long *) malloc(HIST_BINS * sizeof(long long));
+ if (hist == NULL)
+    {
+    printf("\nunable to allocate the histogram\n");
+    return(-1);
+    }
+
+ for (b = 0; b < c->bands; b++)
+    {
+    memset(hist,0,HIST_BINS * sizeof(long long));
+    n = 0;
+    for (l = 0; l < c->lines; l++)
+       {
+       convert_line(c, cube_line(c, b, l), line);
+       for (s = 0; s < c->samples; s++)
+          {
+          if (c->psize == 1)
+             {
+             if ((k = line[s]) == 0)
+                continue;
+             }
+          else if (c->psize == 2)
+             {
+             memcpy(&word,line + 2*s,2);
+             if (word == NULL2)
+                continue;
+             k = word + 32768;
+             }
+          else
+             {
+             memcpy(&bits,line + 4*s,4);
+             if (bits == NULL4_BITS)
+                continue;
+             k = float_key(bits) >> 12;
+             }
+          hist[k]++;
+          n++;
+          }
+       }
+
+    o->dmin[b] = o->dmax[b] = 0.0;
+    if (n > 0)
+       {
+       o->dmin[b] = percent(c, hist, n, 0.5);
+       o->dmax[b] = percent(c, hist, n, 99.5);
+       }
+    if (o->dmax[b] <= o->dmin[b])
+       o->dmax[b] = o->dmin[b] + 1.0;
+    printf("band %d: %lld valid pixels, stretch %g to %g\n",b+1,n,o->dmin[b],o->dmax[b]);
+    }
+
+ free(hist);
+ return(0);
+}
+
+/**************  output_line  **********************
+*                                                  *
+*  Converts a line of the cube (from convert_line) *
+*  to the output samples of a component:           *
+*  stretched, truncated to 16 bit or as is         *
+*                                                  *
+****************************************************/
+void output_line(isis_cube *c, jp2_output *o, int comp, unsigned char *in,
+                 unsigned char *out)
+{
+ double v, dmin, scale, omin, omax;
+ unsigned int bits;
+ float f;
+ short word;
+ int s, valid;
+
+ if (!o->stretch && !o->truncate)
+    {
+    memcpy(out,in,(long long) c->samples * c->psize);
+    return;
+    }
+
+ omin = (o->osize == 1) ? 1.0 : -32767.0;
+ omax = (o->osize == 1) ? 255.0 : 32767.0;
+ dmin = o->dmin[o->band[comp]];
+ scale = (omax - omin) / (o->dmax[o->band[comp]] - dmin);
+
+ for (s = 0; s < c->samples; s++)
+    {
+    if (c->psize == 1)
+       {
+       v = in[s];
+       valid = (in[s] != 0);
+       }
+    else if (c->psize == 2)
+       {
+       memcpy(&word,in + 2*s,2);
+       v = word;
+       valid = (word != NULL2);
+       }
+    else
+       {
+       memcpy(&bits,in + 4*s,4);
+       memcpy(&f,&bits,4);
+       v = f;
+       valid = (bits != NULL4_BITS);
+       }
+
+    if (!valid)
+       v = o->nodata;
+    else
+       {
+       if (o->stretch)
+          v = omin + (v - dmin) * scale;
+       v = floor(v + 0.5);
+       if (v < omin) v = omin;
+       if (v > omax) v = omax;
+       }
+
+    if (o->osize == 1)
+       out[s] = (unsigned char) v;
+    else
+       {
+       word = (short) v;
+       memcpy(out + 2*s,&word,2);
+       }
+    }
+}
+
+/**************  codestream output  ****************
+*                                                  *
+*  OpenJPEG writes the codestream through these,   *
+*  after the JP2 boxes already in the file         *
+*                                                  *
+****************************************************/
+static OPJ_SIZE_T stream_write(void *buf, OPJ_SIZE_T n, void *user)
+{
+ jp2_stream *js = (jp2_stream *) user;
+
+ if (fwrite(buf,1,n,js->fp) != n)
+    return((OPJ_SIZE_T) -1);
+ return(n);
+}
+
+static OPJ_OFF_T stream_skip(OPJ_OFF_T n, void *user)
+{
+ jp2_stream *js = (jp2_stream *) user;
+
+ if (fseeko(js->fp,n,SEEK_CUR) != 0)
+    return(-1);
+ return(n);
+}
+
+static OPJ_BOOL stream_seek(OPJ_OFF_T n, void *user)
+{
+ jp2_stream *js = (jp2_stream *) user;
+
+ return(fseeko(js->fp,js->base + n,SEEK_SET) == 0);
+}
+
+static void opj_message(const char *msg, void *user)
+{
+ printf("%s: %s",(char *) user,msg);
+}
+
+static void put_be(unsigned char *p, unsigned long long v, int n)
+{
+ int i;
+
+ for (i = 0; i < n; i++)
+    p[i] = (unsigned char) (v >> (8*(n-1-i)));
+}
+
+/**************  encode_jp2  ***********************
+*                                                  *
+*  Reads the cube a tile row at a time and hands   *
+*  each JPEG2000 tile to OpenJPEG, which encodes   *
+*  its code-blocks on threads, then sets the       *
+*  length of the jp2c box                          *
+*                                                  *
+****************************************************/
+int encode_jp2(isis_cube *c, jp2_output *o, char *file, int quality, int tile,
+               int threads, long long base)
+{
+ opj_cparameters_t param;
+ opj_image_cmptparm_t cparm[MAX_BANDS];
+ opj_image_t *image;
+ opj_codec_t *codec;
+ opj_stream_t *stream;
+ jp2_stream js;
+ unsigned char *rows[MAX_BANDS], *tbuf, *in, *line, *p, box[8];
+ long long rowbytes, end;
+ int ntx, nty, tx, ty, k, l, l0, nl, x0, nx, ok;
+
+ /*****************************************************
+ * Coding parameters: one quality layer, lossless
+ * (5/3 wavelet) at 100%, otherwise the 9/7 wavelet at
+ * a compression ratio of 100/quality
+ *****************************************************/
+
+ opj_set_default_encoder_parameters(&param);
+ param.tcp_numlayers = 1;
+ param.cp_disto_alloc = 1;
+ if (quality < 100)
+    {
+    param.irreversible = 1;
+    param.tcp_rates[0] = 100.0f / quality;
+    }
+ else
+    param.tcp_rates[0] = 0;
+ param.tile_size_on = OPJ_TRUE;
+ param.cp_tx0 = param.cp_ty0 = 0;
+ param.cp_tdx = param.cp_tdy = tile;
+ param.tcp_mct = (o->ncomps == 3) ? 1 : 0;
+ param.numresolution = MAX_RESOLUTIONS;
+ while (param.numresolution > 1 &&
+        (1 << (param.numresolution-1)) > (c->samples < c->lines ? c->samples : c->lines))
+    param.numresolution--;
+
+ memset(cparm,0,sizeof(cparm));
+ for (k = 0; k < o->ncomps; k++)
+    {
+    cparm[k].dx = cparm[k].dy = 1;
+    cparm[k].w = c->samples;
+    cparm[k].h = c->lines;
+    cparm[k].prec = 8 * o->osize;
+    cparm[k].sgnd = o->sgnd;
+    }
+ image = opj_image_tile_create(o->ncomps, cparm,
+                               o->ncomps == 3 ? OPJ_CLRSPC_SRGB : OPJ_CLRSPC_GRAY);
+ if (image == NULL)
+    {
+    printf("\nunable to create the JPEG2000 image\n");
+    return(-1);
+    }
+ image->x0 = image->y0 = 0;
+ image->x1 = c->samples;
+ image->y1 = c->lines;
+
+ codec = opj_create_compress(OPJ_CODEC_J2K);
+ opj_set_error_handler(codec, opj_message, (void *) "OpenJPEG error");
+ opj_set_warning_handler(codec, opj_message, (void *) "OpenJPEG warning");
+ if (!opj_setup_encoder(codec, &param, image))
+    {
+    printf("\nunable to set up the JPEG2000 encoder\n");
+    return(-1);
+    }
+ if (threads > 1 && !opj_codec_set_threads(codec, threads))
+    printf("\nOpenJPEG can't encode on %d threads, using one\n",threads);
+
+ js.fp = fopen(file,"r+b");
+ js.base = base;
+ if (js.fp == NULL || fseeko(js.fp,base,SEEK_SET) != 0)
+    {
+    printf("\ncan't reopen the output file %s!\n",file);
+    return(-1);
+    }
+ stream = opj_stream_create(OPJ_J2K_STREAM_CHUNK_SIZE, OPJ_FALSE);
+ opj_stream_set_user_data(stream, &js, NULL);
+ opj_stream_set_write_function(stream, stream_write);
+ opj_stream_set_skip_function(stream, stream_skip);
+ opj_stream_set_seek_function(stream, stream_seek);
+
+ /*****************************************************
+ * The tiles of each tile row, the components of a tile
+ * one after the other
+ *****************************************************/
+
+ ntx = (c->samples + tile - 1) / tile;
+ nty = (c->lines + tile - 1) / tile;
+ rowbytes = (long long) c->samples * o->osize;
+ line = (unsigned char *) malloc((long long) c->samples * 4);
+ tbuf = (unsigned char *) malloc((long long) o->ncomps * tile * tile * o->osize);
+ ok = (line != NULL && tbuf != NULL);
+ for (k = 0; k < o->ncomps; k++)
+    ok = ok && (rows[k] = (unsigned char *) malloc(rowbytes * tile)) != NULL;
+ if (!ok)
+    {
+    printf("\nunable to allocate a tile row of %d lines\n",tile);
+    return(-1);
+    }
+
+ ok = opj_start_compress(codec, image, stream);
+ for (ty = 0; ok && ty < nty; ty++)
+    {
+    l0 = ty * tile;
+    nl = (l0 + tile <= c->lines) ? tile : c->lines - l0;
+    for (k = 0; k < o->ncomps; k++)
+       {
+       if (k > 0 && o->band[k] == o->band[k-1])
+          {
+          memcpy(rows[k], rows[k-1], rowbytes * nl);
+          continue;
+          }
+       for (l = 0; l < nl; l++)
+          {
+          in = cube_line(c, o->band[k], l0 + l);
+          convert_line(c, in, line);
+          output_line(c, o, k, line, rows[k] + l*rowbytes);
+          }
+       }
+
+    for (tx = 0; ok && tx < ntx; tx++)
+       {
+       x0 = tx * tile;
+       nx = (x0 + tile <= c->samples) ? tile : c->samples - x0;
+       p = tbuf;
+       for (k = 0; k < o->ncomps; k++)
+          for (l = 0; l < nl; l++, p += (long long) nx * o->osize)
+             memcpy(p, rows[k] + l*rowbytes + (long long) x0 * o->osize,
+                    (long long) nx * o->osize);
+       ok = opj_write_tile(codec, ty*ntx + tx, tbuf, (OPJ_UINT32) (p - tbuf), stream);
+       }
+    }
+ ok = ok && opj_end_compress(codec, stream);
+
+ opj_stream_destroy(stream);
+ opj_destroy_codec(codec);
+ opj_image_destroy(image);
+ for (k = 0; k < o->ncomps; k++)
+    free(rows[k]);
+ free(tbuf);
+ free(line);
+
+ if (!ok)
+    {
+    fclose(js.fp);
+    printf("\nerror encoding %s\n",file);
+    return(-1);
+    }
+
+ /* the jp2c box header ends at base, its XLBox length is the last 8
+    bytes */
+ fseeko(js.fp,0,SEEK_END);
+ end = ftello(js.fp);
+ put_be(box, end - (base - 16), 8);
+ if (fseeko(js.fp,base - 8,SEEK_SET) != 0 || fwrite(box,1,8,js.fp) != 8 ||
+     fclose(js.fp) != 0)
+    {
+    printf("\nerror writing %s\n",file);
+    return(-1);
+    }
+
+ return(0);
+}
+
+/**************  GeoJP2 box  ***********************
+*                                                  *
+*  A GeoJP2 box is a uuid box holding a 1x1 pixel  *
+*  GeoTIFF with the georeferencing tags            *
+*                                                  *
+****************************************************/
+static int type_size(int type)
+{
+ if (type == T_ASCII) return(1);
+ if (type == T_SHORT) return(2);
+ if (type == T_LONG) return(4);
+ return(8);
+}
+
+static void put_le(unsigned char *p, unsigned long long v, int n)
+{
+ int i;
+
+ for (i = 0; i < n; i++)
+    p[i] = (unsigned char) (v >> (8*i));
+}
+
+static void put_value(unsigned char *p, tiff_tag *t, long long i)
+{
+ unsigned long long bits;
+
+ if (t->type == T_ASCII)
+    p[0] = ((char *) t->data)[i];
+ else if (t->type == T_SHORT)
+    put_le(p, ((unsigned short *) t->data)[i], 2);
+ else if (t->type == T_DOUBLE)
+    {
+    memcpy(&bits, &((double *) t->data)[i], 8);
+    put_le(p, bits, 8);
+    }
+ else
+    put_le(p, ((unsigned long long *) t->data)[i], type_size(t->type));
+}
+
+static unsigned char *geotiff_1x1(isis_cube *c, long long *size)
+{
+ static unsigned short one_s[1] = {1}, bits_s[1] = {8}, none_s[1] = {1},
+                       black_s[1] = {1};
+ static unsigned long long offset_l[1], one_l[1] = {1};
+ tiff_tag tags[MAX_TAGS];
+ unsigned short keys[4*MAX_GEOKEYS+4];
+ double dbl[MAX_GEOKEYS];
+ char ascii[LINELENGTH];
+ unsigned char *buf, *e;
+ long long ext, n, j;
+ int i, ntags;
+
+#define TAG(t,ty,n,d) { tags[ntags].tag = t; tags[ntags].type = ty; \
+                        tags[ntags].count = n; tags[ntags++].data = d; }
+ ntags = 0;
+ TAG(256, T_SHORT, 1, one_s);              /* ImageWidth */
+ TAG(257, T_SHORT, 1, one_s);              /* ImageLength */
+ TAG(258, T_SHORT, 1, bits_s);             /* BitsPerSample */
+ TAG(259, T_SHORT, 1, none_s);             /* Compression */
+ TAG(262, T_SHORT, 1, black_s);            /* PhotometricInterpretation */
+ TAG(273, T_LONG, 1, offset_l);            /* StripOffsets */
+ TAG(277, T_SHORT, 1, one_s);              /* SamplesPerPixel */
+ TAG(278, T_SHORT, 1, one_s);              /* RowsPerStrip */
+ TAG(279, T_LONG, 1, one_l);               /* StripByteCounts */
+#undef TAG
+ ntags = geo_tags(c, tags, ntags, keys, dbl, ascii);
+
+ /* header, IFD, the values that don't fit in an entry, the pixel */
+ *size = 8 + 2 + 12*ntags + 4;
+ for (i = 0; i < ntags; i++)
+    {
+    n = tags[i].count * type_size(tags[i].type);
+    if (n > 4)
+       *size += n + (n & 1);
+    }
+ offset_l[0] = *size;
+ *size += 2;
+
+ buf = (unsigned char *) calloc(*size, 1);
+ if (buf == NULL)
+    return(NULL);
+ buf[0] = buf[1] = 'I';
+ put_le(buf+2, 42, 2);
+ put_le(buf+4, 8, 4);
+ put_le(buf+8, ntags, 2);
+ ext = 8 + 2 + 12*ntags + 4;
+ for (i = 0, e = buf + 10; i < ntags; i++, e += 12)
+    {
+    put_le(e, tags[i].tag, 2);
+    put_le(e+2, tags[i].type, 2);
+    put_le(e+4, tags[i].count, 4);
+    n = tags[i].count * type_size(tags[i].type);
+    if (n <= 4)
+       {
+       for (j = 0; j < tags[i].count; j++)
+          put_value(e + 8 + j*type_size(tags[i].type), &tags[i], j);
+       continue;
+       }
+    put_le(e+8, ext, 4);
+    for (j = 0; j < tags[i].count; j++)
+       put_value(buf + ext + j*type_size(tags[i].type), &tags[i], j);
+    ext += n + (n & 1);
+    }
+
+ return(buf);
+}
+
+/**************  write_jp2_header  *****************
+*                                                  *
+*  Writes the signature, ftyp, jp2h (ihdr, colr)   *
+*  and GeoJP2 boxes and the header of the jp2c     *
+*  box, with an XLBox length set at the end        *
+*                                                  *
+****************************************************/
+int write_jp2_header(isis_cube *c, jp2_output *o, FILE *fp)
+{
+ static unsigned char geojp2_uuid[16] =
+    {0xb1, 0x4b, 0xf8, 0xbd, 0x08, 0x3d, 0x4b, 0x43,
+     0xa5, 0xae, 0x8c, 0xd7, 0xd5, 0xa6, 0xce, 0x03};
+ unsigned char box[64], *tif;
+ long long tifsize;
+ int ok;
+
+ /* signature and file type */
+ put_be(box, 12, 4);
+ memcpy(box+4, "jP  \r\n\x87\n", 8);
+ put_be(box+12, 20, 4);
+ memcpy(box+16, "ftypjp2 ", 8);
+ put_be(box+24, 0, 4);
+ memcpy(box+28, "jp2 ", 4);
+
+ /* header: image size and colour space */
+ put_be(box+32, 8 + 22 + 15, 4);
+ memcpy(box+36, "jp2h", 4);
+ ok = (fwrite(box,1,40,fp) == 40);
+
+ put_be(box, 22, 4);
+ memcpy(box+4, "ihdr", 4);
+ put_be(box+8, c->lines, 4);
+ put_be(box+12, c->samples, 4);
+ put_be(box+16, o->ncomps, 2);
+ box[18] = (unsigned char) ((8*o->osize - 1) | (o->sgnd ? 0x80 : 0));
+ box[19] = 7;                              /* wavelet compression */
+ box[20] = 0;
+ box[21] = 0;
+ put_be(box+22, 15, 4);
+ memcpy(box+26, "colr", 4);
+ box[30] = 1;                              /* enumerated colour space */
+ box[31] = box[32] = 0;
+ put_be(box+33, o->ncomps == 3 ? 16 : 17, 4);  /* sRGB or greyscale */
+ ok = ok && (fwrite(box,1,37,fp) == 37);
+
+ /* georeferencing */
+ tif = geotiff_1x1(c, &tifsize);
+ if (tif == NULL)
+    {
+    printf("\nunable to allocate the GeoJP2 box\n");
+    return(-1);
+    }
+ put_be(box, 8 + 16 + tifsize, 4);
+ memcpy(box+4, "uuid", 4);
+ memcpy(box+8, geojp2_uuid, 16);
+ ok = ok && (fwrite(box,1,24,fp) == 24) && (fwrite(tif,1,tifsize,fp) == tifsize);
+ free(tif);
+
+ /* codestream box, length to come */
+ put_be(box, 1, 4);
+ memcpy(box+4, "jp2c", 4);
+ put_be(box+8, 0, 8);
+ ok = ok && (fwrite(box,1,16,fp) == 16);
+
+ if (!ok)
+    {
+    printf("\nerror writing the JP2 header\n");
+    return(-1);
+    }
+ return(0);
+}
+
+/**************  write_aux  ************************
+*                                                  *
+*  GDAL auxiliary file with the NULL value of      *
+*  each band                                       *
+*                                                  *
+****************************************************/
+int write_aux(char *jp2, jp2_output *o)
+{
+ char aux[LINELENGTH];
+ FILE *fp;
+ int k;
+
+ sprintf(aux,"%s.aux.xml",jp2);
+ fp = fopen(aux,"w");
+ if (fp == NULL)
+    {
+    printf("\ncan't open the auxiliary file %s!\n",aux);
+    return(-1);
+    }
+ fprintf(fp,"<PAMDataset>\n");
+ for (k = 0; k < o->ncomps; k++)
+    fprintf(fp,"  <PAMRasterBand band=\"%d\">\n    <NoDataValue>%d</NoDataValue>\n  </PAMRasterBand>\n",
+            k+1,o->nodata);
+ fprintf(fp,"</PAMDataset>\n");
+ fclose(fp);
+
+ return(0);
+}
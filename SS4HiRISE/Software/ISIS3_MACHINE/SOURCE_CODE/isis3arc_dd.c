@@ -13,6 +13,12 @@
 *  by Trent Hare       for USGS, flagstaff         *
 *                                                  *
 * Nov 2008, rewrite from isis2arc_dd.c             *
+* Oct 2026, 32-bit cubes with a <cube>.spans NULL- *
+*   span index (written by dem2isis3) have their   *
+*   NULL runs written without reading them         *
+* Oct 2026, the index is used only if its check of *
+*   the posts at the ends of each run and gap      *
+*   matches the cube                               *
 ****************************************************/
 
 // Set up ISIS NULL values
@@ -20,11 +26,24 @@
 #define NULL2 -32768
 #define NULL3 -0.3402822655089E+39 /*0xFF7FFFFB*/
 
+/* NULL-span index (see open_span_index in dem2isis3's export_subroutines):
+   a 40 byte header ("NULLSPAN", version, lines, samples, runs, valid
+   posts, check), then for each line a run count and (first sample,
+   length) pairs of the non-NULL runs, all little-endian.  The check is
+   the FNV-1a hash of the first and last post of each run and gap. */
+#define SPAN_HEADER_BYTES 40
+#define SPAN_VERSION 2
+#define SPAN_CHECK_BASIS 0xcbf29ce484222325ULL
+#define SPAN_CHECK_PRIME 0x100000001b3ULL
+
 
 /* routines */
 int parse_label(char *file, char *keyword, char *value);
 int strstrip(char instr[], char outstr[], int position);
 int stripp(char instr[], char outstr[], int position);
+FILE *open_span_index(char *cub, int skipbytes, int nlines, int nsamples,
+                      unsigned int **runs);
+int read_span_line(FILE *fp, unsigned int *runs, int nsamples);
 void swap_float_4(float *tnf4)              /* 4 byte floating point numbers */
 {
  int *tni4=(int *)tnf4;
@@ -55,6 +74,12 @@ main(int argc,char *argv[])
  short int z16[1];
  float z32[1];
  FILE *ifp,*outfp,*VRTfp;
+ FILE *spanfp = NULL;
+ unsigned int *runs = NULL;
+ int nruns, run, s0, s1;
+ float *span_buf = NULL;
+ char *null_buf = NULL;
+ int null_len;
 
  if ((argc<3) || (argc>4))
     {
@@ -220,6 +245,10 @@ else
   for (i=1;i<=skipbytes;i++)
 	fread(z8,sizeof(char),1,ifp);
 
+  /** NULL-span index of a single band 32-bit cube, if there is one **/
+  if (itype == 32 && nbands == 1)
+    spanfp = open_span_index(argv[1], skipbytes, nlines, nsamples, &runs);
+
   printf("\nLines %d /Samples %d /Bands %d /Type %d\n",nlines,nsamples,nbands,itype);
   if (nbands > 1) {
     printf("Multiple Bands. Program will add _b# for each band...\n");
@@ -336,6 +365,62 @@ else
 		  fprintf(outfp,"\n");
 		  y = y - cellsize;
 		}
+	  } else if (spanfp != NULL) {
+		/**** Loop through 32 bit binary Image, by the span index ******/
+		/* a NULL post is written as the loop below writes it, so a
+		   line of them is made once and NULL runs are copied from it */
+		z32[0] = NULL3;
+		if (argc > 3)
+		  sprintf(str,"%.f ", usernodata);
+		else
+		  sprintf(str,"%E ", z32[0]);
+		null_len = strlen(str);
+		null_buf = (char *) malloc((size_t) nsamples * null_len);
+		span_buf = (float *) malloc((size_t) nsamples * sizeof(float));
+		if (null_buf == NULL || span_buf == NULL) {
+		  printf("Out of memory for %d samples.\n", nsamples);
+		  exit(1);
+		}
+		for (i = 0; i < nsamples; i++)
+		  memcpy(null_buf + (size_t) i * null_len, str, null_len);
+
+		for (xi=1; xi <= nlines; xi++) {
+		  nruns = read_span_line(spanfp, runs, nsamples);
+		  if (nruns < 0) {
+			printf("NULL-span index of '%s' is not valid at line %.0f.\n", argv[1], xi);
+			exit(1);
+		  }
+		  s0 = 0;
+		  for (run = 0; run <= nruns; run++) {
+			/* NULL gap up to the run (or the end of the line) */
+			s1 = (run < nruns) ? (int) runs[2*run] : nsamples;
+			if (s1 > s0) {
+			  fwrite(null_buf, null_len, s1 - s0, outfp);
+			  fseek(ifp, (long) (s1 - s0) * sizeof(float), SEEK_CUR);
+			  j += s1 - s0;
+			}
+			if (run == nruns)
+			  break;
+			s0 = s1 + runs[2*run+1];
+			fread(span_buf, sizeof(float), s0 - s1, ifp);
+			for (i = 0; i < s0 - s1; i++) {
+			  sprintf(str,"%.8f",span_buf[i]);
+			  z = (float) atof(str) + 10;
+			  if (z > nodata)
+			    fprintf(outfp,"%.8f ", span_buf[i]);
+			  else {
+			    if (argc > 3)
+			      fprintf(outfp,"%.f ", usernodata);
+			    else
+			      fprintf(outfp,"%E ", span_buf[i]);
+			  }
+			  j++;
+			}
+		  }
+		  fprintf(outfp,"\n");
+		}
+		free(null_buf);
+		free(span_buf);
 	  } else { 
 		/**** Loop through 32 bit binary Image ******/
 		y = yllcenter;
@@ -367,6 +452,10 @@ else
 
   ending:
   fclose(ifp);
+  if (spanfp != NULL) {
+    fclose(spanfp);
+    free(runs);
+  }
   if (nbands > 1) {
     fprintf(VRTfp,"</VRTDataset>\n");
     fclose(VRTfp);
@@ -419,6 +508,163 @@ int parse_label(char *file, char *keyword, char *value)
 }
 
 
+/**************  span_check  ***********************
+*                                                  *
+*  Adds the bits of post s of line of the cube     *
+*  (pixels from skipbytes) to the check            *
+*                                                  *
+****************************************************/
+unsigned long long span_check(unsigned long long check, FILE *cfp,
+                              int skipbytes, int line, int nsamples, int s)
+{
+  unsigned char b[4];
+  unsigned int bits;
+  float v = 0;
+  int i;
+
+  fseek(cfp, skipbytes + ((long) line * nsamples + s) * (long) sizeof(float),
+        SEEK_SET);
+  if (fread(&v, sizeof(float), 1, cfp) != 1)
+    return(check + 1);
+  memcpy(&bits, &v, 4);
+  for (i = 0; i < 4; i++) {
+    check ^= (bits >> (8 * i)) & 0xFF;
+    check *= SPAN_CHECK_PRIME;
+  }
+  return(check);
+}
+
+/**************  open_span_index  ******************
+*                                                  *
+*  Opens <cube>.spans, the NULL-span index of the  *
+*  cube, positioned at its first line, and         *
+*  allocates runs[] for a line's runs.  Returns    *
+*  NULL if there is none, or it is not for a cube  *
+*  of nlines x nsamples, or its run and valid post *
+*  counts or its check of the posts at the ends of *
+*  each run and gap (read from the cube, pixels    *
+*  from skipbytes) do not match                    *
+*                                                  *
+****************************************************/
+FILE *open_span_index(char *cub, int skipbytes, int nlines, int nsamples,
+                      unsigned int **runs)
+{
+  char file[512];
+  unsigned char h[SPAN_HEADER_BYTES];
+  char *dot;
+  FILE *fp, *cfp;
+  unsigned int nspans, total = 0;
+  unsigned long long valid, check, sum, count = 0;
+  int line, n, k, s0, s1, ok;
+
+  strcpy(file, cub);
+  dot = strrchr(file, '.');
+  if (dot != NULL && strchr(dot, '/') == NULL)
+    *dot = '\0';
+  strcat(file, ".spans");
+
+  fp = fopen(file, "rb");
+  if (fp == NULL)
+    return(NULL);
+  if (fread(h, 1, SPAN_HEADER_BYTES, fp) != SPAN_HEADER_BYTES ||
+      memcmp(h, "NULLSPAN", 8) != 0 ||
+      (h[8] | h[9] << 8 | h[10] << 16 | h[11] << 24) != SPAN_VERSION ||
+      (h[12] | h[13] << 8 | h[14] << 16 | h[15] << 24) != nlines ||
+      (h[16] | h[17] << 8 | h[18] << 16 | h[19] << 24) != nsamples) {
+    printf("Ignoring '%s': not a NULL-span index of this cube.\n", file);
+    fclose(fp);
+    return(NULL);
+  }
+  nspans = h[20] | h[21] << 8 | h[22] << 16 | (unsigned int) h[23] << 24;
+  valid = (h[24] | h[25] << 8 | h[26] << 16 | (unsigned long long) h[27] << 24) |
+          (unsigned long long) (h[28] | h[29] << 8 | h[30] << 16 |
+                                (unsigned int) h[31] << 24) << 32;
+  check = (h[32] | h[33] << 8 | h[34] << 16 | (unsigned long long) h[35] << 24) |
+          (unsigned long long) (h[36] | h[37] << 8 | h[38] << 16 |
+                                (unsigned int) h[39] << 24) << 32;
+  /* at most (nsamples+1)/2 runs in a line */
+  *runs = (unsigned int *) malloc(((size_t) nsamples + 1) * sizeof(unsigned int));
+  cfp = fopen(cub, "rb");
+  if (*runs == NULL || cfp == NULL) {
+    if (cfp != NULL)
+      fclose(cfp);
+    free(*runs);
+    fclose(fp);
+    return(NULL);
+  }
+
+  /* check the index against the cube, a few posts a line (unbuffered,
+     as the reads are scattered) */
+  setvbuf(cfp, NULL, _IONBF, 0);
+  ok = 1;
+  sum = SPAN_CHECK_BASIS;
+  for (line = 0; line < nlines; line++) {
+    n = read_span_line(fp, *runs, nsamples);
+    if (n < 0) {
+      ok = 0;
+      break;
+    }
+    total += n;
+    s0 = 0;
+    for (k = 0; k <= n; k++) {
+      /* NULL gap up to the run (or the end of the line), then the run */
+      s1 = (k < n) ? (int) (*runs)[2*k] : nsamples;
+      if (s1 > s0) {
+        sum = span_check(sum, cfp, skipbytes, line, nsamples, s0);
+        sum = span_check(sum, cfp, skipbytes, line, nsamples, s1 - 1);
+      }
+      if (k == n)
+        break;
+      s0 = s1 + (*runs)[2*k+1];
+      sum = span_check(sum, cfp, skipbytes, line, nsamples, s1);
+      sum = span_check(sum, cfp, skipbytes, line, nsamples, s0 - 1);
+      count += (*runs)[2*k+1];
+    }
+  }
+  fclose(cfp);
+  if (!ok || total != nspans || count != valid || sum != check) {
+    printf("Ignoring '%s': it does not match the cube.\n", file);
+    free(*runs);
+    fclose(fp);
+    return(NULL);
+  }
+  fseek(fp, SPAN_HEADER_BYTES, SEEK_SET);
+  printf("Skipping NULL runs by the index '%s'\n", file);
+  return(fp);
+}
+
+/**************  read_span_line  *******************
+*                                                  *
+*  Reads the next line's runs into runs[] (first   *
+*  sample and length pairs).  Returns the number   *
+*  of runs, or -1 if the index is short or the     *
+*  runs are out of order or off the line           *
+*                                                  *
+****************************************************/
+int read_span_line(FILE *fp, unsigned int *runs, int nsamples)
+{
+  unsigned char b[8];
+  unsigned int n, k, end = 0;
+
+  if (fread(b, 1, 4, fp) != 4)
+    return(-1);
+  n = b[0] | b[1] << 8 | b[2] << 16 | (unsigned int) b[3] << 24;
+  if (n > (unsigned int) (nsamples + 1) / 2)
+    return(-1);
+  for (k = 0; k < n; k++) {
+    if (fread(b, 1, 8, fp) != 8)
+      return(-1);
+    runs[2*k] = b[0] | b[1] << 8 | b[2] << 16 | (unsigned int) b[3] << 24;
+    runs[2*k+1] = b[4] | b[5] << 8 | b[6] << 16 | (unsigned int) b[7] << 24;
+    if (runs[2*k] < end || runs[2*k+1] == 0 ||
+        runs[2*k+1] > (unsigned int) nsamples - runs[2*k])
+      return(-1);
+    end = runs[2*k] + runs[2*k+1];
+  }
+  return((int) n);
+}
+
+
 int strstrip(char instr[], char outstr[], int position)
 /*************************************************************************
 *_Title strstrip Trim leading and trailing blanks from string
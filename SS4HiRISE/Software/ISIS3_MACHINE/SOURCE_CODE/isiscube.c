@@ -0,0 +1,560 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "isiscube.h"
+
+/**************  isiscube.c ************************
+*                                                  *
+*  Reads ISIS3 cubes a tile row (or for            *
+*  BandSequential cubes, block of BSQ_BLOCK lines) *
+*  at a time, and builds the GeoTIFF tags and      *
+*  GeoKeys of a cube's Mapping group, for          *
+*  hinoprojmos, hi8bitraw, isis2geotiff and        *
+*  isis2jp2:                                       *
+*                                                  *
+*    read_cube_label   Core and Mapping keywords   *
+*    open_cube         checks the pixel type and   *
+*                      size and opens the pixels   *
+*    open_map_cube     both, for a projection      *
+*                      geo_tags supports           *
+*    cube_line         a line, reading its tile    *
+*                      row when needed             *
+*    host_line,        a line in host byte order,  *
+*    convert_line      with the special pixels     *
+*                      kept or set to NULL         *
+*    geo_tags          GeoTIFF georeferencing tags *
+*                                                  *
+*  Unsigned byte, signed word and real cubes are   *
+*  supported, Tile or BandSequential.              *
+*                                                  *
+* Oct 2026, original version (the cube reader of   *
+*   hinoprojmos, hi8bitraw, isis2geotiff and       *
+*   isis2jp2, and the GeoKeys of the last two)     *
+****************************************************/
+
+#if defined(_WIN32)
+#define FSEEK64 _fseeki64
+#else
+#define FSEEK64 fseeko
+#endif
+
+/**************  read_cube_label  ******************
+*                                                  *
+*  Reads the Core and Mapping group keywords of an *
+*  ISIS3 cube label.  Returns 1 if the file can't  *
+*  be read                                         *
+*                                                  *
+****************************************************/
+int read_cube_label(isis_cube *c, char *file)
+{
+ char id[CUBE_PATHLENGTH], token[CUBE_PATHLENGTH], value[CUBE_PATHLENGTH];
+ char *v;
+ FILE *fp;
+ int mapping, order_seen;
+
+ memset(c,0,sizeof(isis_cube));
+ strncpy(c->file,file,CUBE_PATHLENGTH-1);
+ c->mult = 1.0;
+ c->bands = 1;
+ strcpy(c->order,"Lsb");
+ strcpy(c->londir,"PositiveEast");
+ c->res = -1.0;
+
+ fp = fopen(file,"r");
+ if (fp == NULL)
+    {
+    printf("\ncan't open the input file %s!\n",file);
+    return(1);
+    }
+
+ /* Only the first of the Core keywords counts: Table and History objects
+    that follow have a StartByte, Type and ByteOrder of their own */
+ id[0] = '\0';
+ mapping = 0;
+ order_seen = 0;
+ while (fscanf(fp,"%s",token) == 1 && strcmp(token,"End") != 0)
+    {
+    if (strcmp(token,"End_Group") == 0)
+       mapping = 0;
+    if (strcmp(token,"=") != 0)
+       {
+       strcpy(id,token);
+       continue;
+       }
+    if (fscanf(fp,"%s",value) != 1)
+       break;
+    v = value;
+    if (*v == '"')
+       {
+       v++;
+       if (*v && v[strlen(v)-1] == '"') v[strlen(v)-1] = '\0';
+       }
+
+    if (strcmp(id,"Object") == 0 && strcmp(v,"IsisCube") == 0)
+       c->isis3 = 1;
+    else if (strcmp(id,"Group") == 0)
+       mapping = (strcmp(v,"Mapping") == 0);
+    else if (strcmp(id,"StartByte") == 0 && c->start == 0)
+       c->start = (long long) atof(v) - 1;
+    else if (strcmp(id,"Format") == 0 && c->tile_l == 0)
+       c->tiled = (strcmp(v,"Tile") == 0);
+    else if (strcmp(id,"TileSamples") == 0)
+       c->tile_s = atoi(v);
+    else if (strcmp(id,"TileLines") == 0)
+       c->tile_l = atoi(v);
+    else if (strcmp(id,"Samples") == 0 && c->samples == 0)
+       c->samples = atoi(v);
+    else if (strcmp(id,"Lines") == 0 && c->lines == 0)
+       c->lines = atoi(v);
+    else if (strcmp(id,"Bands") == 0)
+       c->bands = atoi(v);
+    else if (strcmp(id,"Type") == 0 && c->type[0] == '\0')
+       strncpy(c->type,v,31);
+    else if (strcmp(id,"ByteOrder") == 0 && !order_seen)
+       {
+       strncpy(c->order,v,7);
+       order_seen = 1;
+       }
+    else if (strcmp(id,"Base") == 0)
+       c->base = atof(v);
+    else if (strcmp(id,"Multiplier") == 0)
+       c->mult = atof(v);
+    else if (!mapping)
+       continue;
+    else if (strcmp(id,"ProjectionName") == 0)
+       strncpy(c->projection,v,63);
+    else if (strcmp(id,"TargetName") == 0)
+       strncpy(c->target,v,63);
+    else if (strcmp(id,"LongitudeDirection") == 0)
+       strncpy(c->londir,v,31);
+    else if (strcmp(id,"EquatorialRadius") == 0)
+       c->eqradius = atof(v);
+    else if (strcmp(id,"PolarRadius") == 0)
+       c->polradius = atof(v);
+    else if (strcmp(id,"CenterLatitude") == 0)
+       c->clat = atof(v);
+    else if (strcmp(id,"CenterLongitude") == 0)
+       c->clon = atof(v);
+    else if (strcmp(id,"PixelResolution") == 0)
+       c->res = atof(v);
+    else if (strcmp(id,"UpperLeftCornerX") == 0)
+       c->ulx = atof(v);
+    else if (strcmp(id,"UpperLeftCornerY") == 0)
+       c->uly = atof(v);
+    }
+ fclose(fp);
+
+ return(0);
+}
+
+/**************  open_cube  ************************
+*                                                  *
+*  Checks the pixel type and size of a cube whose  *
+*  label has been read (up to maxbands bands) and  *
+*  opens it in mode ("rb", or "r+b" to write tile  *
+*  rows back).  Returns 1 on any error             *
+*                                                  *
+****************************************************/
+int open_cube(isis_cube *c, char *mode, int maxbands)
+{
+ unsigned int one = 1;
+ long long nchunk;
+
+ if (strcmp(c->type,"Real") == 0)
+    c->psize = 4;
+ else if (strcmp(c->type,"SignedWord") == 0)
+    c->psize = 2;
+ else if (strcmp(c->type,"UnsignedByte") == 0)
+    c->psize = 1;
+ else
+    {
+    printf("\n%s: pixel type '%s' is not supported\n",c->file,c->type);
+    return(1);
+    }
+
+ if (c->samples <= 0 || c->lines <= 0 || c->bands <= 0 || c->bands > maxbands ||
+     (c->tiled && (c->tile_s <= 0 || c->tile_l <= 0)))
+    {
+    if (maxbands == 1)
+       printf("\n%s: only single band Tile or BandSequential cubes are supported\n",
+              c->file);
+    else
+       printf("\n%s: only Tile or BandSequential cubes of up to %d bands are supported\n",
+              c->file,maxbands);
+    return(1);
+    }
+
+ if (!c->tiled)
+    {
+    c->tile_s = c->samples;
+    c->tile_l = BSQ_BLOCK;
+    }
+ c->ntx = (c->samples + c->tile_s - 1) / c->tile_s;
+ nchunk = (long long) c->ntx * c->tile_s * c->tile_l * c->psize;
+ if (c->tiled)
+    c->bandbytes = nchunk * ((c->lines + c->tile_l - 1) / c->tile_l);
+ else
+    c->bandbytes = (long long) c->samples * c->lines * c->psize;
+ c->row = -1;
+
+ /* cube byte order against this machine's */
+ c->swap = ((*(unsigned char *) &one == 1) != (strcmp(c->order,"Lsb") == 0));
+
+ c->chunk = (unsigned char *) malloc(nchunk);
+ c->buf = c->tiled ? (unsigned char *) malloc(nchunk) : c->chunk;
+ c->fp = fopen(c->file,mode);
+ if (c->chunk == NULL || c->buf == NULL || c->fp == NULL)
+    {
+    printf("\nunable to open %s or allocate %lld bytes for it\n",c->file,nchunk);
+    return(1);
+    }
+
+ return(0);
+}
+
+/**************  open_map_cube  ********************
+*                                                  *
+*  Reads the label of a map projected cube and     *
+*  opens it for reading.  Returns 2 if the file is *
+*  not an ISIS3 cube or its projection is not one  *
+*  geo_tags supports (Equirectangular,             *
+*  SimpleCylindrical, Sinusoidal and               *
+*  PolarStereographic), 1 on any other error       *
+*                                                  *
+****************************************************/
+int open_map_cube(isis_cube *c, char *file, int maxbands)
+{
+ if (read_cube_label(c, file) != 0)
+    return(1);
+
+ if (!c->isis3)
+    {
+    printf("\n%s is not an ISIS3 cube\n",file);
+    return(2);
+    }
+ if (strcmp(c->projection,"Equirectangular") != 0 &&
+     strcmp(c->projection,"SimpleCylindrical") != 0 &&
+     strcmp(c->projection,"PolarStereographic") != 0 &&
+     strcmp(c->projection,"Sinusoidal") != 0)
+    {
+    printf("\n%s: projection '%s' is not supported\n",file,c->projection);
+    return(2);
+    }
+ if (c->res <= 0.0 || c->eqradius <= 0.0)
+    {
+    printf("\n%s: Mapping group has no PixelResolution/EquatorialRadius\n",file);
+    return(1);
+    }
+ if (c->polradius <= 0.0)
+    c->polradius = c->eqradius;
+
+ return(open_cube(c, "rb", maxbands));
+}
+
+/**************  tile row i/o  *********************
+*                                                  *
+*  A tile row holds tile_l lines; in the file it   *
+*  is ntx tiles of tile_l x tile_s pixels one      *
+*  after the other (the last tile row and column   *
+*  padded out), in buf it is tile_l lines of       *
+*  ntx*tile_s pixels.  The bands follow each other.*
+*                                                  *
+****************************************************/
+int read_tile_row(isis_cube *c, int band, int row)
+{
+ long long nchunk, n, rowbytes, tilebytes;
+ int t, l;
+
+ nchunk = (long long) c->ntx * c->tile_s * c->tile_l * c->psize;
+ n = nchunk;
+ if (!c->tiled && (long long) (row + 1) * c->tile_l > c->lines)
+    n = (long long) (c->lines - row*c->tile_l) * c->samples * c->psize;
+
+ if (FSEEK64(c->fp, c->start + band*c->bandbytes + row*nchunk, SEEK_SET) != 0 ||
+     fread(c->chunk,1,n,c->fp) != (size_t) n)
+    {
+    printf("\nerror reading %s\n",c->file);
+    return(-1);
+    }
+
+ if (c->tiled)
+    {
+    rowbytes = (long long) c->ntx * c->tile_s * c->psize;
+    tilebytes = (long long) c->tile_s * c->psize;
+    for (t = 0; t < c->ntx; t++)
+       for (l = 0; l < c->tile_l; l++)
+          memcpy(c->buf + l*rowbytes + t*tilebytes,
+                 c->chunk + ((long long) t*c->tile_l + l)*tilebytes, tilebytes);
+    }
+
+ c->band = band;
+ c->row = row;
+ return(0);
+}
+
+int write_tile_row(isis_cube *c, int band, int row)
+{
+ long long nchunk, n, rowbytes, tilebytes;
+ int t, l;
+
+ nchunk = (long long) c->ntx * c->tile_s * c->tile_l * c->psize;
+ n = nchunk;
+ if (!c->tiled && (long long) (row + 1) * c->tile_l > c->lines)
+    n = (long long) (c->lines - row*c->tile_l) * c->samples * c->psize;
+
+ if (c->tiled)
+    {
+    rowbytes = (long long) c->ntx * c->tile_s * c->psize;
+    tilebytes = (long long) c->tile_s * c->psize;
+    for (t = 0; t < c->ntx; t++)
+       for (l = 0; l < c->tile_l; l++)
+          memcpy(c->chunk + ((long long) t*c->tile_l + l)*tilebytes,
+                 c->buf + l*rowbytes + t*tilebytes, tilebytes);
+    }
+
+ if (FSEEK64(c->fp, c->start + band*c->bandbytes + row*nchunk, SEEK_SET) != 0 ||
+     fwrite(c->chunk,1,n,c->fp) != (size_t) n)
+    {
+    printf("\nerror writing %s\n",c->file);
+    return(-1);
+    }
+
+ return(0);
+}
+
+/**************  cube_line  ************************
+*                                                  *
+*  Pixels of a (0-based) line of a band of a cube, *
+*  as stored, reading its tile row when needed;    *
+*  NULL if the line is outside the cube            *
+*                                                  *
+****************************************************/
+unsigned char *cube_line(isis_cube *c, int band, int line)
+{
+ int row;
+
+ if (line < 0 || line >= c->lines)
+    return(NULL);
+
+ row = line / c->tile_l;
+ if ((row != c->row || band != c->band) && read_tile_row(c, band, row) != 0)
+    exit(1);
+
+ return(c->buf + (long long) (line - row*c->tile_l) * c->ntx * c->tile_s * c->psize);
+}
+
+/**************  host_line  ************************
+*                                                  *
+*  Copies a line of the cube to host byte order    *
+*                                                  *
+****************************************************/
+void host_line(isis_cube *c, unsigned char *in, unsigned char *out)
+{
+ int s, b;
+
+ if (c->psize == 1 || !c->swap)
+    {
+    memcpy(out,in,(long long) c->samples*c->psize);
+    return;
+    }
+
+ for (s = 0; s < c->samples; s++)
+    for (b = 0; b < c->psize; b++)
+       out[(long long) s*c->psize + b] = in[(long long) s*c->psize + c->psize-1-b];
+}
+
+/**************  convert_line  *********************
+*                                                  *
+*  Copies a line of the cube to host byte order,   *
+*  setting the special pixels to NULL              *
+*                                                  *
+****************************************************/
+void convert_line(isis_cube *c, unsigned char *in, unsigned char *out)
+{
+ int s;
+ unsigned int bits;
+ unsigned short word;
+ unsigned char *p;
+
+ if (c->psize == 1)
+    {
+    memcpy(out,in,c->samples);
+    return;
+    }
+
+ for (s = 0; s < c->samples; s++)
+    {
+    p = in + (long long) s*c->psize;
+    if (c->psize == 4)
+       {
+       if (c->swap)
+          bits = ((unsigned int) p[0] << 24) | ((unsigned int) p[1] << 16) |
+                 ((unsigned int) p[2] << 8) | p[3];
+       else
+          memcpy(&bits,p,4);
+       if (bits >= NULL4_BITS || (bits & 0x7F800000) == 0x7F800000)
+          bits = NULL4_BITS;      /* special pixel, Inf or NaN */
+       memcpy(out + (long long) s*4,&bits,4);
+       }
+    else
+       {
+       if (c->swap)
+          word = (unsigned short) ((p[0] << 8) | p[1]);
+       else
+          memcpy(&word,p,2);
+       if ((short) word <= -32764)
+          word = (unsigned short) NULL2;    /* special pixel */
+       memcpy(out + (long long) s*2,&word,2);
+       }
+    }
+}
+
+/**************  null_pixel  ***********************
+*                                                  *
+*  ISIS NULL of the cube's pixel type, as stored   *
+*                                                  *
+****************************************************/
+void null_pixel(isis_cube *c, unsigned char *null)
+{
+ unsigned int v;
+ int i, lsb;
+
+ if (c->psize == 4)
+    v = NULL4_BITS;
+ else if (c->psize == 2)
+    v = 0x8000;         /* -32768 */
+ else
+    v = 0;
+
+ lsb = (strcmp(c->order,"Lsb") == 0);
+ for (i = 0; i < c->psize; i++)
+    null[i] = (v >> (8 * (lsb ? i : c->psize - 1 - i))) & 0xff;
+}
+
+/**************  geo_tags  *************************
+*                                                  *
+*  Adds the GeoTIFF tags (pixel scale, tie point   *
+*  and GeoKeys) for the Mapping group of the cube  *
+*  to tags; returns the new number of tags.  keys  *
+*  has room for 4*MAX_GEOKEYS+4 shorts, dbl for    *
+*  MAX_GEOKEYS doubles and ascii for a             *
+*  CUBE_PATHLENGTH string                          *
+*                                                  *
+*  Equirectangular and SimpleCylindrical are on    *
+*  the sphere ISIS uses for them (local radius at  *
+*  CenterLatitude and EquatorialRadius),           *
+*  Sinusoidal on the EquatorialRadius sphere and   *
+*  PolarStereographic on the ellipsoid.            *
+*  PositiveWest center longitudes are given +East. *
+*                                                  *
+****************************************************/
+int geo_tags(isis_cube *c, tiff_tag *tags, int ntags,
+             unsigned short *keys, double *dbl, char *ascii)
+{
+ static double scale[3], tie[6];
+ int nkeys, ndbl, ct;
+ double a, b, lat, clon, stdpar;
+ char cit[CUBE_PATHLENGTH];
+
+#define SHORT_KEY(id,val) { keys[4*nkeys+4] = id; keys[4*nkeys+5] = 0; \
+                            keys[4*nkeys+6] = 1; keys[4*nkeys+7] = val; nkeys++; }
+#define DOUBLE_KEY(id,val) { keys[4*nkeys+4] = id; keys[4*nkeys+5] = 34736; \
+                             keys[4*nkeys+6] = 1; keys[4*nkeys+7] = ndbl; \
+                             dbl[ndbl++] = val; nkeys++; }
+#define ASCII_KEY(id,str) { keys[4*nkeys+4] = id; keys[4*nkeys+5] = 34737; \
+                            keys[4*nkeys+6] = strlen(str)+1; keys[4*nkeys+7] = strlen(ascii); \
+                            strcat(ascii,str); strcat(ascii,"|"); nkeys++; }
+
+ /* +East center longitude; the sphere or ellipsoid ISIS uses for the
+    projection */
+ clon = c->clon;
+ if (strcmp(c->londir,"PositiveWest") == 0)
+    clon = -clon;
+ a = c->eqradius;
+ b = c->polradius;
+ stdpar = 0.0;
+ if (strcmp(c->projection,"Equirectangular") == 0)
+    {
+    ct = CT_Equirectangular;
+    lat = c->clat * M_PI / 180.0;
+    a = b = c->eqradius * c->polradius /
+            sqrt(pow(c->polradius*cos(lat),2) + pow(c->eqradius*sin(lat),2));
+    stdpar = c->clat;
+    }
+ else if (strcmp(c->projection,"SimpleCylindrical") == 0)
+    {
+    ct = CT_Equirectangular;
+    b = a;
+    }
+ else if (strcmp(c->projection,"Sinusoidal") == 0)
+    {
+    ct = CT_Sinusoidal;
+    b = a;
+    }
+ else
+    ct = CT_PolarStereographic;
+
+ scale[0] = scale[1] = c->res;
+ scale[2] = 0.0;
+ tie[0] = tie[1] = tie[2] = tie[5] = 0.0;
+ tie[3] = c->ulx;
+ tie[4] = c->uly;
+
+ nkeys = 0;
+ ndbl = 0;
+ ascii[0] = '\0';
+ SHORT_KEY(1024, 1);                       /* GTModelType: projected */
+ SHORT_KEY(1025, 1);                       /* GTRasterType: PixelIsArea */
+ sprintf(cit,"%s %s",c->projection,c->target);
+ ASCII_KEY(1026, cit);                     /* GTCitation */
+ SHORT_KEY(2048, KvUserDefined);           /* GeographicType */
+ sprintf(cit,"GCS_%s",c->target);
+ ASCII_KEY(2049, cit);                     /* GeogCitation */
+ SHORT_KEY(2050, KvUserDefined);           /* GeogGeodeticDatum */
+ SHORT_KEY(2051, 8901);                    /* GeogPrimeMeridian: reference meridian */
+ SHORT_KEY(2054, 9102);                    /* GeogAngularUnits: degree */
+ SHORT_KEY(2056, KvUserDefined);           /* GeogEllipsoid */
+ DOUBLE_KEY(2057, a);                      /* GeogSemiMajorAxis */
+ DOUBLE_KEY(2058, b);                      /* GeogSemiMinorAxis */
+ SHORT_KEY(3072, KvUserDefined);           /* ProjectedCSType */
+ SHORT_KEY(3074, KvUserDefined);           /* Projection */
+ SHORT_KEY(3075, ct);                      /* ProjCoordTrans */
+ SHORT_KEY(3076, 9001);                    /* ProjLinearUnits: meter */
+ if (ct == CT_Equirectangular)
+    DOUBLE_KEY(3078, stdpar);              /* ProjStdParallel1 */
+ if (ct == CT_PolarStereographic)
+    DOUBLE_KEY(3081, c->clat);             /* ProjNatOriginLat */
+ DOUBLE_KEY(3082, 0.0);                    /* ProjFalseEasting */
+ DOUBLE_KEY(3083, 0.0);                    /* ProjFalseNorthing */
+ if (ct != CT_PolarStereographic)
+    DOUBLE_KEY(3088, clon);                /* ProjCenterLong */
+ if (ct == CT_Equirectangular)
+    DOUBLE_KEY(3089, 0.0);                 /* ProjCenterLat */
+ if (ct == CT_PolarStereographic)
+    {
+    DOUBLE_KEY(3092, 1.0);                 /* ProjScaleAtNatOrigin */
+    DOUBLE_KEY(3095, clon);                /* ProjStraightVertPoleLong */
+    }
+ keys[0] = 1;
+ keys[1] = 1;
+ keys[2] = 0;
+ keys[3] = nkeys;
+
+#undef SHORT_KEY
+#undef DOUBLE_KEY
+#undef ASCII_KEY
+
+ tags[ntags].tag = 33550; tags[ntags].type = T_DOUBLE; tags[ntags].count = 3;
+ tags[ntags++].data = scale;
+ tags[ntags].tag = 33922; tags[ntags].type = T_DOUBLE; tags[ntags].count = 6;
+ tags[ntags++].data = tie;
+ tags[ntags].tag = 34735; tags[ntags].type = T_SHORT; tags[ntags].count = 4*nkeys+4;
+ tags[ntags++].data = keys;
+ tags[ntags].tag = 34736; tags[ntags].type = T_DOUBLE; tags[ntags].count = ndbl;
+ tags[ntags++].data = dbl;
+ tags[ntags].tag = 34737; tags[ntags].type = T_ASCII; tags[ntags].count = strlen(ascii)+1;
+ tags[ntags++].data = ascii;
+
+ return(ntags);
+}
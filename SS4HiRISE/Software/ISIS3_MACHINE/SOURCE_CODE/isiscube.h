@@ -0,0 +1,95 @@
+/**************  isiscube.h ************************
+*                                                  *
+*  ISIS3 cube reader and GeoTIFF GeoKeys builder   *
+*  shared by hinoprojmos, hi8bitraw, isis2geotiff  *
+*  and isis2jp2 (see isiscube.c).  Each is built   *
+*  with isiscube.c, e.g.                           *
+*                                                  *
+*    cc -O2 hinoprojmos.c isiscube.c -lm           *
+*                                                  *
+* Oct 2026, original version                       *
+****************************************************/
+
+#ifndef ISISCUBE_H
+#define ISISCUBE_H
+
+#include <stdio.h>
+
+#define CUBE_PATHLENGTH 1024
+#define BSQ_BLOCK 128        /* lines per block of a BandSequential cube */
+
+#define NULL4_BITS 0xFF7FFFFB
+#define NULL2 -32768
+
+/* TIFF field types */
+#define T_ASCII  2
+#define T_SHORT  3
+#define T_LONG   4
+#define T_DOUBLE 12
+#define T_LONG8  16
+
+/* GeoTIFF coordinate transformation codes */
+#define CT_PolarStereographic 15
+#define CT_Equirectangular    17
+#define CT_Sinusoidal         24
+#define KvUserDefined         32767
+
+#define MAX_GEOKEYS 32
+
+typedef struct {
+   char file[CUBE_PATHLENGTH];
+   FILE *fp;
+   long long start;          /* byte offset of the pixels */
+   long long bandbytes;      /* bytes of one band as stored */
+   int samples, lines, bands;
+   int tiled;                /* 1 = Tile format, 0 = BandSequential */
+   int tile_s, tile_l;       /* tile (or block) size */
+   int ntx;                  /* tiles across */
+   int psize;                /* bytes per pixel */
+   char type[32];
+   char order[8];
+   int swap;                 /* 1 = byte order differs from this machine */
+   double base, mult;
+   int band, row;            /* tile row in buf, -1 = none */
+   unsigned char *chunk;     /* one tile row as stored */
+   unsigned char *buf;       /* the same tile row as tile_l full lines */
+
+   /* Mapping group */
+   int isis3;                /* label has Object = IsisCube */
+   char projection[64];
+   char target[64];
+   char londir[32];
+   double eqradius, polradius;
+   double clat, clon;
+   double res;               /* PixelResolution, meters */
+   double ulx, uly;          /* UpperLeftCorner, outer corner of pixel 1,1 */
+} isis_cube;
+
+typedef struct {
+   int tag, type;
+   long long count;
+   void *data;               /* host order: char, unsigned short, double
+                                or unsigned long long (LONG/LONG8) */
+} tiff_tag;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int read_cube_label(isis_cube *c, char *file);
+int open_cube(isis_cube *c, char *mode, int maxbands);
+int open_map_cube(isis_cube *c, char *file, int maxbands);
+int read_tile_row(isis_cube *c, int band, int row);
+int write_tile_row(isis_cube *c, int band, int row);
+unsigned char *cube_line(isis_cube *c, int band, int line);
+void host_line(isis_cube *c, unsigned char *in, unsigned char *out);
+void convert_line(isis_cube *c, unsigned char *in, unsigned char *out);
+void null_pixel(isis_cube *c, unsigned char *null);
+int geo_tags(isis_cube *c, tiff_tag *tags, int ntags,
+             unsigned short *keys, double *dbl, char *ascii);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
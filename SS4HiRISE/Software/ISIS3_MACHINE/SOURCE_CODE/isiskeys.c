@@ -0,0 +1,355 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+/**************  isiskeys.c ************************
+*                                                  *
+*  This routine reads the PVL label of one or      *
+*  more ISIS3 cubes or PVL files (campt, stats,    *
+*  percent output...) once each and prints the     *
+*  values of all the requested keywords as JSON,   *
+*  in place of one getkey run per keyword per      *
+*  file:                                           *
+*                                                  *
+*    isiskeys Instrument/CcdId,Dimensions/Lines \  *
+*             a.cub b.cub                          *
+*                                                  *
+*    {                                             *
+*      "a.cub": {                                  *
+*        "Instrument/CcdId": "RED5",               *
+*        "Dimensions/Lines": "20000"               *
+*      },                                          *
+*      "b.cub": {                                  *
+*        ...                                       *
+*      }                                           *
+*    }                                             *
+*                                                  *
+*  A key is Keyword or Group/Keyword, where Group  *
+*  is the name of the Group or Object holding the  *
+*  keyword (case does not matter, as in PVL).      *
+*  Values are strings as getkey prints them        *
+*  (quotes and units removed).  A keyword found    *
+*  more than once, e.g. GroundPoint values of a    *
+*  campt file written with append=yes, gives an    *
+*  array of values in file order; a keyword not    *
+*  found gives null.  Each key is on a line of     *
+*  its own.                                        *
+*                                                  *
+*  Exits 1 if a file can't be read.                *
+*                                                  *
+* Oct 2026, original version                       *
+****************************************************/
+
+#define LINELENGTH 4096
+#define KEYLENGTH 256
+#define MAX_KEYS 64
+#define MAX_DEPTH 32
+#define MAX_VALUES 256
+
+typedef struct {
+   char group[KEYLENGTH];
+   char keyword[KEYLENGTH];
+   int nvalues;
+   char *values[MAX_VALUES];
+} label_key;
+
+/* routines */
+int parse_keys(char *list, label_key *keys);
+int read_label(char *file, label_key *keys, int nkeys);
+void trim(char *s);
+void clean_value(char *value);
+void print_json_string(char *s);
+
+main(int argc,char *argv[])
+{
+
+ label_key keys[MAX_KEYS];
+ int nkeys, f, k, v;
+
+ if (argc < 3)
+    {
+    printf("\nUsage: isiskeys [Group/]Keyword[,[Group/]Keyword...] file [file...]\n");
+    printf("\n  prints the values of the keywords in the PVL labels of the files\n");
+    printf("  as JSON (one getkey run for all keywords and files)\n\n");
+    exit(1);
+    }
+
+ nkeys = parse_keys(argv[1], keys);
+ if (nkeys <= 0)
+    exit(1);
+
+ printf("{\n");
+ for (f = 2; f < argc; f++)
+    {
+    for (k = 0; k < nkeys; k++)
+       {
+       for (v = 0; v < keys[k].nvalues; v++)
+          free(keys[k].values[v]);
+       keys[k].nvalues = 0;
+       }
+
+    if (read_label(argv[f], keys, nkeys) != 0)
+       {
+       fflush(stdout);
+       fprintf(stderr,"\nisiskeys: can't read the label of %s\n",argv[f]);
+       exit(1);
+       }
+
+    printf("  ");
+    print_json_string(argv[f]);
+    printf(": {\n");
+    for (k = 0; k < nkeys; k++)
+       {
+       printf("    ");
+       if (keys[k].group[0])
+          {
+          char key[2*KEYLENGTH+2];
+          sprintf(key,"%s/%s",keys[k].group,keys[k].keyword);
+          print_json_string(key);
+          }
+       else
+          print_json_string(keys[k].keyword);
+       printf(": ");
+
+       if (keys[k].nvalues == 0)
+          printf("null");
+       else if (keys[k].nvalues == 1)
+          print_json_string(keys[k].values[0]);
+       else
+          {
+          printf("[");
+          for (v = 0; v < keys[k].nvalues; v++)
+             {
+             if (v > 0) printf(", ");
+             print_json_string(keys[k].values[v]);
+             }
+          printf("]");
+          }
+       printf("%s\n", (k < nkeys-1) ? "," : "");
+       }
+    printf("  }%s\n", (f < argc-1) ? "," : "");
+    }
+ printf("}\n");
+
+ return(0);
+
+}
+
+/**************  parse_keys  ***********************
+*                                                  *
+*  Splits the comma separated [Group/]Keyword      *
+*  list                                            *
+*                                                  *
+****************************************************/
+int parse_keys(char *list, label_key *keys)
+{
+ char buf[LINELENGTH];
+ char *tok, *slash;
+ int n;
+
+ strncpy(buf,list,LINELENGTH-1);
+ buf[LINELENGTH-1] = '\0';
+
+ n = 0;
+ for (tok = strtok(buf,","); tok != NULL; tok = strtok(NULL,","))
+    {
+    if (n == MAX_KEYS)
+       {
+       printf("\nmore than %d keywords requested\n",MAX_KEYS);
+       return(-1);
+       }
+    trim(tok);
+    if (*tok == '\0')
+       continue;
+    if (strlen(tok) >= KEYLENGTH)
+       {
+       printf("\nkeyword too long: %s\n",tok);
+       return(-1);
+       }
+
+    memset(&keys[n],0,sizeof(label_key));
+    slash = strrchr(tok,'/');
+    if (slash != NULL)
+       {
+       *slash = '\0';
+       strcpy(keys[n].group,tok);
+       strcpy(keys[n].keyword,slash+1);
+       }
+    else
+       strcpy(keys[n].keyword,tok);
+    n++;
+    }
+
+ if (n == 0)
+    printf("\nno keywords requested\n");
+ return(n);
+}
+
+/**************  read_label  ***********************
+*                                                  *
+*  Reads the PVL label of a file up to its End     *
+*  statement (or the end of the file), keeping     *
+*  track of the enclosing Group/Object, and saves  *
+*  the values of the requested keywords            *
+*                                                  *
+****************************************************/
+int read_label(char *file, label_key *keys, int nkeys)
+{
+ char line[LINELENGTH];
+ char value[LINELENGTH];
+ char id[LINELENGTH];
+ char stack[MAX_DEPTH][KEYLENGTH];
+ char *eq, *c;
+ int depth, k, open, quote;
+ FILE *fp;
+
+ fp = fopen(file,"r");
+ if (fp == NULL)
+    return(-1);
+
+ depth = 0;
+ while (fgets(line,LINELENGTH,fp) != NULL)
+    {
+    /* drop comments */
+    c = strstr(line,"/*");
+    if (c != NULL && strchr(line,'"') == NULL)
+       *c = '\0';
+    trim(line);
+    if (line[0] == '\0' || line[0] == '#')
+       continue;
+
+    if (strcasecmp(line,"End") == 0)
+       break;
+
+    if (strncasecmp(line,"End_Object",10) == 0 ||
+        strncasecmp(line,"End_Group",9) == 0 ||
+        strncasecmp(line,"EndObject",9) == 0 ||
+        strncasecmp(line,"EndGroup",8) == 0)
+       {
+       if (depth > 0) depth--;
+       continue;
+       }
+
+    eq = strchr(line,'=');
+    if (eq == NULL)
+       continue;
+    *eq = '\0';
+    strcpy(id,line);
+    trim(id);
+    strcpy(value,eq+1);
+    trim(value);
+
+    /* values continued on the following lines: open lists and
+       quoted strings */
+    for (;;)
+       {
+       open = 0;
+       quote = 0;
+       for (c = value; *c; c++)
+          {
+          if (*c == '"') quote = !quote;
+          else if (!quote && (*c == '(' || *c == '{')) open++;
+          else if (!quote && (*c == ')' || *c == '}')) open--;
+          }
+       if ((open <= 0 && !quote) || strlen(value) > LINELENGTH/2 ||
+           fgets(line,LINELENGTH/2,fp) == NULL)
+          break;
+       trim(line);
+       strcat(value," ");
+       strcat(value,line);
+       }
+
+    if (strcasecmp(id,"Object") == 0 || strcasecmp(id,"Group") == 0)
+       {
+       clean_value(value);
+       if (depth < MAX_DEPTH)
+          {
+          strncpy(stack[depth],value,KEYLENGTH-1);
+          stack[depth][KEYLENGTH-1] = '\0';
+          }
+       depth++;
+       continue;
+       }
+
+    for (k = 0; k < nkeys; k++)
+       {
+       if (strcasecmp(id,keys[k].keyword) != 0)
+          continue;
+       if (keys[k].group[0] &&
+           (depth == 0 || depth > MAX_DEPTH ||
+            strcasecmp(stack[depth-1],keys[k].group) != 0))
+          continue;
+       if (keys[k].nvalues == MAX_VALUES)
+          continue;
+       keys[k].values[keys[k].nvalues] = (char *) malloc(strlen(value)+1);
+       strcpy(keys[k].values[keys[k].nvalues],value);
+       clean_value(keys[k].values[keys[k].nvalues]);
+       keys[k].nvalues++;
+       }
+    }
+
+ fclose(fp);
+ return(0);
+}
+
+/**************  trim  *****************************
+*                                                  *
+*  Removes leading and trailing white space        *
+*                                                  *
+****************************************************/
+void trim(char *s)
+{
+ char *b, *e;
+
+ for (b = s; *b && isspace((unsigned char) *b); b++);
+ for (e = b + strlen(b); e > b && isspace((unsigned char) e[-1]); e--);
+ memmove(s,b,e-b);
+ s[e-b] = '\0';
+}
+
+/**************  clean_value  **********************
+*                                                  *
+*  Drops the units (<...>) following a value and   *
+*  the quotes around a string, as getkey does      *
+*                                                  *
+****************************************************/
+void clean_value(char *value)
+{
+ char *c;
+ int len;
+
+ len = strlen(value);
+ if (len > 0 && value[len-1] == '>' && value[0] != '"')
+    {
+    c = strrchr(value,'<');
+    if (c != NULL)
+       {
+       *c = '\0';
+       trim(value);
+       }
+    }
+
+ len = strlen(value);
+ if (len >= 2 && value[0] == '"' && value[len-1] == '"')
+    {
+    memmove(value,value+1,len-2);
+    value[len-2] = '\0';
+    }
+}
+
+/**************  print_json_string  ****************/
+void print_json_string(char *s)
+{
+ putchar('"');
+ for (; *s; s++)
+    {
+    if (*s == '"' || *s == '\\')
+       printf("\\%c",*s);
+    else if ((unsigned char) *s < 0x20)
+       printf("\\u%04x",(unsigned char) *s);
+    else
+       putchar(*s);
+    }
+ putchar('"');
+}
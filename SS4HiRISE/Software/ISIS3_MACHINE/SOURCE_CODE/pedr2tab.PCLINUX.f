@@ -316,7 +316,7 @@ c
 	 read(1,rec=i+10,err=9) pedr
 	 dptime=iswap4(pedr(1)) + 1.d-06*iswap4(pedr(2))
 	 irev = iswap4(pedr(3))
-  	 iseq=iand(iswap2(ipdr(248)),mask)
+  	 iseq=iand(int(iswap2(ipdr(248))),mask)
 	 dlat= 1.d-6*iswap4(pedr(85))
 	 dlon= 1.d-6*iswap4(pedr(86))
 c Check frame midpoint for bounds
@@ -0,0 +1,1156 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title BENCH_EXPORTERS times the SS<->ISIS conversion hot paths on synthetic data
+//
+//_Desc  Generates synthetic HiRISE-scale inputs and times the conversion
+//       code on them, so the cost of the exporters and converters can be
+//       measured (and changes to them compared) without a real project or
+//       a SOCET licence.  The inputs are:
+//
+//              a DTM grid (float elevations plus FOM, with NULL holes)
+//              an 8-bit orthoimage (tiled TIFF)
+//              a GPF of tie and control points
+//              a PEDR file of MOLA frames
+//              a BandSequential Real ISIS3 cube
+//
+//       and the cases timed are:
+//
+//              dem2isis3 raw DEM/FOM/confidence writers (Moon project, no
+//                resampling) and the full export with the standard grid
+//                resampling (Mars project), with a FOM mask (Moon) and
+//                with the 5x5 terrain products (Mars)
+//              ortho2isis3 raw writer
+//              gpf_level (GPF tie points leveled to the DTM)
+//              dtm_destripe (stripes at 7 degrees, no reference)
+//              remap_fom_row (FOM -> LMMP confidence)
+//              fom_mask_row + pack_mask_row (FOM mask and its bit plane)
+//              PushbroomSensorModel imageToGround and groundToImage
+//                (a USGSAstroLineScanner support file of the ortho's size)
+//              parse_label (SOCET project keywords)
+//              isiskeys (ISIS3 label keywords)
+//              isis3arc_dd, without and with the cube's NULL-span index
+//              gpfTies2LatLonHeightCSV_360sys and mergeTransformedGPFties
+//              pedr2tab
+//
+//       dem2isis3.cpp, ortho2isis3.cpp, gpf_level.cpp, dtm_destripe.cpp
+//       and export_subroutines.cpp are built unchanged into this program
+//       against the native DEV_KIT routines in ../socet_native (DtmGrid,
+//       img_load_buffer, ...), and each export runs in a child process as
+//       it would under start_socet.  The ISIS machine
+//       programs are run from the tools directory; a case whose program
+//       has not been built there is skipped.  Build both with
+//
+//              make -f makefile_bench_exporters.linux all tools
+//
+//       Usage:
+//
+//              bench_exporters [-hirise] [-rows n] [-cols n] [-lines n]
+//                              [-samples n] [-points n] [-frames n]
+//                              [-tools dir] [-work dir] [-keep]
+//
+//       The default sizes run in a few seconds.  -hirise uses HiRISE
+//       scale inputs: a 1 m DTM of 40000 rows by 6000 posts, a 25 cm ortho
+//       of 48000 lines by 24000 samples, a 100000 point GPF and a 50000
+//       frame PEDR file (about 10 GB in the work directory, including the
+//       outputs).  -rows/-cols (DTM and cube), -lines/-samples (ortho),
+//       -points (GPF) and -frames (PEDR) set the sizes one at a time.
+//
+//       Throughput is reported in MB/s (MB = 2^20 bytes) of input and in
+//       points (posts, pixels, keywords, shots) per second.  The inputs
+//       are written just before they are read, so they are normally in
+//       the page cache and the times are those of the converters rather
+//       than of the disk.  Converter output goes to bench_exporters.log in
+//       the work directory (default ./bench_work), which is removed when
+//       done unless -keep is given.
+//
+//_Hist Oct 18 2026      Orig Version
+//      Oct 18 2026      DTMs are read by the native reader in ../socet_native
+//                       (LOWER_LEFT_XYZ/UPPER_RIGHT_XYZ headers)
+//      Oct 18 2026      The ortho is a 256x256 tiled TIFF read by the native
+//                       image reader; the DEV_KIT stand-in is gone.
+//      Oct 18 2026      FOM mask cases (dem2isis3 with a mask, fom_mask_row)
+//      Oct 18 2026      gpf_level case
+//      Oct 18 2026      The DTM is a diagonal strip, half of it NULL, as
+//                       HiRISE DTMs are; isis3arc_dd + NULL-span index case
+//      Oct 18 2026      dtm_destripe case
+//      Oct 18 2026      dem2isis3 terrain products case
+//      Oct 18 2026      pushbroom sensor model cases
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "socet_native.h"
+#include "../export_subs/export_subroutines.h"
+
+using namespace std;
+
+#define FILELEN 512
+#define MB (1024.0*1024.0)
+
+#define MARS_A 3396190.0
+#define MARS_B 3376200.0
+#define MOON_R 1737400.0
+
+// ISIS3 special pixel (Real NULL)
+#define ISIS_NULL4 0xFF7FFFFBu
+
+// exporter entry points and routines under test (dem2isis3.cpp and
+// ortho2isis3.cpp are compiled with main renamed, see the makefile)
+extern int dem2isis3_main(int argc, char *argv[]);
+extern int ortho2isis3_main(int argc, char *argv[]);
+extern int gpf_level_main(int argc, char *argv[]);
+extern int dtm_destripe_main(int argc, char *argv[]);
+extern void set_default_confidence_lut(unsigned char *lut);
+extern void remap_fom_row(unsigned char *lut, char *fom_buf,
+                          unsigned char *conf_row, int ncols);
+
+struct bench_sizes {
+	int dtm_rows, dtm_cols;        // 1 m DTM and ISIS cube
+	int ortho_lines, ortho_samples;  // 25 cm ortho
+	int gpf_points;
+	int pedr_frames;
+};
+
+// prototypes
+static double now();
+static unsigned int next_random();
+static void dtm_row(int y, int rows, int cols, float *elev, unsigned char *fom);
+static int write_project(char *work, char *name, int mars);
+static int write_dtm(char *dir, char *name, int rows, int cols, double radius);
+static int write_ortho(char *dir, char *name, int lines, int samples,
+                       double radius);
+static int write_gpf(char *file, int points);
+static int write_pedr(char *work, char *file, int frames);
+static int write_cube(char *file, int lines, int samples, int *label_bytes);
+static int write_pushbroom_sup(char *dir, char *name, int lines, int samples);
+static long long file_size(char *file);
+static void report(const char *name, double bytes, double points,
+                   const char *unit, double seconds);
+static double run_export(char *work, int (*export_main)(int, char **),
+                         int argc, const char **argv);
+static double run_tool(char *work, char *tools, const char *tool,
+                       const char *args);
+
+static unsigned int random_state = 2463534242u;
+
+int main(int argc, char *argv[])
+{
+	bench_sizes sz;
+	char tools[FILELEN];
+	char work[FILELEN];
+	char path[FILELEN];
+	char cube[FILELEN];
+	char gpf[FILELEN];
+	char args[16*FILELEN];    // isiskeys keys + 200 cube names
+	char value[FILELEN];
+	int keep = 0;
+	int label_bytes;
+	int i, k, n;
+	double t, bytes, posts;
+
+	sz.dtm_rows = 4000;
+	sz.dtm_cols = 1500;
+	sz.ortho_lines = 8000;
+	sz.ortho_samples = 4000;
+	sz.gpf_points = 10000;
+	sz.pedr_frames = 2000;
+	strcpy(tools, "tools");
+	strcpy(work, "bench_work");
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-hirise") == 0) {
+			sz.dtm_rows = 40000;
+			sz.dtm_cols = 6000;
+			sz.ortho_lines = 48000;
+			sz.ortho_samples = 24000;
+			sz.gpf_points = 100000;
+			sz.pedr_frames = 50000;
+		}
+		else if (strcmp(argv[i], "-keep") == 0)
+			keep = 1;
+		else if (i + 1 < argc && strcmp(argv[i], "-rows") == 0)
+			sz.dtm_rows = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-cols") == 0)
+			sz.dtm_cols = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-lines") == 0)
+			sz.ortho_lines = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-samples") == 0)
+			sz.ortho_samples = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-points") == 0)
+			sz.gpf_points = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-frames") == 0)
+			sz.pedr_frames = atoi(argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-tools") == 0)
+			strcpy(tools, argv[++i]);
+		else if (i + 1 < argc && strcmp(argv[i], "-work") == 0)
+			strcpy(work, argv[++i]);
+		else {
+			cerr << "\nRun bench_exporters as follows:\n";
+			cerr << "bench_exporters [-hirise] [-rows n] [-cols n] [-lines n] [-samples n]\n";
+			cerr << "                [-points n] [-frames n] [-tools dir] [-work dir] [-keep]\n";
+			cerr << "\nwhere:\n";
+			cerr << "-hirise  = HiRISE scale inputs (40000x6000 DTM, 48000x24000 ortho,\n";
+			cerr << "           100000 point GPF, 50000 frame PEDR)\n";
+			cerr << "-rows, -cols = DTM and ISIS cube size\n";
+			cerr << "-lines, -samples = ortho size\n";
+			cerr << "-points = GPF points, -frames = PEDR frames\n";
+			cerr << "-tools  = directory of the ISIS machine programs (default tools)\n";
+			cerr << "-work   = scratch directory (default bench_work)\n";
+			cerr << "-keep   = keep the scratch directory\n";
+			exit(1);
+		}
+	}
+	if (sz.dtm_rows < 2 || sz.dtm_cols < 2 || sz.ortho_lines < 10 ||
+	    sz.ortho_samples < 1 || sz.gpf_points < 1 || sz.pedr_frames < 2) {
+		printf("\nsizes too small (need 2x2 DTM, 10 line ortho, 2 PEDR frames)\n");
+		exit(1);
+	}
+
+	// Work in absolute paths, the exports run in the work directory
+	if (work[0] != '/') {
+		if (getcwd(path, FILELEN) == NULL) {
+			printf("\ncan't get the current directory!\n");
+			exit(1);
+		}
+		strcpy(value, work);
+		snprintf(work, FILELEN, "%s/%s", path, value);
+	}
+	if (tools[0] != '/' && getcwd(path, FILELEN) != NULL) {
+		strcpy(value, tools);
+		snprintf(tools, FILELEN, "%s/%s", path, value);
+	}
+	mkdir(work, 0755);
+	setenv("DBDIR", work, 1);
+	setenv("SOCET_PROJECTS", work, 1);
+	// the synthetic DTMs are written in the native layout itself
+	setenv(NATIVE_DTM_OPT_IN, "1", 1);
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Generate the inputs
+	/////////////////////////////////////////////////////////////////////////////
+
+	printf("Generating inputs in %s\n", work);
+	t = now();
+	if (write_project(work, (char *) "bench_mars", 1) != 0 ||
+	    write_project(work, (char *) "bench_moon", 0) != 0)
+		exit(1);
+	sprintf(path, "%s/bench_mars", work);
+	if (write_dtm(path, (char *) "bench_dtm", sz.dtm_rows, sz.dtm_cols, MARS_A) != 0 ||
+	    write_ortho(path, (char *) "bench_ortho", sz.ortho_lines,
+	                sz.ortho_samples, MARS_A) != 0)
+		exit(1);
+	sprintf(path, "%s/bench_moon", work);
+	if (write_dtm(path, (char *) "bench_dtm", sz.dtm_rows, sz.dtm_cols, MOON_R) != 0)
+		exit(1);
+	sprintf(gpf, "%s/bench.gpf", work);
+	if (write_gpf(gpf, sz.gpf_points) != 0)
+		exit(1);
+	sprintf(path, "%s/AP10001L.B", work);
+	if (write_pedr(work, path, sz.pedr_frames) != 0)
+		exit(1);
+	sprintf(cube, "%s/bench_cube.cub", work);
+	if (write_cube(cube, sz.dtm_rows, sz.dtm_cols, &label_bytes) != 0)
+		exit(1);
+	printf("...done in %.2f s\n\n", now() - t);
+
+	printf("%-34s %9s %16s %9s %10s %14s\n", "case", "input MB", "points",
+	       "seconds", "MB/s", "points/s");
+
+	/////////////////////////////////////////////////////////////////////////////
+	// SOCET side exporters
+	/////////////////////////////////////////////////////////////////////////////
+
+	bytes = (double) sz.dtm_rows * sz.dtm_cols * 5;
+	posts = (double) sz.dtm_rows * sz.dtm_cols;
+	{
+		const char *av[] = {"dem2isis3", "bench_moon", "bench_dtm",
+		                    "bench_moon_dem.cub", "n"};
+		report("dem2isis3 raw writers (Moon)", bytes, posts, "posts",
+		       run_export(work, dem2isis3_main, 5, av));
+	}
+	{
+		const char *av[] = {"dem2isis3", "bench_mars", "bench_dtm",
+		                    "bench_mars_dem.cub", "n"};
+		report("dem2isis3 + standard grid (Mars)", bytes, posts, "posts",
+		       run_export(work, dem2isis3_main, 5, av));
+	}
+	{
+		const char *av[] = {"dem2isis3", "bench_moon", "bench_dtm",
+		                    "bench_masked_dem.cub", "n", "-", "2-254:3,40-45"};
+		report("dem2isis3 + FOM mask (Moon)", bytes, posts, "posts",
+		       run_export(work, dem2isis3_main, 7, av));
+	}
+	{
+		const char *av[] = {"dem2isis3", "bench_mars", "bench_dtm",
+		                    "bench_terrain_dem.cub", "n", "-", "-", "5"};
+		report("dem2isis3 + terrain products (Mars)", bytes, posts, "posts",
+		       run_export(work, dem2isis3_main, 8, av));
+	}
+	{
+		const char *av[] = {"ortho2isis3", "bench_mars", "bench_ortho",
+		                    "bench_ortho.cub", "n"};
+		report("ortho2isis3 raw writer", (double) sz.ortho_lines * sz.ortho_samples,
+		       (double) sz.ortho_lines * sz.ortho_samples, "pixels",
+		       run_export(work, ortho2isis3_main, 5, av));
+	}
+	{
+		const char *av[] = {"gpf_level", "bench_moon", "bench_dtm", "bench.gpf",
+		                    "bench_level.gpf", "10.0"};
+		report("gpf_level", (double) file_size(gpf), sz.gpf_points, "points",
+		       run_export(work, gpf_level_main, 6, av));
+	}
+	{
+		const char *av[] = {"dtm_destripe", "bench_moon", "bench_dtm",
+		                    "bench_destriped", "8", "7"};
+		report("dtm_destripe", bytes, posts, "posts",
+		       run_export(work, dtm_destripe_main, 6, av));
+	}
+
+	// FOM -> confidence remap over the DTM's FOM rows
+	{
+		unsigned char lut[256];
+		float *elev = new float [sz.dtm_cols];
+		unsigned char *fom = new unsigned char [(size_t) sz.dtm_rows * sz.dtm_cols];
+		unsigned char *conf = new unsigned char [sz.dtm_cols];
+		unsigned long long check = 0;
+
+		set_default_confidence_lut(lut);
+		for (i = 0; i < sz.dtm_rows; i++)
+			dtm_row(i, sz.dtm_rows, sz.dtm_cols, elev,
+			        fom + (size_t) i * sz.dtm_cols);
+		t = now();
+		for (i = 0; i < sz.dtm_rows; i++) {
+			remap_fom_row(lut, (char *) fom + (size_t) i * sz.dtm_cols, conf,
+			              sz.dtm_cols);
+			check += conf[i % sz.dtm_cols];
+		}
+		t = now() - t;
+		if (check == 0)
+			printf("(no confidence values)\n");
+		report("remap_fom_row", posts, posts, "posts", t);
+
+		// the same rows through the FOM mask (range and class tests)
+		char spec[] = "2-254:3,40-45";
+		fom_mask *mask = open_fom_mask(spec);
+		unsigned char *bits = new unsigned char [(sz.dtm_cols + 7) / 8];
+		if (mask == NULL)
+			exit(1);
+		check = 0;
+		t = now();
+		for (i = 0; i < sz.dtm_rows; i++) {
+			check += fom_mask_row(mask, (char *) fom + (size_t) i * sz.dtm_cols,
+			                      conf, sz.dtm_cols);
+			pack_mask_row(conf, bits, sz.dtm_cols);
+		}
+		t = now() - t;
+		if (check == 0)
+			printf("(no posts kept by the FOM mask)\n");
+		report("fom_mask_row + pack_mask_row", posts, posts, "posts", t);
+		close_fom_mask(mask);
+		delete [] bits;
+		delete [] elev;
+		delete [] fom;
+		delete [] conf;
+	}
+
+	// pushbroom sensor model, a grid of points over a HiRISE-like image
+	// (points on the ground from image to ground are mapped back)
+	sprintf(path, "%s/bench_pushbroom.sup", work);
+	if (write_pushbroom_sup(work, "bench_pushbroom", sz.ortho_lines,
+	                        sz.ortho_samples) == 0) {
+		PushbroomSensorModel *sup = read_pushbroom_support_file(path);
+		int npts = 10 * sz.gpf_points, side = (int) sqrt((double) npts);
+		double *line, *sample, *height, *l2, *s2, err = 0.0;
+		ground_point_struct *gp;
+
+		if (sup == NULL) {
+			printf("couldn't read %s\n", path);
+			exit(1);
+		}
+		npts = side * side;
+		line = new double [npts];
+		sample = new double [npts];
+		height = new double [npts];
+		l2 = new double [npts];
+		s2 = new double [npts];
+		gp = new ground_point_struct [npts];
+		for (i = 0; i < side; i++)
+			for (k = 0; k < side; k++) {
+				n = i * side + k;
+				line[n] = 0.5 + (i + 0.5) * sz.ortho_lines / side;
+				sample[n] = 0.5 + (k + 0.5) * sz.ortho_samples / side;
+				height[n] = -3000.0 + 500.0 * sin(0.01 * line[n]) *
+				            cos(0.013 * sample[n]);
+			}
+		t = now();
+		n = sup->imageToGround(npts, line, sample, height, gp);
+		t = now() - t;
+		report("PushbroomSensorModel imageToGround", 0.0, npts, "points",
+		       n == 0 ? t : -1.0);
+		t = now();
+		n = sup->groundToImage(npts, gp, l2, s2);
+		t = now() - t;
+		report("PushbroomSensorModel groundToImage", 0.0, npts, "points",
+		       n == 0 ? t : -1.0);
+		for (i = 0; i < npts; i++)
+			err = fmax(err, fmax(fabs(l2[i] - line[i]), fabs(s2[i] - sample[i])));
+		if (!(err < 1.0e-3))
+			printf("(pushbroom round trip off by %g pixels)\n", err);
+		delete [] line;
+		delete [] sample;
+		delete [] height;
+		delete [] l2;
+		delete [] s2;
+		delete [] gp;
+		delete sup;
+	}
+
+	// SOCET project keywords, as the exporters look them up
+	{
+		const char *keys[] = {"COORD_SYS", "XY_UNITS", "Z_UNITS", "ELLIPSOID",
+		                      "A_EARTH", "E_EARTH", "GP_ORIGIN_Y", "GP_ORIGIN_X",
+		                      "PROJECTION_TYPE", "POLAR_ASPECT",
+		                      "CENTER_LONGITUDE", "CENTRAL_SCALE_FACTOR",
+		                      "CENTRAL_MERIDIAN", "ZONE"};
+		int nkeys = sizeof(keys) / sizeof(keys[0]);
+		int reps = 200;
+
+		sprintf(path, "%s/bench_mars.prj", work);
+		t = now();
+		for (k = 0; k < reps; k++)
+			for (n = 0; n < nkeys; n++)
+				parse_label(path, (char *) keys[n], value);
+		t = now() - t;
+		report("parse_label (.prj)", (double) file_size(path) * reps * nkeys,
+		       (double) reps * nkeys, "keys", t);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// ISIS machine converters
+	/////////////////////////////////////////////////////////////////////////////
+
+	// every label of a directory of cubes, as isis3world.pl/hi4socet.pl read them
+	{
+		int reps = 200;
+		int nkeys = 6;
+
+		strcpy(args, "Dimensions/Samples,Dimensions/Lines,Pixels/Type,"
+		       "Mapping/Scale,Mapping/MinimumLatitude,Mapping/MaximumLongitude");
+		for (k = 0; k < reps; k++)
+			strcat(args, " bench_cube.cub");
+		t = run_tool(work, tools, "isiskeys", args);
+		report("isiskeys (ISIS3 labels)", (double) label_bytes * reps, (double) reps * nkeys,
+		       "keys", t);
+	}
+	// without, then with, the cube's NULL-span index
+	sprintf(path, "%s/bench_cube.spans", work);
+	sprintf(value, "%s/bench_cube.spans.off", work);
+	rename(path, value);
+	report("isis3arc_dd", (double) sz.dtm_rows * sz.dtm_cols * 4, posts, "pixels",
+	       run_tool(work, tools, "isis3arc_dd", "bench_cube.cub bench_cube.asc -99999"));
+	rename(value, path);
+	report("isis3arc_dd + NULL-span index", (double) sz.dtm_rows * sz.dtm_cols * 4,
+	       posts, "pixels",
+	       run_tool(work, tools, "isis3arc_dd", "bench_cube.cub bench_spans.asc -99999"));
+	report("gpfTies2LatLonHeightCSV_360sys", (double) file_size(gpf),
+	       sz.gpf_points, "points",
+	       run_tool(work, tools, "gpfTies2LatLonHeightCSV_360sys", "bench.gpf"));
+	report("mergeTransformedGPFties", (double) file_size(gpf), sz.gpf_points,
+	       "points", run_tool(work, tools, "mergeTransformedGPFties",
+	                          "bench.gpf bench.csv bench_tfm.gpf"));
+	sprintf(path, "%s/AP10001L.B", work);
+	report("pedr2tab", (double) file_size(path), 20.0 * sz.pedr_frames, "shots",
+	       run_tool(work, tools, "pedr2tab", "AP10001L.B"));
+
+	if (keep)
+		printf("\nInputs, outputs and bench_exporters.log kept in %s\n", work);
+	else {
+		snprintf(args, sizeof(args), "rm -rf '%s'", work);
+		if (system(args) != 0)
+			printf("\ncouldn't remove %s\n", work);
+	}
+	return(0);
+}
+
+/**************  now  ******************************
+*                                                  *
+*  Wall clock seconds                              *
+*                                                  *
+****************************************************/
+static double now()
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return(ts.tv_sec + 1.0e-9 * ts.tv_nsec);
+}
+
+/**************  next_random  **********************
+*                                                  *
+*  xorshift32, so every run sees the same inputs   *
+*                                                  *
+****************************************************/
+static unsigned int next_random()
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 17;
+	random_state ^= random_state << 5;
+	return(random_state);
+}
+
+/**************  dtm_row  **************************
+*                                                  *
+*  One row of synthetic terrain: rolling hills     *
+*  plus noise, with FOM values spread over the     *
+*  correlated/interpolated classes and runs of     *
+*  FOM 1 (no data) of up to a few hundred posts.   *
+*  Like a HiRISE stereo strip, only a diagonal     *
+*  band half the width of the DTM has data; the    *
+*  rest is FOM 0 (outside the overlap)             *
+*                                                  *
+****************************************************/
+static void dtm_row(int y, int rows, int cols, float *elev, unsigned char *fom)
+{
+	static int hole = 0;   // posts left in the current hole
+	unsigned int r;
+	int x, x0, x1;
+
+	x0 = (int) (cols * (0.5 * y / (rows - 1)));
+	x1 = x0 + cols / 2;
+	for (x = 0; x < cols; x++) {
+		r = next_random();
+		elev[x] = (float) (-2500.0 + 300.0 * sin(x * 0.0021) * cos(y * 0.0017) +
+		                   40.0 * sin((x + y) * 0.013) + (r & 0xff) / 64.0);
+		if (hole == 0 && (r >> 8) % 2000 == 0)
+			hole = 1 + (r >> 20) % 300;
+		if (hole > 0) {
+			hole--;
+			fom[x] = 1;
+		}
+		else if ((r >> 24) < 8)
+			fom[x] = 2;                     // interpolated
+		else if ((r >> 24) < 12)
+			fom[x] = 22 + (r >> 8) % 6;     // manually interpolated
+		else
+			fom[x] = 40 + (r >> 8) % 60;    // correlated
+		if (x < x0 || x >= x1)
+			fom[x] = 0;
+	}
+}
+
+/**************  write_project  ********************
+*                                                  *
+*  <work>/<name>.prj and its data directory.       *
+*  Mars is the IAU2000 ellipsoid, the Moon a       *
+*  sphere (so dem2isis3 doesn't resample it)       *
+*                                                  *
+****************************************************/
+static int write_project(char *work, char *name, int mars)
+{
+	char file[FILELEN];
+	FILE *fp;
+
+	sprintf(file, "%s/%s", work, name);
+	mkdir(file, 0755);
+	strcat(file, ".prj");
+	fp = fopen(file, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the output project file: %s!\n", file);
+		return(-1);
+	}
+	fprintf(fp, "PROJECT_NAME %s\n", name);
+	fprintf(fp, "COORD_SYS 1\n");
+	fprintf(fp, "XY_UNITS 3\n");
+	fprintf(fp, "Z_UNITS 1\n");
+	if (mars) {
+		fprintf(fp, "ELLIPSOID Mars2000\n");
+		fprintf(fp, "A_EARTH %.1f\n", MARS_A);
+		fprintf(fp, "E_EARTH %.15f\n", sqrt(1.0 - (MARS_B*MARS_B) / (MARS_A*MARS_A)));
+	}
+	else {
+		fprintf(fp, "ELLIPSOID Moon2000\n");
+		fprintf(fp, "A_EARTH %.1f\n", MOON_R);
+		fprintf(fp, "E_EARTH 0.0\n");
+	}
+	fprintf(fp, "GP_ORIGIN_Y %.15f\n", -5.0 * M_PI / 180.0);
+	fprintf(fp, "GP_ORIGIN_X %.15f\n", 140.0 * M_PI / 180.0);
+	fclose(fp);
+	return(0);
+}
+
+/**************  write_dtm  ************************
+*                                                  *
+*  <dir>/<name>.dth and .dtm of a 1 m geographic   *
+*  DTM with its lower left post at 5S 140E         *
+*                                                  *
+****************************************************/
+static int write_dtm(char *dir, char *name, int rows, int cols, double radius)
+{
+	char file[FILELEN];
+	double lat0 = -5.0 * M_PI / 180.0, lon0 = 140.0 * M_PI / 180.0;
+	double dy = 1.0 / radius, dx = dy / cos(lat0);
+	float *elev = new float [cols];
+	unsigned char *fom = new unsigned char [cols];
+	FILE *fp;
+	int y;
+
+	sprintf(file, "%s/%s.dth", dir, name);
+	fp = fopen(file, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the output DTM header: %s!\n", file);
+		return(-1);
+	}
+	fprintf(fp, "DTM_FORMAT GRID\nNUM_X_POSTS %d\nNUM_Y_POSTS %d\n", cols, rows);
+	fprintf(fp, "X_SPACING %.17g\nY_SPACING %.17g\n", dx, dy);
+	fprintf(fp, "LOWER_LEFT_XYZ %.17g %.17g 0.0\n", lon0, lat0);
+	fprintf(fp, "UPPER_RIGHT_XYZ %.17g %.17g 0.0\n", lon0 + (cols - 1) * dx,
+	        lat0 + (rows - 1) * dy);
+	fclose(fp);
+
+	sprintf(file, "%s/%s.dtm", dir, name);
+	fp = fopen(file, "wb");
+	if (fp == NULL) {
+		printf("\ncan't open the output DTM: %s!\n", file);
+		return(-1);
+	}
+	for (y = 0; y < rows; y++) {
+		dtm_row(y, rows, cols, elev, fom);
+		if (fwrite(elev, sizeof(float), cols, fp) != (size_t) cols ||
+		    fwrite(fom, 1, cols, fp) != (size_t) cols) {
+			printf("\nerror writing the DTM: %s!\n", file);
+			fclose(fp);
+			return(-1);
+		}
+	}
+	fclose(fp);
+	delete [] elev;
+	delete [] fom;
+	return(0);
+}
+
+/**************  write_ortho  **********************
+*                                                  *
+*  <dir>/<name>.sup and .tif (uncompressed, in     *
+*  256x256 tiles) of a 25 cm ortho, with a         *
+*  no-data collar of 0 on the left edge            *
+*                                                  *
+****************************************************/
+static int write_ortho(char *dir, char *name, int lines, int samples,
+                       double radius)
+{
+	char file[FILELEN];
+	char image[FILELEN];
+	double lat0 = -5.0 * M_PI / 180.0, lon0 = 140.0 * M_PI / 180.0;
+	double dy = 0.25 / radius, dx = dy / cos(lat0);
+	const int tile = 256;
+	int across = (samples + tile - 1) / tile, down = (lines + tile - 1) / tile;
+	int width = across * tile;
+	unsigned char *rows = new unsigned char [(size_t) tile * width];
+	unsigned int *offsets = new unsigned int [across * down];
+	unsigned int *counts = new unsigned int [across * down];
+	unsigned short one = 1;
+	unsigned int ifd, data;
+	FILE *fp;
+	int x, y, r, tx, ty, e, collar;
+
+	// classic TIFF offsets are 32 bits
+	if ((double) width * tile * down > 4.0e9) {
+		printf("\northo too large for a TIFF: %d x %d!\n", lines, samples);
+		return(-1);
+	}
+
+	sprintf(image, "%s/%s.tif", dir, name);
+	sprintf(file, "%s/%s.sup", dir, name);
+	fp = fopen(file, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the output support file: %s!\n", file);
+		return(-1);
+	}
+	fprintf(fp, "IMAGE_FILENAME %s.tif\nSENSOR_TYPE ORTHO\n", name);
+	fprintf(fp, "LAT_REF_PT %.17g\nLON_REF_PT %.17g\n", lat0, lon0);
+	fprintf(fp, "INTERLINE_DIST %.17g\nINTERPIXEL_DIST %.17g\n", dy, dx);
+	fclose(fp);
+
+	fp = fopen(image, "wb");
+	if (fp == NULL) {
+		printf("\ncan't open the output ortho image: %s!\n", image);
+		return(-1);
+	}
+
+	// header (IFD offset filled in at the end), then the tiles a tile
+	// row at a time
+	fwrite(*(unsigned char *) &one ? "II*\0" : "MM\0*", 1, 4, fp);
+	ifd = 0;
+	fwrite(&ifd, 4, 1, fp);
+	data = 8;
+	for (ty = 0; ty < down; ty++) {
+		memset(rows, 0, (size_t) tile * width);
+		for (r = 0; r < tile && ty * tile + r < lines; r++) {
+			y = ty * tile + r;
+			collar = (int) ((double) (lines - y) / lines * samples / 8);
+			for (x = 0; x < samples; x++)
+				rows[r * width + x] = (x < collar) ? 0 :
+				         (unsigned char) (1 + ((x / 7 + y / 5) & 0x7f) +
+				                          (next_random() & 0x3f));
+		}
+		for (tx = 0; tx < across; tx++) {
+			offsets[ty * across + tx] = data;
+			counts[ty * across + tx] = tile * tile;
+			for (r = 0; r < tile; r++)
+				fwrite(rows + r * width + tx * tile, 1, tile, fp);
+			data += tile * tile;
+		}
+	}
+
+	// IFD: tags in order, then the tile offset and byte count arrays
+	{
+		unsigned short tags[11] = {256, 257, 258, 259, 262, 277, 284,
+		                           322, 323, 324, 325};
+		unsigned short types[11] = {4, 4, 3, 3, 3, 3, 3, 3, 3, 4, 4};
+		unsigned int values[11] = {(unsigned int) samples, (unsigned int) lines,
+		                           8, 1, 1, 1, 1, (unsigned int) tile,
+		                           (unsigned int) tile, 0, 0};
+		unsigned int ntiles = across * down, n;
+		unsigned short nentries = 11, v16;
+		unsigned int next = 0;
+
+		ifd = data;
+		values[9] = ifd + 2 + 11 * 12 + 4;
+		values[10] = values[9] + 4 * ntiles;
+		if (ntiles == 1) {
+			values[9] = offsets[0];
+			values[10] = counts[0];
+		}
+		fwrite(&nentries, 2, 1, fp);
+		for (e = 0; e < 11; e++) {
+			n = (e >= 9) ? ntiles : 1;
+			fwrite(&tags[e], 2, 1, fp);
+			fwrite(&types[e], 2, 1, fp);
+			fwrite(&n, 4, 1, fp);
+			if (types[e] == 3) {
+				v16 = (unsigned short) values[e];
+				fwrite(&v16, 2, 1, fp);
+				v16 = 0;
+				fwrite(&v16, 2, 1, fp);
+			}
+			else
+				fwrite(&values[e], 4, 1, fp);
+		}
+		fwrite(&next, 4, 1, fp);
+		if (ntiles > 1) {
+			fwrite(offsets, 4, ntiles, fp);
+			fwrite(counts, 4, ntiles, fp);
+		}
+		fseek(fp, 4, SEEK_SET);
+		fwrite(&ifd, 4, 1, fp);
+	}
+	if (ferror(fp)) {
+		printf("\nerror writing the ortho image: %s!\n", image);
+		fclose(fp);
+		return(-1);
+	}
+	fclose(fp);
+	delete [] rows;
+	delete [] offsets;
+	delete [] counts;
+	return(0);
+}
+
+/**************  write_gpf  ************************
+*                                                  *
+*  A SOCET ground point file of tie points (80%    *
+*  on, 10% off) and XYZ control points (10%)       *
+*                                                  *
+****************************************************/
+static int write_gpf(char *file, int points)
+{
+	double lat, lon, ht;
+	unsigned int r;
+	int i, stat, known;
+	FILE *fp;
+
+	fp = fopen(file, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the output gpf: %s!\n", file);
+		return(-1);
+	}
+	fprintf(fp, "GROUND POINT FILE\n%d\n", points);
+	fprintf(fp, "point_id,stat,known,lat_Y_North,long_X_East,ht,sig(3),res(3)\n");
+	for (i = 0; i < points; i++) {
+		r = next_random();
+		stat = (r % 10 != 0);
+		known = (r % 10 == 1) ? 3 : 0;
+		lat = (-5.0 + (r >> 8) % 10000 * 1.0e-5) * M_PI / 180.0;
+		lon = (140.0 + (r >> 4) % 10000 * 1.0e-5) * M_PI / 180.0;
+		ht = -2500.0 + (r >> 16) % 600;
+		fprintf(fp, "P%08d %d %d\n", i, stat, known);
+		fprintf(fp, "%.15f %.15f %.6f\n", lat, lon, ht);
+		fprintf(fp, "%.6f %.6f %.6f\n", 1.0, 1.0, 1.0);
+		fprintf(fp, "%.6f %.6f %.6f\n\n", 0.0, 0.0, 0.0);
+	}
+	fclose(fp);
+	return(0);
+}
+
+/**************  write_pedr  ***********************
+*                                                  *
+*  A PEDR file of 776 byte frames (big-endian, 10  *
+*  label records then the frames, 20 shots each)   *
+*  and the PEDR2TAB.PRM pedr2tab reads from the    *
+*  current directory                               *
+*                                                  *
+****************************************************/
+static void put4(unsigned char *frame, int word, int v)  // pedr(word)
+{
+	unsigned char *p = frame + 4 * (word - 1);
+	p[0] = (v >> 24) & 0xff;  p[1] = (v >> 16) & 0xff;
+	p[2] = (v >> 8) & 0xff;   p[3] = v & 0xff;
+}
+
+static void put2(unsigned char *frame, int half, int v)  // ipdr(half)
+{
+	unsigned char *p = frame + 2 * (half - 1);
+	p[0] = (v >> 8) & 0xff;  p[1] = v & 0xff;
+}
+
+static int write_pedr(char *work, char *file, int frames)
+{
+	unsigned char frame[776];
+	char prm[FILELEN];
+	int i, k, lat, lon;
+	FILE *fp;
+
+	sprintf(prm, "%s/PEDR2TAB.PRM", work);
+	fp = fopen(prm, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the output PEDR2TAB.PRM: %s!\n", prm);
+		return(-1);
+	}
+	// header, 8 output groups, all shots, ground shots, crossovers,
+	// one big file, lon range, lat range, flattening
+	fprintf(fp, "T\nT\nF\nT\nF\nF\nF\nF\nF\nT\nT\nT\nF 'MOLA.TAB'\n");
+	fprintf(fp, "-360.\n360.\n-90.\n90.\n169.8\n");
+	fclose(fp);
+
+	fp = fopen(file, "wb");
+	if (fp == NULL) {
+		printf("\ncan't open the output PEDR: %s!\n", file);
+		return(-1);
+	}
+	memset(frame, ' ', sizeof(frame));
+	sprintf((char *) frame, "CCSD3ZF0000100000001NJPL3IF0PDSX00000001\r\n"
+	        "PDS_VERSION_ID = PDS3\r\nSOFTWARE_NAME = \"SYNTHPED7.130\"\r\n");
+	frame[strlen((char *) frame)] = ' ';
+	fwrite(frame, 1, sizeof(frame), fp);
+	memset(frame, ' ', sizeof(frame));
+	for (i = 1; i < 10; i++)
+		fwrite(frame, 1, sizeof(frame), fp);
+
+	for (i = 0; i < frames; i++) {
+		memset(frame, 0, sizeof(frame));
+		lat = -5000000 + i * 60;
+		lon = 140000000 + i * 7;
+		put4(frame, 1, 600000000 + i);         // time
+		put4(frame, 2, (i * 100000) % 1000000);
+		put4(frame, 3, 10001);                 // rev
+		put4(frame, 4, lat);                   // MGS location
+		put4(frame, 5, lon);
+		put4(frame, 6, 377000000);             // MGS radius, cm
+		for (k = 1; k <= 20; k++) {
+			put4(frame, k + 12, 339000000 + (int) (next_random() % 100000));
+			put4(frame, k + 162, 40000000 + (int) (next_random() % 100000));
+			put2(frame, k + 192, 1);           // ground shot
+			frame[k + 224 - 1] = 1 + (k - 1) % 4;  // channel
+		}
+		put4(frame, 33, 339050000);            // frame planetary radius
+		put4(frame, 85, lat);                  // frame midpoint
+		put4(frame, 86, lon);
+		put4(frame, 154, 339000000);           // areoid
+		put4(frame, 162, 99999000);            // clock
+		put2(frame, 246, 1 + i % 7);           // frame in packet
+		put2(frame, 269, 3);                   // GMM version
+		if (fwrite(frame, 1, sizeof(frame), fp) != sizeof(frame)) {
+			printf("\nerror writing the PEDR: %s!\n", file);
+			fclose(fp);
+			return(-1);
+		}
+	}
+	fclose(fp);
+	return(0);
+}
+
+/**************  write_pushbroom_sup  **************
+*                                                  *
+*  A USGSAstroLineScanner support file (name.sup)  *
+*  of a HiRISE-like image: lines by samples of     *
+*  0.3 m pixels from a north going, nadir pointed  *
+*  290 km circular orbit over lon 0 lat 22.  The   *
+*  ephemeris and quaternions are every 0.04 s      *
+*                                                  *
+****************************************************/
+static int write_pushbroom_sup(char *dir, char *name, int lines, int samples)
+{
+	char file[FILELEN];
+	double r = MARS_A + 290000.0;      // orbit radius, m
+	double w = 3400.0 / r;             // rad/s
+	double e = sqrt(1.0 - (MARS_B * MARS_B) / (MARS_A * MARS_A));
+	double px = 0.012, focal = 12000.0;  // mm
+	double int_time = 290000.0 * px / focal / (w * MARS_A);
+	double dt = 0.04, t0, lat, s, c, q[4];
+	int i, n;
+	FILE *fp;
+
+	sprintf(file, "%s/%s.sup", dir, name);
+	fp = fopen(file, "w");
+	if (fp == NULL)
+		return(-1);
+
+	t0 = -(0.5 * lines * int_time + 1.0);
+	n = (int) (-2.0 * t0 / dt) + 2;
+	fprintf(fp, "IMAGE_FILENAME %s.cub\n", name);
+	fprintf(fp, "SENSOR_TYPE USGSAstroLineScanner\n");
+	fprintf(fp, "TOTAL_LINES %d\nTOTAL_SAMPLES %d\n", lines, samples);
+	fprintf(fp, "INT_TIME %.12e\nT_CENTER 0.0\n", int_time);
+	fprintf(fp, "FOCAL %.1f\nISIS_Z_DIRECTION 1.0\n", focal);
+	fprintf(fp, "OPTICAL_DIST_COEF 0.0 0.0 0.0\n");
+	fprintf(fp, "ITRANSS 0.0 0.0 %.6f\n", 1.0 / px);
+	fprintf(fp, "ITRANSL 0.0 %.6f 0.0\n", 1.0 / px);
+	fprintf(fp, "DETECTOR_SAMPLE_ORIGIN %.1f\n", 0.5 * samples + 0.5);
+	fprintf(fp, "DETECTOR_LINE_ORIGIN 0.0\nDETECTOR_LINE_OFFSET 0.0\n");
+	fprintf(fp, "DETECTOR_SAMPLE_SUMMING 1.0\nSTARTING_SAMPLE 1.0\n");
+	fprintf(fp, "MOUNTING_ANGLES 0.0 0.0 0.0\n");
+	fprintf(fp, "SEMI_MAJOR_AXIS %.1f\nECCENTRICITY %.12f\n", MARS_A, e);
+
+	fprintf(fp, "T0_EPHEM %.12e\nDT_EPHEM %.3f\nNUMBER_OF_EPHEM %d\nEPHEM_PTS\n",
+	        t0, dt, n);
+	for (i = 0; i < n; i++) {
+		lat = 22.0 * M_PI / 180.0 + w * (t0 + i * dt);
+		fprintf(fp, "%.6f 0.0 %.6f\n", r * cos(lat), r * sin(lat));
+	}
+
+	// camera x north, y east, z down: the camera to body matrix is
+	// (-s 0 -c, 0 1 0, c 0 -s), as x y z w
+	fprintf(fp, "T0_QUAT %.12e\nDT_QUAT %.3f\nNUMBER_OF_QUATERNIONS %d\nQUATERNIONS\n",
+	        t0, dt, n);
+	for (i = 0; i < n; i++) {
+		lat = 22.0 * M_PI / 180.0 + w * (t0 + i * dt);
+		s = sin(lat);
+		c = cos(lat);
+		q[3] = 0.5 * sqrt(2.0 - 2.0 * s);
+		q[0] = 0.0;
+		q[1] = (-c - c) / (4.0 * q[3]);
+		q[2] = 0.0;
+		fprintf(fp, "%.15f %.15f %.15f %.15f\n", q[0], q[1], q[2], q[3]);
+	}
+	fclose(fp);
+	return(0);
+}
+
+/**************  write_cube  ***********************
+*                                                  *
+*  A BandSequential Real ISIS3 cube (Lsb, 64 KB    *
+*  label) of the synthetic terrain, NULL where     *
+*  the FOM is < 2.  label_bytes is the length of   *
+*  the label text                                  *
+*                                                  *
+****************************************************/
+static int write_cube(char *file, int lines, int samples, int *label_bytes)
+{
+	char label[65536];
+	double scale = MARS_A * M_PI / 180.0;   // 1 m pixels
+	float *elev = new float [samples];
+	unsigned char *fom = new unsigned char [samples];
+	union { unsigned int i; float f; } null4;
+	char spanFile[FILELEN];
+	span_index *spans;
+	FILE *fp;
+	int x, y, n;
+
+	null4.i = ISIS_NULL4;
+	memset(label, ' ', sizeof(label));
+	n = sprintf(label,
+	            "Object = IsisCube\n"
+	            "  Object = Core\n"
+	            "    StartByte   = 65537\n"
+	            "    Format      = BandSequential\n\n"
+	            "    Group = Dimensions\n"
+	            "      Samples = %d\n"
+	            "      Lines   = %d\n"
+	            "      Bands   = 1\n"
+	            "    End_Group\n\n"
+	            "    Group = Pixels\n"
+	            "      Type       = Real\n"
+	            "      ByteOrder  = Lsb\n"
+	            "      Base       = 0.0\n"
+	            "      Multiplier = 1.0\n"
+	            "    End_Group\n"
+	            "  End_Object\n\n"
+	            "  Group = Mapping\n"
+	            "    ProjectionName     = SimpleCylindrical\n"
+	            "    CenterLongitude    = 140.0 <degrees>\n"
+	            "    TargetName         = Mars\n"
+	            "    EquatorialRadius   = %.1f <meters>\n"
+	            "    PolarRadius        = %.1f <meters>\n"
+	            "    LatitudeType       = Planetocentric\n"
+	            "    LongitudeDirection = PositiveEast\n"
+	            "    LongitudeDomain    = 360\n"
+	            "    MinimumLatitude    = %.10f <degrees>\n"
+	            "    MaximumLatitude    = %.10f <degrees>\n"
+	            "    MinimumLongitude   = 140.0 <degrees>\n"
+	            "    MaximumLongitude   = %.10f <degrees>\n"
+	            "    PixelResolution    = 1.0 <meters/pixel>\n"
+	            "    Scale              = %.6f <pixels/degree>\n"
+	            "  End_Group\n"
+	            "End_Object\n"
+	            "End\n",
+	            samples, lines, MARS_A, MARS_B, -5.0, -5.0 + lines / scale,
+	            140.0 + samples / scale, scale);
+	label[n] = ' ';
+	*label_bytes = n;
+
+	fp = fopen(file, "wb");
+	if (fp == NULL) {
+		printf("\ncan't open the output cube: %s!\n", file);
+		return(-1);
+	}
+	// and its NULL-span index, as dem2isis3 writes for SS_ cubes
+	strcpy(spanFile, file);
+	strcpy(strrchr(spanFile, '.'), ".spans");
+	spans = open_span_index(spanFile, lines, samples);
+	if (spans == NULL)
+		return(-1);
+	fwrite(label, 1, sizeof(label), fp);
+	for (y = 0; y < lines; y++) {
+		dtm_row(y, lines, samples, elev, fom);
+		for (x = 0; x < samples; x++)
+			if (fom[x] < 2)
+				elev[x] = null4.f;
+		if (fwrite(elev, sizeof(float), samples, fp) != (size_t) samples ||
+		    add_span_row(spans, elev) != 0) {
+			printf("\nerror writing the cube: %s!\n", file);
+			fclose(fp);
+			return(-1);
+		}
+	}
+	fclose(fp);
+	if (close_span_index(spans) != 0)
+		return(-1);
+	delete [] elev;
+	delete [] fom;
+	return(0);
+}
+
+static long long file_size(char *file)
+{
+	struct stat st;
+
+	if (stat(file, &st) != 0)
+		return(0);
+	return((long long) st.st_size);
+}
+
+/**************  report  ***************************
+*                                                  *
+*  One line of the results table.  A negative      *
+*  time is a case that failed or was skipped       *
+*                                                  *
+****************************************************/
+static void report(const char *name, double bytes, double points,
+                   const char *unit, double seconds)
+{
+	char count[64];
+
+	sprintf(count, "%.0f %s", points, unit);
+	if (seconds == -1.0)
+		printf("%-34s %9.1f %16s   FAILED (see bench_exporters.log)\n", name,
+		       bytes / MB, count);
+	else if (seconds < 0.0)
+		printf("%-34s %9.1f %16s   skipped (not in the tools directory)\n",
+		       name, bytes / MB, count);
+	else
+		printf("%-34s %9.1f %16s %9.3f %10.1f %14.0f\n", name, bytes / MB, count,
+		       seconds, bytes / MB / seconds, points / seconds);
+	fflush(stdout);
+}
+
+/**************  run_export  ***********************
+*                                                  *
+*  Runs an exporter's main in a child process in   *
+*  the work directory (the exporters exit() on     *
+*  errors and write to the current directory),     *
+*  output appended to bench_exporters.log.         *
+*  Returns the elapsed seconds or -1 on failure    *
+*                                                  *
+****************************************************/
+static double run_export(char *work, int (*export_main)(int, char **),
+                         int argc, const char **argv)
+{
+	char log[FILELEN];
+	char *av[16];
+	double t;
+	pid_t pid;
+	int i, status;
+
+	sprintf(log, "%s/bench_exporters.log", work);
+	fflush(stdout);
+	t = now();
+	pid = fork();
+	if (pid == 0) {
+		if (chdir(work) != 0 || freopen(log, "a", stdout) == NULL ||
+		    freopen(log, "a", stderr) == NULL)
+			_exit(1);
+		for (i = 0; i < argc; i++)
+			av[i] = strdup(argv[i]);
+		av[argc] = NULL;
+		i = export_main(argc, av);
+		fflush(stdout);
+		fflush(stderr);
+		_exit(i);
+	}
+	if (pid < 0 || waitpid(pid, &status, 0) != pid ||
+	    !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		return(-1.0);
+	return(now() - t);
+}
+
+/**************  run_tool  *************************
+*                                                  *
+*  Runs <tools>/<tool> <args> in the work          *
+*  directory.  Returns the elapsed seconds, -1 on  *
+*  failure or -2 if the tool isn't built           *
+*                                                  *
+****************************************************/
+static double run_tool(char *work, char *tools, const char *tool,
+                       const char *args)
+{
+	char exe[FILELEN];
+	char *command;
+	double t;
+	int status;
+
+	snprintf(exe, FILELEN, "%s/%s", tools, tool);
+	if (access(exe, X_OK) != 0)
+		return(-2.0);
+
+	command = new char [strlen(args) + 3*FILELEN];
+	sprintf(command, "cd '%s' && '%s' %s >> bench_exporters.log 2>&1", work, exe,
+	        args);
+	fflush(stdout);
+	t = now();
+	status = system(command);
+	t = now() - t;
+	delete [] command;
+	if (status != 0)
+		return(-1.0);
+	return(t);
+}
@@ -7,14 +7,28 @@
 //       This boundary is then used in orthophotogeneration to get 1:1
 //       pixel correspondence between the orthoimage and the DEM. 
 //
+//       With the -footprint option, the FOM of the DEM is also read row by
+//       row and the outline of its valid (FOM >= 2) posts is traced with a
+//       marching squares boundary follower.  Oblique stereo pairs cover only
+//       a parallelogram-like part of the DEM rectangle, so this footprint is
+//       what should be used to clip orthos and plan mosaics.  The outline is
+//       written in project coordinates and as WKT and GeoJSON.
+//
 //       Input parameters are:
 //
 //              SS_project
 //              socet_dem
+//              -footprint (optional)
 //
 //       Output files are:
 //
-//              <project_data_dir>/calcOrthoBdry.log
+//              <project_data_dir>/calcOrthoBdry_<dem>.log
+//
+//       and with -footprint:
+//
+//              <project_data_dir>/<dem>_footprint.txt
+//              <project_data_dir>/<dem>_footprint.wkt
+//              <project_data_dir>/<dem>_footprint.geojson
 //
 //_Hist	May 18 2007 Elpitha H. Kraus, USGS, Flagstaff Original Version
 //      Jun 18 2007 EHK - corrected formatted output error when reporting
@@ -28,6 +42,10 @@
 //                        in Windows, and not necessary under Solaris)
 //      Nov 04 2008 EHK - Changed log file from print.prt to calcOrthoBdry.log
 //      Oct 14 2010 EHK - Changed log file from calcOrthoBdry.log to calcOrthoBdry_<dem>.log
+//      Oct 18 2026 - Added -footprint option to trace the valid-data
+//                    boundary of the DEM from its FOM
+//      Oct 19 2026 - FOM values of 128 and up count as valid in the
+//                    footprint mask, as in the exported DEM
 //_End
 //
 ////////////////////////////////////////////////////////////////////////////////
@@ -43,6 +61,7 @@
 #include <key/handle_key.h>
 #include <dtm/dtm.h>
 #include <dtmUtil/dtm_util.h>
+#include <dtmAccess/DtmGrid.h>
 #include <dtmAccess/DtmHeader.h>
 #include <dtmAccess/dtm_edit_util.h>
 #include <dtmAccess/fom_defs.h>
@@ -59,12 +78,38 @@
 #define NO_ERRS 0
 #define PARINV_ERR -1
 
+// Footprint tracing
+#define MIN_FOOTPRINT_POSTS 100  // smaller islands of valid posts are ignored
+#define FOOTPRINT_TOLERANCE 1.0  // outline simplification tolerance, posts
+
 // prototypes
 int stripp(char instr[], char outstr[], int position);
 int parse_label(char *file, char *keyword, char *value);
 int writeToLog(char *msg, char *logfile);
 int writeReport(char *msg, char *logfile);
 
+// One closed outline of the valid-data footprint; vertices are DEM post
+// corners (column, row from the top), the first vertex is not repeated
+struct footprint_ring {
+   int     npts;
+   double  *x;
+   double  *y;
+   double  area;       // area in posts
+};
+
+unsigned char *loadValidMask(DtmGrid *di, int ncols, int nrows, int rowbytes,
+                             double *nvalid);
+double traceRing(unsigned char *mask, unsigned char *visited, int ncols,
+                 int nrows, int rowbytes, int sx, int sy,
+                 struct footprint_ring *ring);
+int simplifyRing(double *x, double *y, int npts, double tol);
+int traceFootprint(DtmGrid *di, int ncols, int nrows,
+                   struct footprint_ring **rings, double *nvalid);
+int writeFootprint(char *basename, struct footprint_ring *rings, int nrings,
+                   int coord_sys, ground_point_struct ll_corner,
+                   ground_point_struct ur_corner, double x_realspacing,
+                   double y_realspacing, char *logfile);
+
 void main(int argc,char *argv[]) 
 {
    // DECLARATIONS:
@@ -78,8 +123,13 @@ void main(int argc,char *argv[])
    char logfile[FILELEN];
    char logfileName[FILELEN];
 
+   int  footprint_flag;
+
    // DEM Header Variables
+   DtmGrid* di;
    DtmHeader* di_header;
+   int demReadErr;
+   int ncols, nrows;
    double x_realspacing, y_realspacing; //real spacing of a DEM, in project coordinates
    ground_point_struct ll_corner; 
    ground_point_struct ur_corner; 
@@ -99,25 +149,36 @@ void main(int argc,char *argv[])
    ground_point_struct ortho_ll, ortho_ur;
    char DMS[20];
 
+   // Footprint variables
+   struct footprint_ring *rings;
+   int nrings;
+   double nvalid, footprint_area;
+   char footprintName[FILELEN];
+
   /////////////////////////////////////////////////////////////////////////////
   // Check number of command line args and issue help if needed
   // Otherwise initiate the socet set application
   /////////////////////////////////////////////////////////////////////////////
 
-   if (argc!=3) {
+   footprint_flag = (argc == 4 && strcmp(argv[3],"-footprint") == 0);
+
+   if (argc != 3 && !footprint_flag) {
     //cerr << "\nRun " << argv[0] << " as follows:\n\n";
     //cerr << "start_socet -single " << argv[0] << " <project> <DEM>\n";
     cerr << "\nRun calcOrthoBdry as follows:\n\n";
-    cerr << "start_socet -single calcOrthoBdry <project> <DEM>\n";
+    cerr << "start_socet -single calcOrthoBdry <project> <DEM> [-footprint]\n";
     cerr << "\nwhere:\n";
     cerr << "project = SOCET SET project name\n";
     cerr << "          (path and extension is not required)\n";
     cerr << "DEM = SOCET SET DEM to be used for Orthophoto Generation\n";
     cerr << "      (path and extension is not required)\n";
+    cerr << "-footprint = also trace the outline of the valid (FOM >= 2) DEM posts\n";
     cerr << "\ncalcOrthoBdry will output:\n";
     cerr << "           Upperleft and Lower Right coordinates to be used in Orthophoto Generation.\n";
     cerr << "           Coordinates will be written to the screen and appended to logfile:\n";
     cerr << "           <project_data_path>/calcOrthoBdry_<DEM>.log.\n";
+    cerr << "           With -footprint, the valid-data outline is written to\n";
+    cerr << "           <project_data_path>/<DEM>_footprint.txt|.wkt|.geojson\n";
     exit(1);
    }
 
@@ -193,8 +254,12 @@ void main(int argc,char *argv[])
   build_file_name(logfile, project.project_data_path, logfileName, ".log");
 
    //output calcOrthoBdry command that was issued to calcOrthoBdry.log file
-   sprintf(msg,"start_socet -single %s %s %s",
-      argv[0],argv[1],argv[2]);
+   if (footprint_flag)
+     sprintf(msg,"start_socet -single %s %s %s %s",
+        argv[0],argv[1],argv[2],argv[3]);
+   else
+     sprintf(msg,"start_socet -single %s %s %s",
+        argv[0],argv[1],argv[2]);
    writeToLog(msg, logfile);
   
   /////////////////////////////////////////////////////////////////////////////
@@ -277,9 +342,427 @@ void main(int argc,char *argv[])
      writeReport(msg, logfile);
    } 
 
+   if (!footprint_flag)
+     return;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Trace the valid-data footprint from the DEM's FOM
+  /////////////////////////////////////////////////////////////////////////////
+
+   di = new DtmGrid(di_header);
+   if (demReadErr = di->openDtm(fname, FALSE, O_RDONLY, FALSE, FALSE)) {
+      cerr << "DEM READ ERROR #" << demReadErr << " reading DEM file.\n";
+      exit(-1);
+   }
+
+   ncols = di_header->numXPosts();
+   nrows = di_header->numYPosts();
+
+   nrings = traceFootprint(di, ncols, nrows, &rings, &nvalid);
+
+   if (nrings == 0) {
+     sprintf(msg,"\nFootprint: DEM has no valid posts");
+     writeReport(msg, logfile);
+     return;
+   }
+
+   footprint_area = 0.0;
+   for (i=0; i<nrings; i++)
+     footprint_area += rings[i].area;
+
+   sprintf(msg,"\nFootprint: %d outline(s), %.0lf of %.0lf posts valid",
+           nrings, nvalid, (double)ncols*nrows);
+   writeReport(msg, logfile);
+   sprintf(msg,"Footprint: outline area is %.1lf%% of the DEM rectangle",
+           100.0*footprint_area/((double)ncols*nrows));
+   writeReport(msg, logfile);
+
+   strcpy(footprintName,demName);
+   strcat(footprintName,"_footprint");
+   build_file_name(fname, project.project_data_path, footprintName, "");
+
+   writeFootprint(fname, rings, nrings, coord_sys, ll_corner, ur_corner,
+                  x_realspacing, y_realspacing, logfile);
+
+   for (i=0; i<nrings; i++) {
+     free(rings[i].x);
+     free(rings[i].y);
+   }
+   free(rings);
+
 } // END MAIN
 
 
+/**************  loadValidMask  ********************
+*                                                  *
+*  Reads the DEM FOM one row at a time and packs   *
+*  a bit per post, set where the post is valid     *
+*  (FOM >= 2).  Mask row 0 is the top (north) row  *
+*  of the DEM.                                     *
+*                                                  *
+****************************************************/
+unsigned char *loadValidMask(DtmGrid *di, int ncols, int nrows, int rowbytes,
+                             double *nvalid)
+{
+   unsigned char *mask, *mrow;
+   char *fom_buf;
+   int index_y, i;
+
+   mask = (unsigned char *) calloc((size_t)rowbytes*nrows, 1);
+   fom_buf = new char [ncols];
+   if (mask == NULL) {
+      printf("\ncan't allocate %d x %d footprint mask!\n", ncols, nrows);
+      exit(1);
+   }
+
+   *nvalid = 0.0;
+   for (index_y = nrows - 1; index_y >= 0; index_y--) {
+      di->getFomBlock(0, index_y, ncols - 1, index_y, fom_buf);
+      mrow = mask + (size_t)(nrows - 1 - index_y)*rowbytes;
+      for (i = 0; i < ncols; i++) {
+         if ((unsigned char) fom_buf[i] >= 2) {
+            mrow[i >> 3] |= (unsigned char)(1 << (i & 7));
+            *nvalid += 1.0;
+         }
+      }
+   }
+
+   delete [] fom_buf;
+   return mask;
+
+} // End of loadValidMask
+
+// Valid post test for the marching squares tracer (outside the DEM is invalid)
+#define POST_VALID(m,rb,nc,nr,x,y) \
+   ((x) >= 0 && (y) >= 0 && (x) < (nc) && (y) < (nr) && \
+    ((m)[(size_t)(y)*(rb) + ((x) >> 3)] & (1 << ((x) & 7))))
+
+enum { MOVE_UP, MOVE_RIGHT, MOVE_DOWN, MOVE_LEFT };
+
+/**************  traceRing  ************************
+*                                                  *
+*  Marching squares boundary follower.  Walks the  *
+*  post corners from corner (sx,sy+1) upward along *
+*  the left edge of valid post (sx,sy), keeping    *
+*  valid posts on the right, until it returns to   *
+*  the start.  Diagonal neighbours are treated as  *
+*  connected.  Every upward edge walked is marked  *
+*  in visited so no outline is traced twice.       *
+*  Only corners where the direction changes are    *
+*  stored.  Returns the signed area in posts:      *
+*  positive for outer outlines, negative for       *
+*  holes.                                          *
+*                                                  *
+****************************************************/
+double traceRing(unsigned char *mask, unsigned char *visited, int ncols,
+                 int nrows, int rowbytes, int sx, int sy,
+                 struct footprint_ring *ring)
+{
+   int cx, cy, dir, newdir;
+   int a, b, c, d;
+   int maxpts;
+   double area;
+
+   ring->npts = 0;
+   maxpts = 1024;
+   ring->x = (double *) malloc(maxpts*sizeof(double));
+   ring->y = (double *) malloc(maxpts*sizeof(double));
+
+   cx = sx;
+   cy = sy + 1;
+   dir = MOVE_UP;
+   area = 0.0;
+
+   do {
+      // step along current direction, accumulating the shoelace sum
+      // x0*y1 - x1*y0 of the step
+      switch (dir) {
+         case MOVE_UP:
+            visited[(size_t)(cy-1)*rowbytes + (cx >> 3)] |= (unsigned char)(1 << (cx & 7));
+            area -= (double) cx;
+            cy--;
+            break;
+         case MOVE_DOWN:
+            area += (double) cx;
+            cy++;
+            break;
+         case MOVE_RIGHT:
+            area -= (double) cy;
+            cx++;
+            break;
+         case MOVE_LEFT:
+            area += (double) cy;
+            cx--;
+            break;
+      }
+
+      // the four posts around corner (cx,cy)
+      a = POST_VALID(mask,rowbytes,ncols,nrows,cx-1,cy-1) != 0;
+      b = POST_VALID(mask,rowbytes,ncols,nrows,cx,  cy-1) != 0;
+      c = POST_VALID(mask,rowbytes,ncols,nrows,cx-1,cy  ) != 0;
+      d = POST_VALID(mask,rowbytes,ncols,nrows,cx,  cy  ) != 0;
+
+      if (a && d && !b && !c)        // saddle, turn left to stay connected
+         newdir = (dir == MOVE_DOWN) ? MOVE_RIGHT : MOVE_LEFT;
+      else if (b && c && !a && !d)   // saddle, turn left to stay connected
+         newdir = (dir == MOVE_RIGHT) ? MOVE_UP : MOVE_DOWN;
+      else if (b && !a)
+         newdir = MOVE_UP;
+      else if (d && !b)
+         newdir = MOVE_RIGHT;
+      else if (c && !d)
+         newdir = MOVE_DOWN;
+      else
+         newdir = MOVE_LEFT;
+
+      if (newdir != dir) {
+         if (ring->npts == maxpts) {
+            maxpts *= 2;
+            ring->x = (double *) realloc(ring->x, maxpts*sizeof(double));
+            ring->y = (double *) realloc(ring->y, maxpts*sizeof(double));
+         }
+         ring->x[ring->npts] = cx;
+         ring->y[ring->npts] = cy;
+         ring->npts++;
+         dir = newdir;
+      }
+
+   } while (cx != sx || cy != sy + 1 || dir != MOVE_UP);
+
+   ring->area = area / 2.0;
+   return ring->area;
+
+} // End of traceRing
+
+/**************  simplifyRing  *********************
+*                                                  *
+*  Douglas-Peucker simplification of a closed      *
+*  ring, in place.  The ring is split at vertex 0  *
+*  and the vertex farthest from it; each half is   *
+*  simplified with an explicit stack.  Returns the *
+*  new number of vertices.                         *
+*                                                  *
+****************************************************/
+int simplifyRing(double *x, double *y, int npts, double tol)
+{
+   char *keep;
+   int *stack;
+   int nstack, first, last, far, i, n;
+   double dx, dy, len, dist, maxdist;
+
+   if (npts <= 4)
+      return npts;
+
+   keep = (char *) calloc(npts + 1, 1);
+   stack = (int *) malloc(2*(npts + 1)*sizeof(int));
+
+   // farthest vertex from vertex 0 splits the ring in two chains
+   far = 0;
+   maxdist = -1.0;
+   for (i = 1; i < npts; i++) {
+      dist = (x[i]-x[0])*(x[i]-x[0]) + (y[i]-y[0])*(y[i]-y[0]);
+      if (dist > maxdist) { maxdist = dist; far = i; }
+   }
+
+   keep[0] = keep[far] = keep[npts] = 1;
+   nstack = 0;
+   stack[nstack++] = 0;   stack[nstack++] = far;
+   stack[nstack++] = far; stack[nstack++] = npts;   // index npts == vertex 0
+
+   while (nstack > 0) {
+      last = stack[--nstack];
+      first = stack[--nstack];
+      if (last - first < 2)
+         continue;
+
+      dx = x[last % npts] - x[first];
+      dy = y[last % npts] - y[first];
+      len = sqrt(dx*dx + dy*dy);
+
+      maxdist = -1.0;
+      for (i = first + 1; i < last; i++) {
+         if (len > 0.0)
+            dist = fabs(dy*(x[i]-x[first]) - dx*(y[i]-y[first])) / len;
+         else
+            dist = sqrt((x[i]-x[first])*(x[i]-x[first]) +
+                        (y[i]-y[first])*(y[i]-y[first]));
+         if (dist > maxdist) { maxdist = dist; far = i; }
+      }
+
+      if (maxdist > tol) {
+         keep[far] = 1;
+         stack[nstack++] = first; stack[nstack++] = far;
+         stack[nstack++] = far;   stack[nstack++] = last;
+      }
+   }
+
+   n = 0;
+   for (i = 0; i < npts; i++) {
+      if (keep[i]) {
+         x[n] = x[i];
+         y[n] = y[i];
+         n++;
+      }
+   }
+
+   free(keep);
+   free(stack);
+   return n;
+
+} // End of simplifyRing
+
+/**************  traceFootprint  *******************
+*                                                  *
+*  Builds the valid post mask of the DEM and       *
+*  traces every outline in it.  Outer outlines     *
+*  enclosing at least MIN_FOOTPRINT_POSTS are      *
+*  kept and simplified; holes and small islands    *
+*  are dropped.  Returns the number of outlines.   *
+*                                                  *
+****************************************************/
+int traceFootprint(DtmGrid *di, int ncols, int nrows,
+                   struct footprint_ring **rings, double *nvalid)
+{
+   unsigned char *mask, *visited;
+   int rowbytes, nrings, maxrings, x, y;
+   struct footprint_ring ring;
+   double area;
+
+   rowbytes = (ncols + 7) / 8;
+
+   cout << "Reading FOM for footprint...\n";
+   mask = loadValidMask(di, ncols, nrows, rowbytes, nvalid);
+   visited = (unsigned char *) calloc((size_t)rowbytes*nrows, 1);
+   if (visited == NULL) {
+      printf("\ncan't allocate %d x %d footprint mask!\n", ncols, nrows);
+      exit(1);
+   }
+
+   nrings = 0;
+   maxrings = 16;
+   *rings = (struct footprint_ring *) malloc(maxrings*sizeof(struct footprint_ring));
+
+   cout << "Tracing footprint...\n";
+   for (y = 0; y < nrows; y++) {
+      for (x = 0; x < ncols; x++) {
+         // a valid post with an invalid post to its left starts an outline,
+         // unless that edge was already walked
+         if (!POST_VALID(mask,rowbytes,ncols,nrows,x,y) ||
+             POST_VALID(mask,rowbytes,ncols,nrows,x-1,y) ||
+             (visited[(size_t)y*rowbytes + (x >> 3)] & (1 << (x & 7))))
+            continue;
+
+         area = traceRing(mask, visited, ncols, nrows, rowbytes, x, y, &ring);
+
+         if (area < MIN_FOOTPRINT_POSTS) {   // hole or small island
+            free(ring.x);
+            free(ring.y);
+            continue;
+         }
+
+         ring.npts = simplifyRing(ring.x, ring.y, ring.npts, FOOTPRINT_TOLERANCE);
+
+         if (nrings == maxrings) {
+            maxrings *= 2;
+            *rings = (struct footprint_ring *) realloc(*rings,
+                               maxrings*sizeof(struct footprint_ring));
+         }
+         (*rings)[nrings++] = ring;
+      }
+   }
+
+   free(mask);
+   free(visited);
+
+   return nrings;
+
+} // End of traceFootprint
+
+/**************  writeFootprint  *******************
+*                                                  *
+*  Converts the outline post corners to project    *
+*  coordinates and writes them as a vertex list    *
+*  (<base>.txt, project units), WKT (<base>.wkt)   *
+*  and GeoJSON (<base>.geojson).  WKT and GeoJSON  *
+*  are in degrees for geographic projects, else in *
+*  project meters.  Outer outlines are written     *
+*  counterclockwise.                               *
+*                                                  *
+****************************************************/
+int writeFootprint(char *basename, struct footprint_ring *rings, int nrings,
+                   int coord_sys, ground_point_struct ll_corner,
+                   ground_point_struct ur_corner, double x_realspacing,
+                   double y_realspacing, char *logfile)
+{
+   char txtFile[FILELEN], wktFile[FILELEN], jsonFile[FILELEN];
+   char msg[FILELEN];
+   FILE *txtfp, *wktfp, *jsonfp;
+   double X, Y, scale;
+   int r, i, j;
+
+   strcpy(txtFile, concat(basename, ".txt"));
+   strcpy(wktFile, concat(basename, ".wkt"));
+   strcpy(jsonFile, concat(basename, ".geojson"));
+
+   txtfp = fopen(txtFile, "w");
+   wktfp = fopen(wktFile, "w");
+   jsonfp = fopen(jsonFile, "w");
+   if (txtfp == NULL || wktfp == NULL || jsonfp == NULL) {
+      printf("\ncan't open footprint output files %s.*!\n", basename);
+      exit(1);
+   }
+
+   // radians to degrees for geographic projects
+   scale = (coord_sys == 1) ? 180.0 / M_PI : 1.0;
+
+   fprintf(txtfp, "# %d outline(s), project coordinates (%s)\n", nrings,
+           (coord_sys == 1) ? "radians" : "meters");
+   fprintf(wktfp, "MULTIPOLYGON (");
+   fprintf(jsonfp, "{\"type\": \"Feature\", \"properties\": {}, ");
+   fprintf(jsonfp, "\"geometry\": {\"type\": \"MultiPolygon\", \"coordinates\": [");
+
+   for (r = 0; r < nrings; r++) {
+      fprintf(txtfp, "OUTLINE %d %d\n", r+1, rings[r].npts + 1);
+      fprintf(wktfp, "%s((", (r > 0) ? ", " : "");
+      fprintf(jsonfp, "%s[[", (r > 0) ? ", " : "");
+
+      // Post corners are half a spacing from the posts; post 0 of the top
+      // row is at (LL X, UR Y).  Walk back to front so that outer outlines
+      // run counterclockwise in project coordinates (Y up)
+      for (j = 0; j <= rings[r].npts; j++) {
+         i = (rings[r].npts - j) % rings[r].npts;
+         X = ll_corner.x + (rings[r].x[i] - 0.5) * x_realspacing;
+         Y = ur_corner.y - (rings[r].y[i] - 0.5) * y_realspacing;
+
+         fprintf(txtfp, "%.12lf %.12lf\n", X, Y);
+         fprintf(wktfp, "%s%.10lf %.10lf", (j > 0) ? ", " : "",
+                 X*scale, Y*scale);
+         fprintf(jsonfp, "%s[%.10lf, %.10lf]", (j > 0) ? ", " : "",
+                 X*scale, Y*scale);
+      }
+
+      fprintf(wktfp, "))");
+      fprintf(jsonfp, "]]");
+   }
+
+   fprintf(wktfp, ")\n");
+   fprintf(jsonfp, "]}}\n");
+
+   fclose(txtfp);
+   fclose(wktfp);
+   fclose(jsonfp);
+
+   sprintf(msg, "Footprint written to %s", txtFile);
+   writeReport(msg, logfile);
+   sprintf(msg, "                     %s", wktFile);
+   writeReport(msg, logfile);
+   sprintf(msg, "                     %s", jsonFile);
+   writeReport(msg, logfile);
+
+   return (0);
+
+} // End of writeFootprint
+
 //*****************************************************************************
 //*****************************************************************************
 
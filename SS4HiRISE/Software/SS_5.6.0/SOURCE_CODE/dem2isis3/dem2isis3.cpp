@@ -19,6 +19,9 @@
 //              socet_dem.dth
 //              isis_dem.cub
 //              layout_flag
+//              confidence_lut (optional, - for the default)
+//              fom_mask (optional, - for none)
+//              terrain (optional: y, or an odd roughness window size)
 //
 //
 //       Output files are:
@@ -27,7 +30,71 @@
 //              ./FOM_isis_dem.raw (FOM filename auto created by either:
 //                                  1) replace DEM with FOM in <isis_dem>, if "DEM" string exists, or
 //                                  2) adding FOM prefix t<isis_dem> if "DEM" string does not exist
+//              ./CONF_isis_dem.raw (LMMP confidence, named like the FOM file with CONF for FOM)
+//              ./isis_dem_standard.raw, ./FOM_isis_dem_standard.raw,
+//              ./CONF_isis_dem_standard.raw (geographic projects of
+//                                  ellipsoidal bodies only, see below)
 //              ./isis_dem2isis3.sh
+//              ./isis_dem_stats.json
+//              ./SS_isis_dem_mask.raw (with fom_mask only)
+//              ./SS_isis_dem.spans (NULL-span index of SS_isis_dem.cub;
+//                                  isis_dem.spans when there is no SS_ cube)
+//              ./SS_isis_dem_slope.raw, ./SS_isis_dem_aspect.raw,
+//              ./SS_isis_dem_hillshade.raw, ./SS_isis_dem_roughness.raw
+//                                 (with terrain only)
+//
+//       While the DEM is streamed to the raw files, elevation statistics
+//       (min/max/mean/standard deviation and a fixed-width histogram) of
+//       the valid posts and per-FOM/per-LMMP confidence class counts are
+//       accumulated, so no second read of the DEM is needed to get them.
+//       They are written to isis_dem_stats.json, and the script adds them
+//       to the DEM and FOM cube labels as groups SS2ISIS_DEM_STATISTICS and
+//       SS2ISIS_FOM_STATISTICS.  (The statistics are of the native SOCET
+//       posts, not of the resampled standard cube.)
+//
+//       The FOM of each post is also remapped to an LMMP confidence class
+//       through a 256 entry lookup table as the FOM is written, giving the
+//       CONF_isis_dem.raw file.  The script carries it through the same
+//       steps as the FOM file (nearest neighbor resampling) to give
+//       CONF_isis_dem.cub (and SS_CONF_isis_dem.cub).  The table defaults to
+//       the mapping of LMMP_FOMremap_confidence.py; a different mapping can
+//       be supplied as confidence_lut, a text file of lines:
+//
+//              <fom> <confidence>   or   <first_fom>-<last_fom> <confidence>
+//
+//       ('#' starts a comment; FOM values not listed map to 0.)  See
+//       LMMP_FOM_confidence.lut for the default table in this format.
+//
+//       With fom_mask, posts are also masked by FOM as the DEM is streamed
+//       (the masking of USGS_FOM_Masking, without the GUI).  The mask keeps
+//       the posts whose FOM is in low..high less any classes listed after a
+//       colon, e.g. 2-254:3,40-45.  Masked posts are NULL in the DEM (the
+//       FOM and confidence files are not changed) and left out of the DEM
+//       statistics, SS_isis_dem_mask.raw gets the mask as a bit plane (one
+//       bit per post, (samples+7)/8 bytes a line, north line first, first
+//       post in the low bit, 1 = kept) and the report gets a fom_mask
+//       member with the kept/masked counts.  The fom_mask program applies
+//       the same mask without the ISIS export.
+//
+//       SS_isis_dem.spans indexes the runs of non-NULL posts of each line of
+//       the DEM (see open_span_index in export_subroutines for the format),
+//       so the ISIS side tools (isis3arc_dd) can skip the NULL runs of
+//       SS_isis_dem.cub rather than read and convert them.  When the
+//       standard cube is resampled here, isis_dem.spans indexes it.  The
+//       script makes SS_ cubes only for geographic projects of ellipsoidal
+//       bodies; otherwise isis_dem.cub is on the native grid and the index
+//       of the DEM is isis_dem.spans.
+//
+//       With terrain, the slope (degrees), aspect (degrees clockwise from
+//       north, downslope), hillshade (8-bit, sun at azimuth 315 and 45
+//       degrees up) and RMS roughness about a plane (meters, over an NxN
+//       window: 3x3 for y, else N) of the native posts are computed from a
+//       window of the lines as the DEM is streamed (see open_terrain in
+//       export_subroutines), so they need no separate tools or reads of
+//       the DEM.  Post spacings are taken in meters, at the latitude of
+//       each line for geographic projects.  The script imports them on the
+//       grid of SS_isis_dem.cub (isis_dem.cub where there is no SS_ cube)
+//       as SS_isis_dem_slope.cub etc.
 //
 //       This isis_dem2isis3.sh script will generate up to four output
 //       files:
@@ -36,6 +103,13 @@
 //              FOM_isis_dem.cub
 //              isis_dem_layout.cub (optional)
 //
+//       With layout_flag set, 2x, 4x, 8x... overviews of the raw files
+//       (SS_isis_dem_ovr2.raw, ...) are built while the DEM is streamed:
+//       elevations are the mean of the valid posts of each 2x2 block, FOM
+//       and confidence the most common valid class.  The script imports
+//       them as isis_dem_ovr<N>.cub etc. (SS_isis_dem_ovr<N>.cub for the
+//       SS_ cubes), and the layout cube is reduced from the 4x overview.
+//
 //
 //       For DEMs in the Geographic Coordinate System:
 //       -------------------------------------------------------------
@@ -98,6 +172,11 @@
 //                     - polar stereographic map projection.
 //                  Note: the center/average lat of the cube is used to
 //                  determine if cube falls in 'polar region'.
+//               dem2isis3 does this resampling itself (bilinear for the
+//               DEM, nearest neighbor for the FOM and confidence files)
+//               and writes *_standard.raw files in the standard cube
+//               geometry, so the script only has to import them and add
+//               the mapping labels.
 //
 //
 //       For DEMs in Polar Stereographic (Grid) Coordinates:
@@ -155,6 +234,45 @@
 //      Jul 08 2011 EHK chnaged dem2isis3 to dem2isis3.exe in help for start_socet command
 //                         (the .exe extension will insure program will run in a command prompt),
 //                         Changed variable name outcub_name to outcubName
+//      Oct 18 2026      Accumulate DEM statistics, histogram and FOM class
+//                       counts while streaming the DEM, write them to a JSON
+//                       report and the ISIS cube labels.  Raw files are now
+//                       written a row at a time.
+//      Oct 18 2026      Remap FOM to LMMP confidence with a (configurable)
+//                       256 entry lookup table while writing the FOM, and
+//                       output a confidence raw file/cubes.
+//      Oct 18 2026      Resample the standard cube of geographic projects of
+//                       ellipsoidal bodies here (generate_standard_dem)
+//                       rather than with enlarge/reduce + map2map.
+//      Oct 18 2026      With layout_flag set, build 2x, 4x, 8x... overview
+//                       raw files of the DEM/FOM/confidence while streaming
+//                       the DEM (see open_overviews), for the script to
+//                       import as overview cubes and reduce the layout cube
+//                       from.
+//      Oct 18 2026      layout_flag has room for its terminator.
+//      Oct 18 2026      main returns int so the program builds with g++
+//                       against ../socet_native (see makefile_dem2isis3.linux),
+//                       and the raw byte order is that of the host rather
+//                       than msb for any Unix DBDIR.
+//      Oct 18 2026      Optional fom_mask argument: mask posts by FOM range
+//                       and class list while streaming the DEM (with the
+//                       export_subroutines FOM masking engine), writing a
+//                       mask bit plane and mask counts in the report.
+//      Oct 18 2026      Write the NULL-span index of the DEM while streaming
+//                       it (SS_<cube>.spans).
+//      Oct 18 2026      Optional terrain argument: slope, aspect, hillshade
+//                       and roughness raw files from the DEM stream (with
+//                       the export_subroutines terrain pass), imported by
+//                       the script; fom_mask may be - for none.
+//      Oct 19 2026      The overview plane types and routines come from
+//                       ../export_subs/export_subroutines.h.
+//      Oct 19 2026      The NULL-span index is named for the cube the script
+//                       makes on the native grid (native_cube_name), so
+//                       SS_<cube>.spans is written only with an SS_ cube.
+//      Oct 19 2026      FOM and confidence names from form_product_names
+//                       (export_subroutines), shared with the script.
+//      Oct 19 2026      accumulate_dem_row takes four posts a step with
+//                       SSE2 (scalar loop where the compiler lacks it).
 //
 //_End
 //
@@ -182,6 +300,8 @@
 #include <ground_point.h>
 #include <image_point.h>
 
+#include "../export_subs/export_subroutines.h"
+
 #define FILELEN 512
 #define NO_ERRS 0
 #define PARINV_ERR -1
@@ -195,17 +315,50 @@
 //const int INULL4 = 0xFF7FFFFB;
 //const float NULL4 =(*((const float *) &INULL4));
 
+// Elevation histogram: HIST_BINS bins of equal width.  The width starts at
+// HIST_MIN_WIDTH meters and is doubled (merging bin pairs) whenever the
+// elevation range seen so far no longer fits, so the DEM is read only once.
+#define HIST_BINS 256
+#define HIST_MIN_WIDTH 0.015625
+
+// accumulate_dem_row takes four posts at a time with SSE2, where the
+// compiler targets it
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define DEM_STATS_SSE2
+#endif
+
+// Statistics accumulated while streaming the DEM
+struct dem_stats {
+	unsigned long long valid;     // posts with FOM >= 2
+	unsigned long long nulls;     // posts with FOM < 2
+	double ref;                   // first valid elevation; sums are about ref
+	double sum, sumsq;            // sum of (z-ref) and (z-ref)^2
+	double min, max;
+	double width;                 // histogram bin width (meters)
+	long long base;               // hist[k] holds [(base+k)*width, (base+k+1)*width)
+	long long first, last;        // occupied range of bins, as base+k
+	unsigned long long hist[HIST_BINS];
+	unsigned long long fom[256];  // count of each FOM value
+};
+
 // prototypes
-extern int parse_label(char *file, char *keyword, char *value);
-extern int getTargetInfo (char *ellipsoid, char *isisTargName, char *isisTargDef,
-	        char *ographicPosLonDir, char *ocentricPosLonDir);
-extern int writeToScript(char *isis_script, char *command);
-extern int generate_ss2isis_script (char *isis_script, char *prj,
-            char *productType, char *byteOrder, char *outcubName,
-            char *layout_flag, int lines, int samples, double x_realspacing,
-            double y_realspacing, double ulcenter_Xlon, double ulcenter_Ylat);
+void init_dem_stats(dem_stats *stats);
+void accumulate_dem_row(dem_stats *stats, float *elev_buf, char *fom_buf,
+            unsigned char *keep, float *dem_row, int ncols, float null);
+void hist_cover(dem_stats *stats, double lo, double hi);
+void set_default_confidence_lut(unsigned char *lut);
+int read_confidence_lut(char *file, unsigned char *lut);
+void remap_fom_row(unsigned char *lut, char *fom_buf, unsigned char *conf_row,
+            int ncols);
+int write_stats_report(char *report, char *prj, char *dem, int lines,
+            int samples, dem_stats *stats, unsigned char *lut,
+            fom_mask *mask, char *mask_file);
+void label_dem_stats(char *isis_script, char *cub, dem_stats *stats);
+void label_fom_stats(char *isis_script, char *cub, dem_stats *stats,
+            unsigned char *lut);
             
-void main(int argc, char *argv[]) {
+int main(int argc, char *argv[]) {
 	// DECLARATIONS:
 
 	// Input variables
@@ -214,7 +367,10 @@ void main(int argc, char *argv[]) {
 	char fname[FILELEN];
 	char outcub[FILELEN];
 	char outcubName[FILELEN];
-	char layout_flag[1];
+	char layout_flag[2];
+	char confLut[FILELEN];
+	char maskSpec[FILELEN];
+	int terrain_size;
 
 	// DEM Header Variables
 	unsigned char dem_loaded;
@@ -249,22 +405,43 @@ void main(int argc, char *argv[]) {
 	// Misc declarations
     char rawDEM[FILELEN];
     char rawFOM[FILELEN];
+    char rawCONF[FILELEN];
+    char rawMASK[FILELEN];
+    char spanFile[FILELEN];
+    char CONF_outcubName[FILELEN];
     char FOM_outcubName[FILELEN];
 	int i, ii = 0, scan_value;
 	int ret;
+	int resampled_flag;
 	char value[FILELEN];
 	int x, y;
 	char command[512];
-	float demz[1];
-	float z[1];
-	char fom[1];
 	double rad2deg = 180.0 / M_PI;  //convert deg to radians and back
 	ground_point_struct ul_corner;
 	ground_point_struct gp_ul, gp_lr;
 	char productType[4];   //productType=DEM,FOM or ORT
 	char byteOrder[4];     //needed for DEMs only
+	union { int i; char c[sizeof(int)]; } endian;
 	FILE *ofp_DEM;
 	FILE *ofp_FOM;
+	FILE *ofp_CONF;
+	FILE *ofp_MASK = NULL;
+	fom_mask *mask = NULL;
+	span_index *spans;
+	overview_pyramid *ovr = NULL;
+	terrain_pass *terrain = NULL;
+	char terrain_names[4][FILELEN];
+	char *terrain_files[4];
+	int overview_flag;
+	int ovr_types[3] = {OVR_DEM, OVR_FOM, OVR_CONF};
+	char *ovr_files[3];
+	void *ovr_rows[3];
+
+	// Statistics variables
+	dem_stats stats;
+	unsigned char confidence_lut[256];  // FOM -> LMMP confidence class
+	char statsReport[FILELEN];
+	char cub[FILELEN];
 
 	//Set what NULL to use
 	null = (float) NULL3;
@@ -276,7 +453,7 @@ void main(int argc, char *argv[]) {
 
 	if (argc < 4) {
 		cerr << "\nRun dem2isis3 as follows:\n";
-		cerr << "start_socet -single dem2isis3.exe <project> <socet_dem> <isis.cub> <layout_flag>\n";
+		cerr << "start_socet -single dem2isis3.exe <project> <socet_dem> <isis.cub> <layout_flag> [confidence_lut] [fom_mask] [terrain]\n";
 		cerr << "\nwhere:\n";
 		cerr << "project = SOCET SET project name to export DEM from\n";
 		cerr << "          (path and extension is not required)\n";
@@ -287,6 +464,14 @@ void main(int argc, char *argv[]) {
 		cerr << "          (are to be copied to an ISIS machine)\n";
 		cerr << "layout_flag = flag to generate lower resolution standard cube for\n";
 		cerr << "              use in ARCMAP layouts.  Enter y or n, default=n\n";
+		cerr << "confidence_lut = optional FOM to LMMP confidence table\n";
+		cerr << "          (default, or -, is the LMMP_FOMremap_confidence.py mapping)\n";
+		cerr << "fom_mask = optional FOM mask, low-high[:fom,first-last,...]\n";
+		cerr << "          (posts with FOM outside low..high or in a listed class\n";
+		cerr << "          are NULLed, e.g. 2-254:3,40-45; - for none)\n";
+		cerr << "terrain = optional slope, aspect, hillshade and roughness\n";
+		cerr << "          cubes: y for a 3x3 roughness window, or an odd\n";
+		cerr << "          window size 3-31 (default, or n, is none)\n";
 		exit(1);
 	}
 
@@ -301,10 +486,30 @@ void main(int argc, char *argv[]) {
 	strcpy(prj, argv[1]);
 	strcpy(dem, argv[2]);
 	strcpy(outcub, argv[3]);
-	if (argc == 5)
+	if (argc >= 5)
 		strcpy(layout_flag, argv[4]);
 	else
 		strcpy(layout_flag, "n");
+	if (argc >= 6 && strcmp(argv[5], "-") != 0)
+		strcpy(confLut, argv[5]);
+	else
+		strcpy(confLut, "");
+	if (argc >= 7 && strcmp(argv[6], "-") != 0)
+		strcpy(maskSpec, argv[6]);
+	else
+		strcpy(maskSpec, "");
+	terrain_size = 0;
+	if (argc >= 8) {
+		if (argv[7][0] == 'y' || argv[7][0] == 'Y')
+			terrain_size = 3;
+		else if (strcmp(argv[7], "-") != 0 && argv[7][0] != 'n' && argv[7][0] != 'N') {
+			if (sscanf(argv[7], "%d", &terrain_size) != 1 ||
+			    terrain_size < 3 || terrain_size > 31 || terrain_size % 2 == 0) {
+				cerr << "\nterrain must be y, n or an odd window size 3-31\n";
+				exit(1);
+			}
+		}
+	}
 
 	/////////////////////////////////////////////////////////////////////////////
 	// Populate the project structure - with error checking
@@ -376,24 +581,10 @@ void main(int argc, char *argv[]) {
 	if (file_exists(rawDEM))
 		file_remove(rawDEM);
 
-        // Form output raw FOM file name...add the SS_ prefix and *.raw exension after
-        // the FOM prefix is added
-        strcpy(FOM_outcubName, outcubName);
-        upper_case(FOM_outcubName);
-        char* pos=NULL;
-        if (pos=strstr(FOM_outcubName,"DEM")) {
-           strcpy (FOM_outcubName,outcubName); // Reset original case of filename
-           strncpy (pos,"FOM",3);  // Replace "DEM" with FOM, if DEM is in filename
-        }
-        else if (pos=strstr(FOM_outcubName,"DTM")) {
-           strcpy (FOM_outcubName,outcubName); // Reset original case of filename
-           strncpy (pos,"FOM",3);  // Replace "DTM" with FOM, if DTM is in filename
-        }
-        else {
-           strcpy (FOM_outcubName,"FOM_"); // else, add FOM_ prefix
-           strcat (FOM_outcubName,outcubName);
-        }
-    
+        // Form output raw FOM and confidence file names...add the SS_ prefix
+        // and *.raw exension after the FOM/CONF name is formed
+        form_product_names(outcubName, FOM_outcubName, CONF_outcubName);
+
         strcpy(rawFOM, "SS_");  // add SS_  prefix
         strcat(rawFOM,FOM_outcubName);
         strcat(rawFOM, ".raw");  // add *.raw file exension
@@ -401,6 +592,35 @@ void main(int argc, char *argv[]) {
         if (file_exists(rawFOM))
                  file_remove(rawFOM);
 
+        strcpy(rawCONF, "SS_");
+        strcat(rawCONF,CONF_outcubName);
+        strcat(rawCONF, ".raw");
+
+        if (file_exists(rawCONF))
+                 file_remove(rawCONF);
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Set up the FOM -> LMMP confidence table
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (confLut[0] == '\0')
+		set_default_confidence_lut(confidence_lut);
+	else if (read_confidence_lut(confLut, confidence_lut) != 0)
+		exit(1);
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Set up the FOM mask, if any, and its bit plane file name
+	/////////////////////////////////////////////////////////////////////////////
+
+	sprintf(rawMASK, "SS_%s_mask.raw", outcubName);
+	if (maskSpec[0] != '\0') {
+		mask = open_fom_mask(maskSpec);
+		if (mask == NULL)
+			exit(1);
+		if (file_exists(rawMASK))
+			file_remove(rawMASK);
+	}
+
 	/////////////////////////////////////////////////////////////////////////////
 	// Generate output isis script name
 	/////////////////////////////////////////////////////////////////////////////
@@ -410,6 +630,11 @@ void main(int argc, char *argv[]) {
 	if (file_exists(isis_script))
 		file_remove(isis_script);
 
+	strcpy(statsReport, outcubName);
+	strcat(statsReport, "_stats.json");
+	if (file_exists(statsReport))
+		file_remove(statsReport);
+
 	/////////////////////////////////////////////////////////////////////////////
 	//output dem2isis3 command that was issued to isis_script file
 	/////////////////////////////////////////////////////////////////////////////
@@ -420,6 +645,12 @@ void main(int argc, char *argv[]) {
 		sprintf(command, "## start_socet -single dem2isis3 %s %s %s\n", argv[1], argv[2], argv[3]);
 	if (argc == 5)
 		sprintf(command, "## start_socet -single dem2isis3 %s %s %s %s\n", argv[1], argv[2], argv[3], argv[4]);
+	if (argc == 6)
+		sprintf(command, "## start_socet -single dem2isis3 %s %s %s %s %s\n", argv[1], argv[2], argv[3], argv[4], argv[5]);
+	if (argc == 7)
+		sprintf(command, "## start_socet -single dem2isis3 %s %s %s %s %s %s\n", argv[1], argv[2], argv[3], argv[4], argv[5], argv[6]);
+	if (argc == 8)
+		sprintf(command, "## start_socet -single dem2isis3 %s %s %s %s %s %s %s\n", argv[1], argv[2], argv[3], argv[4], argv[5], argv[6], argv[7]);
 	writeToScript(isis_script, command);
 
 	/////////////////////////////////////////////////////////////////////////////
@@ -505,6 +736,52 @@ void main(int argc, char *argv[]) {
 		exit(1);
 	}
 
+	ofp_CONF = fopen(rawCONF, "wb");
+	if (ofp_CONF == NULL) {
+		printf("\ncan't open the output raw confidence file: %s!\n", rawCONF);
+		exit(1);
+	}
+
+	// NULL-span index of the cube of the native posts (SS_<cube>.cub or
+	// <cube>.cub), named for it
+	native_cube_name(prj, outcubName, spanFile);
+	strcat(spanFile, ".spans");
+	spans = open_span_index(spanFile, nrows, ncols);
+	if (spans == NULL)
+		exit(1);
+
+	// Terrain products of the native posts, from a window of the lines
+	// as they are written
+	if (terrain_size > 0) {
+		for (i = 0; i < 4; i++)
+			terrain_files[i] = terrain_names[i];
+		terrain_raw_names(rawDEM, terrain_files);
+		terrain = open_terrain(prj, nrows, ncols, x_realspacing, y_realspacing,
+		                       ulcenter_Ylat, terrain_size, terrain_files);
+		if (terrain == NULL)
+			exit(1);
+	}
+
+	if (mask != NULL) {
+		ofp_MASK = fopen(rawMASK, "wb");
+		if (ofp_MASK == NULL) {
+			printf("\ncan't open the output raw mask file: %s!\n", rawMASK);
+			exit(1);
+		}
+	}
+
+	// With a layout cube requested, build the overview pyramids of the
+	// raw files as they are written
+	overview_flag = (layout_flag[0] == 'y' || layout_flag[0] == 'Y');
+	if (overview_flag) {
+		ovr_files[0] = rawDEM;
+		ovr_files[1] = rawFOM;
+		ovr_files[2] = rawCONF;
+		ovr = open_overviews(nrows, ncols, 3, ovr_types, ovr_files);
+		if (ovr == NULL)
+			exit(1);
+	}
+
 	cout << "Converting DEM and FOM to raw files...\n";
 	int quarter_rows = nrows / 4;
 	int half_rows = nrows / 2;
@@ -512,28 +789,55 @@ void main(int argc, char *argv[]) {
 
 	//Read in data backwards (flips on mid horizontal line)
 	int index_y;
-	demz[0] = null;
 
 	float *elev_buf = new float [ncols];
 	char *fom_buf = new char [ncols];
+	float *dem_row = new float [ncols];
+	unsigned char *conf_row = new unsigned char [ncols];
+	unsigned char *keep_row = new unsigned char [ncols];
+	unsigned char *mask_row = new unsigned char [(ncols + 7) / 8];
+
+	init_dem_stats(&stats);
 
 	for (index_y = nrows - 1; index_y >= 0; index_y--) {
 
 		di->getElevationBlock(0, index_y, ncols - 1, index_y, elev_buf);
 		di->getFomBlock(0, index_y, ncols - 1, index_y, fom_buf);
 
-		for (i = 0; i < ncols; i++) {
+		// Mask by FOM, if asked to, and write the mask bit plane
+		if (mask != NULL) {
+			fom_mask_row(mask, fom_buf, keep_row, ncols);
+			pack_mask_row(keep_row, mask_row, ncols);
+			if (fwrite(mask_row, 1, (ncols + 7) / 8, ofp_MASK) != (size_t) (ncols + 7) / 8) {
+				printf("\nerror writing the raw mask file!\n");
+				exit(1);
+			}
+		}
 
-			fom[0] = *(fom_buf + i);
-			fwrite(&fom[0], sizeof(char), 1, ofp_FOM);
+		// NULL out posts with FOM < 2 (or masked) and update the statistics
+		accumulate_dem_row(&stats, elev_buf, fom_buf,
+		                   (mask != NULL) ? keep_row : NULL, dem_row, ncols, null);
+		if (add_span_row(spans, dem_row) != 0)
+			exit(1);
+		if (terrain != NULL && add_terrain_row(terrain, dem_row) != 0)
+			exit(1);
 
-			if (*(fom_buf + i) < 2 )
-				fwrite(&demz[0], sizeof(float), 1, ofp_DEM);
-			else {
-				z[0] = *(elev_buf + i);
-				fwrite(&z[0], sizeof(float), 1, ofp_DEM);
-			}
+		// FOM -> LMMP confidence
+		remap_fom_row(confidence_lut, fom_buf, conf_row, ncols);
+
+		if (fwrite(fom_buf, sizeof(char), ncols, ofp_FOM) != (size_t) ncols ||
+		    fwrite(conf_row, sizeof(unsigned char), ncols, ofp_CONF) != (size_t) ncols ||
+		    fwrite(dem_row, sizeof(float), ncols, ofp_DEM) != (size_t) ncols) {
+			printf("\nerror writing raw DEM/FOM/confidence files!\n");
+			exit(1);
 		}
+
+		ovr_rows[0] = dem_row;
+		ovr_rows[1] = fom_buf;
+		ovr_rows[2] = conf_row;
+		if (ovr != NULL && add_overview_row(ovr, ovr_rows) != 0)
+			exit(1);
+
 		if (index_y == threequarter_rows )
 			cout << "...Conversion 25% Done\n";
 		if (index_y == half_rows )
@@ -546,17 +850,47 @@ void main(int argc, char *argv[]) {
 
 	free(elev_buf);
 	free(fom_buf);
+	delete [] dem_row;
+	delete [] conf_row;
+	delete [] keep_row;
+	delete [] mask_row;
 	fclose(ofp_DEM);
 	fclose(ofp_FOM);
+	fclose(ofp_CONF);
+	if (ofp_MASK != NULL && fclose(ofp_MASK) != 0) {
+		printf("\nerror writing the raw mask file!\n");
+		exit(1);
+	}
+	if (close_span_index(spans) != 0)
+		exit(1);
+	if (terrain != NULL && close_terrain(terrain) != 0)
+		exit(1);
+	if (ovr != NULL && close_overviews(ovr) != 0)
+		exit(1);
 
 	/////////////////////////////////////////////////////////////////////////////
-	// Set the byte order for the DEM based on the Socet Set platform
+	// Set the byte order for the DEM: the raw files are written in the
+	// order of the machine we run on (a Unix SOCET host isn't necessarily
+	// big-endian, e.g. a Linux node running the native build)
 	/////////////////////////////////////////////////////////////////////////////
-	if (unix_os == 1)
+	endian.i = 1;
+	if (endian.c[0] == 0)
 		strcpy(byteOrder,"msb");
 	else
 		strcpy(byteOrder,"lsb");
 
+	/////////////////////////////////////////////////////////////////////////////
+	// For geographic projects of ellipsoidal bodies, resample the raw files
+	// to the standard ISIS cube geometry here rather than in the script
+	/////////////////////////////////////////////////////////////////////////////
+
+	resampled_flag = generate_standard_dem(prj, outcubName, nrows, ncols,
+	                                       x_realspacing, y_realspacing,
+	                                       ulcenter_Xlon, ulcenter_Ylat, 1,
+	                                       overview_flag);
+	if (resampled_flag < 0)
+		exit(1);
+
 	/////////////////////////////////////////////////////////////////////////////
 	// Generate the dem2isis3 script
 	/////////////////////////////////////////////////////////////////////////////
@@ -574,6 +908,611 @@ void main(int argc, char *argv[]) {
 	        x_realspacing,
 	        y_realspacing,
 	        ulcenter_Xlon,
-	        ulcenter_Ylat);
+	        ulcenter_Ylat,
+	        1,
+	        resampled_flag);
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Write the statistics report, and have the script add the statistics
+	// to the DEM and FOM cube labels (the SS_ cubes only exist for some
+	// projects, so check for them in the script)
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (write_stats_report(statsReport, prj, demName, nrows, ncols,
+	                       &stats, confidence_lut, mask, rawMASK) != 0)
+		exit(1);
+	if (mask != NULL)
+		close_fom_mask(mask);
+
+	sprintf(command,"######################################################");
+	writeToScript(isis_script,command);
+	sprintf(command,"## Add SOCET DEM statistics to the cube labels");
+	writeToScript(isis_script,command);
+	sprintf(command,"######################################################\n");
+	writeToScript(isis_script,command);
+
+	strcpy(cub, concat(outcubName, ".cub"));
+	label_dem_stats(isis_script, cub, &stats);
+
+	strcpy(cub, concat(FOM_outcubName, ".cub"));
+	label_fom_stats(isis_script, cub, &stats, confidence_lut);
+
+	sprintf(cub, "SS_%s.cub", outcubName);
+	sprintf(command, "if (-e %s) then", cub);
+	writeToScript(isis_script, command);
+	label_dem_stats(isis_script, cub, &stats);
+	sprintf(cub, "SS_%s.cub", FOM_outcubName);
+	label_fom_stats(isis_script, cub, &stats, confidence_lut);
+	sprintf(command, "endif\n");
+	writeToScript(isis_script, command);
+
+	if (terrain_size > 0)
+		script_terrain_products(isis_script, outcubName, byteOrder, rawDEM,
+		                        nrows, ncols, terrain_size);
+
+	cout << "DEM statistics written to " << statsReport << "\n";
+
+	return(0);
 } // END MAIN
 
+
+
+/**************  init_dem_stats  *******************
+*                                                  *
+*  Clears the statistics accumulated by            *
+*  accumulate_dem_row                              *
+*                                                  *
+****************************************************/
+void init_dem_stats(dem_stats *stats)
+{
+	memset(stats, 0, sizeof(dem_stats));
+	stats->width = HIST_MIN_WIDTH;
+	stats->first = 0;
+	stats->last = -1;   // no occupied bins yet
+}
+
+/**************  accumulate_dem_row  ***************
+*                                                  *
+*  Copies one row of the DEM to dem_row, with      *
+*  posts having a FOM < 2 (or keep[i] == 0, if     *
+*  keep isn't NULL) set to NULL, and adds the row  *
+*  to the statistics.                              *
+*                                                  *
+*  The sums, min, max and valid count are kept in  *
+*  four lanes, post i in lane i % 4, combined at   *
+*  the end of the row.  With SSE2 the four lanes   *
+*  are the lanes of the vectors, four posts a      *
+*  step, so the sums are the same as the scalar    *
+*  loop's to the bit.  The FOM counts and the      *
+*  histogram are scatters and stay scalar.         *
+*                                                  *
+****************************************************/
+void accumulate_dem_row(dem_stats *stats, float *elev_buf, char *fom_buf,
+                        unsigned char *keep, float *dem_row, int ncols,
+                        float null)
+{
+	double sum[4] = {0.0, 0.0, 0.0, 0.0};
+	double sumsq[4] = {0.0, 0.0, 0.0, 0.0};
+	float rmin[4], rmax[4];
+	unsigned long long count[4] = {0, 0, 0, 0};
+	unsigned long long row_valid;
+	unsigned char f;
+	double d, ref, inv_width;
+	float z;
+	int i, l;
+#ifdef DEM_STATS_SSE2
+	__m128d vsum01, vsum23, vsq01, vsq23, vref, d01, d23;
+	__m128 vmin, vmax, vz, vnull, vbig, vsmall, vvalid;
+	__m128i vcount, vf, vk, valid, zero, one;
+	unsigned int count32[4];
+	int fom4, keep4;
+#endif
+
+	// sums are taken about the first valid elevation of the DEM to
+	// keep the variance from losing precision on large elevations
+	if (stats->valid == 0) {
+		for (i = 0; i < ncols; i++)
+			if ((unsigned char) fom_buf[i] >= 2 && (keep == NULL || keep[i])) {
+				stats->ref = elev_buf[i];
+				break;
+			}
+	}
+	ref = stats->ref;
+
+	for (l = 0; l < 4; l++) {
+		rmin[l] = 3.0e+38f;
+		rmax[l] = -3.0e+38f;
+	}
+
+	i = 0;
+#ifdef DEM_STATS_SSE2
+	vsum01 = vsum23 = vsq01 = vsq23 = _mm_setzero_pd();
+	vref = _mm_set1_pd(ref);
+	vmin = _mm_set1_ps(3.0e+38f);
+	vmax = _mm_set1_ps(-3.0e+38f);
+	vbig = vmin;
+	vsmall = vmax;
+	vnull = _mm_set1_ps(null);
+	vcount = zero = _mm_setzero_si128();
+	one = _mm_set1_epi32(1);
+	for (; i + 4 <= ncols; i += 4) {
+		stats->fom[(unsigned char) fom_buf[i]]++;
+		stats->fom[(unsigned char) fom_buf[i+1]]++;
+		stats->fom[(unsigned char) fom_buf[i+2]]++;
+		stats->fom[(unsigned char) fom_buf[i+3]]++;
+
+		// valid = FOM >= 2 and kept, as 32-bit lane masks
+		memcpy(&fom4, fom_buf + i, 4);
+		vf = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(fom4), zero), zero);
+		valid = _mm_cmpgt_epi32(vf, one);
+		if (keep != NULL) {
+			memcpy(&keep4, keep + i, 4);
+			vk = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(keep4), zero), zero);
+			valid = _mm_andnot_si128(_mm_cmpeq_epi32(vk, zero), valid);
+		}
+
+		// posts not valid are NULL in dem_row and don't move min/max
+		vz = _mm_loadu_ps(elev_buf + i);
+		vvalid = _mm_castsi128_ps(valid);
+		vz = _mm_and_ps(vvalid, vz);
+		_mm_storeu_ps(dem_row + i, _mm_or_ps(vz, _mm_andnot_ps(vvalid, vnull)));
+		vmin = _mm_min_ps(vmin, _mm_or_ps(vz, _mm_andnot_ps(vvalid, vbig)));
+		vmax = _mm_max_ps(vmax, _mm_or_ps(vz, _mm_andnot_ps(vvalid, vsmall)));
+		vcount = _mm_sub_epi32(vcount, valid);
+
+		// z - ref in double, 0 where not valid
+		d01 = _mm_and_pd(_mm_sub_pd(_mm_cvtps_pd(vz), vref),
+		                 _mm_castsi128_pd(_mm_unpacklo_epi32(valid, valid)));
+		d23 = _mm_and_pd(_mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(vz, vz)), vref),
+		                 _mm_castsi128_pd(_mm_unpackhi_epi32(valid, valid)));
+		vsum01 = _mm_add_pd(vsum01, d01);
+		vsum23 = _mm_add_pd(vsum23, d23);
+		vsq01 = _mm_add_pd(vsq01, _mm_mul_pd(d01, d01));
+		vsq23 = _mm_add_pd(vsq23, _mm_mul_pd(d23, d23));
+	}
+	_mm_storeu_pd(sum, vsum01);
+	_mm_storeu_pd(sum + 2, vsum23);
+	_mm_storeu_pd(sumsq, vsq01);
+	_mm_storeu_pd(sumsq + 2, vsq23);
+	_mm_storeu_ps(rmin, vmin);
+	_mm_storeu_ps(rmax, vmax);
+	_mm_storeu_si128((__m128i *) count32, vcount);
+	for (l = 0; l < 4; l++)
+		count[l] = count32[l];
+#endif
+
+	for (; i < ncols; i++) {
+		l = i & 3;
+		f = (unsigned char) fom_buf[i];
+		stats->fom[f]++;
+		if (f < 2 || (keep != NULL && !keep[i])) {
+			dem_row[i] = null;
+			continue;
+		}
+		z = elev_buf[i];
+		dem_row[i] = z;
+		d = z - ref;
+		sum[l] += d;
+		sumsq[l] += d * d;
+		count[l]++;
+		if (z < rmin[l]) rmin[l] = z;
+		if (z > rmax[l]) rmax[l] = z;
+	}
+
+	row_valid = count[0] + count[1] + count[2] + count[3];
+	stats->nulls += ncols - row_valid;
+	if (row_valid == 0)
+		return;
+
+	for (l = 1; l < 4; l++) {
+		if (rmin[l] < rmin[0]) rmin[0] = rmin[l];
+		if (rmax[l] > rmax[0]) rmax[0] = rmax[l];
+	}
+	if (stats->valid == 0 || rmin[0] < stats->min) stats->min = rmin[0];
+	if (stats->valid == 0 || rmax[0] > stats->max) stats->max = rmax[0];
+	stats->sum += (sum[0] + sum[1]) + (sum[2] + sum[3]);
+	stats->sumsq += (sumsq[0] + sumsq[1]) + (sumsq[2] + sumsq[3]);
+	stats->valid += row_valid;
+
+	// Make the histogram cover this row, then bin it.  The bin width is
+	// a power of two, so z*inv_width is exact.
+	hist_cover(stats, rmin[0], rmax[0]);
+	inv_width = 1.0 / stats->width;
+	for (i = 0; i < ncols; i++)
+		if ((unsigned char) fom_buf[i] >= 2 && (keep == NULL || keep[i]))
+			stats->hist[(long long) floor(dem_row[i] * inv_width) - stats->base]++;
+}
+
+/**************  hist_cover  ***********************
+*                                                  *
+*  Widens and/or slides the elevation histogram    *
+*  so that elevations lo..hi fall within it.       *
+*  When the occupied range no longer fits in       *
+*  HIST_BINS bins, the bin width is doubled and    *
+*  pairs of bins merged; the counts already        *
+*  gathered stay exact since bin edges are always  *
+*  multiples of the (power of two) width.          *
+*                                                  *
+****************************************************/
+#define FLOOR_HALF(g) ((g) < 0 ? ((g) - 1) / 2 : (g) / 2)
+
+void hist_cover(dem_stats *stats, double lo, double hi)
+{
+	unsigned long long tmp[HIST_BINS];
+	long long glo, ghi, nbase;
+	int k;
+
+	if (stats->first > stats->last) {
+		// first valid row: just pick a width the row fits in
+		while ((long long) floor(hi / stats->width) -
+		       (long long) floor(lo / stats->width) >= HIST_BINS)
+			stats->width *= 2.0;
+		glo = (long long) floor(lo / stats->width);
+		ghi = (long long) floor(hi / stats->width);
+		stats->base = glo - (HIST_BINS - (ghi - glo + 1)) / 2;
+		stats->first = glo;
+		stats->last = ghi;
+		return;
+	}
+
+	glo = (long long) floor(lo / stats->width);
+	ghi = (long long) floor(hi / stats->width);
+	if (stats->first < glo) glo = stats->first;
+	if (stats->last > ghi) ghi = stats->last;
+
+	// Double the bin width until the occupied range fits
+	while (ghi - glo >= HIST_BINS) {
+		nbase = FLOOR_HALF(stats->base);
+		memset(tmp, 0, sizeof(tmp));
+		for (k = 0; k < HIST_BINS; k++)
+			tmp[FLOOR_HALF(stats->base + k) - nbase] += stats->hist[k];
+		memcpy(stats->hist, tmp, sizeof(tmp));
+		stats->base = nbase;
+		stats->width *= 2.0;
+		stats->first = FLOOR_HALF(stats->first);
+		stats->last = FLOOR_HALF(stats->last);
+
+		glo = (long long) floor(lo / stats->width);
+		ghi = (long long) floor(hi / stats->width);
+		if (stats->first < glo) glo = stats->first;
+		if (stats->last > ghi) ghi = stats->last;
+	}
+
+	// Slide the window, re-centering the occupied range, if needed
+	if (glo < stats->base || ghi >= stats->base + HIST_BINS) {
+		nbase = glo - (HIST_BINS - (ghi - glo + 1)) / 2;
+		memset(tmp, 0, sizeof(tmp));
+		for (k = 0; k < HIST_BINS; k++)
+			if (stats->hist[k] != 0)
+				tmp[stats->base + k - nbase] = stats->hist[k];
+		memcpy(stats->hist, tmp, sizeof(tmp));
+		stats->base = nbase;
+	}
+
+	stats->first = glo;
+	stats->last = ghi;
+}
+
+/**************  set_default_confidence_lut  *******
+*                                                  *
+*  Fills the 256 entry SOCET FOM -> LMMP           *
+*  confidence class table.  This is the same       *
+*  mapping as LMMP_FOMremap_confidence.py:         *
+*                                                  *
+*   FOM 0-1                  0 NoDATA              *
+*   FOM 2                    1 shadowed            *
+*   FOM 21                   2 saturated           *
+*   FOM 3,5-20,28,31-39      3 suspicious          *
+*   FOM 4,30                 4 interpolated        *
+*   FOM 40-59 ... 90-99  10-14 correlated          *
+*                              (poor -> best)      *
+*   FOM 22-27,29            15 manually            *
+*                              interpolated        *
+*   FOM > 99                 0 (should not exist)  *
+*                                                  *
+****************************************************/
+void set_default_confidence_lut(unsigned char *lut)
+{
+	int f;
+
+	for (f = 0; f < 256; f++) {
+		if (f < 2 || f > 99)
+			lut[f] = 0;
+		else if (f == 2)
+			lut[f] = 1;
+		else if (f == 21)
+			lut[f] = 2;
+		else if (f == 4 || f == 30)
+			lut[f] = 4;
+		else if ((f >= 22 && f <= 27) || f == 29)
+			lut[f] = 15;
+		else if (f < 40)
+			lut[f] = 3;
+		else if (f < 60)
+			lut[f] = 10;
+		else
+			lut[f] = 11 + (f - 60) / 10;
+	}
+}
+
+/**************  read_confidence_lut  **************
+*                                                  *
+*  Reads a FOM -> LMMP confidence table.  Each     *
+*  line is "<fom> <confidence>" or                 *
+*  "<first_fom>-<last_fom> <confidence>"; '#'      *
+*  starts a comment.  FOM values not listed map    *
+*  to 0 (NoDATA).  Confidence values must be       *
+*  0-254 (255 is HRS in an 8-bit ISIS cube).       *
+*                                                  *
+****************************************************/
+int read_confidence_lut(char *file, unsigned char *lut)
+{
+	char line[FILELEN];
+	char extra[FILELEN];
+	char *hash;
+	int first, last, conf, f, n, lineno;
+	FILE *fp;
+
+	fp = fopen(file, "r");
+	if (fp == NULL) {
+		printf("\ncan't open the confidence lookup table: %s!\n", file);
+		return(-1);
+	}
+
+	memset(lut, 0, 256);
+	lineno = 0;
+	while (fgets(line, FILELEN, fp) != NULL) {
+		lineno++;
+		if ((hash = strchr(line, '#')) != NULL)
+			*hash = '\0';
+
+		n = sscanf(line, "%d-%d %d %s", &first, &last, &conf, extra);
+		if (n < 3) {
+			n = sscanf(line, "%d %d %s", &first, &conf, extra);
+			if (n == EOF)
+				continue;   // blank or comment line
+			last = first;
+			n++;
+		}
+		if (n != 3 || first < 0 || last > 255 || first > last ||
+		    conf < 0 || conf > 254) {
+			// (LMMP_color_confidence.lut is a confidence -> color table
+			// of 4 columns, and is not usable here)
+			printf("\nbad line %d in confidence lookup table %s:\n%s\n",
+			       lineno, file, line);
+			printf("expected <fom> <confidence> or <first_fom>-<last_fom> <confidence>\n");
+			fclose(fp);
+			return(-1);
+		}
+		for (f = first; f <= last; f++)
+			lut[f] = (unsigned char) conf;
+	}
+
+	fclose(fp);
+	return(0);
+}
+
+/**************  remap_fom_row  ********************
+*                                                  *
+*  Maps one row of FOM values through the 256      *
+*  entry confidence table.  The table is 256       *
+*  bytes and stays in L1 cache, so a plain         *
+*  (unrolled) table lookup keeps up with the DTM   *
+*  reads.                                          *
+*                                                  *
+****************************************************/
+void remap_fom_row(unsigned char *lut, char *fom_buf, unsigned char *conf_row,
+                   int ncols)
+{
+	unsigned char *fom = (unsigned char *) fom_buf;
+	int i;
+
+	for (i = 0; i + 3 < ncols; i += 4) {
+		conf_row[i]     = lut[fom[i]];
+		conf_row[i + 1] = lut[fom[i + 1]];
+		conf_row[i + 2] = lut[fom[i + 2]];
+		conf_row[i + 3] = lut[fom[i + 3]];
+	}
+	for ( ; i < ncols; i++)
+		conf_row[i] = lut[fom[i]];
+}
+
+/**************  confidence_name  ******************
+*                                                  *
+*  Label keyword stem for an LMMP confidence class *
+*                                                  *
+****************************************************/
+static void confidence_name(int cls, char *name)
+{
+	switch (cls) {
+		case 0:  strcpy(name, "NoData"); break;
+		case 1:  strcpy(name, "Shadowed"); break;
+		case 2:  strcpy(name, "Saturated"); break;
+		case 3:  strcpy(name, "Suspicious"); break;
+		case 4:  strcpy(name, "Interpolated"); break;
+		case 10: strcpy(name, "PoorCorrelation"); break;
+		case 11: strcpy(name, "LowCorrelation"); break;
+		case 12: strcpy(name, "MediumCorrelation"); break;
+		case 13: strcpy(name, "HighCorrelation"); break;
+		case 14: strcpy(name, "BestCorrelation"); break;
+		case 15: strcpy(name, "ManuallyInterpolated"); break;
+		case 17: strcpy(name, "SeedPoint"); break;
+		default: sprintf(name, "Confidence%d", cls); break;
+	}
+}
+
+/**************  dem_stats_moments  ****************
+*                                                  *
+*  Mean and (sample) standard deviation of the     *
+*  valid posts                                     *
+*                                                  *
+****************************************************/
+static void dem_stats_moments(dem_stats *stats, double *mean, double *stddev)
+{
+	double n = (double) stats->valid;
+	double var;
+
+	*mean = 0.0;
+	*stddev = 0.0;
+	if (stats->valid == 0)
+		return;
+
+	*mean = stats->ref + stats->sum / n;
+	if (stats->valid > 1) {
+		var = (stats->sumsq - stats->sum * stats->sum / n) / (n - 1.0);
+		*stddev = (var > 0.0) ? sqrt(var) : 0.0;
+	}
+}
+
+/**************  write_stats_report  ***************
+*                                                  *
+*  Writes the statistics (and the FOM mask counts, *
+*  if mask isn't NULL) to a JSON report            *
+*                                                  *
+****************************************************/
+int write_stats_report(char *report, char *prj, char *dem, int lines,
+                       int samples, dem_stats *stats, unsigned char *lut,
+                       fom_mask *mask, char *mask_file)
+{
+	unsigned long long classes[256];
+	double mean, stddev;
+	long long g;
+	int f, n;
+	FILE *fp;
+
+	fp = fopen(report, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the output statistics file: %s!\n", report);
+		return(-1);
+	}
+
+	dem_stats_moments(stats, &mean, &stddev);
+
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"project\": \"%s\",\n", ReturnFileName(prj));
+	fprintf(fp, "  \"dem\": \"%s\",\n", dem);
+	fprintf(fp, "  \"lines\": %d,\n", lines);
+	fprintf(fp, "  \"samples\": %d,\n", samples);
+	fprintf(fp, "  \"valid_pixels\": %llu,\n", stats->valid);
+	fprintf(fp, "  \"null_pixels\": %llu,\n", stats->nulls);
+	if (stats->valid > 0) {
+		fprintf(fp, "  \"minimum\": %.6f,\n", stats->min);
+		fprintf(fp, "  \"maximum\": %.6f,\n", stats->max);
+		fprintf(fp, "  \"average\": %.6f,\n", mean);
+		fprintf(fp, "  \"standard_deviation\": %.6f,\n", stddev);
+	}
+	else {
+		fprintf(fp, "  \"minimum\": null,\n");
+		fprintf(fp, "  \"maximum\": null,\n");
+		fprintf(fp, "  \"average\": null,\n");
+		fprintf(fp, "  \"standard_deviation\": null,\n");
+	}
+
+	// Histogram: only the occupied bins are written
+	fprintf(fp, "  \"histogram\": {\n");
+	fprintf(fp, "    \"bin_width\": %.6f,\n", stats->width);
+	fprintf(fp, "    \"first_bin_minimum\": %.6f,\n",
+	        (stats->valid > 0) ? stats->first * stats->width : 0.0);
+	fprintf(fp, "    \"counts\": [");
+	n = 0;
+	for (g = stats->first; g <= stats->last; g++, n++)
+		fprintf(fp, "%s%s%llu", (n == 0) ? "" : ",",
+		        (n % 16 == 0) ? "\n      " : " ", stats->hist[g - stats->base]);
+	fprintf(fp, "%s]\n", (n == 0) ? "" : "\n    ");
+	fprintf(fp, "  },\n");
+
+	// Counts of each FOM value present, and of each confidence class
+	memset(classes, 0, sizeof(classes));
+	fprintf(fp, "  \"fom_counts\": {");
+	n = 0;
+	for (f = 0; f < 256; f++) {
+		if (stats->fom[f] == 0)
+			continue;
+		classes[lut[f]] += stats->fom[f];
+		fprintf(fp, "%s\n    \"%d\": %llu", (n++ == 0) ? "" : ",", f, stats->fom[f]);
+	}
+	fprintf(fp, "\n  },\n");
+
+	fprintf(fp, "  \"confidence_counts\": {");
+	n = 0;
+	for (f = 0; f < 256; f++) {
+		if (classes[f] == 0)
+			continue;
+		fprintf(fp, "%s\n    \"%d\": %llu", (n++ == 0) ? "" : ",", f, classes[f]);
+	}
+	fprintf(fp, "\n  }");
+	if (mask != NULL) {
+		fprintf(fp, ",\n");
+		write_fom_mask_json(fp, mask, mask_file);
+	}
+	fprintf(fp, "\n}\n");
+
+	fclose(fp);
+	return(0);
+}
+
+/**************  label_dem_stats  ******************
+*                                                  *
+*  Writes the editlab commands that add the        *
+*  elevation statistics to a DEM cube label        *
+*                                                  *
+****************************************************/
+void label_dem_stats(char *isis_script, char *cub, dem_stats *stats)
+{
+	char command[512];
+	double mean, stddev;
+
+	dem_stats_moments(stats, &mean, &stddev);
+
+	sprintf(command, "editlab from=%s options=addg grpname=SS2ISIS_DEM_STATISTICS", cub);
+	writeToScript(isis_script, command);
+	sprintf(command, "editlab from=%s grpname=SS2ISIS_DEM_STATISTICS keyword=NOTE1 value=\"STATISTICS OF NATIVE SOCET DEM POSTS\"", cub);
+	writeToScript(isis_script, command);
+	sprintf(command, "editlab from=%s grpname=SS2ISIS_DEM_STATISTICS keyword=ValidPixels value=%llu", cub, stats->valid);
+	writeToScript(isis_script, command);
+	sprintf(command, "editlab from=%s grpname=SS2ISIS_DEM_STATISTICS keyword=NullPixels value=%llu", cub, stats->nulls);
+	writeToScript(isis_script, command);
+	if (stats->valid > 0) {
+		sprintf(command, "editlab from=%s grpname=SS2ISIS_DEM_STATISTICS keyword=Minimum value=%.6f", cub, stats->min);
+		writeToScript(isis_script, command);
+		sprintf(command, "editlab from=%s grpname=SS2ISIS_DEM_STATISTICS keyword=Maximum value=%.6f", cub, stats->max);
+		writeToScript(isis_script, command);
+		sprintf(command, "editlab from=%s grpname=SS2ISIS_DEM_STATISTICS keyword=Average value=%.6f", cub, mean);
+		writeToScript(isis_script, command);
+		sprintf(command, "editlab from=%s grpname=SS2ISIS_DEM_STATISTICS keyword=StandardDeviation value=%.6f", cub, stddev);
+		writeToScript(isis_script, command);
+	}
+	sprintf(command, "\n");
+	writeToScript(isis_script, command);
+}
+
+/**************  label_fom_stats  ******************
+*                                                  *
+*  Writes the editlab commands that add the LMMP   *
+*  confidence class counts to a FOM cube label     *
+*                                                  *
+****************************************************/
+void label_fom_stats(char *isis_script, char *cub, dem_stats *stats,
+                     unsigned char *lut)
+{
+	unsigned long long classes[256];
+	char command[512];
+	char name[64];
+	int f;
+
+	memset(classes, 0, sizeof(classes));
+	for (f = 0; f < 256; f++)
+		classes[lut[f]] += stats->fom[f];
+
+	sprintf(command, "editlab from=%s options=addg grpname=SS2ISIS_FOM_STATISTICS", cub);
+	writeToScript(isis_script, command);
+	for (f = 0; f < 256; f++) {
+		if (classes[f] == 0)
+			continue;
+		confidence_name(f, name);
+		sprintf(command, "editlab from=%s grpname=SS2ISIS_FOM_STATISTICS keyword=%sPixels value=%llu", cub, name, classes[f]);
+		writeToScript(isis_script, command);
+	}
+	sprintf(command, "\n");
+	writeToScript(isis_script, command);
+}
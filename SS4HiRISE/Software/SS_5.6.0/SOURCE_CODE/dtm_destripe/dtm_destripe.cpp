@@ -0,0 +1,785 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title DTM_DESTRIPE removes jitter stripes from a SOCET DEM
+//
+//_Desc  This is a SOCET Set program that uses SOCET DEV_KIT routines to
+//       remove the stripes jitter leaves across a DTM, as the "Destriping
+//       DEMs with Jitter" SOP does with fx, rotate, mask, lowpass and crop
+//       in ISIS, in two passes over the SOCET DEM.
+//
+//       Stripes are lines at stripe_angle degrees from the sample
+//       direction (positive rising to the right, as measured with the qview
+//       angle tool), so each post falls in a stripe bin: its line plus its
+//       sample times tan(stripe_angle).  Rather than rotating the DEM, the
+//       posts are binned in place.
+//
+//       With a reference DEM (global altimetry resampled onto the DEM's
+//       grid, the SOP's "B") the first pass takes the median of the DEM less
+//       the reference over the valid posts (FOM >= 2) of each bin, in place
+//       of the SOP's boxcar as wide as the DEM, so craters and NULLs don't
+//       pull the stripe level; as in the SOP the DEM is also brought onto
+//       the reference's level.  With no reference each bin takes the median
+//       change of the DEM from the line above, which leaves out the
+//       topography across the line, and the changes are summed down the
+//       bins.  Values outside the optional mask range (the SOP's mask of
+//       crater centers and rims) are left out of the medians.  The bins
+//       are done a block of lines at a time, the medians of a block in
+//       parallel (Windows threads, or POSIX threads on Linux).
+//
+//       The profile is then smoothed over max(stripe_width/2, 3) bins, the
+//       lines dimension of the SOP's lowpass, skipping bins with no valid
+//       posts.  Without a reference the profile also holds the topography
+//       down the DEM, so the line fitted to it over trend_lines bins
+//       (default 10 x stripe_width) is taken off, leaving stripes narrower
+//       than about trend_lines / 2.  The second pass subtracts the stripe
+//       of each post's bin from the DEM (the SOP's final fx).
+//
+//       Input parameters are:
+//
+//              SS_project
+//              socet_dem.dth
+//              output
+//              stripe_width (lines, width of the narrowest stripes)
+//              stripe_angle (optional, degrees, default or - is 0)
+//              reference (optional, - for none: 32-bit float raw in the
+//                         host byte order, north line first, with the
+//                         DEM's lines and samples; values below -1e30 or
+//                         NaN are NULL)
+//              mask_range (optional, low:high, - for none: DEM less
+//                          reference, or line to line changes with no
+//                          reference, outside low..high are left out of
+//                          the medians)
+//              trend_lines (optional, no reference only, default
+//                           10 x stripe_width)
+//
+//
+//       Output files are:
+//
+//              ./output.raw  (32-bit float destriped DEM in the host byte
+//                             order, north line first, NULL where FOM < 2)
+//              ./output_stripes.csv  (stripe profile: bin, line of the bin
+//                                     at the first sample, posts, median
+//                                     (DEM less reference, or change from
+//                                     the line above) and the stripe removed)
+//              ./output_dtm_destripe.sh  (csh script importing output.raw as
+//                                         output.cub, with the mapping of the
+//                                         dem2isis3 cube of the DEM; run it
+//                                         with that cube's name)
+//
+//_Hist Oct 18 2026      Orig Version
+//      Oct 19 2026      The project and DEM are opened by open_project_dem
+//                       (export_subroutines), which deletes the DtmHeader
+//                       rather than free()ing it
+//      Oct 19 2026      Medians taken with POSIX threads on Linux.  Writes
+//                       output_dtm_destripe.sh to import output.raw as a cube.
+//      Oct 19 2026      The median threads are run by run_workers
+//                       (export_subroutines), the thread pool the export
+//                       tools share.
+//
+//_End
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <system_includes.h>
+#include <math.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+//SOCET SET
+#include <key/handle_key.h>
+#include <dtm/dtm.h>
+#include <dtmUtil/dtm_util.h>
+#include <dtmAccess/DtmGrid.h>
+#include <dtmAccess/DtmHeader.h>
+#include <dtmAccess/fom_defs.h>
+#include <project/proj.h>
+#include <util/string_dpw.h>
+#include <util/init_socet_app.h>
+#include <ground_point.h>
+
+#include "../export_subs/export_subroutines.h"
+
+#define FILELEN 512
+
+// ISIS NULL (as dem2isis3)
+#define NULL3 -3.4028226550889044521e+38
+
+// Reference values below this are NULL
+#define REF_NULL_LIMIT -1.0e30
+
+// Stripe bins whose medians are taken together
+#define BLOCK_BINS 256
+
+// Largest stripe angle (degrees); the rows a bin crosses are held in memory
+#define MAX_STRIPE_ANGLE 45.0
+
+// Work shared by the median threads for one block of stripe bins
+struct stripe_block {
+	float *win;               // residual rows win_y0.., north line first
+	int win_y0;
+	int nrows, ncols;
+	int *off;                 // bin of sample x on line y is y + off[x]
+	int b0, nbins;            // bins of this block
+	volatile long next_bin;
+	int diff;                 // 1: medians of the change from the line above
+	int use_range;
+	double low, high;         // mask range of the residuals (changes)
+	float *median;            // per bin (all bins) median and posts
+	int *count;
+	volatile long err;
+};
+
+// prototypes
+static float select_median(float *a, int n);
+static int read_residual_row(DtmGrid *di, int nrows, int ncols, int y,
+            FILE *ref, float *elev, char *fom, float *row);
+void stripe_block_medians(stripe_block *blk);
+int stripe_profile(float *median, int *count, int nbins, int width,
+            int trend, float *stripe);
+int write_stripe_profile(char *file, int nbins, int *off, float *median,
+            int *count, float *stripe);
+int write_import_script(char *script, char *output, char *rawDEM, int lines,
+            int samples, int argc, char *argv[]);
+
+int main(int argc, char *argv[]) {
+	// DECLARATIONS:
+
+	// Input variables
+	char dem[FILELEN];
+	char demName[FILELEN];
+	char output[FILELEN];
+	char reference[FILELEN];
+	int width, trend;
+	double angle;
+
+	// DEM Header Variables
+	project_dem pd;
+	DtmGrid* di;
+	DtmHeader* di_header;
+	int ncols, nrows;
+
+	// Project File Variables
+	img_proj_struct project;        //SS project structure
+	char prj[FILELEN];         //SS project with full path and extension
+
+	// Output files
+	char rawDEM[FILELEN];
+	char profileFile[FILELEN];
+	char isis_script[FILELEN];
+	FILE *ofp_DEM;
+	FILE *ref_fp;
+
+	// Misc declarations
+	int i, x, y, span, nbins, win_rows, keep, next_row;
+	float null;
+	double t, rms;
+	long long nfixed;
+	stripe_block blk;
+
+	null = (float) NULL3;
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Check number of command line args and issue help if needed
+	// Otherwise initiate the socet set application
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (argc < 5) {
+		cerr << "\nRun dtm_destripe as follows:\n";
+		cerr << "start_socet -single dtm_destripe.exe <project> <socet_dem> <output> <stripe_width> [stripe_angle] [reference] [mask_range] [trend_lines]\n";
+		cerr << "\nwhere:\n";
+		cerr << "project = SOCET SET project name to read DEM from\n";
+		cerr << "          (path and extension is not required)\n";
+		cerr << "socet_dem = SOCET SET dem to destripe\n";
+		cerr << "          (path and extension is not required)\n";
+		cerr << "output = base name of the output files; writes <output>.raw,\n";
+		cerr << "         <output>_stripes.csv and <output>_dtm_destripe.sh\n";
+		cerr << "stripe_width = width (lines) of the narrowest stripes\n";
+		cerr << "stripe_angle = optional angle (degrees) of the stripes from the\n";
+		cerr << "          sample direction, positive rising to the right\n";
+		cerr << "          (default, or -, is 0)\n";
+		cerr << "reference = optional DEM (32-bit float raw, north line first,\n";
+		cerr << "          same lines and samples) the stripes are measured\n";
+		cerr << "          against, e.g. MOLA (default, or -, is none)\n";
+		cerr << "mask_range = optional low:high; DEM less reference values (or\n";
+		cerr << "          line to line changes with no reference) outside it\n";
+		cerr << "          are ignored (default, or -, is none)\n";
+		cerr << "trend_lines = optional width (lines) of the topography trend\n";
+		cerr << "          taken off the profile without a reference\n";
+		cerr << "          (default 10 x stripe_width)\n";
+		exit(1);
+	}
+
+	// Top level SOCET SET initialization  routine.
+	// Should be  called  before  any  PCI services.
+	init_socet_app ( argv[0], argc, argv);
+
+	/////////////////////////////////////////////////////////////////////////////
+	//Get input arguments
+	/////////////////////////////////////////////////////////////////////////////
+
+	strcpy(prj, argv[1]);
+	strcpy(dem, argv[2]);
+	strcpy(output, argv[3]);
+	width = atoi(argv[4]);
+	angle = 0.0;
+	if (argc >= 6 && strcmp(argv[5], "-") != 0)
+		angle = atof(argv[5]);
+	strcpy(reference, "-");
+	if (argc >= 7)
+		strcpy(reference, argv[6]);
+	blk.use_range = 0;
+	if (argc >= 8 && strcmp(argv[7], "-") != 0) {
+		if (sscanf(argv[7], "%lf:%lf", &blk.low, &blk.high) != 2 ||
+		    blk.low > blk.high) {
+			cerr << "mask_range must be low:high, with low <= high\n";
+			exit(1);
+		}
+		blk.use_range = 1;
+	}
+	trend = 10 * width;
+	if (argc >= 9)
+		trend = atoi(argv[8]);
+
+	if (width < 1) {
+		cerr << "stripe_width must be at least 1 line\n";
+		exit(1);
+	}
+	if (fabs(angle) > MAX_STRIPE_ANGLE) {
+		cerr << "stripe_angle must be -" << MAX_STRIPE_ANGLE << " to "
+		     << MAX_STRIPE_ANGLE << " degrees\n";
+		exit(1);
+	}
+	if (trend <= width) {
+		cerr << "trend_lines must be greater than stripe_width\n";
+		exit(1);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Populate the project structure and load the DEM
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (open_project_dem(prj, project, dem, demName, &pd) != 0)
+		exit(1);
+	di = pd.grid;
+	di_header = pd.header;
+
+	ncols = di_header->numXPosts();
+	nrows = di_header->numYPosts();
+
+	ref_fp = NULL;
+	if (strcmp(reference, "-") != 0) {
+		ref_fp = fopen(reference, "rb");
+		if (ref_fp == NULL) {
+			printf("\ncan't open the reference DEM: %s!\n", reference);
+			exit(1);
+		}
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Stripe bins: the bin of sample x on line y (north line 0) is
+	// y + off[x], off[] running 0..span across the DEM
+	/////////////////////////////////////////////////////////////////////////////
+
+	t = tan(angle * M_PI / 180.0);
+	int *off = new int [ncols];
+	for (x = 0; x < ncols; x++)
+		off[x] = (int) floor(x * t + 0.5);
+	span = (t >= 0.0) ? off[ncols - 1] : -off[ncols - 1];
+	if (t < 0.0)
+		for (x = 0; x < ncols; x++)
+			off[x] += span;
+	nbins = nrows + span;
+
+	float *median = new float [nbins];
+	int *count = new int [nbins];
+	float *stripe = new float [nbins];
+	float *elev_buf = new float [ncols];
+	char *fom_buf = new char [ncols];
+
+	/////////////////////////////////////////////////////////////////////////////
+	// First pass: median residual of each bin, or with no reference the
+	// median change of the DEM from the line above, which leaves out the
+	// topography across the line.  A block of bins b0..b1 uses lines
+	// b0 - span - 1..b1, so the window holds span + 1 + BLOCK_BINS lines and
+	// the last span + 1 lines are carried over to the next block.
+	/////////////////////////////////////////////////////////////////////////////
+
+	cout << "Measuring the stripes of DEM " << demName << "...\n";
+
+	win_rows = span + 1 + BLOCK_BINS;
+	blk.win = new float [(size_t) win_rows * ncols];
+	blk.nrows = nrows;
+	blk.ncols = ncols;
+	blk.off = off;
+	blk.diff = (ref_fp == NULL);
+	blk.median = median;
+	blk.count = count;
+	blk.err = 0;
+	blk.win_y0 = -span - 1;
+	next_row = 0;
+
+	for (blk.b0 = 0; blk.b0 < nbins; blk.b0 += BLOCK_BINS) {
+		blk.nbins = nbins - blk.b0;
+		if (blk.nbins > BLOCK_BINS) blk.nbins = BLOCK_BINS;
+
+		// slide the window to lines b0 - span - 1.. and read the new lines
+		keep = blk.win_y0 + win_rows - (blk.b0 - span - 1);
+		if (keep > span + 1) keep = span + 1;
+		if (keep > 0)
+			memmove(blk.win, blk.win + (size_t) (win_rows - keep) * ncols,
+			        (size_t) keep * ncols * sizeof(float));
+		blk.win_y0 = blk.b0 - span - 1;
+		for (y = (next_row > blk.win_y0) ? next_row : blk.win_y0;
+		     y < blk.b0 + blk.nbins && y < nrows; y++) {
+			if (read_residual_row(di, nrows, ncols, y, ref_fp, elev_buf,
+			                      fom_buf, blk.win + (size_t) (y - blk.win_y0) * ncols) != 0) {
+				printf("\nerror reading the DEM or reference DEM!\n");
+				exit(1);
+			}
+			next_row = y + 1;
+		}
+
+		stripe_block_medians(&blk);
+		if (blk.err) {
+			printf("\nunable to allocate memory for the stripe medians\n");
+			exit(1);
+		}
+	}
+	delete [] blk.win;
+	if (ref_fp != NULL)
+		fclose(ref_fp);
+
+	if (stripe_profile(median, count, nbins, width,
+	                   (strcmp(reference, "-") != 0) ? 0 : trend, stripe) != 0) {
+		printf("\nno valid posts to measure the stripes from!\n");
+		exit(1);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Second pass: subtract the stripe of each post's bin
+	/////////////////////////////////////////////////////////////////////////////
+
+	strcpy(output, ReturnFileName(output));
+	StripFileExt(output);
+	sprintf(rawDEM, "%s.raw", output);
+	sprintf(profileFile, "%s_stripes.csv", output);
+	sprintf(isis_script, "%s_dtm_destripe.sh", output);
+
+	ofp_DEM = fopen(rawDEM, "wb");
+	if (ofp_DEM == NULL) {
+		printf("\ncan't open the output raw DEM file: %s!\n", rawDEM);
+		exit(1);
+	}
+
+	cout << "Removing the stripes...\n";
+
+	rms = 0.0;
+	nfixed = 0;
+	for (y = 0; y < nrows; y++) {
+		di->getElevationBlock(0, nrows - 1 - y, ncols - 1, nrows - 1 - y, elev_buf);
+		di->getFomBlock(0, nrows - 1 - y, ncols - 1, nrows - 1 - y, fom_buf);
+
+		for (i = 0; i < ncols; i++) {
+			if ((unsigned char) fom_buf[i] < 2) {
+				elev_buf[i] = null;
+				continue;
+			}
+			elev_buf[i] -= stripe[y + off[i]];
+			rms += (double) stripe[y + off[i]] * stripe[y + off[i]];
+			nfixed++;
+		}
+
+		if (fwrite(elev_buf, sizeof(float), ncols, ofp_DEM) != (size_t) ncols) {
+			printf("\nerror writing the raw DEM file!\n");
+			exit(1);
+		}
+	}
+	if (fclose(ofp_DEM) != 0) {
+		printf("\nerror writing the raw DEM file!\n");
+		exit(1);
+	}
+
+	if (write_stripe_profile(profileFile, nbins, off, median, count, stripe) != 0)
+		exit(1);
+	if (write_import_script(isis_script, output, rawDEM, nrows, ncols, argc, argv) != 0)
+		exit(1);
+
+	if (nfixed > 0)
+		rms = sqrt(rms / nfixed);
+	printf("Removed stripes of %.3f m RMS from %lld posts\n", rms, nfixed);
+
+	delete [] off;
+	delete [] median;
+	delete [] count;
+	delete [] stripe;
+	delete [] elev_buf;
+	delete [] fom_buf;
+	close_project_dem(&pd);
+
+	cout << "Wrote " << rawDEM << ", " << profileFile << " and " << isis_script << "\n";
+	return(0);
+}
+
+/**************  select_median  ********************
+*                                                  *
+*  Median of a[0..n-1] (n > 0), partially          *
+*  reordering a (Wirth's selection)                *
+*                                                  *
+****************************************************/
+static float select_median(float *a, int n)
+{
+	int k = n / 2;
+	int l = 0, m = n - 1;
+	int i, j;
+	float x, w;
+
+	while (l < m) {
+		x = a[k];
+		i = l;
+		j = m;
+		do {
+			while (a[i] < x) i++;
+			while (x < a[j]) j--;
+			if (i <= j) {
+				w = a[i]; a[i] = a[j]; a[j] = w;
+				i++;
+				j--;
+			}
+		} while (i <= j);
+		if (j < k) l = i;
+		if (k < i) m = j;
+	}
+
+	if (n % 2 == 1)
+		return(a[k]);
+
+	// even: mean of a[k] and the largest of a[0..k-1]
+	x = a[0];
+	for (i = 1; i < k; i++)
+		if (a[i] > x) x = a[i];
+	return((float) (0.5 * ((double) x + a[k])));
+}
+
+/**************  read_residual_row  ****************
+*                                                  *
+*  Reads line y (north line 0) of the DEM and the  *
+*  reference into row: the DEM less the reference, *
+*  NULL where FOM < 2 or the reference is NULL.    *
+*  Returns 0, or -1 on a reference read error      *
+*                                                  *
+****************************************************/
+static int read_residual_row(DtmGrid *di, int nrows, int ncols, int y,
+            FILE *ref, float *elev, char *fom, float *row)
+{
+	float null = (float) NULL3;
+	int i;
+
+	di->getElevationBlock(0, nrows - 1 - y, ncols - 1, nrows - 1 - y, elev);
+	di->getFomBlock(0, nrows - 1 - y, ncols - 1, nrows - 1 - y, fom);
+
+	if (ref != NULL) {
+		if (fread(row, sizeof(float), ncols, ref) != (size_t) ncols)
+			return(-1);
+		for (i = 0; i < ncols; i++) {
+			if ((unsigned char) fom[i] < 2 || !(row[i] > REF_NULL_LIMIT))
+				row[i] = null;
+			else
+				row[i] = elev[i] - row[i];
+		}
+		return(0);
+	}
+
+	for (i = 0; i < ncols; i++)
+		row[i] = ((unsigned char) fom[i] < 2) ? null : elev[i];
+	return(0);
+}
+
+/**************  median_worker  ********************
+*                                                  *
+*  Takes the medians of bins of a block until      *
+*  none are left                                   *
+*                                                  *
+****************************************************/
+static void median_worker(void *arg)
+{
+	stripe_block *blk = (stripe_block *) arg;
+	float null = (float) NULL3;
+	float *vals;
+	float v, *row;
+	int b, x, y, n;
+
+	vals = (float *) malloc(blk->ncols * sizeof(float));
+	if (vals == NULL) {
+		blk->err = 1;
+		return;
+	}
+
+	while (!blk->err && (b = next_work_item(&blk->next_bin)) < blk->nbins) {
+		b += blk->b0;
+		n = 0;
+		for (x = 0; x < blk->ncols; x++) {
+			y = b - blk->off[x];
+			if (y < blk->diff || y >= blk->nrows)
+				continue;
+			row = blk->win + (size_t) (y - blk->win_y0) * blk->ncols;
+			v = row[x];
+			if (v == null)
+				continue;
+			if (blk->diff) {
+				if (row[x - blk->ncols] == null)
+					continue;
+				v -= row[x - blk->ncols];
+			}
+			if (blk->use_range && (v < blk->low || v > blk->high))
+				continue;
+			vals[n++] = v;
+		}
+		blk->count[b] = n;
+		blk->median[b] = (n > 0) ? select_median(vals, n) : 0.0f;
+	}
+
+	free(vals);
+}
+
+/**************  stripe_block_medians  *************
+*                                                  *
+*  Takes the medians of the bins of a block, in    *
+*  parallel where there are threads                *
+*                                                  *
+****************************************************/
+void stripe_block_medians(stripe_block *blk)
+{
+	blk->next_bin = 0;
+	run_workers(median_worker, blk, worker_threads(blk->nbins));
+}
+
+/**************  stripe_profile  *******************
+*                                                  *
+*  Makes the stripe of each bin from the bin       *
+*  medians.  With trend > 0 the medians are line   *
+*  to line changes, summed down the bins into the  *
+*  profile.  The profile is smoothed over          *
+*  max(width/2, 3) bins (odd), less the line       *
+*  fitted to it over trend bins if trend > 0,      *
+*  using only bins with posts.  Bins with none in  *
+*  reach take the stripe of the nearest bins.      *
+*  Returns 0, or -1 if no bin has posts            *
+*                                                  *
+****************************************************/
+int stripe_profile(float *median, int *count, int nbins, int width,
+            int trend, float *stripe)
+{
+	// running sums over the bins with posts of 1, b, b*b, p and b*p,
+	// p the profile
+	double *sum = new double [5 * (nbins + 1)];
+	unsigned char *gap = new unsigned char [nbins];
+	int b, lo, hi, h, k, last;
+	double p, n, sb, sbb, sp, sbp, slope;
+
+	p = 0.0;
+	for (k = 0; k < 5; k++)
+		sum[k] = 0.0;
+	for (b = 0; b < nbins; b++) {
+		if (count[b] > 0)
+			p = (trend > 0) ? p + median[b] : median[b];
+		for (k = 0; k < 5; k++)
+			sum[5 * (b + 1) + k] = sum[5 * b + k];
+		if (count[b] > 0) {
+			sum[5 * (b + 1)] += 1.0;
+			sum[5 * (b + 1) + 1] += b;
+			sum[5 * (b + 1) + 2] += (double) b * b;
+			sum[5 * (b + 1) + 3] += p;
+			sum[5 * (b + 1) + 4] += b * p;
+		}
+	}
+	if (sum[5 * nbins] == 0.0) {
+		delete [] sum;
+		delete [] gap;
+		return(-1);
+	}
+
+	// SOP lowpass lines: width / 2 or 3, whichever is greater, made odd
+	h = width / 2;
+	if (h < 3) h = 3;
+	h /= 2;
+
+	for (b = 0; b < nbins; b++) {
+		lo = (b - h < 0) ? 0 : b - h;
+		hi = (b + h + 1 > nbins) ? nbins : b + h + 1;
+		n = sum[5 * hi] - sum[5 * lo];
+		gap[b] = (n == 0.0);
+		if (gap[b])
+			continue;
+		stripe[b] = (float) ((sum[5 * hi + 3] - sum[5 * lo + 3]) / n);
+		if (trend > 0) {
+			// least squares line through the profile about bin b
+			lo = (b - trend / 2 < 0) ? 0 : b - trend / 2;
+			hi = (b + trend / 2 + 1 > nbins) ? nbins : b + trend / 2 + 1;
+			n = sum[5 * hi] - sum[5 * lo];
+			sb = sum[5 * hi + 1] - sum[5 * lo + 1] - b * n;
+			sbb = sum[5 * hi + 2] - sum[5 * lo + 2] -
+			      2.0 * b * (sum[5 * hi + 1] - sum[5 * lo + 1]) + (double) b * b * n;
+			sp = sum[5 * hi + 3] - sum[5 * lo + 3];
+			sbp = sum[5 * hi + 4] - sum[5 * lo + 4] - b * sp;
+			slope = n * sbb - sb * sb;
+			slope = (slope > 0.0) ? (n * sbp - sb * sp) / slope : 0.0;
+			stripe[b] = (float) (stripe[b] - (sp - slope * sb) / n);
+		}
+	}
+
+	// fill gaps from the nearest bins, interpolating between them
+	last = -1;
+	for (b = 0; b <= nbins; b++) {
+		if (b < nbins && gap[b])
+			continue;
+		for (k = last + 1; k < b; k++) {
+			if (last < 0)
+				stripe[k] = stripe[b];
+			else if (b == nbins)
+				stripe[k] = stripe[last];
+			else
+				stripe[k] = stripe[last] + (stripe[b] - stripe[last]) *
+				            (float) (k - last) / (b - last);
+		}
+		last = b;
+	}
+
+	delete [] sum;
+	delete [] gap;
+	return(0);
+}
+
+/**************  write_stripe_profile  *************
+*                                                  *
+*  Writes the stripe profile as CSV, a bin a line  *
+*  (median is empty for bins with no posts).       *
+*  Returns 0, or -1 on a write error               *
+*                                                  *
+****************************************************/
+int write_stripe_profile(char *file, int nbins, int *off, float *median,
+            int *count, float *stripe)
+{
+	FILE *fp;
+	int b;
+
+	fp = fopen(file, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the stripe profile: %s!\n", file);
+		return(-1);
+	}
+
+	fprintf(fp, "bin,line,posts,median,stripe\n");
+	for (b = 0; b < nbins; b++) {
+		if (count[b] > 0)
+			fprintf(fp, "%d,%d,%d,%.4f,%.4f\n", b, b - off[0], count[b],
+			        median[b], stripe[b]);
+		else
+			fprintf(fp, "%d,%d,0,,%.4f\n", b, b - off[0], stripe[b]);
+	}
+
+	if (fclose(fp) != 0) {
+		printf("\nerror writing the stripe profile: %s!\n", file);
+		return(-1);
+	}
+	return(0);
+}
+
+/**************  write_import_script  **************
+*                                                  *
+*  Writes csh script script, which imports rawDEM  *
+*  as <output>.cub with raw2isis and labels it     *
+*  with maplab with the mapping of the dem2isis3   *
+*  cube of the DEM, named on the script's command  *
+*  line (SS_<cube>.cub if there is one, else       *
+*  <cube>.cub, as script_terrain_products).        *
+*  Returns 0, or -1 on a write error               *
+*                                                  *
+****************************************************/
+int write_import_script(char *script, char *output, char *rawDEM, int lines,
+            int samples, int argc, char *argv[])
+{
+	union { int i; char c[sizeof(int)]; } endian;
+	char byteOrder[4];
+	char command[2048];
+	int i;
+
+	// the raw file is in the order of the machine we run on
+	endian.i = 1;
+	if (endian.c[0] == 0)
+		strcpy(byteOrder, "msb");
+	else
+		strcpy(byteOrder, "lsb");
+
+	if (file_exists(script))
+		file_remove(script);
+
+	sprintf(command, "#!/bin/csh\n");
+	if (writeToScript(script, command) != 0)
+		return(-1);
+	strcpy(command, "## start_socet -single dtm_destripe");
+	for (i = 1; i < argc; i++) {
+		strcat(command, " ");
+		strncat(command, argv[i], sizeof(command) - strlen(command) - 2);
+	}
+	strcat(command, "\n");
+	writeToScript(script, command);
+
+	sprintf(command, "######################################################");
+	writeToScript(script, command);
+	sprintf(command, "## Import the destriped DEM as %s.cub, with the mapping of", output);
+	writeToScript(script, command);
+	sprintf(command, "## the dem2isis3 cube of the DEM:");
+	writeToScript(script, command);
+	sprintf(command, "##    %s <dem2isis3 cube name>", ReturnFileName(script));
+	writeToScript(script, command);
+	sprintf(command, "######################################################\n");
+	writeToScript(script, command);
+
+	sprintf(command, "if ($#argv != 1) then");
+	writeToScript(script, command);
+	sprintf(command, "   echo \"usage: %s <dem2isis3 cube name>\"", ReturnFileName(script));
+	writeToScript(script, command);
+	sprintf(command, "   exit 1");
+	writeToScript(script, command);
+	sprintf(command, "endif");
+	writeToScript(script, command);
+	sprintf(command, "if (-e SS_$1.cub) then");
+	writeToScript(script, command);
+	sprintf(command, "   set dem_cub = SS_$1");
+	writeToScript(script, command);
+	sprintf(command, "else");
+	writeToScript(script, command);
+	sprintf(command, "   set dem_cub = $1");
+	writeToScript(script, command);
+	sprintf(command, "endif");
+	writeToScript(script, command);
+	sprintf(command, "if (`getkey from=${dem_cub}.cub objname=IsisCube grpname=Dimensions keyword=Lines` != %d || \\", lines);
+	writeToScript(script, command);
+	sprintf(command, "    `getkey from=${dem_cub}.cub objname=IsisCube grpname=Dimensions keyword=Samples` != %d) then", samples);
+	writeToScript(script, command);
+	sprintf(command, "   echo \"${dem_cub}.cub is not on the grid of the DEM (%d lines, %d samples)\"", lines, samples);
+	writeToScript(script, command);
+	sprintf(command, "   exit 1");
+	writeToScript(script, command);
+	sprintf(command, "endif\n");
+	writeToScript(script, command);
+
+	sprintf(command, "catlab from=${dem_cub}.cub to=%s_destripe.lbl", output);
+	writeToScript(script, command);
+	sprintf(command, "set ulx = `getkey from=${dem_cub}.cub grpname=Mapping keyword=UpperLeftCornerX`");
+	writeToScript(script, command);
+	sprintf(command, "set uly = `getkey from=${dem_cub}.cub grpname=Mapping keyword=UpperLeftCornerY`");
+	writeToScript(script, command);
+	sprintf(command, "raw2isis from=%s to=%s.cub samples=%d lines=%d bands=1 bittype=real byteorder=%s",
+	        rawDEM, output, samples, lines, byteOrder);
+	writeToScript(script, command);
+	sprintf(command, "maplab from=%s.cub map=%s_destripe.lbl sample=0.5 line=0.5 x=$ulx y=$uly",
+	        output, output);
+	writeToScript(script, command);
+	sprintf(command, "/bin/rm -f %s_destripe.lbl", output);
+	if (writeToScript(script, command) != 0)
+		return(-1);
+	return(0);
+}
@@ -70,6 +70,45 @@
 //     May 30 2014 EHK, Updated Socet Set Native geographic DEMs to also set clon=0, and a londom of 180 for ARC compatibility,
 //                                and added the ARC compatibility details and IAU postive lon direction to the commnets in the output script,
 //                                and updated setisis to isis3.4.6
+//     Oct 18 2026      Added confidence_flag: when set, an 8-bit LMMP confidence raw file
+//                                 (written by dem2isis3 alongside the FOM) is carried through the same
+//                                 steps as the FOM to give CONF cubes next to the FOM cubes
+//     Oct 18 2026      Added generate_standard_dem, which resamples the raw DEM/FOM/confidence
+//                                 files of geographic projects of ellipsoidal bodies to the standard cube
+//                                 geometry on the SOCET SET side.  With resampled_flag set, the script
+//                                 imports those files in place of running enlarge/reduce + map2map.
+//     Oct 18 2026      Added overview pyramids (open_overviews/add_overview_row/close_overviews),
+//                                 built from the raw file rows as they are written.  With layout_flag
+//                                 set, the script imports them as <cube>_ovr<N> cubes and reduces the
+//                                 layout cube from the 4x overview rather than the full cube.
+//     Oct 18 2026      parse_label closes the project file when the keyword is found (the
+//                                 exporters look up dozens of keywords and ran out of file handles)
+//     Oct 18 2026      Added the FOM masking engine (open_fom_mask/fom_mask_row/...), used by
+//                                 dem2isis3 and fom_mask to mask posts by FOM range and class
+//                                 while the DEM is streamed
+//     Oct 18 2026      Added the NULL-span index (open_span_index/add_span_row/close_span_index):
+//                                 the runs of valid posts of each line of a DEM, written as the raw
+//                                 file is, for ISIS side tools to skip the NULL runs by.
+//                                 generate_standard_dem writes one for the standard cube.
+//     Oct 18 2026      Added the terrain pass (open_terrain/add_terrain_row/close_terrain):
+//                                 slope, aspect, hillshade and RMS roughness raw files of a DEM,
+//                                 from a sliding window of the rows as the DEM raw file is written,
+//                                 and script_terrain_products to import them as cubes.
+//     Oct 19 2026      The overview pyramid constants are in export_subroutines.h, shared with
+//                                 the exporters.  open_overviews frees what it had set up on an error.
+//     Oct 19 2026      Added open_project_dem/close_project_dem: the project read and grid DEM
+//                                 open that fom_mask, gpf_level and dtm_destripe had each copied
+//                                 from dem2isis3.  The DtmHeader is deleted, not free()d.
+//     Oct 19 2026      NULL-span index version 2: the header has a check of the posts at the
+//                                 ends of each run and gap, for readers to verify the index
+//                                 against the cube.  Added native_cube_name, the cube the script
+//                                 makes on the grid of the SS_ raw files.
+//     Oct 19 2026      Added run_workers/worker_threads/next_work_item, one thread pool for the
+//                                 tools (Windows threads or POSIX threads), so the standard DEM is
+//                                 resampled in parallel on Linux too.  generate_standard_dem closes
+//                                 and frees everything on its error returns.  form_product_names,
+//                                 the FOM/CONF names of a DEM, is shared with generate_ss2isis_script
+//                                 and dem2isis3 rather than copied into each.
 //_End
 //
 ////////////////////////////////////////////////////////////////////////////////
@@ -97,6 +136,8 @@
 #include <ground_point.h>
 #include <image_point.h>
 
+#include "export_subroutines.h"
+
 #define FILELEN 512
 #define NO_ERRS 0
 #define PARINV_ERR -1
@@ -111,11 +152,180 @@
 //const int INULL4 = 0xFF7FFFFB;
 //const float NULL4 =(*((const float *) &INULL4));
 
+// Worker threads (see run_workers)
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+// Standard DEM resampling (see generate_standard_dem)
+#ifdef _WIN32
+#define FSEEK64 _fseeki64
+#else
+#define FSEEK64 fseeko
+#endif
+
+#define STD_TILE 256               // output tile size, lines and samples
+#define STD_NULL_BITS 0xFF7FFFFB   // ISIS 32-bit NULL
+
+// Input (native SOCET SET) grid and output (standard ISIS) projection/grid
+struct standard_grid {
+   // input grid: radians, ographic latitudes, +East longitudes
+   int in_lines, in_samples;
+   double in_lat0, in_lon0;     // at center of upper left post
+   double in_dlat, in_dlon;     // post spacing
+   double in_lonmid;            // longitude at center of the grid
+
+   // output projection
+   int polar;                   // 0 = equirectangular, 1 = polar stereographic
+   int south;                   // polar: 1 = south pole
+   double a, b, e;              // equatorial/polar radius (m), eccentricity
+   double clat, clon;           // degrees, as given to maptemplate
+   int londom;
+   char londir[13];
+   double clon_east;            // clon in radians, +East
+   double radius;               // equirectangular: local radius at clat
+   double cosclat;
+   double e4;                   // polar: sqrt((1+e)^(1+e) * (1-e)^(1-e))
+   double res;                  // pixel size (m)
+
+   // output grid
+   int lines, samples;
+   double ulx, uly;             // x/y (m) at center of upper left pixel
+};
+
+// Work shared by the resampling threads for one band of output lines
+struct resample_band {
+   standard_grid *grid;
+   char *inDEM, *inFOM, *inCONF;   // inCONF is NULL if no confidence file
+   int line0, nlines;              // output lines in this band
+   int ntiles;
+   volatile long next_tile;
+   float *dem;                     // band buffers, nlines x samples
+   unsigned char *fom, *conf;
+   volatile long err;
+};
+
+// FOM masking (see open_fom_mask).  Kept FOM values making up no more than
+// FOM_MASK_SIMD_RANGES ranges are tested 16 posts at a time with SSE2
+// compares; otherwise (or without SSE2) through the 256 entry table.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FOM_MASK_SSE2
+#define TERRAIN_SSE2
+#endif
+#define FOM_MASK_SIMD_RANGES 4
+
+struct fom_mask {
+   char spec[FILELEN];
+   unsigned char keep[256];        // 0xFF = kept, 0 = masked, by FOM
+   int nranges;                    // kept FOM values as ranges lo..hi
+   unsigned char lo[256], hi[256];
+   unsigned long long kept, masked;
+   unsigned long long masked_fom[256];  // masked posts by FOM
+};
+
+// NULL-span index (see open_span_index): a <cube>.spans sidecar holding,
+// for each line of a 32-bit DEM, the runs of non-NULL posts.  All values
+// are little-endian whatever the host:
+//
+//    header (SPAN_HEADER_BYTES)  "NULLSPAN", version, lines, samples
+//                                (int32), total runs (uint32), valid
+//                                posts (uint64) and check (uint64)
+//    each line, north first      run count n (uint32), then n pairs of
+//                                first sample (0 based) and length (uint32)
+//
+// The check is the 64-bit FNV-1a hash of the first and last post of each
+// run and of each NULL gap, line by line, as 32-bit patterns (low byte
+// first).  A reader checks it against those posts of the cube, a few
+// reads a line, so an index left from another export of the cube is not
+// trusted.
+#define SPAN_MAGIC "NULLSPAN"
+#define SPAN_VERSION 2
+#define SPAN_HEADER_BYTES 40
+#define SPAN_CHECK_BASIS 0xcbf29ce484222325ULL   // FNV-1a 64-bit
+#define SPAN_CHECK_PRIME 0x100000001b3ULL
+
+struct span_index {
+   char file[FILELEN];
+   FILE *fp;
+   int lines, samples, line;
+   unsigned int nspans;
+   unsigned long long valid;
+   unsigned long long check;
+   unsigned char *rec;             // one line's record, 4 + 8 * runs bytes
+};
+
+// Terrain products (see open_terrain): slope, aspect, hillshade and RMS
+// roughness from a sliding window of DEM rows.  The roughness window is
+// TERRAIN_MIN_SIZE..TERRAIN_MAX_SIZE posts square (odd); the gradients
+// are always from the 3x3 posts about a post.
+#define TERRAIN_PLANES 4
+#define TERRAIN_SLOPE     0        // 32-bit, degrees
+#define TERRAIN_ASPECT    1        // 32-bit, degrees clockwise from north, downslope
+#define TERRAIN_HILLSHADE 2        // 8-bit, 1..254 (0 is NULL)
+#define TERRAIN_ROUGHNESS 3        // 32-bit, meters
+#define TERRAIN_MIN_SIZE 3
+#define TERRAIN_MAX_SIZE 31
+#define TERRAIN_SUN_AZIMUTH 315.0  // hillshade sun, degrees clockwise from north
+#define TERRAIN_SUN_ALTITUDE 45.0  // and above the horizon
+
+struct terrain_pass {
+   int lines, samples;
+   int size, half;                 // roughness window, and half of it
+   int nbuf;                       // rows kept, 2 * half + 1
+   int added, done;                // lines added, and written out
+   float **row;                    // ring: line k is in row[k % nbuf]
+   float *null_row;
+   int geographic;                 // 1: spacings in radians, per line
+   double a, e2;                   // radius (m) and eccentricity^2
+   double lat0;                    // latitude of the first (north) line
+   double xspacing, yspacing;      // project units (radians or meters)
+   double sun_up, sun_east, sun_north;
+   unsigned char *ok;              // all 3x3 posts about a post valid
+   float *p, *q;                   // dz/dx east and dz/dy north
+   double *col;                    // roughness column sums, 6 per column
+   float *out[TERRAIN_PLANES];
+   unsigned char *shade;
+   FILE *fp[TERRAIN_PLANES];
+   char file[TERRAIN_PLANES][FILELEN];
+};
+
+// Cascade of row accumulators: level k (2^k reduction) holds one row of
+// level k-1 until its pair arrives, then writes the reduced row and
+// passes it on to level k+1.  Level 0 is the full resolution product.
+struct overview_pyramid {
+   int nlevels, nplanes;
+   int lines[MAX_OVR_LEVELS+1], samples[MAX_OVR_LEVELS+1];
+   int held[MAX_OVR_LEVELS+1];     // level k is holding a row of level k-1
+   int type[MAX_OVR_PLANES];
+   int size[MAX_OVR_PLANES];       // bytes per post
+   FILE *fp[MAX_OVR_PLANES][MAX_OVR_LEVELS+1];
+   unsigned char *row[MAX_OVR_PLANES][MAX_OVR_LEVELS+1];   // held row
+   unsigned char *out[MAX_OVR_PLANES][MAX_OVR_LEVELS+1];   // reduced row
+};
+
 // prototypes
-int parse_label(char *file, char *keyword, char *value);
-int getTargetInfo (char *uc_ellipsoid, char *isisTargName,
-	                char *ographicPosLonDir, char *ocentricPosLonDir);
-int writeToScript(char *isis_script, char *command);
+static int plan_standard_grid(char *prj, int lines, int samples,
+                              double x_realspacing, double y_realspacing,
+                              double ulcenter_Xlon, double ulcenter_Ylat,
+                              standard_grid *g);
+int overview_levels(int lines, int samples, int *ovr_lines, int *ovr_samples);
+static void free_overviews(overview_pyramid *p);
+static void discard_span_index(span_index *s);
+static void overview_raw_name(char *raw, int scale, char *name);
+static void script_overviews(char *isis_script, char *cub_name, char *raw,
+                             int lines, int samples, char *rawopts);
+static void script_product_overviews(char *isis_script, char *productType,
+                             char *byteOrder, char *prefix, char *outcub_name,
+                             char *FOM_name, char *CONF_name, char *raw,
+                             char *rawFOM, char *rawCONF, int confidence_flag,
+                             int lines, int samples);
+static void script_layout(char *isis_script, char *outcub, char *outcub_name,
+                          char *layout_cub, int from_overviews, int lines,
+                          int samples);
 
 /***********  generate_ss2isis_script **************
 *                                                  *
@@ -136,7 +346,9 @@ int generate_ss2isis_script (char *isis_script,
                                double x_realspacing,
                                double y_realspacing,
                                double ulcenter_Xlon,  // X (meters) or lon (radians) at center of upperleft pixel
-                               double ulcenter_Ylat   // Y (meters) or lat (radians) at center of upperleft pixel 
+                               double ulcenter_Ylat,  // Y (meters) or lat (radians) at center of upperleft pixel 
+                               int confidence_flag,   // 1 = also generate confidence cubes (DEMs only)
+                               int resampled_flag     // 1 = generate_standard_dem wrote the standard raw files
                                )
 
 {
@@ -166,6 +378,18 @@ int generate_ss2isis_script (char *isis_script,
    char SS_outcub[FILELEN];
    char SS_FOM_outcub[FILELEN];
    char layout_cub[FILELEN];
+   char rawCONF[FILELEN];
+   char CONF_outcub_name[FILELEN];
+   char CONF_outcub[FILELEN];
+   char SS_CONF_outcub[FILELEN];
+   char input_confcub[FILELEN];
+   char CONF_sqrcub[FILELEN];
+   char CONF_outcub_tiled[FILELEN];
+   char std_rawDEM[FILELEN];
+   char std_rawFOM[FILELEN];
+   char std_rawCONF[FILELEN];
+   standard_grid grid;
+   int standard_resampled = 0;   // standard cubes imported from generate_standard_dem files
    
    char note[256];
     
@@ -263,21 +487,11 @@ int generate_ss2isis_script (char *isis_script,
    // Get outcub (DEM or ORTHO)
    strcpy(outcub,concat(outcub_name,".cub"));
 
-   // Form output FOM file name
-   strcpy (FOM_outcub_name,outcub_name);
-   upper_case(FOM_outcub_name);
-   char* pos=NULL;
-   if (pos=strstr(FOM_outcub_name,"DEM")) {
-      strcpy (FOM_outcub_name,outcub_name); // Reset original case of filename
-      strncpy (pos,"FOM",3);               // Replace "DEM" with FOM, if DEM is in filename
-   }
-   else if (pos=strstr(FOM_outcub_name,"DTM")) {
-      strcpy (FOM_outcub_name,outcub_name); // Reset original case of filename
-      strncpy (pos,"FOM",3);             // Replace "DTM" with FOM, if DTM is in filename
-   }
-   else {       
-      strcpy (FOM_outcub_name,"FOM_");   // else, add FOM_ prefix
-      strcat (FOM_outcub_name,outcub_name);
+   // Form output FOM and confidence file names
+   form_product_names(outcub_name, FOM_outcub_name, CONF_outcub_name);
+   if (!strstr(productType,"DEM")) {
+      confidence_flag = 0;
+      resampled_flag = 0;
    }
    
    // Get raw binary input files
@@ -289,6 +503,10 @@ int generate_ss2isis_script (char *isis_script,
    strcat (rawFOM,FOM_outcub_name);
    strcat (rawFOM,".raw");
    
+   strcpy(rawCONF,"SS_");
+   strcat (rawCONF,CONF_outcub_name);
+   strcat (rawCONF,".raw");
+
    strcpy(rawORTHO,"SS_");
    strcat(rawORTHO,outcub_name);
    strcat(rawORTHO,".raw");
@@ -303,6 +521,10 @@ int generate_ss2isis_script (char *isis_script,
    strcpy (SS_FOM_outcub,"SS_");
    strcat (SS_FOM_outcub,FOM_outcub);
 
+   strcpy(CONF_outcub,concat(CONF_outcub_name,".cub"));
+   strcpy (SS_CONF_outcub,"SS_");
+   strcat (SS_CONF_outcub,CONF_outcub);
+
    // form socetset_map, standard_map, tempcub, input_cub, input_fomcub, sqrcub,
    // FOM_sqrcub, and layout_cub file names
 
@@ -333,6 +555,20 @@ int generate_ss2isis_script (char *isis_script,
    strcpy(FOM_outcub_tiled,FOM_outcub_name);
    strcat(FOM_outcub_tiled,".tiled.cub");
 
+   strcpy(input_confcub,"input_");
+   strcat(input_confcub,CONF_outcub);
+
+   strcpy(CONF_sqrcub,CONF_outcub_name);
+   strcat(CONF_sqrcub,".sqr.cub");
+
+   strcpy(CONF_outcub_tiled,CONF_outcub_name);
+   strcat(CONF_outcub_tiled,".tiled.cub");
+
+   // raw files already resampled to the standard cube (generate_standard_dem)
+   sprintf(std_rawDEM,"%s_standard.raw",outcub_name);
+   sprintf(std_rawFOM,"%s_standard.raw",FOM_outcub_name);
+   sprintf(std_rawCONF,"%s_standard.raw",CONF_outcub_name);
+
    strcpy(layout_cub,outcub_name);
    strcat(layout_cub,"_layout.cub");
 
@@ -366,6 +602,13 @@ int generate_ss2isis_script (char *isis_script,
       sprintf(command,"raw2isis from=%s to=%s samples=%d lines=%d bands=1\n",
               rawFOM,input_fomcub,samples,lines);
       writeToScript(isis_script,command);
+
+      // Convert the raw binary confidence file to a basic ISIS cube
+      if (confidence_flag) {
+         sprintf(command,"raw2isis from=%s to=%s samples=%d lines=%d bands=1\n",
+                 rawCONF,input_confcub,samples,lines);
+         writeToScript(isis_script,command);
+      }
    }
    else { // productType=ORTHO
       // Convert the raw binary ortho file to a basic ISIS cube
@@ -558,6 +801,12 @@ int generate_ss2isis_script (char *isis_script,
                writeToScript(isis_script,command);
             }
 
+            if (confidence_flag) {
+               sprintf(command,"cubeatt from=%s to=%s+BandSequential+Lsb+Attached\n",
+                      input_confcub,SS_CONF_outcub);
+               writeToScript(isis_script,command);
+            }
+
             // Run maplab to add the Socet Set mapping keywords to the DEM/FOM/ORTHO labels
             sprintf(command,"maplab from=%s map=%s sample=0.5 line=0.5 coordinates=latlon lat=%.8f lon=%.8f\n",
                   SS_outcub,socetset_map,ogRef_lat,ogRef_lon);
@@ -569,6 +818,12 @@ int generate_ss2isis_script (char *isis_script,
                writeToScript(isis_script,command);
             }
 
+            if (confidence_flag) {
+               sprintf(command,"maplab from=%s map=%s sample=0.5 line=0.5 coordinates=latlon lat=%.8f lon=%.8f\n",
+                                SS_CONF_outcub,socetset_map,ogRef_lat,ogRef_lon);
+               writeToScript(isis_script,command);
+            }
+
             // For ellipsoidal bodies, the pixels out of SOCET Set are not
             // scaled the same in the x-direction as in ISIS, so add comment to
             // ISIS labels and issue warning
@@ -580,6 +835,11 @@ int generate_ss2isis_script (char *isis_script,
                writeToScript(isis_script,command);
             }
 
+            if (confidence_flag) {
+               sprintf(command,"editlab from=%s options=addg grpname=SS2ISIS_IMPORT_NOTES\n",SS_CONF_outcub);
+               writeToScript(isis_script,command);
+            }
+
             sprintf(note,"PIXEL SCALE NOT ISIS COMPATIBLE, X-dg/px: %.14f, Y-dg/px: %.14f at equator", xSpacingDG, ySpacingDG);
             sprintf(command,"editlab from=%s grpname=SS2ISIS_IMPORT_NOTES keyword=NOTE1 value=\"%s\"\n",SS_outcub,note);
             writeToScript(isis_script,command);
@@ -588,6 +848,11 @@ int generate_ss2isis_script (char *isis_script,
                sprintf(command,"editlab from=%s grpname=SS2ISIS_IMPORT_NOTES keyword=NOTE1 value=\"%s\"\n",SS_FOM_outcub,note);
                writeToScript(isis_script,command);
             }
+
+            if (confidence_flag) {
+               sprintf(command,"editlab from=%s grpname=SS2ISIS_IMPORT_NOTES keyword=NOTE1 value=\"%s\"\n",SS_CONF_outcub,note);
+               writeToScript(isis_script,command);
+            }
          }
  
 //************************************************************************
@@ -685,7 +950,44 @@ int generate_ss2isis_script (char *isis_script,
             ocRef_lon = minlon;
          }
             
-         if (ecc != 0.0) {
+         if (ecc != 0.0 && resampled_flag &&
+             plan_standard_grid(prj, lines, samples, x_realspacing, y_realspacing,
+                                ulcenter_Xlon, ulcenter_Ylat, &grid)) {
+            // The DEM/FOM (and confidence) raw files were resampled to the
+            // standard cube on the SOCET SET side by generate_standard_dem,
+            // so import them and add the mapping labels.  (The resampled
+            // DEM has true ISIS NULLs, so it needs no LRS->NULL stretch.)
+            standard_resampled = 1;
+            sprintf(command,"maptemplate map=%s projection=%s clon=%.8f clat=%.8f targopt=user targetname=%s eqradius=%.3f polradius=%.3f lattype=%s londir=%s londom=%d resopt=mpp resolution=%.8f\n",
+                    standard_map,grid.polar ? "polarstereographic" : "equirectangular",
+                    grid.clon,grid.clat,isisTargName,eqradius,polradius,lattype,
+                    ocentricPosLonDir,grid.londom,grid.res);
+            writeToScript(isis_script,command);
+
+            sprintf(command,"raw2isis from=%s to=%s samples=%d lines=%d bands=1 bittype=real byteorder=%s\n",
+                    std_rawDEM,outcub_tiled,grid.samples,grid.lines,byteOrder);
+            writeToScript(isis_script,command);
+            sprintf(command,"maplab from=%s map=%s sample=1.0 line=1.0 x=%.8f y=%.8f\n",
+                    outcub_tiled,standard_map,grid.ulx,grid.uly);
+            writeToScript(isis_script,command);
+
+            sprintf(command,"raw2isis from=%s to=%s samples=%d lines=%d bands=1\n",
+                    std_rawFOM,FOM_outcub_tiled,grid.samples,grid.lines);
+            writeToScript(isis_script,command);
+            sprintf(command,"maplab from=%s map=%s sample=1.0 line=1.0 x=%.8f y=%.8f\n",
+                    FOM_outcub_tiled,standard_map,grid.ulx,grid.uly);
+            writeToScript(isis_script,command);
+
+            if (confidence_flag) {
+               sprintf(command,"raw2isis from=%s to=%s samples=%d lines=%d bands=1\n",
+                       std_rawCONF,CONF_outcub_tiled,grid.samples,grid.lines);
+               writeToScript(isis_script,command);
+               sprintf(command,"maplab from=%s map=%s sample=1.0 line=1.0 x=%.8f y=%.8f\n",
+                       CONF_outcub_tiled,standard_map,grid.ulx,grid.uly);
+               writeToScript(isis_script,command);
+            }
+         }
+         else if (ecc != 0.0) {
             // Calculate scale factor to apply in sample direction
             // Use dg/px rather than m/px
             sscale = xSpacingDG / ySpacingDG;
@@ -705,6 +1007,12 @@ int generate_ss2isis_script (char *isis_script,
                          input_fomcub, FOM_sqrcub, sscale);
                 writeToScript(isis_script,command);
               }
+
+              if (confidence_flag) {
+                 sprintf(command,"enlarge from=%s to=%s sscale=%.10f lscale=1.0 interp=nearestneighbor\n",
+                         input_confcub, CONF_sqrcub, sscale);
+                 writeToScript(isis_script,command);
+              }
              }
              else {
                //NOTE: scale factor must be greater than 1.0, so pass inverse
@@ -718,6 +1026,12 @@ int generate_ss2isis_script (char *isis_script,
                          input_fomcub, FOM_sqrcub, 1.0/sscale);
                   writeToScript(isis_script,command);
                }
+
+               if (confidence_flag) {
+                  sprintf(command,"reduce from=%s to=%s sscale=%.10f lscale=1.0 algorithm=nearest\n",
+                         input_confcub, CONF_sqrcub, 1.0/sscale);
+                  writeToScript(isis_script,command);
+               }
              }
             
              // Run maplab to add the socetset map projection to the labels
@@ -736,6 +1050,12 @@ int generate_ss2isis_script (char *isis_script,
                         FOM_sqrcub,socetset_map,ogRef_lat,ogRef_lon);
                 writeToScript(isis_script,command);
              }
+
+             if (confidence_flag) {
+                sprintf(command,"maplab from=%s map=%s sample=0.5 line=0.5 coordinates=latlon lat=%.8f lon=%.8f\n",
+                        CONF_sqrcub,socetset_map,ogRef_lat,ogRef_lon);
+                writeToScript(isis_script,command);
+             }
         
             // Now run maptemplate to define the projection of the standard
             // cube depending on the planet
@@ -789,12 +1109,19 @@ int generate_ss2isis_script (char *isis_script,
                       FOM_sqrcub,standard_map,FOM_outcub_tiled);
                writeToScript(isis_script,command);
             }
+
+            if (confidence_flag) {
+               sprintf(command,"map2map from=%s map=%s to=%s pixres=map interp=nearestneighbor\n",
+                      CONF_sqrcub,standard_map,CONF_outcub_tiled);
+               writeToScript(isis_script,command);
+            }
          }
          else { // THIS IS A SPHEROID
             // The input cubes are already "square", so replace the
             // sqrcub and FOM_sqrcub file names with the input file names
             strcpy(sqrcub,input_cub);
             strcpy(FOM_sqrcub,input_fomcub);
+            strcpy(CONF_sqrcub,input_confcub);
              
             // For Moon and other spheres:
             //    keep cubes as equi, with original clat, but change clon as specified.
@@ -820,10 +1147,17 @@ int generate_ss2isis_script (char *isis_script,
                         FOM_sqrcub,standard_map,ocRef_lat,ocRef_lon);
                 writeToScript(isis_script,command);
             }
+
+            if (confidence_flag) {
+                sprintf(command,"maplab from=%s map=%s sample=0.5 line=0.5 coordinates=latlon lat=%.8f lon=%.8f\n",
+                        CONF_sqrcub,standard_map,ocRef_lat,ocRef_lon);
+                writeToScript(isis_script,command);
+            }
             // The input cubes are the "outcub_tiled" cubes, so replace the
             // outcub_tiled and FOM_outcub_tiled file names with the input file names
             strcpy(outcub_tiled,input_cub);
             strcpy(FOM_outcub_tiled,input_fomcub);
+            strcpy(CONF_outcub_tiled,input_confcub);
 
         }
 
@@ -841,6 +1175,12 @@ int generate_ss2isis_script (char *isis_script,
             writeToScript(isis_script,command);
          }
 
+         if (confidence_flag) {
+            sprintf(command,"cubeatt from=%s to=%s+BandSequential+Lsb+Attached\n",
+                    CONF_outcub_tiled,CONF_outcub);
+            writeToScript(isis_script,command);
+         }
+
          // Delete remaining temporary files
          if (strstr(productType,"DEM"))
             sprintf(command,"/bin/rm -f %s %s %s %s %s %s %s %s\n",input_cub,input_fomcub,sqrcub,FOM_sqrcub,outcub_tiled,FOM_outcub_tiled,socetset_map,standard_map);
@@ -848,21 +1188,35 @@ int generate_ss2isis_script (char *isis_script,
             sprintf(command,"/bin/rm -f %s %s %s %s %s\n",sqrcub,input_cub,outcub_tiled,socetset_map,standard_map);
          writeToScript(isis_script,command);
 
+         if (confidence_flag) {
+            sprintf(command,"/bin/rm -f %s %s %s\n",input_confcub,CONF_sqrcub,CONF_outcub_tiled);
+            writeToScript(isis_script,command);
+         }
+
          /////////////////////////////////////////////////////////
-         // If a lower-resolution layout file is need, generate it
+         // If a lower-resolution layout file is need, import the
+         // overview pyramids written with the raw files and
+         // generate it
          /////////////////////////////////////////////////////////
          
          if (layout_flag[0]=='y' || layout_flag[0]=='Y') {
-           // Output description of this section to script file
-           sprintf(command,"#############################################################");
-           writeToScript(isis_script,command);
-           sprintf(command,"## Generate reduced resolution ISIS cubes for ARCMAP layouts");
-           writeToScript(isis_script,command);
-           sprintf(command,"#############################################################\n");
-           writeToScript(isis_script,command);
-         
-           sprintf(command,"reduce from=%s to=%s sscale=5.0 lscale=5.0 validper=10 vper_replace=nearest\n",outcub,layout_cub);
-           writeToScript(isis_script,command);
+           // Native overviews belong to the SS_ cubes of ellipsoids,
+           // and are the standard overviews for spheres
+           script_product_overviews(isis_script,productType,byteOrder,
+                                    (ecc != 0.0) ? (char *)"SS_" : (char *)"",
+                                    outcub_name,FOM_outcub_name,CONF_outcub_name,
+                                    rawDEM,rawFOM,rawCONF,confidence_flag,lines,samples);
+
+           if (standard_resampled)
+              script_product_overviews(isis_script,productType,byteOrder,"",
+                                       outcub_name,FOM_outcub_name,CONF_outcub_name,
+                                       std_rawDEM,std_rawFOM,std_rawCONF,confidence_flag,
+                                       grid.lines,grid.samples);
+
+           if (standard_resampled)
+              script_layout(isis_script,outcub,outcub_name,layout_cub,1,grid.lines,grid.samples);
+           else
+              script_layout(isis_script,outcub,outcub_name,layout_cub,ecc == 0.0,lines,samples);
          }
 
       break;
@@ -976,6 +1330,11 @@ int generate_ss2isis_script (char *isis_script,
           writeToScript(isis_script,command);
        }
 
+       if (confidence_flag) {
+          sprintf(command,"maplab from=%s map=%s sample=1.0 line=1.0 x=%.8f y=%.8f\n",input_confcub,standard_map,ulcenter_Xlon,ulcenter_Ylat);
+          writeToScript(isis_script,command);
+       }
+
        // For portability, convert tiled cubes to BSQ format.
        // NOTE: it is faster run ISIS programs on tiled cubes, and then
        //       run cubeatt to do the reformat
@@ -989,6 +1348,12 @@ int generate_ss2isis_script (char *isis_script,
           writeToScript(isis_script,command);
        }
 
+       if (confidence_flag) {
+          sprintf(command,"cubeatt from=%s to=%s+BandSequential+Lsb+Attached\n",
+                  input_confcub,CONF_outcub);
+          writeToScript(isis_script,command);
+       }
+
        // Delete remaining temporary files
        if (strstr(productType,"DEM"))
           sprintf(command,"/bin/rm -f %s %s %s %s\n",input_cub,input_fomcub,socetset_map,standard_map);
@@ -996,21 +1361,22 @@ int generate_ss2isis_script (char *isis_script,
           sprintf(command,"/bin/rm -f %s %s %s\n",input_cub,socetset_map,standard_map);
        writeToScript(isis_script,command);
 
+       if (confidence_flag) {
+          sprintf(command,"/bin/rm -f %s\n",input_confcub);
+          writeToScript(isis_script,command);
+       }
+
        /////////////////////////////////////////////////////////
-       // If a lower-resolution layout file is need, generate it
+       // If a lower-resolution layout file is need, import the
+       // overview pyramids written with the raw files and
+       // generate it
        /////////////////////////////////////////////////////////
        
        if (layout_flag[0]=='y' || layout_flag[0]=='Y') {
-         // Output description of this section to script file
-         sprintf(command,"#############################################################");
-         writeToScript(isis_script,command);
-         sprintf(command,"## Generate reduced resolution ISIS cubes for ARCMAP layouts");
-         writeToScript(isis_script,command);
-         sprintf(command,"#############################################################\n");
-         writeToScript(isis_script,command);
-       
-         sprintf(command,"reduce from=%s to=%s sscale=5.0 lscale=5.0 validper=10 vper_replace=nearest\n",outcub,layout_cub);
-         writeToScript(isis_script,command);
+         script_product_overviews(isis_script,productType,byteOrder,"",
+                                  outcub_name,FOM_outcub_name,CONF_outcub_name,
+                                  rawDEM,rawFOM,rawCONF,confidence_flag,lines,samples);
+         script_layout(isis_script,outcub,outcub_name,layout_cub,1,lines,samples);
        }
     
 ////SOME UTM NOTES KEPT FOR REFERENECE:
@@ -1063,6 +1429,7 @@ int parse_label(char *file, char *keyword, char *value)
       scan_value = fscanf (fp,"%s",id);
       strcpy(value,id);
       //printf("%s\n",value);
+      fclose(fp);
       return(1);
     }
     scan_value = fscanf (fp,"%s",id);
@@ -1753,3 +2120,2169 @@ int writeToScript(char *isis_script, char *command)
 
 } // End of writeToScript
 
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Standard DEM cube resampling
+//
+// For geographic projects of ellipsoidal bodies, the standard ISIS DEM/FOM
+// cubes have ocentric latitudes and ISIS pixel scale, in equirectangular or
+// (for Mars above +/-65 degrees) polar stereographic projection.  Rather
+// than leave the resampling to enlarge/reduce + map2map in the ISIS script,
+// generate_standard_dem resamples the SS_*.raw files written by dem2isis3
+// directly into raw files in the standard geometry, and the script only
+// imports them and adds the mapping labels.
+//
+// The inverse mapping (output x/y -> input line/sample) is computed once per
+// output tile and used for the DEM (bilinear, falling back to nearest
+// neighbor next to NULLs as map2map does) and for the FOM and confidence
+// files (nearest neighbor).  Tiles of a band of output lines are resampled
+// in parallel (Windows threads) and the band written out in order.
+////////////////////////////////////////////////////////////////////////////////
+
+/**************  wrap_pi  **************************/
+static double wrap_pi(double angle)
+{
+   return angle - 2.0*M_PI*floor((angle + M_PI)/(2.0*M_PI));
+}
+
+/**************  local_radius  *********************
+*                                                  *
+*  Radius (m) of the ellipsoid at ocentric lat     *
+*  (degrees), as ISIS computes it                  *
+*                                                  *
+****************************************************/
+static double local_radius(double a, double b, double lat)
+{
+   double coslat = cos(lat*M_PI/180.0);
+   double sinlat = sin(lat*M_PI/180.0);
+
+   return a*b / sqrt(b*b*coslat*coslat + a*a*sinlat*sinlat);
+}
+
+/**************  std_forward  **********************
+*                                                  *
+*  ographic lat, +East lon (radians) -> standard   *
+*  projection x/y (m).  Equirectangular           *
+*  longitudes are taken relative to the center of  *
+*  the input grid so DEMs crossing the longitude   *
+*  domain edge stay contiguous.                    *
+*                                                  *
+****************************************************/
+static void std_forward(standard_grid *g, double lat, double lon,
+                        double *x, double *y)
+{
+   double phi, sinphi, t, rho, dlon;
+
+   if (!g->polar) {
+      dlon = wrap_pi(g->in_lonmid - g->clon_east) + wrap_pi(lon - g->in_lonmid);
+      *x = g->radius * dlon * g->cosclat;
+      *y = g->radius * atan2(sin(lat)*g->b*g->b, cos(lat)*g->a*g->a);
+   }
+   else {
+      phi = g->south ? -lat : lat;
+      sinphi = sin(phi);
+      t = tan(M_PI/4.0 - phi/2.0) /
+          pow((1.0 - g->e*sinphi)/(1.0 + g->e*sinphi), g->e/2.0);
+      rho = 2.0 * g->a * t / g->e4;
+      dlon = lon - g->clon_east;
+      *x = rho * sin(dlon);
+      *y = g->south ? rho * cos(dlon) : -rho * cos(dlon);
+   }
+}
+
+/**************  std_inverse  **********************
+*                                                  *
+*  standard projection x/y (m) -> ographic lat,    *
+*  +East lon (radians).  Returns 0 if x/y is off   *
+*  the body.                                       *
+*                                                  *
+****************************************************/
+static int std_inverse(standard_grid *g, double x, double y,
+                       double *lat, double *lon)
+{
+   double latoc, rho, t, phi, prev, sinphi;
+   int i;
+
+   if (!g->polar) {
+      latoc = y / g->radius;
+      if (fabs(latoc) > M_PI/2.0)
+         return(0);
+      *lat = atan2(sin(latoc)*g->a*g->a, cos(latoc)*g->b*g->b);
+      *lon = g->clon_east + x / (g->radius * g->cosclat);
+      return(1);
+   }
+
+   rho = sqrt(x*x + y*y);
+   t = rho * g->e4 / (2.0 * g->a);
+   phi = M_PI/2.0 - 2.0*atan(t);
+   for (i = 0; i < 15; i++) {
+      prev = phi;
+      sinphi = sin(phi);
+      phi = M_PI/2.0 - 2.0*atan(t * pow((1.0 - g->e*sinphi)/(1.0 + g->e*sinphi), g->e/2.0));
+      if (fabs(phi - prev) < 1.0e-12)
+         break;
+   }
+   *lat = g->south ? -phi : phi;
+   if (rho == 0.0)
+      *lon = g->clon_east;
+   else
+      *lon = g->clon_east + (g->south ? atan2(x, y) : atan2(x, -y));
+   return(1);
+}
+
+/**************  plan_standard_grid  ***************
+*                                                  *
+*  Works out the standard cube projection the same *
+*  way generate_ss2isis_script does for map2map,   *
+*  and the extent of the standard grid.  Returns   *
+*  1 if the standard cube needs resampling         *
+*  (geographic project of an ellipsoidal body),    *
+*  0 if not.                                       *
+*                                                  *
+****************************************************/
+static int plan_standard_grid(char *prj, int lines, int samples,
+                              double x_realspacing, double y_realspacing,
+                              double ulcenter_Xlon, double ulcenter_Ylat,
+                              standard_grid *g)
+{
+   char value[FILELEN];
+   char ellipsoid[FILELEN];
+   char isisTargName[FILELEN];
+   char ographicPosLonDir[13];
+   double ecc, minlat, maxlat, avglat, lat_cutoff, prjclat;
+   double minx, maxx, miny, maxy, x, y, r, c, res;
+   double rad2deg = 180.0 / M_PI;
+   int i, n, mars;
+
+   parse_label(prj, "COORD_SYS", value);
+   if (atoi(value) != 1)
+      return(0);
+
+   parse_label(prj, "E_EARTH", value);
+   ecc = atof(value);
+   if (ecc == 0.0)
+      return(0);
+
+   memset(g, 0, sizeof(standard_grid));
+
+   parse_label(prj, "A_EARTH", value);
+   g->a = atof(value);
+   g->b = sqrt(g->a*g->a*(1.0-ecc*ecc));
+   g->e = ecc;
+
+   parse_label(prj, "ELLIPSOID", ellipsoid);
+   upper_case(ellipsoid);
+   if (getTargetInfo(ellipsoid, isisTargName, ographicPosLonDir, g->londir) != 0)
+      return(0);
+   mars = (strstr(ellipsoid,"MARS") != NULL);
+
+   parse_label(prj, "GP_ORIGIN_Y", value);
+   prjclat = atof(value) * rad2deg;
+
+   g->in_lines = lines;
+   g->in_samples = samples;
+   g->in_lat0 = ulcenter_Ylat;
+   g->in_lon0 = ulcenter_Xlon;
+   g->in_dlat = y_realspacing;
+   g->in_dlon = x_realspacing;
+   g->in_lonmid = ulcenter_Xlon + x_realspacing*(samples-1)/2.0;
+
+   // Projection: same choices as the map2map branch of generate_ss2isis_script
+   minlat = (ulcenter_Ylat-(y_realspacing*(lines-1))-y_realspacing/2.0 ) * rad2deg;
+   maxlat = (ulcenter_Ylat+y_realspacing/2.0)*rad2deg;
+   avglat = minlat + (maxlat-minlat)/2.0;
+   lat_cutoff = mars ? 65.0 : 999.0;
+
+   g->londom = mars ? 360 : 180;
+   if (avglat < -lat_cutoff || avglat > lat_cutoff) {
+      g->polar = 1;
+      g->south = (avglat < 0.0);
+      g->clat = g->south ? -90.0 : 90.0;
+      g->clon = 0.0;
+      g->e4 = sqrt(pow(1.0+ecc, 1.0+ecc) * pow(1.0-ecc, 1.0-ecc));
+   }
+   else {
+      g->polar = 0;
+      g->clat = mars ? 0.0 : prjclat;
+      g->clon = mars ? 180.0 : 0.0;
+      g->radius = local_radius(g->a, g->b, g->clat);
+      g->cosclat = cos(g->clat/rad2deg);
+   }
+   g->clon_east = g->clon / rad2deg;
+   if (strcmp(g->londir,"positiveWest") == 0)
+      g->clon_east = -g->clon_east;
+
+   // Pixel size: the 1/ySpacingDG pixels/degree used for map2map, at the
+   // true scale latitude of the projection
+   res = y_realspacing * local_radius(g->a, g->b, g->clat);
+   g->res = res;
+
+   // Extent: the standard grid covers the outer edge of the input posts
+   minx = miny = 1.0e+300;
+   maxx = maxy = -1.0e+300;
+   n = 2*(lines + samples) + 4;
+   for (i = 0; i <= n; i++) {
+      if (i <= samples) {                       // top edge
+         r = -0.5;  c = i - 0.5;
+      }
+      else if (i <= 2*samples + 1) {            // bottom edge
+         r = lines - 0.5;  c = i - samples - 1 - 0.5;
+      }
+      else if (i <= 2*samples + lines + 2) {    // left edge
+         r = i - 2*samples - 2 - 0.5;  c = -0.5;
+      }
+      else {                                    // right edge
+         r = i - 2*samples - lines - 3 - 0.5;  c = samples - 0.5;
+      }
+      y = g->in_lat0 - r*g->in_dlat;
+      if (y > M_PI/2.0) y = M_PI/2.0;
+      if (y < -M_PI/2.0) y = -M_PI/2.0;
+      std_forward(g, y, g->in_lon0 + c*g->in_dlon, &x, &y);
+      if (x < minx) minx = x;
+      if (x > maxx) maxx = x;
+      if (y < miny) miny = y;
+      if (y > maxy) maxy = y;
+   }
+
+   // snap the outer edge to whole pixels
+   minx = floor(minx/res) * res;
+   maxy = ceil(maxy/res) * res;
+   g->samples = (int) ceil((maxx - minx)/res);
+   g->lines = (int) ceil((maxy - miny)/res);
+   if (g->samples < 1) g->samples = 1;
+   if (g->lines < 1) g->lines = 1;
+   g->ulx = minx + res/2.0;
+   g->uly = maxy - res/2.0;
+
+   return(1);
+}
+
+/**************  resample_tile  ********************
+*                                                  *
+*  Resamples one output tile of a band.  fp[] are  *
+*  this thread's DEM/FOM/CONF input files, rr/cc   *
+*  hold STD_TILE*STD_TILE input coordinates, and   *
+*  win/winsize the window buffer (grown here)      *
+*                                                  *
+****************************************************/
+static int resample_tile(resample_band *band, int tile, FILE **fp,
+                         double *rr, double *cc, unsigned char **win,
+                         long long *winsize)
+{
+   standard_grid *g = band->grid;
+   union { unsigned int i; float f; } null4;
+   double x, y, lat, lon, r, c, fr, fc, top, bot;
+   double rmin, rmax, cmin, cmax, lonoff;
+   long long need, k, o;
+   int s0, ns, l, s, r0, r1, c0, c1, wl, ws, ir, ic, jr, jc;
+   float *wdem, v00, v01, v10, v11, z;
+   unsigned char *wfom, *wconf, f, cf;
+
+   null4.i = STD_NULL_BITS;
+
+   s0 = tile * STD_TILE;
+   ns = g->samples - s0;
+   if (ns > STD_TILE) ns = STD_TILE;
+
+   // Inverse mapping for every pixel of the tile (rr < -1 flags off-body)
+   lonoff = g->in_lonmid - g->in_lon0;
+   rmin = cmin = 1.0e+300;
+   rmax = cmax = -1.0e+300;
+   for (l = 0; l < band->nlines; l++) {
+      y = g->uly - (band->line0 + l) * g->res;
+      for (s = 0; s < ns; s++) {
+         k = l*STD_TILE + s;
+         x = g->ulx + (s0 + s) * g->res;
+         if (!std_inverse(g, x, y, &lat, &lon)) {
+            rr[k] = -2.0;
+            continue;
+         }
+         r = (g->in_lat0 - lat) / g->in_dlat;
+         c = (wrap_pi(lon - g->in_lonmid) + lonoff) / g->in_dlon;
+         if (r < -0.5 || r > g->in_lines - 0.5 || c < -0.5 || c > g->in_samples - 0.5) {
+            rr[k] = -2.0;
+            continue;
+         }
+         rr[k] = r;
+         cc[k] = c;
+         if (r < rmin) rmin = r;
+         if (r > rmax) rmax = r;
+         if (c < cmin) cmin = c;
+         if (c > cmax) cmax = c;
+      }
+   }
+
+   // Read the window of input posts the tile needs
+   wl = ws = 0;
+   r0 = c0 = 0;
+   if (rmax >= rmin) {
+      r0 = (int) floor(rmin);  if (r0 < 0) r0 = 0;
+      r1 = (int) floor(rmax) + 1;  if (r1 > g->in_lines - 1) r1 = g->in_lines - 1;
+      c0 = (int) floor(cmin);  if (c0 < 0) c0 = 0;
+      c1 = (int) floor(cmax) + 1;  if (c1 > g->in_samples - 1) c1 = g->in_samples - 1;
+      wl = r1 - r0 + 1;
+      ws = c1 - c0 + 1;
+
+      need = (long long) wl * ws * (sizeof(float) + 2);
+      if (need > *winsize) {
+         free(*win);
+         *win = (unsigned char *) malloc((size_t) need);
+         if (*win == NULL) {
+            printf("\nunable to allocate %lld bytes to resample the standard DEM\n", need);
+            *winsize = 0;
+            return(-1);
+         }
+         *winsize = need;
+      }
+   }
+   wdem = (float *) *win;
+   wfom = *win + (long long) wl * ws * sizeof(float);
+   wconf = wfom + (long long) wl * ws;
+
+   for (l = 0; l < wl; l++) {
+      o = (long long)(r0 + l) * g->in_samples + c0;
+      if (FSEEK64(fp[0], o * sizeof(float), SEEK_SET) != 0 ||
+          fread(wdem + (long long) l*ws, sizeof(float), ws, fp[0]) != (size_t) ws ||
+          FSEEK64(fp[1], o, SEEK_SET) != 0 ||
+          fread(wfom + (long long) l*ws, 1, ws, fp[1]) != (size_t) ws) {
+         printf("\nerror reading %s/%s\n", band->inDEM, band->inFOM);
+         return(-1);
+      }
+      if (fp[2] != NULL &&
+          (FSEEK64(fp[2], o, SEEK_SET) != 0 ||
+           fread(wconf + (long long) l*ws, 1, ws, fp[2]) != (size_t) ws)) {
+         printf("\nerror reading %s\n", band->inCONF);
+         return(-1);
+      }
+   }
+
+   // Resample
+   for (l = 0; l < band->nlines; l++) {
+      for (s = 0; s < ns; s++) {
+         k = l*STD_TILE + s;
+         o = (long long) l * g->samples + s0 + s;
+         r = rr[k];
+         if (r < -1.0) {
+            band->dem[o] = null4.f;
+            band->fom[o] = 0;
+            if (band->conf != NULL) band->conf[o] = 0;
+            continue;
+         }
+         c = cc[k];
+
+         // nearest neighbor
+         ir = (int) floor(r + 0.5);
+         ic = (int) floor(c + 0.5);
+         if (ir > g->in_lines - 1) ir = g->in_lines - 1;
+         if (ic > g->in_samples - 1) ic = g->in_samples - 1;
+         if (ir < 0) ir = 0;
+         if (ic < 0) ic = 0;
+         f = wfom[(ir - r0)*ws + (ic - c0)];
+         cf = wconf[(ir - r0)*ws + (ic - c0)];
+         z = wdem[(ir - r0)*ws + (ic - c0)];
+         if (f < 2 || z < -1.0e+38f)
+            z = null4.f;
+
+         // bilinear, if all four neighbors are valid
+         jr = (int) floor(r);
+         jc = (int) floor(c);
+         if (jr >= 0 && jc >= 0 && jr + 1 < g->in_lines && jc + 1 < g->in_samples) {
+            v00 = wdem[(jr - r0)*ws + (jc - c0)];
+            v01 = wdem[(jr - r0)*ws + (jc - c0 + 1)];
+            v10 = wdem[(jr - r0 + 1)*ws + (jc - c0)];
+            v11 = wdem[(jr - r0 + 1)*ws + (jc - c0 + 1)];
+            if (v00 > -1.0e+38f && v01 > -1.0e+38f && v10 > -1.0e+38f && v11 > -1.0e+38f &&
+                wfom[(jr - r0)*ws + (jc - c0)] >= 2 && wfom[(jr - r0)*ws + (jc - c0 + 1)] >= 2 &&
+                wfom[(jr - r0 + 1)*ws + (jc - c0)] >= 2 && wfom[(jr - r0 + 1)*ws + (jc - c0 + 1)] >= 2) {
+               fr = r - jr;
+               fc = c - jc;
+               top = v00 + fc*(v01 - v00);
+               bot = v10 + fc*(v11 - v10);
+               z = (float) (top + fr*(bot - top));
+            }
+         }
+
+         band->dem[o] = z;
+         band->fom[o] = f;
+         if (band->conf != NULL) band->conf[o] = cf;
+      }
+   }
+
+   return(0);
+}
+
+/**************  resample_worker  ******************
+*                                                  *
+*  Resamples tiles of a band until none are left   *
+*                                                  *
+****************************************************/
+static void resample_worker(void *arg)
+{
+   resample_band *band = (resample_band *) arg;
+   FILE *fp[3];
+   double *rr, *cc;
+   unsigned char *win = NULL;
+   long long winsize = 0;
+   int tile;
+
+   fp[0] = fopen(band->inDEM, "rb");
+   fp[1] = fopen(band->inFOM, "rb");
+   fp[2] = (band->inCONF != NULL) ? fopen(band->inCONF, "rb") : NULL;
+   rr = (double *) malloc(STD_TILE*STD_TILE*sizeof(double));
+   cc = (double *) malloc(STD_TILE*STD_TILE*sizeof(double));
+
+   if (fp[0] == NULL || fp[1] == NULL || (band->inCONF != NULL && fp[2] == NULL) ||
+       rr == NULL || cc == NULL) {
+      printf("\nunable to open raw files or allocate memory to resample the standard DEM\n");
+      band->err = 1;
+   }
+
+   while (!band->err && (tile = next_work_item(&band->next_tile)) < band->ntiles)
+      if (resample_tile(band, tile, fp, rr, cc, &win, &winsize) != 0)
+         band->err = 1;
+
+   for (tile = 0; tile < 3; tile++)
+      if (fp[tile] != NULL) fclose(fp[tile]);
+   free(rr);
+   free(cc);
+   free(win);
+}
+
+/**************  form_product_names  ***************
+*                                                  *
+*  FOM and confidence names from the DEM output    *
+*  name: DEM (or else DTM) in the name, in any     *
+*  case, is replaced by FOM/CONF, or without       *
+*  either the name gets a FOM_/CONF_ prefix        *
+*                                                  *
+****************************************************/
+void form_product_names(char *outcub_name, char *FOM_name, char *CONF_name)
+{
+   char *pos;
+   char uc_name[FILELEN];
+
+   strcpy(uc_name, outcub_name);
+   upper_case(uc_name);
+   if ((pos=strstr(uc_name,"DEM")) || (pos=strstr(uc_name,"DTM"))) {
+      sprintf(FOM_name, "%.*sFOM%s", (int)(pos-uc_name), outcub_name, outcub_name+(pos-uc_name)+3);
+      sprintf(CONF_name, "%.*sCONF%s", (int)(pos-uc_name), outcub_name, outcub_name+(pos-uc_name)+3);
+   }
+   else {
+      sprintf(FOM_name, "FOM_%s", outcub_name);
+      sprintf(CONF_name, "CONF_%s", outcub_name);
+   }
+}
+
+/**************  generate_standard_dem  ************
+*                                                  *
+*  Resamples the SS_ raw DEM/FOM (and confidence)  *
+*  files to <name>_standard.raw files in the       *
+*  geometry of the standard ISIS cubes.  Returns   *
+*  1 if the files were written, 0 if the project   *
+*  needs no resampling for the standard cubes      *
+*  (map-projected projects and spherical bodies),  *
+*  and -1 on error.  With overview_flag set, the   *
+*  overview pyramid of the standard files is built *
+*  as they are written.  <name>.spans gets the     *
+*  NULL-span index of the standard DEM.            *
+*                                                  *
+****************************************************/
+int generate_standard_dem(char *prj, char *outcub_name, int lines, int samples,
+                          double x_realspacing, double y_realspacing,
+                          double ulcenter_Xlon, double ulcenter_Ylat,
+                          int confidence_flag, int overview_flag)
+{
+   standard_grid g;
+   resample_band band;
+   overview_pyramid *ovr = NULL;
+   span_index *spans = NULL;
+   int ovr_types[3] = {OVR_DEM, OVR_FOM, OVR_CONF};
+   char *ovr_files[3];
+   void *ovr_rows[3];
+   char FOM_name[FILELEN], CONF_name[FILELEN];
+   char inDEM[FILELEN], inFOM[FILELEN], inCONF[FILELEN];
+   char outDEM[FILELEN], outFOM[FILELEN], outCONF[FILELEN];
+   char spanFile[FILELEN];
+   FILE *ofp_DEM, *ofp_FOM, *ofp_CONF = NULL;
+   long long nband;
+   int l, nthreads, line0, pct, last_pct;
+   int ret = -1;
+
+   if (!plan_standard_grid(prj, lines, samples, x_realspacing, y_realspacing,
+                           ulcenter_Xlon, ulcenter_Ylat, &g))
+      return(0);
+
+   form_product_names(outcub_name, FOM_name, CONF_name);
+   sprintf(inDEM, "SS_%s.raw", outcub_name);
+   sprintf(inFOM, "SS_%s.raw", FOM_name);
+   sprintf(inCONF, "SS_%s.raw", CONF_name);
+   sprintf(outDEM, "%s_standard.raw", outcub_name);
+   sprintf(outFOM, "%s_standard.raw", FOM_name);
+   sprintf(outCONF, "%s_standard.raw", CONF_name);
+   sprintf(spanFile, "%s.spans", outcub_name);   // of the standard <cube>.cub
+
+   printf("Resampling to standard %s cube, %d lines x %d samples at %.3f m/px...\n",
+          g.polar ? "polar stereographic" : "equirectangular", g.lines, g.samples, g.res);
+
+   memset(&band, 0, sizeof(band));
+   ofp_DEM = fopen(outDEM, "wb");
+   ofp_FOM = fopen(outFOM, "wb");
+   if (confidence_flag)
+      ofp_CONF = fopen(outCONF, "wb");
+   if (ofp_DEM == NULL || ofp_FOM == NULL || (confidence_flag && ofp_CONF == NULL)) {
+      printf("\ncan't open the output standard raw files: %s, %s\n", outDEM, outFOM);
+      goto done;
+   }
+
+   band.grid = &g;
+   band.inDEM = inDEM;
+   band.inFOM = inFOM;
+   band.inCONF = confidence_flag ? inCONF : NULL;
+   band.ntiles = (g.samples + STD_TILE - 1) / STD_TILE;
+   nband = (long long) STD_TILE * g.samples;
+   band.dem = (float *) malloc((size_t) nband * sizeof(float));
+   band.fom = (unsigned char *) malloc((size_t) nband);
+   band.conf = confidence_flag ? (unsigned char *) malloc((size_t) nband) : NULL;
+   if (band.dem == NULL || band.fom == NULL || (confidence_flag && band.conf == NULL)) {
+      printf("\nunable to allocate memory to resample the standard DEM\n");
+      goto done;
+   }
+
+   if (overview_flag) {
+      ovr_files[0] = outDEM;
+      ovr_files[1] = outFOM;
+      ovr_files[2] = outCONF;
+      ovr = open_overviews(g.lines, g.samples, confidence_flag ? 3 : 2,
+                           ovr_types, ovr_files);
+      if (ovr == NULL)
+         goto done;
+   }
+
+   spans = open_span_index(spanFile, g.lines, g.samples);
+   if (spans == NULL)
+      goto done;
+
+   nthreads = worker_threads(band.ntiles);
+   last_pct = 0;
+   for (line0 = 0; line0 < g.lines; line0 += STD_TILE) {
+      band.line0 = line0;
+      band.nlines = g.lines - line0;
+      if (band.nlines > STD_TILE) band.nlines = STD_TILE;
+      band.next_tile = 0;
+
+      run_workers(resample_worker, &band, nthreads);
+      if (band.err)
+         goto done;
+
+      nband = (long long) band.nlines * g.samples;
+      if (fwrite(band.dem, sizeof(float), (size_t) nband, ofp_DEM) != (size_t) nband ||
+          fwrite(band.fom, 1, (size_t) nband, ofp_FOM) != (size_t) nband ||
+          (ofp_CONF != NULL && fwrite(band.conf, 1, (size_t) nband, ofp_CONF) != (size_t) nband)) {
+         printf("\nerror writing the standard raw files\n");
+         goto done;
+      }
+
+      for (l = 0; l < band.nlines; l++)
+         if (add_span_row(spans, band.dem + (long long) l * g.samples) != 0)
+            goto done;
+
+      for (l = 0; ovr != NULL && l < band.nlines; l++) {
+         ovr_rows[0] = band.dem + (long long) l * g.samples;
+         ovr_rows[1] = band.fom + (long long) l * g.samples;
+         ovr_rows[2] = (band.conf != NULL) ? band.conf + (long long) l * g.samples : NULL;
+         if (add_overview_row(ovr, ovr_rows) != 0)
+            goto done;
+      }
+
+      pct = (int) (100.0 * (line0 + band.nlines) / g.lines) / 25 * 25;
+      if (pct > last_pct && pct < 100)
+         printf("...Resampling %d%% Done\n", pct);
+      last_pct = pct;
+   }
+   printf("...Resampling 100%% Done\n");
+   ret = 1;
+
+done:
+   if (ofp_DEM != NULL) fclose(ofp_DEM);
+   if (ofp_FOM != NULL) fclose(ofp_FOM);
+   if (ofp_CONF != NULL) fclose(ofp_CONF);
+   if (ret != 1) {
+      if (ovr != NULL) free_overviews(ovr);
+      if (spans != NULL) discard_span_index(spans);
+   }
+   else {
+      if (ovr != NULL && close_overviews(ovr) != 0)
+         ret = -1;
+      if (close_span_index(spans) != 0)
+         ret = -1;
+   }
+   free(band.dem);
+   free(band.fom);
+   free(band.conf);
+
+   return(ret);
+
+} // End of generate_standard_dem
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Worker threads
+//
+// The tools split a pass into work items (tiles, stripe bins, ...) that a
+// few threads take in turn: the caller sets a counter to 0, and
+// run_workers starts the threads, each running work(arg), which takes
+// items with next_work_item until they run out, and waits for them all.
+// Windows threads on Windows, POSIX threads elsewhere.
+////////////////////////////////////////////////////////////////////////////////
+
+// What each thread runs
+struct worker_call {
+   worker_routine work;
+   void *arg;
+};
+
+/**************  worker_start  *********************
+*                                                  *
+*  Thread entry point: runs the worker routine     *
+*                                                  *
+****************************************************/
+#ifdef _WIN32
+static DWORD WINAPI worker_start(LPVOID arg)
+#else
+static void *worker_start(void *arg)
+#endif
+{
+   worker_call *call = (worker_call *) arg;
+
+   call->work(call->arg);
+   return(0);
+}
+
+/**************  worker_threads  *******************
+*                                                  *
+*  Threads to run for nitems work items: the       *
+*  number of processors, at most                   *
+*  MAX_WORKER_THREADS and nitems, and at least 1   *
+*                                                  *
+****************************************************/
+int worker_threads(int nitems)
+{
+   int nthreads;
+
+#ifdef _WIN32
+   SYSTEM_INFO sysinfo;
+   GetSystemInfo(&sysinfo);
+   nthreads = sysinfo.dwNumberOfProcessors;
+#else
+   nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+   if (nthreads > MAX_WORKER_THREADS) nthreads = MAX_WORKER_THREADS;
+   if (nthreads > nitems) nthreads = nitems;
+   if (nthreads < 1) nthreads = 1;
+   return(nthreads);
+}
+
+/**************  run_workers  **********************
+*                                                  *
+*  Runs work(arg) in nthreads threads and waits    *
+*  for them.  With one thread, or if no thread     *
+*  can be started, work runs in the caller.        *
+*                                                  *
+****************************************************/
+void run_workers(worker_routine work, void *arg, int nthreads)
+{
+   worker_call call;
+   int i, started;
+
+   if (nthreads > MAX_WORKER_THREADS) nthreads = MAX_WORKER_THREADS;
+   if (nthreads <= 1) {
+      work(arg);
+      return;
+   }
+
+   call.work = work;
+   call.arg = arg;
+
+#ifdef _WIN32
+   HANDLE threads[MAX_WORKER_THREADS];
+   for (started = 0; started < nthreads; started++)
+      if ((threads[started] = CreateThread(NULL, 0, worker_start, &call, 0, NULL)) == NULL)
+         break;
+   if (started == 0)
+      work(arg);
+   else
+      WaitForMultipleObjects(started, threads, TRUE, INFINITE);
+   for (i = 0; i < started; i++)
+      CloseHandle(threads[i]);
+#else
+   pthread_t threads[MAX_WORKER_THREADS];
+   for (started = 0; started < nthreads; started++)
+      if (pthread_create(&threads[started], NULL, worker_start, &call) != 0)
+         break;
+   if (started == 0)
+      work(arg);
+   for (i = 0; i < started; i++)
+      pthread_join(threads[i], NULL);
+#endif
+}
+
+/**************  next_work_item  *******************
+*                                                  *
+*  Takes the next work item: returns *next and     *
+*  adds 1 to it, atomically                        *
+*                                                  *
+****************************************************/
+long next_work_item(volatile long *next)
+{
+#ifdef _WIN32
+   return(InterlockedIncrement(next) - 1);
+#else
+   return(__sync_fetch_and_add(next, 1));
+#endif
+}
+
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Overview pyramids
+//
+// When a layout cube is requested, dem2isis3/ortho2isis3 (and
+// generate_standard_dem) hand each row of a raw file to add_overview_row
+// as it is written, and a 2x, 4x, 8x... overview raw file is built for
+// each product in the same pass.  The script imports them as <cube>_ovr<N>
+// cubes carrying the mapping group of the full resolution cube, and the
+// layout cube is reduced from the 4x overview instead of the full cube.
+////////////////////////////////////////////////////////////////////////////////
+
+/**************  overview_levels  ******************
+*                                                  *
+*  Number of overview levels for a product, and    *
+*  the lines/samples of each ([0] = full size)     *
+*                                                  *
+****************************************************/
+int overview_levels(int lines, int samples, int *ovr_lines, int *ovr_samples)
+{
+   int n = 0;
+
+   ovr_lines[0] = lines;
+   ovr_samples[0] = samples;
+   while ((lines > OVR_MIN_SIZE || samples > OVR_MIN_SIZE) && n < MAX_OVR_LEVELS) {
+      lines = (lines + 1) / 2;
+      samples = (samples + 1) / 2;
+      n++;
+      ovr_lines[n] = lines;
+      ovr_samples[n] = samples;
+   }
+   return(n);
+}
+
+/**************  overview_raw_name  ****************
+*                                                  *
+*  <name>.raw -> <name>_ovr<scale>.raw             *
+*                                                  *
+****************************************************/
+static void overview_raw_name(char *raw, int scale, char *name)
+{
+   char *ext;
+
+   strcpy(name, raw);
+   ext = strrchr(name, '.');
+   if (ext != NULL && strcmp(ext, ".raw") == 0)
+      *ext = '\0';
+   sprintf(name + strlen(name), "_ovr%d.raw", scale);
+}
+
+/**************  open_overviews  *******************
+*                                                  *
+*  Opens the overview raw files of nplanes raw     *
+*  files of lines x samples posts, planes reduced  *
+*  as given by types (OVR_DEM, ...).  Returns NULL *
+*  on error.                                       *
+*                                                  *
+****************************************************/
+overview_pyramid *open_overviews(int lines, int samples, int nplanes, int *types,
+                                 char **raw_files)
+{
+   overview_pyramid *p;
+   char name[FILELEN];
+   int i, k;
+
+   p = (overview_pyramid *) calloc(1, sizeof(overview_pyramid));
+   if (p == NULL || nplanes > MAX_OVR_PLANES) {
+      printf("\nunable to set up the overview pyramid\n");
+      free(p);
+      return(NULL);
+   }
+
+   p->nplanes = nplanes;
+   p->nlevels = overview_levels(lines, samples, p->lines, p->samples);
+
+   for (i = 0; i < nplanes; i++) {
+      p->type[i] = types[i];
+      p->size[i] = (types[i] == OVR_DEM) ? sizeof(float) : 1;
+      for (k = 1; k <= p->nlevels; k++) {
+         overview_raw_name(raw_files[i], 1 << k, name);
+         p->fp[i][k] = fopen(name, "wb");
+         p->row[i][k] = (unsigned char *) malloc((size_t) p->samples[k-1] * p->size[i]);
+         p->out[i][k] = (unsigned char *) malloc((size_t) p->samples[k] * p->size[i]);
+         if (p->fp[i][k] == NULL || p->row[i][k] == NULL || p->out[i][k] == NULL) {
+            printf("\ncan't open the overview raw file: %s\n", name);
+            free_overviews(p);
+            return(NULL);
+         }
+      }
+   }
+
+   return(p);
+}
+
+/**************  free_overviews  *******************
+*                                                  *
+*  Closes the files and frees the rows of an       *
+*  overview pyramid open_overviews gave up on      *
+*  (those not set up yet are NULL)                 *
+*                                                  *
+****************************************************/
+static void free_overviews(overview_pyramid *p)
+{
+   int i, k;
+
+   for (i = 0; i < p->nplanes; i++)
+      for (k = 1; k <= p->nlevels; k++) {
+         if (p->fp[i][k] != NULL) fclose(p->fp[i][k]);
+         free(p->row[i][k]);
+         free(p->out[i][k]);
+      }
+   free(p);
+}
+
+/**************  reduce_overview_row  **************
+*                                                  *
+*  Combines 2x2 posts of rows a and b (b is NULL   *
+*  for the last row of an odd number of lines)     *
+*  of width n into out                             *
+*                                                  *
+****************************************************/
+static void reduce_overview_row(int type, unsigned char *a, unsigned char *b,
+                                int n, unsigned char *out)
+{
+   union { unsigned int i; float f; } null4;
+   unsigned char v[4], best;
+   float *fa = (float *) a, *fb = (float *) b, *fout = (float *) out, z[4];
+   double sum;
+   int i, j, k, m, nv, count, bestcount, lo;
+
+   null4.i = STD_NULL_BITS;
+   lo = (type == OVR_FOM) ? 2 : 1;
+
+   for (i = 0, j = 0; i < n; i += 2, j++) {
+      m = 0;
+      if (type == OVR_DEM) {
+         z[m++] = fa[i];
+         if (i + 1 < n) z[m++] = fa[i+1];
+         if (fb != NULL) {
+            z[m++] = fb[i];
+            if (i + 1 < n) z[m++] = fb[i+1];
+         }
+         sum = 0.0;
+         nv = 0;
+         for (k = 0; k < m; k++)
+            if (z[k] > -1.0e+38f) {
+               sum += z[k];
+               nv++;
+            }
+         fout[j] = nv ? (float) (sum / nv) : null4.f;
+         continue;
+      }
+
+      v[m++] = a[i];
+      if (i + 1 < n) v[m++] = a[i+1];
+      if (b != NULL) {
+         v[m++] = b[i];
+         if (i + 1 < n) v[m++] = b[i+1];
+      }
+
+      if (type == OVR_ORTHO) {
+         sum = 0.0;
+         nv = 0;
+         for (k = 0; k < m; k++)
+            if (v[k] != 0) {
+               sum += v[k];
+               nv++;
+            }
+         k = nv ? (int) floor(sum / nv + 0.5) : 0;
+         out[j] = (k > 254) ? 254 : k;   // 255 is HRS in ISIS
+         continue;
+      }
+
+      // FOM/confidence: most common valid value, ties to the lowest; if
+      // none are valid, the lowest value
+      best = 255;
+      bestcount = 0;
+      for (k = 0; k < m; k++) {
+         if (v[k] < lo)
+            continue;
+         for (count = 0, nv = 0; nv < m; nv++)
+            count += (v[nv] == v[k]);
+         if (count > bestcount || (count == bestcount && v[k] < best)) {
+            best = v[k];
+            bestcount = count;
+         }
+      }
+      if (bestcount == 0)
+         for (k = 0; k < m; k++)
+            if (v[k] < best) best = v[k];
+      out[j] = best;
+   }
+}
+
+/**************  push_overview_row  ****************
+*                                                  *
+*  Gives level k a row of level k-1 (b = NULL      *
+*  flushes a held row without its pair)            *
+*                                                  *
+****************************************************/
+static int push_overview_row(overview_pyramid *p, int k, unsigned char **b)
+{
+   unsigned char *next[MAX_OVR_PLANES];
+   int i;
+
+   if (k > p->nlevels)
+      return(0);
+
+   if (!p->held[k] && b != NULL) {
+      for (i = 0; i < p->nplanes; i++)
+         memcpy(p->row[i][k], b[i], (size_t) p->samples[k-1] * p->size[i]);
+      p->held[k] = 1;
+      return(0);
+   }
+
+   for (i = 0; i < p->nplanes; i++) {
+      reduce_overview_row(p->type[i], p->row[i][k], (b != NULL) ? b[i] : NULL,
+                          p->samples[k-1], p->out[i][k]);
+      if (fwrite(p->out[i][k], p->size[i], p->samples[k], p->fp[i][k]) != (size_t) p->samples[k]) {
+         printf("\nerror writing overview raw files\n");
+         return(-1);
+      }
+      next[i] = p->out[i][k];
+   }
+   p->held[k] = 0;
+
+   return(push_overview_row(p, k + 1, next));
+}
+
+/**************  add_overview_row  *****************
+*                                                  *
+*  Adds the next full resolution row (top to       *
+*  bottom) of each plane to the pyramid            *
+*                                                  *
+****************************************************/
+int add_overview_row(overview_pyramid *p, void **rows)
+{
+   return(push_overview_row(p, 1, (unsigned char **) rows));
+}
+
+/**************  close_overviews  ******************
+*                                                  *
+*  Flushes rows left without a pair (odd number    *
+*  of lines) and closes the overview raw files     *
+*                                                  *
+****************************************************/
+int close_overviews(overview_pyramid *p)
+{
+   int i, k, ret = 0;
+
+   for (k = 1; k <= p->nlevels; k++)
+      if (p->held[k] && push_overview_row(p, k, NULL) != 0)
+         ret = -1;
+
+   for (i = 0; i < p->nplanes; i++)
+      for (k = 1; k <= p->nlevels; k++) {
+         if (fclose(p->fp[i][k]) != 0)
+            ret = -1;
+         free(p->row[i][k]);
+         free(p->out[i][k]);
+      }
+   free(p);
+
+   if (ret != 0)
+      printf("\nerror writing overview raw files\n");
+   return(ret);
+}
+
+/**************  script_overviews  *****************
+*                                                  *
+*  Has the script import the overviews of raw      *
+*  (lines x samples posts) as <cub_name>_ovr<N>    *
+*  cubes.  Each gets the mapping group of          *
+*  <cub_name>.cub with the pixel size scaled by N  *
+*  and the same upper left corner.                 *
+*                                                  *
+****************************************************/
+static void script_overviews(char *isis_script, char *cub_name, char *raw,
+                             int lines, int samples, char *rawopts)
+{
+   int ovr_lines[MAX_OVR_LEVELS+1], ovr_samples[MAX_OVR_LEVELS+1];
+   char ovr_raw[FILELEN];
+   char command[512];
+   int k, n;
+
+   n = overview_levels(lines, samples, ovr_lines, ovr_samples);
+   if (n == 0)
+      return;
+
+   sprintf(command,"catlab from=%s.cub to=%s_ovr.lbl",cub_name,cub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"set ulx = `getkey from=%s.cub grpname=Mapping keyword=UpperLeftCornerX`",cub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"set uly = `getkey from=%s.cub grpname=Mapping keyword=UpperLeftCornerY`",cub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"set res = `getkey from=%s.cub grpname=Mapping keyword=PixelResolution`",cub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"set scale = `getkey from=%s.cub grpname=Mapping keyword=Scale`",cub_name);
+   writeToScript(isis_script,command);
+
+   for (k = 1; k <= n; k++) {
+      overview_raw_name(raw, 1 << k, ovr_raw);
+      sprintf(command,"raw2isis from=%s to=%s_ovr%d.cub samples=%d lines=%d bands=1%s",
+              ovr_raw,cub_name,1 << k,ovr_samples[k],ovr_lines[k],rawopts);
+      writeToScript(isis_script,command);
+      sprintf(command,"editlab from=%s_ovr.lbl grpname=Mapping keyword=PixelResolution value=`echo \"$res * %d\" | bc -l`",
+              cub_name,1 << k);
+      writeToScript(isis_script,command);
+      sprintf(command,"editlab from=%s_ovr.lbl grpname=Mapping keyword=Scale value=`echo \"$scale / %d\" | bc -l`",
+              cub_name,1 << k);
+      writeToScript(isis_script,command);
+      sprintf(command,"maplab from=%s_ovr%d.cub map=%s_ovr.lbl sample=0.5 line=0.5 x=$ulx y=$uly",
+              cub_name,1 << k,cub_name);
+      writeToScript(isis_script,command);
+   }
+
+   sprintf(command,"/bin/rm -f %s_ovr.lbl\n",cub_name);
+   writeToScript(isis_script,command);
+}
+
+/**************  script_product_overviews  *********
+*                                                  *
+*  Overviews of the DEM/FOM/confidence (or ORTHO)  *
+*  cubes <prefix><name>.cub                        *
+*                                                  *
+****************************************************/
+static void script_product_overviews(char *isis_script, char *productType,
+                             char *byteOrder, char *prefix, char *outcub_name,
+                             char *FOM_name, char *CONF_name, char *raw,
+                             char *rawFOM, char *rawCONF, int confidence_flag,
+                             int lines, int samples)
+{
+   char cub_name[FILELEN];
+   char rawopts[64];
+   char command[512];
+
+   sprintf(command,"#############################################################");
+   writeToScript(isis_script,command);
+   sprintf(command,"## Import the overview pyramids (2x, 4x, ...) of the %s cubes,",
+           prefix[0] ? prefix : "standard");
+   writeToScript(isis_script,command);
+   sprintf(command,"## written along with the raw files");
+   writeToScript(isis_script,command);
+   sprintf(command,"#############################################################\n");
+   writeToScript(isis_script,command);
+
+   sprintf(cub_name,"%s%s",prefix,outcub_name);
+   if (strstr(productType,"DEM")) {
+      sprintf(rawopts," bittype=real byteorder=%s",byteOrder);
+      script_overviews(isis_script,cub_name,raw,lines,samples,rawopts);
+
+      sprintf(cub_name,"%s%s",prefix,FOM_name);
+      script_overviews(isis_script,cub_name,rawFOM,lines,samples,"");
+
+      if (confidence_flag) {
+         sprintf(cub_name,"%s%s",prefix,CONF_name);
+         script_overviews(isis_script,cub_name,rawCONF,lines,samples,"");
+      }
+   }
+   else
+      script_overviews(isis_script,cub_name,raw,lines,samples,"");
+}
+
+/**************  script_layout  ********************
+*                                                  *
+*  Reduced resolution layout cube: from the 4x     *
+*  overview when there is one, otherwise from the  *
+*  full resolution cube                            *
+*                                                  *
+****************************************************/
+static void script_layout(char *isis_script, char *outcub, char *outcub_name,
+                          char *layout_cub, int from_overviews, int lines,
+                          int samples)
+{
+   int ovr_lines[MAX_OVR_LEVELS+1], ovr_samples[MAX_OVR_LEVELS+1];
+   char command[512];
+
+   // Output description of this section to script file
+   sprintf(command,"#############################################################");
+   writeToScript(isis_script,command);
+   sprintf(command,"## Generate reduced resolution ISIS cubes for ARCMAP layouts");
+   writeToScript(isis_script,command);
+   sprintf(command,"#############################################################\n");
+   writeToScript(isis_script,command);
+
+   if (from_overviews && overview_levels(lines, samples, ovr_lines, ovr_samples) >= 2)
+      sprintf(command,"reduce from=%s_ovr4.cub to=%s sscale=1.25 lscale=1.25 validper=10 vper_replace=nearest\n",outcub_name,layout_cub);
+   else
+      sprintf(command,"reduce from=%s to=%s sscale=5.0 lscale=5.0 validper=10 vper_replace=nearest\n",outcub,layout_cub);
+   writeToScript(isis_script,command);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// FOM masking
+//
+// A mask spec keeps the posts whose FOM is in low..high, less any FOM
+// classes listed after a colon:
+//
+//        <low>-<high>[:<fom>|<first>-<last>[,...]]    e.g. 2-254:3,40-45
+//
+// fom_mask_row tests a row of FOM values against it, giving a byte per
+// post (0xFF kept, 0 masked) for the caller to NULL the elevations by and
+// pack_mask_row packs into a 1 bit per post mask plane.  Counts of the
+// kept and masked posts are kept for write_fom_mask_json.
+////////////////////////////////////////////////////////////////////////////////
+
+/**************  open_fom_mask  ********************
+*                                                  *
+*  Parses a mask spec.  Returns NULL (with a       *
+*  message) if it is not valid.                    *
+*                                                  *
+****************************************************/
+fom_mask *open_fom_mask(char *spec)
+{
+   fom_mask *m;
+   char *p, *end;
+   long low, high, first, last;
+   int f;
+
+   m = (fom_mask *) calloc(1, sizeof(fom_mask));
+   if (m == NULL)
+      return(NULL);
+   strncpy(m->spec, spec, FILELEN - 1);
+
+   low = strtol(spec, &end, 10);
+   if (end == spec || *end != '-')
+      goto bad;
+   p = end + 1;
+   high = strtol(p, &end, 10);
+   if (end == p || (*end != '\0' && *end != ':') ||
+       low < 0 || high > 255 || low > high)
+      goto bad;
+   for (f = low; f <= high; f++)
+      m->keep[f] = 0xFF;
+
+   // masked classes
+   if (*end == ':') {
+      do {
+         p = end + 1;
+         first = strtol(p, &end, 10);
+         if (end == p)
+            goto bad;
+         last = first;
+         if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p)
+               goto bad;
+         }
+         if (first < 0 || last > 255 || first > last ||
+             (*end != '\0' && *end != ','))
+            goto bad;
+         for (f = first; f <= last; f++)
+            m->keep[f] = 0;
+      } while (*end == ',');
+   }
+
+   // kept values as ranges
+   for (f = 0; f < 256; f++) {
+      if (!m->keep[f])
+         continue;
+      m->lo[m->nranges] = (unsigned char) f;
+      while (f < 255 && m->keep[f+1])
+         f++;
+      m->hi[m->nranges++] = (unsigned char) f;
+   }
+   return(m);
+
+bad:
+   printf("\ninvalid FOM mask: %s (expected low-high[:fom,first-last,...])\n", spec);
+   free(m);
+   return(NULL);
+}
+
+/**************  fom_mask_row  *********************
+*                                                  *
+*  keep[i] = 0xFF if post i is kept, 0 if masked,  *
+*  for ncols FOM values.  Returns the number kept. *
+*                                                  *
+****************************************************/
+int fom_mask_row(fom_mask *m, char *fom_buf, unsigned char *keep, int ncols)
+{
+   unsigned char *fom = (unsigned char *) fom_buf;
+   int i = 0, r, kept = 0;
+
+#ifdef FOM_MASK_SSE2
+   if (m->nranges <= FOM_MASK_SIMD_RANGES) {
+      __m128i lo[FOM_MASK_SIMD_RANGES], hi[FOM_MASK_SIMD_RANGES];
+      __m128i zero = _mm_setzero_si128();
+      __m128i one = _mm_set1_epi8(1);
+      __m128i sum = _mm_setzero_si128();
+      __m128i v, k;
+      long long part[2];
+
+      for (r = 0; r < m->nranges; r++) {
+         lo[r] = _mm_set1_epi8((char) m->lo[r]);
+         hi[r] = _mm_set1_epi8((char) m->hi[r]);
+      }
+      for (; i + 16 <= ncols; i += 16) {
+         v = _mm_loadu_si128((__m128i *) (fom + i));
+         k = zero;
+         // lo <= v <= hi  <=>  max(v,lo) == v && min(v,hi) == v (unsigned)
+         for (r = 0; r < m->nranges; r++)
+            k = _mm_or_si128(k, _mm_and_si128(
+                   _mm_cmpeq_epi8(_mm_max_epu8(v, lo[r]), v),
+                   _mm_cmpeq_epi8(_mm_min_epu8(v, hi[r]), v)));
+         _mm_storeu_si128((__m128i *) (keep + i), k);
+         sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_and_si128(k, one), zero));
+      }
+      _mm_storeu_si128((__m128i *) part, sum);
+      kept = (int) (part[0] + part[1]);
+   }
+#endif
+
+   for (; i < ncols; i++) {
+      keep[i] = m->keep[fom[i]];
+      kept += keep[i] & 1;
+   }
+
+   // masked posts by FOM (the rare case, so counted separately)
+   if (kept < ncols)
+      for (i = 0; i < ncols; i++)
+         if (!keep[i])
+            m->masked_fom[fom[i]]++;
+
+   m->kept += kept;
+   m->masked += ncols - kept;
+   return(kept);
+}
+
+/**************  pack_mask_row  ********************
+*                                                  *
+*  Packs ncols keep bytes into (ncols+7)/8 bytes,  *
+*  first post in the low bit, 1 = kept             *
+*                                                  *
+****************************************************/
+void pack_mask_row(unsigned char *keep, unsigned char *bits, int ncols)
+{
+   int i = 0, n;
+   unsigned char b;
+
+#ifdef FOM_MASK_SSE2
+   for (; i + 16 <= ncols; i += 16) {
+      n = _mm_movemask_epi8(_mm_loadu_si128((__m128i *) (keep + i)));
+      bits[i / 8] = (unsigned char) n;
+      bits[i / 8 + 1] = (unsigned char) (n >> 8);
+   }
+#endif
+
+   for (; i < ncols; i += 8) {
+      b = 0;
+      for (n = 0; n < 8 && i + n < ncols; n++)
+         if (keep[i + n])
+            b |= 1 << n;
+      bits[i / 8] = b;
+   }
+}
+
+/**************  write_fom_mask_json  **************
+*                                                  *
+*  Writes the mask as a "fom_mask" JSON member     *
+*  (no trailing comma)                             *
+*                                                  *
+****************************************************/
+void write_fom_mask_json(FILE *fp, fom_mask *m, char *mask_file)
+{
+   int f, n;
+
+   fprintf(fp, "  \"fom_mask\": {\n");
+   fprintf(fp, "    \"spec\": \"%s\",\n", m->spec);
+   fprintf(fp, "    \"mask_file\": \"%s\",\n", mask_file);
+   fprintf(fp, "    \"kept_pixels\": %llu,\n", m->kept);
+   fprintf(fp, "    \"masked_pixels\": %llu,\n", m->masked);
+   fprintf(fp, "    \"masked_fom_counts\": {");
+   n = 0;
+   for (f = 0; f < 256; f++) {
+      if (m->masked_fom[f] == 0)
+         continue;
+      fprintf(fp, "%s\n      \"%d\": %llu", (n++ == 0) ? "" : ",", f, m->masked_fom[f]);
+   }
+   fprintf(fp, "%s}\n", (n == 0) ? "" : "\n    ");
+   fprintf(fp, "  }");
+}
+
+void close_fom_mask(fom_mask *m)
+{
+   free(m);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+// NULL-span index
+//
+// HiRISE DTMs are mostly NULL outside the stereo overlap.  As a DEM raw
+// file is written, each line goes to add_span_row as well, which records
+// the runs of non-NULL (ISIS NULL, STD_NULL_BITS) posts, so the ISIS side tools
+// can skip the NULL runs of the cube made from the raw file without
+// reading or converting them (see isis3arc_dd).  The index is named for
+// the cube it describes: SS_<cube>.spans for SS_<cube>.cub (the grid of
+// SS_<cube>.raw), and <cube>.spans for the standard <cube>.cub when
+// generate_standard_dem resamples it.
+////////////////////////////////////////////////////////////////////////////////
+
+static void put_le32(unsigned char *b, unsigned int v)
+{
+   b[0] = (unsigned char) v;
+   b[1] = (unsigned char) (v >> 8);
+   b[2] = (unsigned char) (v >> 16);
+   b[3] = (unsigned char) (v >> 24);
+}
+
+static void write_span_header(span_index *s, unsigned char *h)
+{
+   memset(h, 0, SPAN_HEADER_BYTES);
+   memcpy(h, SPAN_MAGIC, 8);
+   put_le32(h + 8, SPAN_VERSION);
+   put_le32(h + 12, (unsigned int) s->lines);
+   put_le32(h + 16, (unsigned int) s->samples);
+   put_le32(h + 20, s->nspans);
+   put_le32(h + 24, (unsigned int) s->valid);
+   put_le32(h + 28, (unsigned int) (s->valid >> 32));
+   put_le32(h + 32, (unsigned int) s->check);
+   put_le32(h + 36, (unsigned int) (s->check >> 32));
+}
+
+// adds the bits of post v to the check
+static unsigned long long span_check(unsigned long long check, float v)
+{
+   unsigned int bits;
+   int i;
+
+   memcpy(&bits, &v, 4);
+   for (i = 0; i < 4; i++) {
+      check ^= (bits >> (8 * i)) & 0xFF;
+      check *= SPAN_CHECK_PRIME;
+   }
+   return(check);
+}
+
+/**************  native_cube_name  *****************
+*                                                  *
+*  Name (w/o .cub) of the cube the script makes on *
+*  the grid of the SS_ raw files of outcub_name:   *
+*  SS_<name> for geographic projects of            *
+*  ellipsoidal bodies (generate_ss2isis_script's   *
+*  SS_ cubes), else <name>.  Returns 1 for an SS_  *
+*  cube, else 0                                    *
+*                                                  *
+****************************************************/
+int native_cube_name(char *prj, char *outcub_name, char *cub)
+{
+   char value[FILELEN];
+
+   if (parse_label(prj, "COORD_SYS", value) == 1 && atoi(value) == 1 &&
+       parse_label(prj, "E_EARTH", value) == 1 && atof(value) != 0.0) {
+      sprintf(cub, "SS_%s", outcub_name);
+      return(1);
+   }
+   strcpy(cub, outcub_name);
+   return(0);
+}
+
+/**************  open_span_index  ******************
+*                                                  *
+*  Creates a span index for a DEM of lines x       *
+*  samples.  Returns NULL (with a message) if the  *
+*  file can't be written                           *
+*                                                  *
+****************************************************/
+span_index *open_span_index(char *file, int lines, int samples)
+{
+   span_index *s;
+   unsigned char h[SPAN_HEADER_BYTES];
+
+   s = (span_index *) calloc(1, sizeof(span_index));
+   if (s == NULL) {
+      printf("\nunable to allocate memory for the span index\n");
+      return(NULL);
+   }
+   strcpy(s->file, file);
+   s->lines = lines;
+   s->samples = samples;
+   s->check = SPAN_CHECK_BASIS;
+   // at most (samples+1)/2 runs in a line
+   s->rec = (unsigned char *) malloc(4 + 8 * (size_t) ((samples + 1) / 2));
+   s->fp = fopen(file, "wb");
+   if (s->rec == NULL || s->fp == NULL) {
+      printf("\ncan't open the span index: %s!\n", file);
+      free(s->rec);
+      free(s);
+      return(NULL);
+   }
+   // the totals are filled in by close_span_index
+   write_span_header(s, h);
+   if (fwrite(h, 1, SPAN_HEADER_BYTES, s->fp) != SPAN_HEADER_BYTES) {
+      printf("\nerror writing the span index: %s!\n", file);
+      fclose(s->fp);
+      free(s->rec);
+      free(s);
+      return(NULL);
+   }
+   return(s);
+}
+
+/**************  add_span_row  *********************
+*                                                  *
+*  Adds the runs of non-NULL posts of the next     *
+*  line (north first) of the DEM.  Returns 0, or   *
+*  -1 on a write error                             *
+*                                                  *
+****************************************************/
+int add_span_row(span_index *s, float *row)
+{
+   union { unsigned int i; float f; } null4;
+   unsigned int n = 0;
+   unsigned char *p = s->rec + 4;
+   int i = 0, first;
+
+   null4.i = STD_NULL_BITS;
+
+   while (i < s->samples) {
+      first = i;
+      while (i < s->samples && row[i] == null4.f)
+         i++;
+      if (i > first)
+         s->check = span_check(span_check(s->check, row[first]), row[i - 1]);
+      if (i == s->samples)
+         break;
+      first = i;
+      while (i < s->samples && row[i] != null4.f)
+         i++;
+      s->check = span_check(span_check(s->check, row[first]), row[i - 1]);
+      put_le32(p, (unsigned int) first);
+      put_le32(p + 4, (unsigned int) (i - first));
+      p += 8;
+      n++;
+      s->valid += i - first;
+   }
+   put_le32(s->rec, n);
+   s->nspans += n;
+   s->line++;
+   if (fwrite(s->rec, 1, p - s->rec, s->fp) != (size_t) (p - s->rec)) {
+      printf("\nerror writing the span index: %s!\n", s->file);
+      return(-1);
+   }
+   return(0);
+}
+
+/**************  close_span_index  *****************
+*                                                  *
+*  Writes the totals and closes the index.         *
+*  Returns 0, or -1 if it could not be written or  *
+*  is short of lines (and so is removed)           *
+*                                                  *
+****************************************************/
+int close_span_index(span_index *s)
+{
+   unsigned char h[SPAN_HEADER_BYTES];
+   int err = 0;
+
+   write_span_header(s, h);
+   if (s->line != s->lines ||
+       fseek(s->fp, 0L, SEEK_SET) != 0 ||
+       fwrite(h, 1, SPAN_HEADER_BYTES, s->fp) != SPAN_HEADER_BYTES)
+      err = -1;
+   if (fclose(s->fp) != 0)
+      err = -1;
+   if (err) {
+      printf("\nerror writing the span index: %s!\n", s->file);
+      remove(s->file);
+   }
+   free(s->rec);
+   free(s);
+   return(err);
+}
+
+/**************  discard_span_index  ***************
+*                                                  *
+*  Closes and removes an unfinished span index     *
+*                                                  *
+****************************************************/
+static void discard_span_index(span_index *s)
+{
+   fclose(s->fp);
+   remove(s->file);
+   free(s->rec);
+   free(s);
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Terrain products
+//
+// Slope, aspect and hillshade need the 3x3 posts about a post and RMS
+// roughness the size x size posts, so as the DEM raw file is written each
+// line also goes to add_terrain_row, which keeps the last 2 * half + 1
+// lines and writes the products of the line half lines back.  Derived
+// products then cost no more DEM reads.
+//
+// Gradients are Horn's (the weighted 3x3 differences), four posts at a
+// time with SSE2 where all nine posts are valid.  About NULLs and the DEM
+// edges each row (column) of the 3x3 that still has a difference through
+// the post gives one, central or one-sided, and those are weighted as in
+// Horn's; a post with no difference across or down gets no products.
+// Spacings are in meters: for geographic projects the project's radians
+// are taken through the meridian and prime vertical radii at the
+// latitude of the line.  Roughness is the RMS of the valid posts of the
+// window about the plane fitted to them (at least 4, not in a line).
+// Products of NULL posts are NULL.
+////////////////////////////////////////////////////////////////////////////////
+
+/**************  terrain_raw_names  ****************
+*                                                  *
+*  <name>.raw -> <name>_slope.raw, _aspect.raw,    *
+*  _hillshade.raw and _roughness.raw (raw_files[]  *
+*  of FILELEN)                                     *
+*                                                  *
+****************************************************/
+void terrain_raw_names(char *rawDEM, char **raw_files)
+{
+   static const char *suffix[TERRAIN_PLANES] =
+      {"_slope", "_aspect", "_hillshade", "_roughness"};
+   char base[FILELEN];
+   char *ext;
+   int i;
+
+   strcpy(base, rawDEM);
+   ext = strrchr(base, '.');
+   if (ext != NULL && strcmp(ext, ".raw") == 0)
+      *ext = '\0';
+   for (i = 0; i < TERRAIN_PLANES; i++)
+      sprintf(raw_files[i], "%s%s.raw", base, suffix[i]);
+}
+
+/**************  open_terrain  *********************
+*                                                  *
+*  Sets up the terrain products of a DEM of lines  *
+*  x samples (posts spaced as in its header, the   *
+*  first line at ulcenter_Ylat), with a size x     *
+*  size roughness window, and opens raw_files      *
+*  (see terrain_raw_names).  Returns NULL (with a  *
+*  message) on error.                              *
+*                                                  *
+****************************************************/
+terrain_pass *open_terrain(char *prj, int lines, int samples,
+            double x_realspacing, double y_realspacing, double ulcenter_Ylat,
+            int size, char **raw_files)
+{
+   terrain_pass *t;
+   union { unsigned int i; float f; } null4;
+   char value[FILELEN];
+   double e, az, alt;
+   int i, bad;
+
+   if (size < TERRAIN_MIN_SIZE || size > TERRAIN_MAX_SIZE || size % 2 == 0) {
+      printf("\nthe roughness window must be an odd size, %d to %d posts\n",
+             TERRAIN_MIN_SIZE, TERRAIN_MAX_SIZE);
+      return(NULL);
+   }
+
+   t = (terrain_pass *) calloc(1, sizeof(terrain_pass));
+   if (t == NULL) {
+      printf("\nunable to allocate memory for the terrain products\n");
+      return(NULL);
+   }
+   t->lines = lines;
+   t->samples = samples;
+   t->size = size;
+   t->half = size / 2;
+   t->nbuf = 2 * t->half + 1;
+   t->xspacing = x_realspacing;
+   t->yspacing = y_realspacing;
+   t->lat0 = ulcenter_Ylat;
+
+   // Geographic projects (COORD_SYS 1) are spaced in radians
+   t->geographic = (parse_label(prj, "COORD_SYS", value) == 1 && atoi(value) == 1);
+   if (t->geographic) {
+      parse_label(prj, "A_EARTH", value);
+      t->a = atof(value);
+      parse_label(prj, "E_EARTH", value);
+      e = atof(value);
+      t->e2 = e * e;
+   }
+
+   az = TERRAIN_SUN_AZIMUTH * M_PI / 180.0;
+   alt = TERRAIN_SUN_ALTITUDE * M_PI / 180.0;
+   t->sun_up = sin(alt);
+   t->sun_east = cos(alt) * sin(az);
+   t->sun_north = cos(alt) * cos(az);
+
+   bad = (t->geographic && t->a <= 0.0);
+   t->row = (float **) calloc(t->nbuf, sizeof(float *));
+   for (i = 0; t->row != NULL && i < t->nbuf; i++)
+      if ((t->row[i] = (float *) malloc(samples * sizeof(float))) == NULL)
+         bad = 1;
+   t->null_row = (float *) malloc(samples * sizeof(float));
+   t->ok = (unsigned char *) malloc(samples);
+   t->p = (float *) malloc((samples + 3) * sizeof(float));
+   t->q = (float *) malloc((samples + 3) * sizeof(float));
+   t->col = (double *) malloc(6 * (size_t) samples * sizeof(double));
+   t->shade = (unsigned char *) malloc(samples);
+   for (i = 0; i < TERRAIN_PLANES; i++)
+      if (i != TERRAIN_HILLSHADE &&
+          (t->out[i] = (float *) malloc(samples * sizeof(float))) == NULL)
+         bad = 1;
+   if (bad || t->row == NULL || t->null_row == NULL || t->ok == NULL ||
+       t->p == NULL || t->q == NULL || t->col == NULL || t->shade == NULL) {
+      printf("\nunable to set up the terrain products%s\n",
+             (t->geographic && t->a <= 0.0) ? " (no A_EARTH in the project)" : "");
+      t->lines = -1;
+      close_terrain(t);
+      return(NULL);
+   }
+   null4.i = STD_NULL_BITS;
+   for (i = 0; i < samples; i++)
+      t->null_row[i] = null4.f;
+
+   for (i = 0; i < TERRAIN_PLANES; i++) {
+      strcpy(t->file[i], raw_files[i]);
+      t->fp[i] = fopen(raw_files[i], "wb");
+      if (t->fp[i] == NULL) {
+         printf("\ncan't open the terrain raw file: %s!\n", raw_files[i]);
+         t->lines = -1;
+         close_terrain(t);
+         return(NULL);
+      }
+   }
+   return(t);
+}
+
+/**************  terrain_line_row  *****************
+*                                                  *
+*  The buffered row of DEM line k, or a NULL row   *
+*  off the DEM                                     *
+*                                                  *
+****************************************************/
+static float *terrain_line_row(terrain_pass *t, int k)
+{
+   if (k < 0 || k >= t->lines || k >= t->added)
+      return(t->null_row);
+   return(t->row[k % t->nbuf]);
+}
+
+/**************  horn_gradient  ********************
+*                                                  *
+*  NULL-aware Horn gradient at sample x of the     *
+*  middle row (valid): p = dz/dx east, q = dz/dy   *
+*  north, per post.  Returns 0 if there is no      *
+*  difference across or down.                     *
+*                                                  *
+****************************************************/
+static int horn_gradient(float *up, float *mid, float *dn, int x, int n,
+                         float *p, float *q)
+{
+   static const double w[3] = {1.0, 2.0, 1.0};
+   float *r[3];
+   double gx = 0.0, gy = 0.0, wx = 0.0, wy = 0.0, g;
+   float l, c, h;
+   int k, xx;
+
+   r[0] = up;
+   r[1] = mid;
+   r[2] = dn;
+
+   // across: each row's difference through x
+   for (k = 0; k < 3; k++) {
+      l = (x > 0) ? r[k][x-1] : (float) NULL3;
+      c = r[k][x];
+      h = (x < n - 1) ? r[k][x+1] : (float) NULL3;
+      if (l > -1.0e+38f && h > -1.0e+38f)
+         g = 0.5 * ((double) h - l);
+      else if (c > -1.0e+38f && h > -1.0e+38f)
+         g = (double) h - c;
+      else if (c > -1.0e+38f && l > -1.0e+38f)
+         g = (double) c - l;
+      else
+         continue;
+      gx += w[k] * g;
+      wx += w[k];
+   }
+
+   // down: each column's difference through the middle row (north up)
+   for (k = 0; k < 3; k++) {
+      xx = x + k - 1;
+      if (xx < 0 || xx >= n)
+         continue;
+      l = dn[xx];
+      c = mid[xx];
+      h = up[xx];
+      if (l > -1.0e+38f && h > -1.0e+38f)
+         g = 0.5 * ((double) h - l);
+      else if (c > -1.0e+38f && h > -1.0e+38f)
+         g = (double) h - c;
+      else if (c > -1.0e+38f && l > -1.0e+38f)
+         g = (double) c - l;
+      else
+         continue;
+      gy += w[k] * g;
+      wy += w[k];
+   }
+
+   if (wx == 0.0 || wy == 0.0)
+      return(0);
+   *p = (float) (gx / wx);
+   *q = (float) (gy / wy);
+   return(1);
+}
+
+/**************  terrain_gradients  ****************
+*                                                  *
+*  Horn gradients (per post) of the middle row:    *
+*  p/q of the posts with all 3x3 posts valid, four *
+*  at a time with SSE2, and ok[] set for them      *
+*                                                  *
+****************************************************/
+static void terrain_gradients(terrain_pass *t, float *up, float *mid, float *dn)
+{
+   int n = t->samples, x;
+
+   t->ok[0] = t->ok[n-1] = 0;
+   for (x = 1; x < n - 1; x++)
+      t->ok[x] = (up[x-1] > -1.0e+38f && up[x] > -1.0e+38f && up[x+1] > -1.0e+38f &&
+                  mid[x-1] > -1.0e+38f && mid[x] > -1.0e+38f && mid[x+1] > -1.0e+38f &&
+                  dn[x-1] > -1.0e+38f && dn[x] > -1.0e+38f && dn[x+1] > -1.0e+38f);
+
+   x = 1;
+#ifdef TERRAIN_SSE2
+   {
+      const __m128 two = _mm_set1_ps(2.0f), eighth = _mm_set1_ps(0.125f);
+      __m128 ul, uc, ur, ml, mr, dl, dc, dr;
+
+      for (; x + 4 <= n - 1; x += 4) {
+         ul = _mm_loadu_ps(up + x - 1);
+         uc = _mm_loadu_ps(up + x);
+         ur = _mm_loadu_ps(up + x + 1);
+         ml = _mm_loadu_ps(mid + x - 1);
+         mr = _mm_loadu_ps(mid + x + 1);
+         dl = _mm_loadu_ps(dn + x - 1);
+         dc = _mm_loadu_ps(dn + x);
+         dr = _mm_loadu_ps(dn + x + 1);
+         // NULLs (-3.4e38) make inf/nan here; ok[] leaves those posts out
+         _mm_storeu_ps(t->p + x, _mm_mul_ps(eighth,
+            _mm_add_ps(_mm_add_ps(_mm_sub_ps(ur, ul), _mm_sub_ps(dr, dl)),
+                       _mm_mul_ps(two, _mm_sub_ps(mr, ml)))));
+         _mm_storeu_ps(t->q + x, _mm_mul_ps(eighth,
+            _mm_sub_ps(_mm_add_ps(_mm_add_ps(ul, ur), _mm_mul_ps(two, uc)),
+                       _mm_add_ps(_mm_add_ps(dl, dr), _mm_mul_ps(two, dc)))));
+      }
+   }
+#endif
+   for (; x < n - 1; x++) {
+      if (!t->ok[x])
+         continue;
+      t->p[x] = 0.125f * ((up[x+1] - up[x-1]) + (dn[x+1] - dn[x-1]) +
+                          2.0f * (mid[x+1] - mid[x-1]));
+      t->q[x] = 0.125f * ((up[x-1] + up[x+1] + 2.0f * up[x]) -
+                          (dn[x-1] + dn[x+1] + 2.0f * dn[x]));
+   }
+}
+
+/**************  terrain_roughness  ****************
+*                                                  *
+*  RMS roughness of line k: column sums over the   *
+*  window's lines, then the plane fit of each      *
+*  window from them                                *
+*                                                  *
+****************************************************/
+static void terrain_roughness(terrain_pass *t, int k)
+{
+   int n = t->samples, h = t->half, x, c, d, u;
+   float *mid = terrain_line_row(t, k), *r, null;
+   double *s, zr, z, v;
+   double sn, su, suu, sv, svv, suv, sz, szz, suz, svz;
+   double m00, m01, m02, m11, m12, m22, det, a, b, cc, rss;
+
+   null = t->null_row[0];
+
+   // elevations about the line's first valid post, for precision
+   zr = 0.0;
+   for (x = 0; x < n; x++)
+      if (mid[x] > -1.0e+38f) {
+         zr = mid[x];
+         break;
+      }
+
+   // per column: posts, sum v, v^2, z, z^2 and v*z over the window's lines
+   // (v the line offset, z less zr)
+   memset(t->col, 0, 6 * (size_t) n * sizeof(double));
+   for (d = -h; d <= h; d++) {
+      r = terrain_line_row(t, k + d);
+      if (r == t->null_row)
+         continue;
+      v = d;
+      for (x = 0, s = t->col; x < n; x++, s += 6) {
+         if (!(r[x] > -1.0e+38f))
+            continue;
+         z = r[x] - zr;
+         s[0] += 1.0;
+         s[1] += v;
+         s[2] += v * v;
+         s[3] += z;
+         s[4] += z * z;
+         s[5] += v * z;
+      }
+   }
+
+   for (x = 0; x < n; x++) {
+      t->out[TERRAIN_ROUGHNESS][x] = null;
+      if (!(mid[x] > -1.0e+38f))
+         continue;
+      sn = su = suu = sv = svv = suv = sz = szz = suz = svz = 0.0;
+      for (c = x - h; c <= x + h; c++) {
+         if (c < 0 || c >= n)
+            continue;
+         s = t->col + 6 * (size_t) c;
+         if (s[0] == 0.0)
+            continue;
+         u = c - x;
+         sn += s[0];
+         su += u * s[0];
+         suu += (double) u * u * s[0];
+         sv += s[1];
+         svv += s[2];
+         suv += u * s[1];
+         sz += s[3];
+         szz += s[4];
+         suz += u * s[3];
+         svz += s[5];
+      }
+      if (sn < 4.0)
+         continue;
+
+      // least squares plane z = a + b u + cc v (normal equations)
+      m00 = sn;  m01 = su;  m02 = sv;
+      m11 = suu; m12 = suv; m22 = svv;
+      det = m00 * (m11 * m22 - m12 * m12) - m01 * (m01 * m22 - m12 * m02) +
+            m02 * (m01 * m12 - m11 * m02);
+      if (det < 1.0e-9 * sn * sn * sn)
+         continue;    // the posts are in a line
+      a = (sz * (m11 * m22 - m12 * m12) - m01 * (suz * m22 - m12 * svz) +
+           m02 * (suz * m12 - m11 * svz)) / det;
+      b = (m00 * (suz * m22 - m12 * svz) - sz * (m01 * m22 - m12 * m02) +
+           m02 * (m01 * svz - suz * m02)) / det;
+      cc = (m00 * (m11 * svz - suz * m12) - m01 * (m01 * svz - suz * m02) +
+            sz * (m01 * m12 - m11 * m02)) / det;
+      rss = szz - a * sz - b * suz - cc * svz;
+      t->out[TERRAIN_ROUGHNESS][x] = (float) ((rss > 0.0) ? sqrt(rss / sn) : 0.0);
+   }
+}
+
+/**************  terrain_line  *********************
+*                                                  *
+*  Computes and writes the products of line k      *
+*  (its lines +-half must have been added)         *
+*                                                  *
+****************************************************/
+static int terrain_line(terrain_pass *t, int k)
+{
+   int n = t->samples, x, i;
+   float *up = terrain_line_row(t, k - 1);
+   float *mid = terrain_line_row(t, k);
+   float *dn = terrain_line_row(t, k + 1);
+   float null = t->null_row[0];
+   double dx, dy, lat, sl, w, p, q, g, hs;
+
+   // post spacing (m) of the line
+   if (t->geographic) {
+      lat = t->lat0 - k * t->yspacing;
+      sl = sin(lat);
+      w = 1.0 - t->e2 * sl * sl;
+      dx = t->xspacing * t->a / sqrt(w) * cos(lat);
+      dy = t->yspacing * t->a * (1.0 - t->e2) / (w * sqrt(w));
+   }
+   else {
+      dx = t->xspacing;
+      dy = t->yspacing;
+   }
+   if (dx < 1.0e-6) dx = 1.0e-6;     // at a pole
+
+   terrain_gradients(t, up, mid, dn);
+
+   for (x = 0; x < n; x++) {
+      t->out[TERRAIN_SLOPE][x] = null;
+      t->out[TERRAIN_ASPECT][x] = null;
+      t->shade[x] = 0;
+      if (!(mid[x] > -1.0e+38f))
+         continue;
+      if (!t->ok[x] && !horn_gradient(up, mid, dn, x, n, t->p + x, t->q + x))
+         continue;
+      p = t->p[x] / dx;
+      q = t->q[x] / dy;
+      g = sqrt(p * p + q * q);
+
+      t->out[TERRAIN_SLOPE][x] = (float) (atan(g) * 180.0 / M_PI);
+      if (g > 0.0) {
+         // downslope direction, clockwise from north
+         w = atan2(-p, -q) * 180.0 / M_PI;
+         t->out[TERRAIN_ASPECT][x] = (float) ((w < 0.0) ? w + 360.0 : w);
+      }
+      hs = (t->sun_up - p * t->sun_east - q * t->sun_north) / sqrt(1.0 + g * g);
+      t->shade[x] = (unsigned char) (1 + (int) floor(253.0 * ((hs > 0.0) ? hs : 0.0) + 0.5));
+   }
+
+   terrain_roughness(t, k);
+
+   for (i = 0; i < TERRAIN_PLANES; i++)
+      if ((i == TERRAIN_HILLSHADE) ?
+          fwrite(t->shade, 1, n, t->fp[i]) != (size_t) n :
+          fwrite(t->out[i], sizeof(float), n, t->fp[i]) != (size_t) n) {
+         printf("\nerror writing the terrain raw file: %s!\n", t->file[i]);
+         return(-1);
+      }
+   t->done = k + 1;
+   return(0);
+}
+
+/**************  add_terrain_row  ******************
+*                                                  *
+*  Adds the next line (north first) of the DEM,    *
+*  writing the products of the line half lines     *
+*  back.  Returns 0, or -1 on a write error        *
+*                                                  *
+****************************************************/
+int add_terrain_row(terrain_pass *t, float *row)
+{
+   memcpy(t->row[t->added % t->nbuf], row, t->samples * sizeof(float));
+   t->added++;
+   if (t->added - 1 - t->half >= 0)
+      return(terrain_line(t, t->added - 1 - t->half));
+   return(0);
+}
+
+/**************  close_terrain  ********************
+*                                                  *
+*  Writes the products of the last lines and       *
+*  closes the raw files.  Returns 0, or -1 on a    *
+*  write error or if lines are missing (the files  *
+*  are then removed)                               *
+*                                                  *
+****************************************************/
+int close_terrain(terrain_pass *t)
+{
+   int i, err = 0;
+
+   if (t->lines < 0)
+      err = -1;
+   else if (t->added != t->lines)
+      err = -1;
+   while (!err && t->done < t->lines)
+      if (terrain_line(t, t->done) != 0)
+         err = -1;
+
+   for (i = 0; i < TERRAIN_PLANES; i++)
+      if (t->fp[i] != NULL) {
+         if (fclose(t->fp[i]) != 0)
+            err = -1;
+         if (err)
+            remove(t->file[i]);
+      }
+   if (err && t->lines >= 0)
+      printf("\nerror writing the terrain raw files\n");
+
+   for (i = 0; t->row != NULL && i < t->nbuf; i++)
+      free(t->row[i]);
+   free(t->row);
+   free(t->null_row);
+   free(t->ok);
+   free(t->p);
+   free(t->q);
+   free(t->col);
+   free(t->shade);
+   for (i = 0; i < TERRAIN_PLANES; i++)
+      free(t->out[i]);
+   free(t);
+   return(err);
+}
+
+/**************  script_terrain_products  **********
+*                                                  *
+*  Has the script import the terrain raw files of  *
+*  rawDEM as <cube>_slope.cub etc., labeled with   *
+*  the mapping of the cube of rawDEM's grid        *
+*  (SS_<cube>.cub if there is one, else <cube>.cub)*
+*                                                  *
+****************************************************/
+void script_terrain_products(char *isis_script, char *outcub_name,
+            char *byteOrder, char *rawDEM, int lines, int samples, int size)
+{
+   static const char *suffix[TERRAIN_PLANES] =
+      {"_slope", "_aspect", "_hillshade", "_roughness"};
+   char files[TERRAIN_PLANES][FILELEN];
+   char *raw_files[TERRAIN_PLANES];
+   char command[512];
+   int i;
+
+   for (i = 0; i < TERRAIN_PLANES; i++)
+      raw_files[i] = files[i];
+   terrain_raw_names(rawDEM, raw_files);
+
+   sprintf(command,"######################################################");
+   writeToScript(isis_script,command);
+   sprintf(command,"## Import the slope (degrees), aspect (degrees from north),");
+   writeToScript(isis_script,command);
+   sprintf(command,"## hillshade (sun at %.0f/%.0f degrees) and %dx%d RMS roughness (m)",
+           TERRAIN_SUN_AZIMUTH,TERRAIN_SUN_ALTITUDE,size,size);
+   writeToScript(isis_script,command);
+   sprintf(command,"## cubes, written with the raw files on the native DEM grid");
+   writeToScript(isis_script,command);
+   sprintf(command,"######################################################\n");
+   writeToScript(isis_script,command);
+
+   sprintf(command,"if (-e SS_%s.cub) then",outcub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"   set terrain_cub = SS_%s",outcub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"else");
+   writeToScript(isis_script,command);
+   sprintf(command,"   set terrain_cub = %s",outcub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"endif");
+   writeToScript(isis_script,command);
+   sprintf(command,"catlab from=${terrain_cub}.cub to=%s_terrain.lbl",outcub_name);
+   writeToScript(isis_script,command);
+   sprintf(command,"set ulx = `getkey from=${terrain_cub}.cub grpname=Mapping keyword=UpperLeftCornerX`");
+   writeToScript(isis_script,command);
+   sprintf(command,"set uly = `getkey from=${terrain_cub}.cub grpname=Mapping keyword=UpperLeftCornerY`");
+   writeToScript(isis_script,command);
+
+   for (i = 0; i < TERRAIN_PLANES; i++) {
+      if (i == TERRAIN_HILLSHADE)
+         sprintf(command,"raw2isis from=%s to=${terrain_cub}%s.cub samples=%d lines=%d bands=1",
+                 raw_files[i],suffix[i],samples,lines);
+      else
+         sprintf(command,"raw2isis from=%s to=${terrain_cub}%s.cub samples=%d lines=%d bands=1 bittype=real byteorder=%s",
+                 raw_files[i],suffix[i],samples,lines,byteOrder);
+      writeToScript(isis_script,command);
+      sprintf(command,"maplab from=${terrain_cub}%s.cub map=%s_terrain.lbl sample=0.5 line=0.5 x=$ulx y=$uly",
+              suffix[i],outcub_name);
+      writeToScript(isis_script,command);
+   }
+
+   sprintf(command,"/bin/rm -f %s_terrain.lbl\n",outcub_name);
+   writeToScript(isis_script,command);
+}
+
+/**************  open_project_dem  *****************
+*                                                  *
+*  Reads SOCET SET project prj (path and .prj      *
+*  extension optional) into project and makes it   *
+*  the current project, then opens grid DEM dem    *
+*  (path and .dth extension optional) of the       *
+*  project's data directory into d.  demName gets  *
+*  the DEM name w/o path or extension.  Returns 0, *
+*  or -1 after reporting the error (nothing left   *
+*  open).  Close d with close_project_dem.         *
+****************************************************/
+int open_project_dem(char *prj, img_proj_struct &project, char *dem,
+                     char *demName, project_dem *d)
+{
+   char projectName[FILELEN];      // SS project w/o path or .prj ext
+   char projectFile[FILELEN];      // SS project w/.prj ext
+   char dth[FILELEN];
+   char fname[FILELEN];
+   int prjReadErr;
+   int demReadErr;
+
+   d->proj_ptr = NULL;
+   d->header = NULL;
+   d->grid = NULL;
+
+   // Make sure project name contains no path, but has .prj extension
+   strcpy(projectName, ReturnFileName(prj));
+   StripFileExt(projectName);
+   strcpy(projectFile, concat(projectName, ".prj"));
+
+   prjReadErr = project.read(projectFile);
+   switch (prjReadErr) {
+      case 0:
+      setCurrentProj(project);
+      break;
+      case -1:
+      printf("Failed to open project file %s\n", projectFile);
+      return(-1);
+      case -2:
+      printf("Project file read error: unknow line\n");
+      return(-1);
+      default:
+      printf("Project file read error on line #%d\n", prjReadErr);
+      return(-1);
+   }
+
+   strcpy(demName, ReturnFileName(dem));
+   StripFileExt(demName);
+   build_file_name(dth, project.project_data_path, demName, ".dth");
+   strcpy(fname, dth);
+   StripFileExt(fname);
+
+   if (!file_exists(dth)) {
+      printf("\ndem %s does not exist!\n", demName);
+      printf("(NOTE: looking for %s)\n", dth);
+      return(-1);
+   }
+
+   d->proj_ptr = getCurrentProjStruct();
+   d->header = new DtmHeader(d->proj_ptr);
+   d->header->load(fname);
+
+   d->grid = new DtmGrid(d->header);
+   if ((demReadErr = d->grid->openDtm(fname, FALSE, O_RDONLY, FALSE, FALSE)) != 0) {
+      printf("DEM READ ERROR #%d reading DEM file.\n", demReadErr);
+      close_project_dem(d);
+      return(-1);
+   }
+
+   if (d->header->dtmFormat() != DTM_GRID) {
+      printf("ERROR: input DEM is not in GRID format\n");
+      close_project_dem(d);
+      return(-1);
+   }
+
+   return(0);
+}
+
+/**************  close_project_dem  ****************
+*                                                  *
+*  Closes the DEM of open_project_dem and frees    *
+*  its header and project structure                *
+****************************************************/
+void close_project_dem(project_dem *d)
+{
+   delete d->grid;
+   delete d->header;
+   free(d->proj_ptr);      // getCurrentProjStruct returns a malloc'd copy
+   d->grid = NULL;
+   d->header = NULL;
+   d->proj_ptr = NULL;
+}
@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title export_subroutines.h
+//
+//_Desc  Constants and declarations shared by export_subroutines.cpp and the
+//       programs built with it (dem2isis3, ortho2isis3, ...), so each value
+//       is defined once.  Included by path (../export_subs/), so the
+//       makefiles need no extra include directory.  Include it after the
+//       SOCET SET headers (project_dem uses their DEM and project types).
+//
+//_Hist Oct 19 2026      Orig Version, with the overview pyramid constants
+//                       and routines
+//      Oct 19 2026      Added open_project_dem/close_project_dem, the project
+//                       and DEM open of the DEM tools
+//      Oct 19 2026      The prototypes of the script, FOM mask, NULL-span
+//                       index and terrain routines moved here from the
+//                       programs, which each had their own copy
+//      Oct 19 2026      Added the worker threads (run_workers) and
+//                       form_product_names
+//_End
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef EXPORT_SUBROUTINES_H
+#define EXPORT_SUBROUTINES_H
+
+// ISIS label and script routines
+int parse_label(char *file, char *keyword, char *value);
+int getTargetInfo(char *uc_ellipsoid, char *isisTargName,
+                  char *ographicPosLonDir, char *ocentricPosLonDir);
+int writeToScript(char *isis_script, char *command);
+int generate_ss2isis_script(char *isis_script, char *prj, char *productType,
+                            char *byteOrder, char *outcubName,
+                            char *layout_flag, int lines, int samples,
+                            double x_realspacing, double y_realspacing,
+                            double ulcenter_Xlon, double ulcenter_Ylat,
+                            int confidence_flag, int resampled_flag);
+int generate_standard_dem(char *prj, char *outcubName, int lines, int samples,
+                          double x_realspacing, double y_realspacing,
+                          double ulcenter_Xlon, double ulcenter_Ylat,
+                          int confidence_flag, int overview_flag);
+int native_cube_name(char *prj, char *outcub_name, char *cub);
+void form_product_names(char *outcub_name, char *FOM_name, char *CONF_name);
+
+// Worker threads (see run_workers)
+#define MAX_WORKER_THREADS 16
+typedef void (*worker_routine)(void *arg);
+int worker_threads(int nitems);
+void run_workers(worker_routine work, void *arg, int nthreads);
+long next_work_item(volatile long *next);
+
+// FOM masking (see open_fom_mask)
+struct fom_mask;
+fom_mask *open_fom_mask(char *spec);
+int fom_mask_row(fom_mask *m, char *fom_buf, unsigned char *keep, int ncols);
+void pack_mask_row(unsigned char *keep, unsigned char *bits, int ncols);
+void write_fom_mask_json(FILE *fp, fom_mask *m, char *mask_file);
+void close_fom_mask(fom_mask *m);
+
+// NULL-span index of a 32-bit DEM cube (see open_span_index)
+struct span_index;
+span_index *open_span_index(char *file, int lines, int samples);
+int add_span_row(span_index *s, float *row);
+int close_span_index(span_index *s);
+
+// Terrain products: slope, aspect, hillshade and RMS roughness (see open_terrain)
+struct terrain_pass;
+terrain_pass *open_terrain(char *prj, int lines, int samples,
+                           double x_realspacing, double y_realspacing,
+                           double ulcenter_Ylat, int size, char **raw_files);
+int add_terrain_row(terrain_pass *t, float *row);
+int close_terrain(terrain_pass *t);
+void terrain_raw_names(char *rawDEM, char **raw_files);
+void script_terrain_products(char *isis_script, char *outcub_name,
+                             char *byteOrder, char *rawDEM, int lines,
+                             int samples, int size);
+
+// Overview pyramids (see open_overviews)
+#define MAX_OVR_LEVELS 16
+#define MAX_OVR_PLANES 3
+#define OVR_MIN_SIZE 256           // last level fits in OVR_MIN_SIZE x OVR_MIN_SIZE
+
+// how the 2x2 posts of a plane are combined
+#define OVR_DEM   0                // 32-bit elevations: mean of the valid posts
+#define OVR_FOM   1                // 8-bit FOM: most common FOM >= 2, ties to the lowest
+#define OVR_CONF  2                // 8-bit confidence: most common class >= 1, ties to the lowest
+#define OVR_ORTHO 3                // 8-bit image: mean of the non-zero pixels
+
+struct overview_pyramid;
+overview_pyramid *open_overviews(int lines, int samples, int nplanes, int *types,
+                                 char **raw_files);
+int add_overview_row(overview_pyramid *p, void **rows);
+int close_overviews(overview_pyramid *p);
+
+// A grid DEM of the current project (see open_project_dem)
+struct project_dem {
+   img_proj_struct_ptr proj_ptr;   // current project, used by header
+   DtmHeader *header;
+   DtmGrid *grid;
+};
+int open_project_dem(char *prj, img_proj_struct &project, char *dem,
+                     char *demName, project_dem *d);
+void close_project_dem(project_dem *d);
+
+#endif
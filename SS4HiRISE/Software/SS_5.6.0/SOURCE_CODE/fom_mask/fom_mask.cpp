@@ -0,0 +1,273 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title FOM_MASK masks a SOCET DEM by FOM range and class
+//
+//_Desc  This is a SOCET Set program that uses SOCET DEV_KIT routines to
+//       stream a SOCET DEM and its FOM once and write the DEM with the posts
+//       outside a FOM mask set to NULL, the mask as a bit plane, and mask
+//       statistics.  It does the masking of the USGS_FOM_Masking GUI from the
+//       command line, so it can be scripted over many DTMs; dem2isis3 takes
+//       the same mask as its optional fom_mask argument.
+//
+//       The mask keeps the posts whose FOM is in low..high, less any classes
+//       listed after a colon:
+//
+//              <low>-<high>[:<fom>|<first>-<last>[,...]]
+//
+//       e.g. 2-254:3,40-45 keeps the correlated posts except the
+//       interpolated (3) and the 40..45 classes.  (See open_fom_mask in
+//       export_subroutines for the thresholding.)
+//
+//       Input parameters are:
+//
+//              SS_project
+//              socet_dem.dth
+//              output
+//              mask_spec
+//
+//
+//       Output files are:
+//
+//              ./output.raw  (32-bit float DEM in the host byte order, north
+//                             line first, NULL where masked or FOM < 2)
+//              ./output_mask.raw  (bit plane, (samples+7)/8 bytes a line,
+//                                  north line first, first post in the low
+//                                  bit, 1 = kept)
+//              ./output_mask_stats.json  (elevation statistics of the kept
+//                                         posts and the mask counts)
+//
+//_Hist Oct 18 2026      Orig Version
+//      Oct 19 2026      The project and DEM are opened by open_project_dem
+//                       (export_subroutines), which deletes the DtmHeader
+//                       rather than free()ing it
+//
+//_End
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <system_includes.h>
+#include <math.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+//SOCET SET
+#include <key/handle_key.h>
+#include <dtm/dtm.h>
+#include <dtmUtil/dtm_util.h>
+#include <dtmAccess/DtmGrid.h>
+#include <dtmAccess/DtmHeader.h>
+#include <dtmAccess/fom_defs.h>
+#include <project/proj.h>
+#include <util/string_dpw.h>
+#include <util/init_socet_app.h>
+#include <ground_point.h>
+
+#include "../export_subs/export_subroutines.h"
+
+#define FILELEN 512
+
+// ISIS NULL (as dem2isis3)
+#define NULL3 -3.4028226550889044521e+38
+
+int main(int argc, char *argv[]) {
+	// DECLARATIONS:
+
+	// Input variables
+	char dem[FILELEN];
+	char demName[FILELEN];
+	char output[FILELEN];
+	char maskSpec[FILELEN];
+
+	// DEM Header Variables
+	project_dem pd;
+	DtmGrid* di;
+	DtmHeader* di_header;
+	int ncols, nrows;
+
+	// Project File Variables
+	img_proj_struct project;        //SS project structure
+	char prj[FILELEN];         //SS project with full path and extension
+
+	// Output files
+	char rawDEM[FILELEN];
+	char rawMASK[FILELEN];
+	char statsReport[FILELEN];
+	FILE *ofp_DEM;
+	FILE *ofp_MASK;
+	FILE *fp;
+
+	// Misc declarations
+	int i, index_y;
+	float null;
+	fom_mask *mask;
+
+	// Statistics of the kept posts (sums are about the first kept
+	// elevation, ref, for precision)
+	unsigned long long kept = 0;
+	double ref = 0.0, sum = 0.0, sumsq = 0.0, d;
+	double zmin = 0.0, zmax = 0.0, mean, stddev;
+
+	null = (float) NULL3;
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Check number of command line args and issue help if needed
+	// Otherwise initiate the socet set application
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (argc < 5) {
+		cerr << "\nRun fom_mask as follows:\n";
+		cerr << "start_socet -single fom_mask.exe <project> <socet_dem> <output> <mask_spec>\n";
+		cerr << "\nwhere:\n";
+		cerr << "project = SOCET SET project name to read DEM from\n";
+		cerr << "          (path and extension is not required)\n";
+		cerr << "socet_dem = SOCET SET dem to mask\n";
+		cerr << "          (path and extension is not required)\n";
+		cerr << "output = base name of the output files; writes <output>.raw,\n";
+		cerr << "         <output>_mask.raw and <output>_mask_stats.json\n";
+		cerr << "mask_spec = FOM mask, low-high[:fom,first-last,...]\n";
+		cerr << "          (posts with FOM outside low..high or in a listed class\n";
+		cerr << "          are NULLed, e.g. 2-254:3,40-45)\n";
+		exit(1);
+	}
+
+	// Top level SOCET SET initialization  routine.
+	// Should be  called  before  any  PCI services.
+	init_socet_app ( argv[0], argc, argv);
+
+	/////////////////////////////////////////////////////////////////////////////
+	//Get input arguments
+	/////////////////////////////////////////////////////////////////////////////
+
+	strcpy(prj, argv[1]);
+	strcpy(dem, argv[2]);
+	strcpy(output, argv[3]);
+	strcpy(maskSpec, argv[4]);
+
+	mask = open_fom_mask(maskSpec);
+	if (mask == NULL)
+		exit(1);
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Populate the project structure and load the DEM
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (open_project_dem(prj, project, dem, demName, &pd) != 0)
+		exit(1);
+	di = pd.grid;
+	di_header = pd.header;
+
+	ncols = di_header->numXPosts();
+	nrows = di_header->numYPosts();
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Stream the DEM north line first, masking each line
+	/////////////////////////////////////////////////////////////////////////////
+
+	strcpy(output, ReturnFileName(output));
+	StripFileExt(output);
+	sprintf(rawDEM, "%s.raw", output);
+	sprintf(rawMASK, "%s_mask.raw", output);
+	sprintf(statsReport, "%s_mask_stats.json", output);
+
+	ofp_DEM = fopen(rawDEM, "wb");
+	if (ofp_DEM == NULL) {
+		printf("\ncan't open the output raw DEM file: %s!\n", rawDEM);
+		exit(1);
+	}
+	ofp_MASK = fopen(rawMASK, "wb");
+	if (ofp_MASK == NULL) {
+		printf("\ncan't open the output raw mask file: %s!\n", rawMASK);
+		exit(1);
+	}
+
+	cout << "Masking DEM " << demName << " by FOM " << maskSpec << "...\n";
+
+	float *elev_buf = new float [ncols];
+	char *fom_buf = new char [ncols];
+	unsigned char *keep_row = new unsigned char [ncols];
+	unsigned char *mask_row = new unsigned char [(ncols + 7) / 8];
+
+	for (index_y = nrows - 1; index_y >= 0; index_y--) {
+
+		di->getElevationBlock(0, index_y, ncols - 1, index_y, elev_buf);
+		di->getFomBlock(0, index_y, ncols - 1, index_y, fom_buf);
+
+		fom_mask_row(mask, fom_buf, keep_row, ncols);
+		pack_mask_row(keep_row, mask_row, ncols);
+
+		for (i = 0; i < ncols; i++) {
+			// FOM 0 and 1 are never elevations, whatever the mask says
+			if (!keep_row[i] || (unsigned char) fom_buf[i] < 2) {
+				elev_buf[i] = null;
+				continue;
+			}
+			if (kept == 0)
+				ref = zmin = zmax = elev_buf[i];
+			d = elev_buf[i] - ref;
+			sum += d;
+			sumsq += d * d;
+			if (elev_buf[i] < zmin) zmin = elev_buf[i];
+			if (elev_buf[i] > zmax) zmax = elev_buf[i];
+			kept++;
+		}
+
+		if (fwrite(elev_buf, sizeof(float), ncols, ofp_DEM) != (size_t) ncols ||
+		    fwrite(mask_row, 1, (ncols + 7) / 8, ofp_MASK) != (size_t) (ncols + 7) / 8) {
+			printf("\nerror writing raw DEM/mask files!\n");
+			exit(1);
+		}
+	}
+
+	delete [] elev_buf;
+	delete [] fom_buf;
+	delete [] keep_row;
+	delete [] mask_row;
+	if (fclose(ofp_DEM) != 0 || fclose(ofp_MASK) != 0) {
+		printf("\nerror writing raw DEM/mask files!\n");
+		exit(1);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Write the statistics
+	/////////////////////////////////////////////////////////////////////////////
+
+	fp = fopen(statsReport, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the statistics report: %s!\n", statsReport);
+		exit(1);
+	}
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"dem\": \"%s\",\n", demName);
+	fprintf(fp, "  \"lines\": %d,\n", nrows);
+	fprintf(fp, "  \"samples\": %d,\n", ncols);
+	fprintf(fp, "  \"valid_pixels\": %llu,\n", kept);
+	if (kept > 0) {
+		mean = sum / kept;
+		stddev = sumsq / kept - mean * mean;
+		stddev = (stddev > 0.0) ? sqrt(stddev) : 0.0;
+		fprintf(fp, "  \"min\": %.6f,\n", zmin);
+		fprintf(fp, "  \"max\": %.6f,\n", zmax);
+		fprintf(fp, "  \"mean\": %.6f,\n", ref + mean);
+		fprintf(fp, "  \"stddev\": %.6f,\n", stddev);
+	}
+	else {
+		fprintf(fp, "  \"min\": null,\n");
+		fprintf(fp, "  \"max\": null,\n");
+		fprintf(fp, "  \"mean\": null,\n");
+		fprintf(fp, "  \"stddev\": null,\n");
+	}
+	write_fom_mask_json(fp, mask, rawMASK);
+	fprintf(fp, "\n}\n");
+	if (fclose(fp) != 0) {
+		printf("\nerror writing the statistics report: %s!\n", statsReport);
+		exit(1);
+	}
+
+	close_fom_mask(mask);
+	close_project_dem(&pd);
+
+	cout << "Wrote " << rawDEM << ", " << rawMASK << " and " << statsReport << "\n";
+	return(0);
+}
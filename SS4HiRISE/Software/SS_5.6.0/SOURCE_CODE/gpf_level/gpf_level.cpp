@@ -0,0 +1,592 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title GPF_LEVEL levels the tie points of a GPF to a SOCET DEM
+//
+//_Desc  This is a SOCET Set program that uses SOCET DEV_KIT routines to
+//       level a ground point file to a SOCET DEM, as Level_GPF_to_DEM of
+//       the USGS_GPF_Leveling GUI does, from the command line: each active
+//       tie point (stat 1, known 0) that falls on the DEM gets the DEM
+//       height at its X/Y and becomes Z control (known 2), so a bundle
+//       adjustment can't tilt or shift the block away from the DEM.  Other
+//       points are copied unchanged.
+//
+//       The GPF is loaded into arrays, one per field, and the points are
+//       bucketed by the tile of the DEM they fall in.  DTMs are stored row
+//       by row, so a tile is a band of TILE_ROWS rows across the DEM.  Each
+//       tile that has points is read once (with the row past its edge, for
+//       the bilinear cell) and the heights of its points are interpolated
+//       together.  A point is rejected if any of the four posts around it
+//       has a FOM below min_fom (default 2, so NULL posts are never used).
+//
+//       Input parameters are:
+//
+//              SS_project
+//              socet_dem.dth
+//              input.gpf
+//              output.gpf (- to only check the DEM coverage)
+//              z_sigma (optional, - keeps each point's Z sigma)
+//              min_fom (optional, default 2)
+//
+//
+//       Output files are:
+//
+//              ./output.gpf
+//              ./output_level.json (./input_coverage.json with output -)
+//                  point counts (tie points on the DEM, leveled, rejected
+//                  by FOM, off the DEM) and the height changes
+//
+//       X/Y of the GPF and the DEM are in the project's units (radians in
+//       geographic projects, where longitudes are wrapped by 2 pi onto the
+//       DEM).
+//
+//_Hist Oct 18 2026      Orig Version
+//      Oct 19 2026      The project and DEM are opened by open_project_dem
+//                       (export_subroutines), which deletes the DtmHeader
+//                       rather than free()ing it
+//
+//_End
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include <system_includes.h>
+#include <math.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+//SOCET SET
+#include <key/handle_key.h>
+#include <dtm/dtm.h>
+#include <dtmUtil/dtm_util.h>
+#include <dtmAccess/DtmGrid.h>
+#include <dtmAccess/DtmHeader.h>
+#include <dtmAccess/fom_defs.h>
+#include <project/proj.h>
+#include <util/string_dpw.h>
+#include <util/init_socet_app.h>
+#include <ground_point.h>
+
+#include "../export_subs/export_subroutines.h"
+
+#define FILELEN 512
+
+// Rows of a DEM tile (tiles span the DEM's width)
+#define TILE_ROWS 256
+
+// GPF point status and type
+#define GPF_ON 1
+#define GPF_TIE 0
+#define GPF_Z_CONTROL 2
+
+// Outcome of a point
+#define LEVEL_SKIPPED  0    // not an active tie point
+#define LEVEL_OFF_DEM  1
+#define LEVEL_FOM      2    // rejected by FOM
+#define LEVEL_LEVELED  3
+
+// A GPF in memory: the file text and, for each point, its fields and
+// where its lines start
+struct gpf_points {
+	char *text;            // the whole file, lines NUL terminated
+	char *header[3];       // the three header lines
+	int n;
+	char **line;           // line[5*i..5*i+4]: the lines of point i
+	int *stat, *known;
+	double *x, *y, *z;     // X (longitude), Y (latitude), height
+	double *sigz;          // Z sigma
+	float *dem_z;          // leveled height
+	unsigned char *result; // LEVEL_*
+};
+
+// prototypes
+int read_gpf(char *file, gpf_points *gpf);
+void free_gpf(gpf_points *gpf);
+int level_points(DtmGrid *di, int ncols, int nrows, ground_point_struct ll,
+            double dx, double dy, double wrap, gpf_points *gpf, int min_fom);
+int write_gpf(char *file, gpf_points *gpf, char *z_sigma);
+int write_level_report(char *report, char *gpf_file, char *dem,
+            gpf_points *gpf);
+
+int main(int argc, char *argv[]) {
+	// DECLARATIONS:
+
+	// Input variables
+	char dem[FILELEN];
+	char demName[FILELEN];
+	char gpfFile[FILELEN];
+	char outGpf[FILELEN];
+	char zSigma[FILELEN];
+	int min_fom;
+
+	// DEM Header Variables
+	project_dem pd;
+	DtmGrid* di;
+	DtmHeader* di_header;
+	int ncols, nrows;
+	ground_point_struct ll_corner;
+
+	// Project File Variables
+	img_proj_struct project;        //SS project structure
+	char prj[FILELEN];         //SS project with full path and extension
+
+	// Misc declarations
+	char value[FILELEN];
+	char report[FILELEN];
+	double wrap;
+	gpf_points gpf;
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Check number of command line args and issue help if needed
+	// Otherwise initiate the socet set application
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (argc < 5) {
+		cerr << "\nRun gpf_level as follows:\n";
+		cerr << "start_socet -single gpf_level.exe <project> <socet_dem> <input.gpf> <output.gpf> [z_sigma] [min_fom]\n";
+		cerr << "\nwhere:\n";
+		cerr << "project = SOCET SET project name of the GPF and DEM\n";
+		cerr << "          (path and extension is not required)\n";
+		cerr << "socet_dem = SOCET SET dem to level to\n";
+		cerr << "          (path and extension is not required)\n";
+		cerr << "input.gpf = ground point file to level\n";
+		cerr << "output.gpf = leveled ground point file, or - to only report\n";
+		cerr << "          the DEM coverage of the tie points\n";
+		cerr << "z_sigma = optional Z sigma (m) of the leveled points\n";
+		cerr << "          (default, or -, keeps each point's Z sigma)\n";
+		cerr << "min_fom = optional lowest FOM of the posts a point is\n";
+		cerr << "          interpolated from (default 2)\n";
+		exit(1);
+	}
+
+	// Top level SOCET SET initialization  routine.
+	// Should be  called  before  any  PCI services.
+	init_socet_app ( argv[0], argc, argv);
+
+	/////////////////////////////////////////////////////////////////////////////
+	//Get input arguments
+	/////////////////////////////////////////////////////////////////////////////
+
+	strcpy(prj, argv[1]);
+	strcpy(dem, argv[2]);
+	strcpy(gpfFile, argv[3]);
+	strcpy(outGpf, argv[4]);
+	if (argc >= 6)
+		strcpy(zSigma, argv[5]);
+	else
+		strcpy(zSigma, "-");
+	if (argc >= 7)
+		min_fom = atoi(argv[6]);
+	else
+		min_fom = 2;
+
+	if (strcmp(zSigma, "-") != 0 && atof(zSigma) <= 0.0) {
+		cerr << "z_sigma must be greater than 0 (or - for the GPF's)\n";
+		exit(1);
+	}
+	if (min_fom < 0 || min_fom > 255) {
+		cerr << "min_fom must be 0 to 255\n";
+		exit(1);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Populate the project structure and load the DEM
+	/////////////////////////////////////////////////////////////////////////////
+
+	if (open_project_dem(prj, project, dem, demName, &pd) != 0)
+		exit(1);
+	di = pd.grid;
+	di_header = pd.header;
+
+	// Get project with full path and extension
+	strcpy(prj, concat(project.project_data_path, ".prj"));
+
+	// Geographic projects (COORD_SYS 1) wrap longitude by 2 pi
+	wrap = 0.0;
+	if (parse_label(prj, "COORD_SYS", value) == 1 && atoi(value) == 1)
+		wrap = 2.0 * M_PI;
+
+	ncols = di_header->numXPosts();
+	nrows = di_header->numYPosts();
+	ll_corner = di_header->llCorner();
+
+	if (ncols < 2 || nrows < 2) {
+		cerr << "ERROR: the DEM needs at least 2 x 2 posts\n";
+		exit(1);
+	}
+
+	if (read_gpf(gpfFile, &gpf) != 0)
+		exit(1);
+
+	/////////////////////////////////////////////////////////////////////////////
+	// Level the tie points and write the GPF and report
+	/////////////////////////////////////////////////////////////////////////////
+
+	cout << "Leveling " << gpf.n << " points of " << gpfFile << " to DEM "
+	     << demName << "...\n";
+
+	if (level_points(di, ncols, nrows, ll_corner, di_header->xRealSpacing(),
+	                 di_header->yRealSpacing(), wrap, &gpf, min_fom) != 0)
+		exit(1);
+
+	if (strcmp(outGpf, "-") == 0) {
+		strcpy(report, gpfFile);
+		StripFileExt(report);
+		strcat(report, "_coverage.json");
+	}
+	else {
+		if (write_gpf(outGpf, &gpf, zSigma) != 0)
+			exit(1);
+		strcpy(report, outGpf);
+		StripFileExt(report);
+		strcat(report, "_level.json");
+	}
+	if (write_level_report(report, gpfFile, demName, &gpf) != 0)
+		exit(1);
+
+	free_gpf(&gpf);
+	close_project_dem(&pd);
+	return(0);
+}
+
+/**************  read_gpf  *************************
+*                                                  *
+*  Reads a GPF into gpf: the header, then five     *
+*  lines a point (id stat known, Y X Z, sigmas,    *
+*  residuals and a blank line).  Returns 0, or -1  *
+*  if the file can't be read or is short           *
+*                                                  *
+****************************************************/
+int read_gpf(char *file, gpf_points *gpf)
+{
+	FILE *fp;
+	long size;
+	char *p, *sig;
+	char *lines[3];
+	int i, k, nlines;
+
+	memset(gpf, 0, sizeof(gpf_points));
+
+	fp = fopen(file, "rb");
+	if (fp == NULL) {
+		printf("unable to open input gpf file: %s\n", file);
+		return(-1);
+	}
+	fseek(fp, 0L, SEEK_END);
+	size = ftell(fp);
+	rewind(fp);
+	gpf->text = new char [size + 1];
+	if (fread(gpf->text, 1, size, fp) != (size_t) size) {
+		printf("error reading gpf file: %s\n", file);
+		fclose(fp);
+		return(-1);
+	}
+	fclose(fp);
+	gpf->text[size] = '\0';
+
+	// split the text into lines
+	p = gpf->text;
+	for (k = 0; k < 3; k++) {
+		lines[k] = p;
+		p = strchr(p, '\n');
+		if (p == NULL) {
+			printf("gpf file %s has no point count\n", file);
+			return(-1);
+		}
+		*p++ = '\0';
+	}
+	for (k = 0; k < 3; k++)
+		gpf->header[k] = lines[k];
+	gpf->n = atoi(lines[1]);
+	if (gpf->n < 0) {
+		printf("gpf file %s has a bad point count\n", file);
+		return(-1);
+	}
+
+	gpf->line = new char * [5 * (size_t) gpf->n + 1];
+	gpf->stat = new int [gpf->n + 1];
+	gpf->known = new int [gpf->n + 1];
+	gpf->x = new double [gpf->n + 1];
+	gpf->y = new double [gpf->n + 1];
+	gpf->z = new double [gpf->n + 1];
+	gpf->sigz = new double [gpf->n + 1];
+	gpf->dem_z = new float [gpf->n + 1];
+	gpf->result = new unsigned char [gpf->n + 1];
+
+	nlines = 5 * gpf->n;
+	for (k = 0; k < nlines && *p != '\0'; k++) {
+		gpf->line[k] = p;
+		p = strchr(p, '\n');
+		if (p == NULL)
+			p = gpf->line[k] + strlen(gpf->line[k]);
+		else
+			*p++ = '\0';
+	}
+	// the blank line after the last point may be missing
+	if (k == nlines - 1)
+		gpf->line[k++] = p;
+	if (k < nlines) {
+		printf("gpf file %s ends after %d of its %d points\n", file, k / 5,
+		       gpf->n);
+		return(-1);
+	}
+
+	for (i = 0; i < gpf->n; i++) {
+		if (sscanf(gpf->line[5*i], "%*s %d %d", &gpf->stat[i], &gpf->known[i]) != 2 ||
+		    sscanf(gpf->line[5*i+1], "%lf %lf %lf", &gpf->y[i], &gpf->x[i], &gpf->z[i]) != 3) {
+			printf("gpf file %s: bad point %d: %s\n", file, i + 1, gpf->line[5*i]);
+			return(-1);
+		}
+		// Z sigma is the third value of the sigma line
+		sig = gpf->line[5*i+2];
+		if (sscanf(sig, "%*s %*s %lf", &gpf->sigz[i]) != 1)
+			gpf->sigz[i] = 0.0;
+		gpf->result[i] = LEVEL_SKIPPED;
+	}
+	return(0);
+}
+
+/**************  free_gpf  *************************/
+void free_gpf(gpf_points *gpf)
+{
+	delete [] gpf->text;
+	delete [] gpf->line;
+	delete [] gpf->stat;
+	delete [] gpf->known;
+	delete [] gpf->x;
+	delete [] gpf->y;
+	delete [] gpf->z;
+	delete [] gpf->sigz;
+	delete [] gpf->dem_z;
+	delete [] gpf->result;
+}
+
+/**************  level_points  *********************
+*                                                  *
+*  Interpolates the DEM height of each active tie  *
+*  point, reading each DEM tile (band of rows)     *
+*  with points on it once, and sets result[] (and  *
+*  dem_z[] of the leveled points).  Returns 0, or  *
+*  -1 on a DEM read error                          *
+*                                                  *
+****************************************************/
+int level_points(DtmGrid *di, int ncols, int nrows, ground_point_struct ll,
+                 double dx, double dy, double wrap, gpf_points *gpf,
+                 int min_fom)
+{
+	int ntiles = (nrows - 2) / TILE_ROWS + 1;   // tiles of bilinear cells
+	int *start = new int [ntiles + 1];
+	int *order = new int [gpf->n + 1];
+	int *tile = new int [gpf->n + 1];
+	double *fx = new double [gpf->n + 1];
+	double *fy = new double [gpf->n + 1];
+	float *z = new float [(size_t) (TILE_ROWS + 1) * ncols];
+	unsigned char *fom = new unsigned char [(size_t) (TILE_ROWS + 1) * ncols];
+	double cx, cy, u, v;
+	int i, k, t, x0, y0, y1, row;
+	size_t j, w = ncols;
+	int err = 0;
+
+	// DEM cell of each active tie point, in post units
+	for (i = 0; i < gpf->n; i++) {
+		tile[i] = -1;
+		if (gpf->stat[i] != GPF_ON || gpf->known[i] != GPF_TIE)
+			continue;
+		gpf->result[i] = LEVEL_OFF_DEM;
+		cx = gpf->x[i];
+		if (wrap > 0.0) {
+			cx = fmod(cx - ll.x, wrap);
+			if (cx < 0.0)
+				cx += wrap;
+			cx += ll.x;
+		}
+		cx = (cx - ll.x) / dx;
+		cy = (gpf->y[i] - ll.y) / dy;
+		if (cx < 0.0 || cx > ncols - 1 || cy < 0.0 || cy > nrows - 1)
+			continue;
+		y0 = (int) cy;
+		if (y0 > nrows - 2) y0 = nrows - 2;
+		tile[i] = y0 / TILE_ROWS;
+		fx[i] = cx;
+		fy[i] = cy;
+	}
+
+	// bucket the points by tile (counting sort)
+	for (t = 0; t <= ntiles; t++)
+		start[t] = 0;
+	for (i = 0; i < gpf->n; i++)
+		if (tile[i] >= 0)
+			start[tile[i] + 1]++;
+	for (t = 0; t < ntiles; t++)
+		start[t + 1] += start[t];
+	for (i = 0; i < gpf->n; i++)
+		if (tile[i] >= 0)
+			order[start[tile[i]]++] = i;
+	for (t = ntiles; t > 0; t--)
+		start[t] = start[t - 1];
+	start[0] = 0;
+
+	for (t = 0; t < ntiles && err == 0; t++) {
+		if (start[t] == start[t + 1])
+			continue;
+
+		// read the tile's rows, and the row past its edge
+		y0 = t * TILE_ROWS;
+		y1 = (y0 + TILE_ROWS < nrows - 1) ? y0 + TILE_ROWS : nrows - 1;
+		for (row = y0; row <= y1; row++)
+			if (di->getElevationBlock(0, row, ncols - 1, row, z + (row - y0) * w) != 0 ||
+			    di->getFomBlock(0, row, ncols - 1, row, (char *) fom + (row - y0) * w) != 0) {
+				cerr << "DEM read error at row " << row << endl;
+				err = -1;
+				break;
+			}
+
+		// bilinear heights of the tile's points
+		for (k = start[t]; k < start[t + 1] && err == 0; k++) {
+			i = order[k];
+			x0 = (int) fx[i];
+			row = (int) fy[i];
+			if (x0 > ncols - 2) x0 = ncols - 2;
+			if (row > nrows - 2) row = nrows - 2;
+			u = fx[i] - x0;
+			v = fy[i] - row;
+			j = (row - y0) * w + x0;
+			if (fom[j] < min_fom || fom[j + 1] < min_fom ||
+			    fom[j + w] < min_fom || fom[j + w + 1] < min_fom) {
+				gpf->result[i] = LEVEL_FOM;
+				continue;
+			}
+			gpf->dem_z[i] = (float) ((1.0 - v) * ((1.0 - u) * z[j] + u * z[j + 1]) +
+			                         v * ((1.0 - u) * z[j + w] + u * z[j + w + 1]));
+			gpf->result[i] = LEVEL_LEVELED;
+		}
+	}
+
+	delete [] start;
+	delete [] order;
+	delete [] tile;
+	delete [] fx;
+	delete [] fy;
+	delete [] z;
+	delete [] fom;
+	return(err);
+}
+
+/**************  write_gpf  ************************
+*                                                  *
+*  Writes the GPF with the leveled points as Z     *
+*  control at the DEM height (and Z sigma, unless  *
+*  z_sigma is "-"); other lines are copied as read *
+*                                                  *
+****************************************************/
+int write_gpf(char *file, gpf_points *gpf, char *z_sigma)
+{
+	FILE *fp;
+	char id[FILELEN], sx[FILELEN], sy[FILELEN];
+	char ty[FILELEN], tx[FILELEN];
+	int i, k;
+
+	fp = fopen(file, "w");
+	if (fp == NULL) {
+		printf("unable to open output gpf file: %s\n", file);
+		return(-1);
+	}
+	for (k = 0; k < 3; k++)
+		fprintf(fp, "%s\n", gpf->header[k]);
+
+	for (i = 0; i < gpf->n; i++) {
+		char **line = gpf->line + 5 * (size_t) i;
+		if (gpf->result[i] != LEVEL_LEVELED) {
+			for (k = 0; k < 5; k++)
+				fprintf(fp, "%s\n", line[k]);
+			continue;
+		}
+		// keep the X/Y text as it was, so only the height changes
+		sscanf(line[0], "%511s", id);
+		sscanf(line[1], "%511s %511s", ty, tx);
+		fprintf(fp, "%s %d %d\n", id, gpf->stat[i], GPF_Z_CONTROL);
+		fprintf(fp, "%s %s %.6f\n", ty, tx, gpf->dem_z[i]);
+		if (strcmp(z_sigma, "-") != 0 &&
+		    sscanf(line[2], "%511s %511s", sx, sy) == 2)
+			fprintf(fp, "%s %s %s\n", sx, sy, z_sigma);
+		else
+			fprintf(fp, "%s\n", line[2]);
+		fprintf(fp, "%s\n", line[3]);
+		fprintf(fp, "%s\n", line[4]);
+	}
+
+	if (fclose(fp) != 0) {
+		printf("error writing output gpf file: %s\n", file);
+		return(-1);
+	}
+	return(0);
+}
+
+/**************  write_level_report  ***************
+*                                                  *
+*  Writes the DEM coverage of the tie points and   *
+*  the height changes to a JSON report             *
+*                                                  *
+****************************************************/
+int write_level_report(char *report, char *gpf_file, char *dem,
+                       gpf_points *gpf)
+{
+	unsigned long long count[4] = {0, 0, 0, 0};
+	double d, sum = 0.0, sumsq = 0.0, dmin = 0.0, dmax = 0.0;
+	double mean, rms;
+	int i, ties;
+	FILE *fp;
+
+	for (i = 0; i < gpf->n; i++) {
+		count[gpf->result[i]]++;
+		if (gpf->result[i] != LEVEL_LEVELED)
+			continue;
+		d = gpf->dem_z[i] - gpf->z[i];
+		if (count[LEVEL_LEVELED] == 1 || d < dmin) dmin = d;
+		if (count[LEVEL_LEVELED] == 1 || d > dmax) dmax = d;
+		sum += d;
+		sumsq += d * d;
+	}
+	ties = gpf->n - (int) count[LEVEL_SKIPPED];
+
+	fp = fopen(report, "w");
+	if (fp == NULL) {
+		printf("\ncan't open the leveling report: %s!\n", report);
+		return(-1);
+	}
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"gpf\": \"%s\",\n", gpf_file);
+	fprintf(fp, "  \"dem\": \"%s\",\n", dem);
+	fprintf(fp, "  \"points\": %d,\n", gpf->n);
+	fprintf(fp, "  \"active_tie_points\": %d,\n", ties);
+	fprintf(fp, "  \"on_dem\": %llu,\n", count[LEVEL_LEVELED] + count[LEVEL_FOM]);
+	fprintf(fp, "  \"off_dem\": %llu,\n", count[LEVEL_OFF_DEM]);
+	fprintf(fp, "  \"rejected_fom\": %llu,\n", count[LEVEL_FOM]);
+	fprintf(fp, "  \"leveled\": %llu,\n", count[LEVEL_LEVELED]);
+	fprintf(fp, "  \"coverage\": %.6f,\n",
+	        (ties > 0) ? (double) count[LEVEL_LEVELED] / ties : 0.0);
+	if (count[LEVEL_LEVELED] > 0) {
+		mean = sum / count[LEVEL_LEVELED];
+		rms = sqrt(sumsq / count[LEVEL_LEVELED]);
+		fprintf(fp, "  \"dz_min\": %.6f,\n", dmin);
+		fprintf(fp, "  \"dz_max\": %.6f,\n", dmax);
+		fprintf(fp, "  \"dz_mean\": %.6f,\n", mean);
+		fprintf(fp, "  \"dz_rms\": %.6f\n", rms);
+	}
+	else {
+		fprintf(fp, "  \"dz_min\": null,\n");
+		fprintf(fp, "  \"dz_max\": null,\n");
+		fprintf(fp, "  \"dz_mean\": null,\n");
+		fprintf(fp, "  \"dz_rms\": null\n");
+	}
+	fprintf(fp, "}\n");
+	if (fclose(fp) != 0) {
+		printf("\nerror writing the leveling report: %s!\n", report);
+		return(-1);
+	}
+
+	cout << ties << " active tie points: " << count[LEVEL_LEVELED]
+	     << " leveled, " << count[LEVEL_FOM] << " rejected by FOM, "
+	     << count[LEVEL_OFF_DEM] << " off the DEM (" << report << ")\n";
+	return(0);
+}
@@ -11,8 +11,23 @@
 //       was created by ISIS3 program create_pushbroom_keywords, on a
 //       platform running ISIS3.
 //
+//       With the -list option, a list of image/keyword file pairs is
+//       imported into the project in a single run.  The project file and
+//       DBDIR are read once, and the frame imports and generic pushbroom
+//       support files for the images are generated, one image at a time
+//       unless max_jobs is given.  (Running several start_socet frame
+//       imports into one project at once has not been shown to be safe;
+//       max_jobs > 1 is at your own risk.)  Each line of the list file
+//       holds one pair:
+//
+//           fullpath/<image>.raw|tif  fullpath/<image>_keywords.lis
+//
+//       Blank lines and lines starting with # are ignored.
+//
 //_Exec
 //       start_socet -single import_pushbroom <project> <fullpath/image>.raw <fullpath/keywords>.lis
+//  or
+//       start_socet -single import_pushbroom <project> -list <fullpath/import_list>.lis [max_jobs]
 //
 //_Hist  Oct 21 2008 Elpitha H-Kraus, USGS, Flagstaff Original Version
 //       Nov 18 2008 EHK - removed some debug statements
@@ -21,6 +36,19 @@
 //                         images are not updated, so we must delete them first
 //                         to insure they correspond to the full res image
 //       Feb 08 2012 EHK - modified to import 16-bit tiffs also
+//       Oct 18 2026 AG - added -list option to import many images in one
+//                        run, with the frame imports and support file
+//                        generation run in parallel.  Temporary settings
+//                        files are now named per image
+//                        (xxtempframe_<image>.set) so concurrent imports do
+//                        not overwrite each other.
+//       Oct 19 2026 AG - import threads no longer exit() on an error; the
+//                        error is flagged, the running imports finish, and
+//                        import_pushbroom then fails from the main thread.
+//       Oct 19 2026 AG - max_jobs defaults to 1: concurrent start_socet
+//                        frame imports into one project have not been
+//                        tested.  read_import_list checks its allocations
+//                        and returns -1 on any error rather than exiting.
 //
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -30,80 +58,90 @@
 #include <util/init_socet_app.h>
 #include <key/handle_key.h>
 
-/* Define internal functions */
-int parse_keywords(char *file, char keyword[], char *value);
-void create_pushbroom_sup (char *frmSup, char *keywordFile, double gp_origin_z, char *pushSup);
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 #define FILELEN 512
 #define LINELENGTH 200
+#define MAX_IMPORT_JOBS 16     // upper limit on concurrent imports
+
+// Per-image import parameters and file names
+struct import_job {
+  char  inputImg[FILELEN];      // raw|tif image to import
+  char  keywordFile[FILELEN];   // pushbroom keywords list of inputImg
+  char  inputImg_path[FILELEN]; // Path to inputimage
+  char  inputImg_type[4];       // flag indicating a raw 8-bit or 16-bit tiff
+  char  img_name[FILELEN];      // HiRISE image name (w/o extensions)
+  char  frmSettings[FILELEN];   // SOCET settings file for batch frame import
+  char  minSettings[FILELEN];   // SOCET settings file for tif minification
+  char  frmSup[FILELEN];        // temporary framing camera support file
+  char  pushSup[FILELEN];       // generic pushbroom support file
+};
+
+// Settings shared by all images imported into the project
+struct import_context {
+  char  projectFile[FILELEN];   // SS project w/.prj ext
+  char  camFile[FILELEN];       // Camera file needed from frame import
+  int   unix_os;                // flag indicating platform we are on
+  double gp_origin_z;           // project's ground point origin height, m
+  struct import_job *jobs;      // images to import
+  int   njobs;                  // number of images to import
+  volatile long next_job;       // index of next job to be run by a worker
+  volatile long err;            // set by a job that failed; no more start
+};
+
+/* Define internal functions */
+int parse_keywords(char *file, char keyword[], char *value);
+int create_pushbroom_sup (char *frmSup, char *keywordFile, double gp_origin_z, char *pushSup);
+int read_import_list (char *listFile, struct import_job **jobs);
+void prepare_import_job (struct import_job *job, img_proj_struct *project,
+                         struct import_context *ctx);
+int run_import_job (struct import_job *job, struct import_context *ctx);
+void run_import_jobs (struct import_context *ctx, int max_jobs);
 
 int
 main(int argc, char *argv[])
 {
 
   // Input arguments
-  char     inputImg[FILELEN];        // Input linescanner/pushbroom *raw*
-                                   // image processed in ISIS and converted
-                                   // to 8-bit.  Images are expected to
-                                   // have padding such that the boresight
-                                   // is at the center sample
-
-  char     keywordFile[FILELEN];   // Input file of import parameters and
-                                   // pushbroom sensor keyword values
-                                   // associated with the raw input image.
-                                   // This keywordFile was created by
-                                   // get_pushbroom_keywords on a
-                                   // machine/platform running ISIS
-
   char  projectName[FILELEN];      // SS project w/o path or .prj ext
-  char  projectFile[FILELEN];      // SS project w/.prj ext
-
-  // Output Support files
-  char     frmSup[FILELEN];   // temporary framing camera support file
-  char     pushSup[FILELEN];  // generic pushbroom support file
-
-  // settingsfile keywords
-  int      nl;                 // Number of image lines
-  int      ns;                 // Number of image samples
-  double   sizex, sizey;       // Image dimensions in x/y, mm
-  char     camPath[FILELEN];  // Path to internal databases CAM directory
-  char     camFile[FILELEN];  // Camera file needed from frame import
+  char  listFile[FILELEN];         // list of image/keyword file pairs
 
   // project file keywords
   img_proj_struct project;  //SS project structure
 
   // Environment variables
   char  DBDIR_path[FILELEN];   // decoded path to SS internal_dbs directory
-  int   unix_os, windows_os;         // flags indicating platform we are on
+  int   windows_os;            // flag indicating platform we are on
+  char  camPath[FILELEN];      // Path to internal databases CAM directory
+
+  // import jobs
+  struct import_context ctx;   // settings shared by all images
+  struct import_job *jobs;     // images to import
+  int   njobs;                 // number of images to import
+  int   max_jobs;              // maximum number of concurrent imports
+  int   list_mode;             // flag indicating -list option was given
 
-  // temporary files and names
+  // temporary variables
   int   prjReadErr;            // Error flag for reading project file
   int   fileExistErr;          // Error flag checking for input files
-  char  inputImg_path[FILELEN];  // Path to inputimage
-  char  inputImg_type[4];  // flag indicating a raw 8-bit or 16-bit tiff
-  char  img_name[FILELEN];     // HiRISE image name (w/o extensions)
-  char  socet_img[FILELEN];    // Default SOCET Set image name
-  char  img_dir[FILELEN];      // SOCET image directory with full path
-  char  settingsfile[FILELEN]; // SOCET settings file for batch import
-  FILE  *setfp;                // file pointer to settings file
-
-  // System Call variables
-  char  msg[FILELEN];
-  int   scan_value;
-  char  value[200];
-  int   stat;
-  int   count;
+  int   i;
 
   /////////////////////////////////////////////////////////////////////////////
   // Check number of command line args and issue help if needed
   // Otherwise initiate the socet set application
   /////////////////////////////////////////////////////////////////////////////
 
-  if (argc != 4) {
+  list_mode = (argc >= 4 && strcmp(argv[2],"-list") == 0);
+
+  if ((!list_mode && argc != 4) || (list_mode && argc > 5)) {
     //cerr << "\nRun " << argv[0] << " as follows:\n";
     //cerr << "start_socet -single " << argv[0] << " project fullpath/image.raw fullpath/pushbroom_keywords.lis\n";
     cerr << "\nRun import_pushbroom as follows:\n";
     cerr << "start_socet -single import_pushbroom <project> fullpath/<image>.raw|tif fullpath/<pushbroom_keywords.lis>\n";
+    cerr << "  or\n";
+    cerr << "start_socet -single import_pushbroom <project> -list fullpath/<import_list.lis> [max_jobs]\n";
     cerr << "\nwhere:\n";
     cerr << "project = SOCET SET project name to import images under\n";
     cerr << "          (path and extension is not required)\n";
@@ -112,6 +150,12 @@ main(int argc, char *argv[])
     cerr << "fullpath/pushbroom_keywords.lis = output file of get_pushbroom_keywords\n";
     cerr << "                                  associated with input image.\n";
     cerr << "                                  (Path to keywords file is required)\n";
+    cerr << "fullpath/import_list.lis = list of images to import, one\n";
+    cerr << "                           \"fullpath/image.raw|tif fullpath/pushbroom_keywords.lis\"\n";
+    cerr << "                           pair per line\n";
+    cerr << "max_jobs = maximum number of images imported at once\n";
+    cerr << "           (default 1; 0 is the number of processors, up to " << MAX_IMPORT_JOBS << ".\n";
+    cerr << "           Concurrent imports into one project are untested)\n";
     return -1;
   }
 
@@ -123,27 +167,48 @@ main(int argc, char *argv[])
   //Get input arguments
   /////////////////////////////////////////////////////////////////////////////
 
-  strcpy (projectFile,argv[1]);
-  strcpy (inputImg,argv[2]);
-  strcpy (keywordFile,argv[3]);
+  strcpy (ctx.projectFile,argv[1]);
+
+  if (list_mode) {
+    strcpy (listFile,argv[3]);
+    njobs = read_import_list (listFile, &jobs);
+    if (njobs < 0)
+      exit (1);
+    if (njobs == 0) {
+      cerr << "\nNo images listed in import list " << listFile << endl;
+      exit (1);
+    }
+    max_jobs = (argc == 5) ? atoi(argv[4]) : 1;
+  }
+  else {
+    njobs = 1;
+    jobs = (struct import_job *) calloc (1, sizeof(struct import_job));
+    if (jobs == NULL) {
+      cerr << "\nOut of memory\n";
+      exit (1);
+    }
+    strcpy (jobs[0].inputImg,argv[2]);
+    strcpy (jobs[0].keywordFile,argv[3]);
+    max_jobs = 1;
+  }
 
   /////////////////////////////////////////////////////////////////////////////
   // Populate the project structure - with error checking
   /////////////////////////////////////////////////////////////////////////////
 
   // Make sure project name contains no path, but has .prj extension
-  strcpy(projectName,ReturnFileName(projectFile));
+  strcpy(projectName,ReturnFileName(ctx.projectFile));
   StripFileExt(projectName);
-  strcpy(projectFile,concat(projectName, ".prj"));
+  strcpy(ctx.projectFile,concat(projectName, ".prj"));
 
   // Load project structure
-  prjReadErr = project.read(projectFile);
+  prjReadErr = project.read(ctx.projectFile);
   switch (prjReadErr) {
     case 0:
       setCurrentProj(project);
       break;
     case -1:
-      cerr << "Failed to open project file " << projectFile << endl;
+      cerr << "Failed to open project file " << ctx.projectFile << endl;
       exit (1);
       break;
     case -2:
@@ -162,14 +227,16 @@ main(int argc, char *argv[])
 
   fileExistErr = 0;
 
-  if (!file_exists(inputImg)) {
-    cerr << "\nInput image " << inputImg << " does not exist!\n";
-    fileExistErr = 1;
-  }
+  for (i=0; i<njobs; i++) {
+    if (!file_exists(jobs[i].inputImg)) {
+      cerr << "\nInput image " << jobs[i].inputImg << " does not exist!\n";
+      fileExistErr = 1;
+    }
 
-  if (!file_exists(keywordFile)) {
-    cerr << "\nInput keyword file " << keywordFile << " does not exist!\n";
-    fileExistErr = 1;
+    if (!file_exists(jobs[i].keywordFile)) {
+      cerr << "\nInput keyword file " << jobs[i].keywordFile << " does not exist!\n";
+      fileExistErr = 1;
+    }
   }
 
   if (fileExistErr)
@@ -180,7 +247,7 @@ main(int argc, char *argv[])
   // (Windows or Unix)
   /////////////////////////////////////////////////////////////////////////////
 
-  unix_os = 0;
+  ctx.unix_os = 0;
   windows_os = 0;
   str_decode_env_path ("$DBDIR",DBDIR_path); // This works for both unix and
                                              // windows?  At the prompt, the
@@ -191,58 +258,196 @@ main(int argc, char *argv[])
     if (strstr(DBDIR_path,":\\")!=0) // look for :\ in path for windows
       windows_os = 1;
     else
-      unix_os=1;
+      ctx.unix_os=1;
   else {
    cerr << "Unable to decode DBDIR environment variable...is it missing?" << endl;
    exit (1);
   }
 
+  // Build path+file to the default.cam file for framing camera import
+  add_path_if_none (DBDIR_path, "CAM", camPath);
+  build_file_name (ctx.camFile, camPath,"default",".cam");
+
+  ctx.gp_origin_z = project.gp_origin.z;
+  ctx.jobs = jobs;
+  ctx.njobs = njobs;
+  ctx.next_job = 0;
+  ctx.err = 0;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Generate the SOCET SET file names and settings files of each image.
+  // This step also runs usgs_delete_image on images being re-imported, so it
+  // is done one image at a time before any imports are started.
+  /////////////////////////////////////////////////////////////////////////////
+
+  for (i=0; i<njobs; i++)
+    prepare_import_job (&jobs[i], &project, &ctx);
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Import the images and create their generic pushbroom support files
+  /////////////////////////////////////////////////////////////////////////////
+
+  run_import_jobs (&ctx, max_jobs);
+
+  free (jobs);
+
+  if (ctx.err) {
+    cerr << "\nImport failed, see the messages above\n";
+    exit (1);
+  }
+
+  if (list_mode)
+    cout << "\nImport of " << njobs << " images complete\n";
+  else
+    cout << "\nImport complete\n";
+
+} // end of import_pushbroom
+
+/**************  read_import_list   ****************
+*                                                  *
+*  This routine reads the image/keyword file pairs *
+*  of the -list option.  Returns the number of     *
+*  pairs read, or -1 (with *jobs freed) if the     *
+*  list can't be read or memory runs out.          *
+*                                                  *
+****************************************************/
+int
+read_import_list (char *listFile, struct import_job **jobs)
+{
+  FILE  *fp;
+  char  line[2*FILELEN];
+  char  img[FILELEN], key[FILELEN];
+  int   njobs, maxjobs;
+  struct import_job *more;
+
+  *jobs = NULL;
+  fp = fopen(listFile,"r");
+  if (fp == NULL) {
+    printf("\nUnable to open import list %s\n",listFile);
+    return(-1);
+  }
+
+  njobs = 0;
+  maxjobs = 16;
+  *jobs = (struct import_job *) calloc (maxjobs, sizeof(struct import_job));
+  if (*jobs == NULL) {
+    printf("\nOut of memory reading import list %s\n",listFile);
+    fclose(fp);
+    return(-1);
+  }
+
+  while (fgets(line,2*FILELEN,fp) != NULL) {
+    if (sscanf(line,"%s",img) != 1 || img[0] == '#')
+      continue;
+
+    if (sscanf(line,"%s %s",img,key) != 2) {
+      printf("\nImport list line has no keyword file: %s\n",line);
+      fclose(fp);
+      free(*jobs);
+      *jobs = NULL;
+      return(-1);
+    }
+
+    if (njobs == maxjobs) {
+      more = (struct import_job *) realloc (*jobs,
+                                   2 * maxjobs * sizeof(struct import_job));
+      if (more == NULL) {
+        printf("\nOut of memory reading import list %s\n",listFile);
+        fclose(fp);
+        free(*jobs);
+        *jobs = NULL;
+        return(-1);
+      }
+      *jobs = more;
+      maxjobs *= 2;
+    }
+
+    memset(&(*jobs)[njobs],0,sizeof(struct import_job));
+    strcpy((*jobs)[njobs].inputImg,img);
+    strcpy((*jobs)[njobs].keywordFile,key);
+    njobs++;
+  }
+
+  fclose(fp);
+  return(njobs);
+
+} // end of read_import_list
+
+/**************  prepare_import_job   **************
+*                                                  *
+*  This routine generates the file names of one    *
+*  image, deletes a previous import of the image,  *
+*  and writes its frame import (and minification)  *
+*  settings files                                  *
+*                                                  *
+****************************************************/
+void
+prepare_import_job (
+   struct import_job *job,      // Image to import
+   img_proj_struct *project,    // SS project structure
+   struct import_context *ctx)  // Settings shared by all images
+{
+  // settingsfile keywords
+  int      nl;                 // Number of image lines
+  int      ns;                 // Number of image samples
+  double   sizex, sizey;       // Image dimensions in x/y, mm
+  char     socet_img[FILELEN]; // Default SOCET Set image name
+  char     tmpname[FILELEN];   // temporary file name w/o path
+  FILE     *setfp;             // file pointer to settings file
+
+  // System Call variables
+  char  msg[FILELEN];
+  int   scan_value;
+  char  value[200];
+  int   stat;
+
   /////////////////////////////////////////////////////////////////////////////
   // Determine if input image is 8-bit raw or 16-bit tif
   /////////////////////////////////////////////////////////////////////////////
   
-  if (strstr(inputImg,"tif")!=0) 
-    strcpy(inputImg_type,"tif");
+  if (strstr(job->inputImg,"tif")!=0) 
+    strcpy(job->inputImg_type,"tif");
   else
-    strcpy( inputImg_type,"raw");
+    strcpy(job->inputImg_type,"raw");
 
   /////////////////////////////////////////////////////////////////////////////
   // Generate SOCET SET and temporary filenames
   /////////////////////////////////////////////////////////////////////////////
 
   // extract HiRISE image name from input inputImg name
-  ReturnPathAndFile(inputImg,inputImg_path,img_name);
-  StripFileExts (img_name);
+  ReturnPathAndFile(job->inputImg,job->inputImg_path,job->img_name);
+  StripFileExts (job->img_name);
 
   // if local directory is defaulted to for location of inputImg, make sure
   // the syntax is correct
 
-  if (strlen(inputImg_path)==0)
-    if (unix_os)
-      strcpy(inputImg_path,"./");
+  if (strlen(job->inputImg_path)==0)
+    if (ctx->unix_os)
+      strcpy(job->inputImg_path,"./");
     else
-      strcpy(inputImg_path,".\\");
+      strcpy(job->inputImg_path,".\\");
 
-  // Create a temporary SOCET Set framing import settings file name
-  build_file_name(settingsfile, inputImg_path, "xxtempframe", ".set");
+  // Create temporary SOCET Set framing import and minification settings
+  // file names.  The image name is included so that images imported at the
+  // same time do not share a settings file
+  sprintf(tmpname,"xxtempframe_%s",job->img_name);
+  build_file_name(job->frmSettings, job->inputImg_path, tmpname, ".set");
+  sprintf(tmpname,"xxtempminify_%s",job->img_name);
+  build_file_name(job->minSettings, job->inputImg_path, tmpname, ".set");
 
   // Create HiRISE support file name, with SOCET Set data path
-  build_file_name(pushSup, project.project_data_path, img_name, ".sup");
+  build_file_name(job->pushSup, project->project_data_path, job->img_name, ".sup");
 
   // Create temporary framing camera support file name, with SOCET Set data path
-  build_file_name(frmSup, project.project_data_path, img_name, ".sup_frame");
+  build_file_name(job->frmSup, project->project_data_path, job->img_name, ".sup_frame");
 
-  // Build path+file to the default.cam file for framing camera import
-  add_path_if_none (DBDIR_path, "CAM", camPath);
-  build_file_name (camFile, camPath,"default",".cam");
-    
   /////////////////////////////////////////////////////////////////////////////
   // If pushSup already exists, we are re-importing the images, so delete all
   // image files first by running usgs_delete_image
   /////////////////////////////////////////////////////////////////////////////
 
-  if (file_exists(pushSup)) {
-    sprintf(msg,"start_socet -single usgs_delete_image %s\n",pushSup);
+  if (file_exists(job->pushSup)) {
+    sprintf(msg,"start_socet -single usgs_delete_image %s\n",job->pushSup);
     printf("%s\n",msg);
     scan_value = system(msg);
   }
@@ -252,10 +457,10 @@ main(int argc, char *argv[])
   /////////////////////////////////////////////////////////////////////////////
 
   // Get image size from Keyword list (PVL) file
-  stat = parse_keywords(keywordFile, "TOTAL_LINES", value);
+  stat = parse_keywords(job->keywordFile, "TOTAL_LINES", value);
   nl = atoi(value);
 
-  stat = parse_keywords(keywordFile, "TOTAL_SAMPLES", value);
+  stat = parse_keywords(job->keywordFile, "TOTAL_SAMPLES", value);
   ns = atoi(value);
 
   // Set images size to nl and ns for frame import
@@ -265,38 +470,38 @@ main(int argc, char *argv[])
 
   // Generate the default SOCET Set *.img|tif file name as a 
   // keyword value in the settings file
-  if (strcmp(inputImg_type,"tif")==0) 
-    strcpy (socet_img,concat(img_name,".tif"));
+  if (strcmp(job->inputImg_type,"tif")==0) 
+    strcpy (socet_img,concat(job->img_name,".tif"));
   else
-    strcpy (socet_img,concat(img_name,".img"));
+    strcpy (socet_img,concat(job->img_name,".img"));
 
   /////////////////////////////////////////////////////////////////////////////
   // Populate the temporary framing camera settings file
   /////////////////////////////////////////////////////////////////////////////
 
-  setfp = fopen (settingsfile,"w");
+  setfp = fopen (job->frmSettings,"w");
   if (setfp == NULL) {
-    printf ("Unable to open frame import settings file %s\n",settingsfile);
+    printf ("Unable to open frame import settings file %s\n",job->frmSettings);
     exit (1);
   }
 
   fprintf (setfp,"setting_file                  1.1\n");
-  fprintf (setfp,"multi_frame.project                 %s\n",projectFile);
-  fprintf (setfp,"multi_frame.cam_calib_filename      %s\n",camFile);
+  fprintf (setfp,"multi_frame.project                 %s\n",ctx->projectFile);
+  fprintf (setfp,"multi_frame.cam_calib_filename      %s\n",ctx->camFile);
   fprintf (setfp,"multi_frame.create_files            IMAGE_AND_SUPPORT\n");
   fprintf (setfp,"multi_frame.atmos_ref               0\n");
-  if (strcmp(inputImg_type,"tif")==0)
+  if (strcmp(job->inputImg_type,"tif")==0)
     fprintf (setfp,"multi_frame.auto_min                NO\n");
   else
    fprintf (setfp,"multi_frame.auto_min                YES\n");
   fprintf (setfp,"multi_frame.digital_cam             YES\n");
-  fprintf (setfp,"multi_frame.input_image_filename    %s\n",inputImg);
-  if (strcmp(inputImg_type,"tif")==0)
+  fprintf (setfp,"multi_frame.input_image_filename    %s\n",job->inputImg);
+  if (strcmp(job->inputImg_type,"tif")==0)
     fprintf (setfp,"multi_frame.output_format           img_type_tiff_tiled\n");
   else
     fprintf (setfp,"multi_frame.output_format           img_type_vitec\n");
   fprintf (setfp,"multi_frame.output_name             %s\n",socet_img);
-  fprintf (setfp,"multi_frame.output_location         %s\n",project.project_image_location);
+  fprintf (setfp,"multi_frame.output_location         %s\n",project->project_image_location);
   fprintf (setfp,"multi_frame.cam_loc_ang_sys         OPK\n");
   fprintf (setfp,"multi_frame.cam_loc_ang_units       UNIT_DEGREES\n");
   fprintf (setfp,"multi_frame.cam_loc_xy_units        UNIT_DEGREES\n");
@@ -309,47 +514,69 @@ main(int argc, char *argv[])
   fclose (setfp);
 
   /////////////////////////////////////////////////////////////////////////////
-  // Import image to Socet Set as a framing camera
-  /////////////////////////////////////////////////////////////////////////////
-
-  sprintf(msg,"start_socet -single multi_frame -a frame -batch -s %s\n",
-          settingsfile);
-  printf("%s\n",msg);
-  scan_value = system(msg);
-  
-  /////////////////////////////////////////////////////////////////////////////
-  // If this is a tif image, minify it
+  // If this is a tif image, populate the minification settings file
   // (Autominification during import results in a single tif image with internal
   // pyramids - an undesirable feature for gdal....)
   /////////////////////////////////////////////////////////////////////////////
 
-   if(strcmp(inputImg_type,"tif")==0) {
-    //file_remove(settingsfile);  // delete xxtempframe.set
-   
-    // Create a temporary SOCET Set minification settings file name
-    build_file_name(settingsfile, inputImg_path, "xxtempminify", ".set");
-  
-    setfp = fopen (settingsfile,"w");
+  if(strcmp(job->inputImg_type,"tif")==0) {
+    setfp = fopen (job->minSettings,"w");
     if (setfp == NULL) {
-      printf ("Unable to open frame import settings file %s\n",settingsfile);
+      printf ("Unable to open frame import settings file %s\n",job->minSettings);
       exit (1);
     }
 
     fprintf (setfp,"setting_file                     1.1\n");
-    fprintf (setfp,"min.project                     %s\n",projectFile);
-    fprintf (setfp,"min.resampling_method      BILINEAR\n",pushSup);
-    fprintf (setfp,"min.output_location          %s\n",project.project_image_location);
-    fprintf (setfp,"min.location_method         SINGLE_LOCATION\n",pushSup);
-    fprintf (setfp,"min.create_single_file        NO\n",pushSup);
-    fprintf (setfp,"min.single_file_format        img_type_tiff_tiled\n",pushSup);
-    fprintf (setfp,"min.input_sup                  %s\n",pushSup);
-    fprintf (setfp,"min.condor_selected          0\n",pushSup);
-    fprintf (setfp,"min.condor_machine          Any Machine\n",pushSup);
+    fprintf (setfp,"min.project                     %s\n",ctx->projectFile);
+    fprintf (setfp,"min.resampling_method      BILINEAR\n");
+    fprintf (setfp,"min.output_location          %s\n",project->project_image_location);
+    fprintf (setfp,"min.location_method         SINGLE_LOCATION\n");
+    fprintf (setfp,"min.create_single_file        NO\n");
+    fprintf (setfp,"min.single_file_format        img_type_tiff_tiled\n");
+    fprintf (setfp,"min.input_sup                  %s\n",job->pushSup);
+    fprintf (setfp,"min.condor_selected          0\n");
+    fprintf (setfp,"min.condor_machine          Any Machine\n");
     
     fclose (setfp);
-    
+  }
+
+  return;
+
+} // end of prepare_import_job
+
+/**************  run_import_job   ******************
+*                                                  *
+*  This routine imports one image as a framing     *
+*  camera and converts its support file to a       *
+*  generic pushbroom support file.  Returns 0, or  *
+*  -1 if the support file could not be made        *
+*                                                  *
+****************************************************/
+int
+run_import_job (
+   struct import_job *job,      // Image to import
+   struct import_context *ctx)  // Settings shared by all images
+{
+  // System Call variables
+  char  msg[FILELEN];
+  int   scan_value;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Import image to Socet Set as a framing camera
+  /////////////////////////////////////////////////////////////////////////////
+
+  sprintf(msg,"start_socet -single multi_frame -a frame -batch -s %s\n",
+          job->frmSettings);
+  printf("%s\n",msg);
+  scan_value = system(msg);
+  
+  /////////////////////////////////////////////////////////////////////////////
+  // If this is a tif image, minify it
+  /////////////////////////////////////////////////////////////////////////////
+
+  if(strcmp(job->inputImg_type,"tif")==0) {
     sprintf(msg,"start_socet -single minifier -batch -s %s\n",
-            settingsfile);
+            job->minSettings);
     printf("%s\n",msg);
     scan_value = system(msg);
   }
@@ -364,10 +591,10 @@ main(int argc, char *argv[])
   //       tried move, and it worked....
   /////////////////////////////////////////////////////////////////////////////
 
-  if (unix_os)
-    sprintf(msg,"/bin/mv %s %s\n",pushSup,frmSup);
+  if (ctx->unix_os)
+    sprintf(msg,"/bin/mv %s %s\n",job->pushSup,job->frmSup);
   else
-    sprintf(msg,"move %s %s\n",pushSup,frmSup);
+    sprintf(msg,"move %s %s\n",job->pushSup,job->frmSup);
 
   scan_value = system(msg);
 
@@ -376,18 +603,108 @@ main(int argc, char *argv[])
   // keywords with pushbroom keywords in the keywordFile
   /////////////////////////////////////////////////////////////////////////////
 
-  create_pushbroom_sup (frmSup, keywordFile, project.gp_origin.z, pushSup);
+  if (create_pushbroom_sup (job->frmSup, job->keywordFile, ctx->gp_origin_z,
+                            job->pushSup) != 0)
+    return(-1);
 
   /////////////////////////////////////////////////////////////////////////////
   // Delete temporary files
   /////////////////////////////////////////////////////////////////////////////
 
-  //file_remove(settingsfile);
-  file_remove(frmSup);
+  //file_remove(job->frmSettings);
+  file_remove(job->frmSup);
 
-  cout << "\nImport complete\n";
+  printf("\nImported %s\n",job->img_name);
 
-} // end of import_pushbroom
+  return(0);
+
+} // end of run_import_job
+
+/**************  import_worker   *******************
+*                                                  *
+*  Thread routine that runs import jobs until none *
+*  are left or one has failed                      *
+*                                                  *
+****************************************************/
+#ifdef _WIN32
+DWORD WINAPI
+import_worker (LPVOID arg)
+{
+  struct import_context *ctx = (struct import_context *) arg;
+  long  i;
+
+  while (!ctx->err &&
+         (i = InterlockedIncrement(&ctx->next_job) - 1) < ctx->njobs)
+    if (run_import_job (&ctx->jobs[i], ctx) != 0)
+      ctx->err = 1;
+
+  return 0;
+
+} // end of import_worker
+#endif
+
+/**************  run_import_jobs   *****************
+*                                                  *
+*  This routine runs all import jobs, max_jobs at  *
+*  a time.  If max_jobs is 0, the number of        *
+*  processors is used.  On platforms without       *
+*  thread support the jobs are run one at a time.  *
+*  A failed job sets ctx->err, and no more jobs    *
+*  are started once the running ones finish.       *
+*                                                  *
+****************************************************/
+void
+run_import_jobs (struct import_context *ctx, int max_jobs)
+{
+  int   i;
+
+#ifdef _WIN32
+  HANDLE  threads[MAX_IMPORT_JOBS];
+  SYSTEM_INFO sysinfo;
+  int   nthreads;
+
+  if (max_jobs <= 0) {
+    GetSystemInfo(&sysinfo);
+    max_jobs = sysinfo.dwNumberOfProcessors;
+  }
+
+  nthreads = max_jobs;
+  if (nthreads > MAX_IMPORT_JOBS)
+    nthreads = MAX_IMPORT_JOBS;
+  if (nthreads > ctx->njobs)
+    nthreads = ctx->njobs;
+
+  if (nthreads > 1) {
+    printf("\nImporting %d images, %d at a time\n",ctx->njobs,nthreads);
+
+    // the threads started take the jobs of any that couldn't be
+    for (i=0; i<nthreads; i++) {
+      threads[i] = CreateThread(NULL, 0, import_worker, ctx, 0, NULL);
+      if (threads[i] == NULL) {
+        printf ("Unable to start import thread\n");
+        break;
+      }
+    }
+    nthreads = i;
+
+    if (nthreads > 0) {
+      WaitForMultipleObjects(nthreads, threads, TRUE, INFINITE);
+
+      for (i=0; i<nthreads; i++)
+        CloseHandle(threads[i]);
+
+      return;
+    }
+  }
+#endif
+
+  for (i=0; i<ctx->njobs && !ctx->err; i++)
+    if (run_import_job (&ctx->jobs[i], ctx) != 0)
+      ctx->err = 1;
+
+  return;
+
+} // end of run_import_jobs
 
 /**************  parse_keywords   ******************
 *                                                  *
@@ -429,7 +746,7 @@ parse_keywords(char *file, char keyword[], char *value)
 
 } // end of parse_keywords
 
-void
+int
 create_pushbroom_sup (
    char *frmSup,       // Input framing camera support file
    char *keywordFile,  // Input pushbroom keywords list
@@ -450,9 +767,12 @@ create_pushbroom_sup (
 //
 //_Desc	This subroutine takes as input a framing camera support file and a
 //       corresponding pushbroom keyword file, and merges the content of the
-//       two files to create a SS Generic Pushbroom support file
+//       two files to create a SS Generic Pushbroom support file.
+//       Returns 0, or -1 if a file can't be opened (it is run by the
+//       import threads, so it doesn't exit)
 //
 //_Hist	Oct 23 2008 Elpitha H. Kraus, USGS, Flagstaff Original Version
+//      Oct 19 2026 - return -1 rather than exit on an open failure
 //
 //_End
 //
@@ -483,14 +803,14 @@ create_pushbroom_sup (
   frmfp = fopen (frmSup,"r");
   if (frmfp == NULL) {
     printf ("Unable to open input framing camera support file: %s\n",frmSup);
-    exit (1);
+    return(-1);
   }
 
   keyfp = fopen (keywordFile,"r");
   if (keyfp == NULL) {
     printf ("Unable to open input pushbroom keyword file: %s\n",keywordFile);
     fclose(frmfp);
-    exit (1);
+    return(-1);
   }
 
   pushfp = fopen (pushSup,"w");
@@ -498,7 +818,7 @@ create_pushbroom_sup (
     printf ("Unable to open output generic pushbroom support file: %s\n",pushSup);
     fclose(frmfp);
     fclose(keyfp);
-    exit (1);
+    return(-1);
   }
 
   /////////////////////////////////////////////////////////////////////////////
@@ -618,5 +938,5 @@ create_pushbroom_sup (
   fclose (keyfp);
   fclose (pushfp);
 
-  return;
+  return(0);
 }
@@ -166,6 +166,18 @@
 //      Oct 17 2011 EHK  Added SS_ prefix to output *.raw files to avoid confusion with
 //                        the 'standard' ISIS cubes having the same core name, but different
 //                         number of lines and samples
+//      Oct 18 2026      With layout_flag set, build 2x, 4x, 8x... overview raw
+//                       files (mean of the non-zero pixels of each 2x2 block)
+//                       while writing the raw ortho, for the script to import
+//                       as overview cubes and reduce the layout cube from.
+//      Oct 18 2026      Fixed the raw file loops deleting the advanced
+//                       buffer pointers (and reloading band 2 onwards past
+//                       the end of the buffer).
+//      Oct 18 2026      layout_flag has room for its terminator.
+//      Oct 18 2026      main returns int so the program builds with g++
+//                       against ../socet_native (see makefile_ortho2isis3.linux).
+//      Oct 19 2026      OVR_ORTHO and the overview routines come from
+//                       ../export_subs/export_subroutines.h.
 //
 //_End
 //
@@ -186,19 +198,11 @@
 #include <util/init_socet_app.h>
 #include <ground_point.h>
 
+#include "../export_subs/export_subroutines.h"
+
 #define FILELEN 512
 
-// prototypes
-extern int parse_label(char *file, char *keyword, char *value);
-extern int getTargetInfo (char *ellipsoid, char *isisTargName, char *isisTargDef,
-                           char *ographicPosLonDir, char *ocentricPosLonDir);
-extern int writeToScript(char *isis_script, char *command);
-extern int generate_ss2isis_script (char *isis_script, char *prj,
-            char *productType, char *byteOrder, char *outcub_name,
-            char *layout_flag, int lines, int samples, double x_realspacing,
-            double y_realspacing, double ulcenter_Xlon, double ulcenter_Ylat);
-
-void main(int argc,char *argv[])
+int main(int argc,char *argv[])
 {
 
 /*        declaration            */
@@ -222,6 +226,11 @@ void main(int argc,char *argv[])
    double y_realspacing;
    double ulcenter_Xlon, ulcenter_Ylat;
    FILE *out_img;
+   overview_pyramid *ovr = NULL;
+   int ovr_type = OVR_ORTHO;
+   char *ovr_file;
+   void *ovr_row;
+   int r;
 
    // Project File Variables
    img_proj_struct project;        //SS project structure
@@ -250,7 +259,7 @@ void main(int argc,char *argv[])
    char outcub_name[FILELEN];
    char SS_outcub[FILELEN];
    char note[256];
-   char layout_flag[1];
+   char layout_flag[2];
    char layout_cub[FILELEN];
 
    // temporary files and names
@@ -435,6 +444,15 @@ void main(int argc,char *argv[])
    tenth_lines = lines / (num_sec+1);
    rest_lines = lines - num_sec * tenth_lines;
 
+   // With a layout cube requested, build the overview pyramid of the
+   // (first band of the) raw file as it is written
+   if (layout_flag[0]=='y' || layout_flag[0]=='Y') {
+      ovr_file = rawORTHO;
+      ovr = open_overviews(lines, samples, 1, &ovr_type, &ovr_file);
+      if (ovr == NULL)
+         exit(1);
+   }
+
    cout << "Converting ortho image to a raw file...\n";
 
    unsigned char *buf1 = new unsigned char [tenth_lines*samples];
@@ -442,31 +460,45 @@ void main(int argc,char *argv[])
    
    for (sec=0; sec <num_sec; sec++)
    {
-      buf1 = save_buf1;
       for (iband=0; iband < bands; iband++)
       {
+        buf1 = save_buf1;
         img_load_buffer(in_img,sec*tenth_lines,0,tenth_lines,samples,0,
                         buf1,samples,(unsigned char *)"\0");
+        for (r=0; ovr != NULL && iband == 0 && r < tenth_lines; r++) {
+           ovr_row = buf1 + r*samples;
+           if (add_overview_row(ovr, &ovr_row) != 0)
+              exit(1);
+        }
         for (i=0 ; i < tenth_lines*samples ; i++)
            fwrite(buf1++,sizeof(unsigned char),1,out_img);
       }
       cout << "...Conversion " << 10*(sec+1) << "% Done\n";
    }
 
-   delete [] buf1;
+   delete [] save_buf1;
 
    unsigned char *buf2 = new unsigned char [rest_lines*samples];
+   unsigned char *save_buf2 = buf2;
    for (iband=0; iband < bands; iband++)
    {
+     buf2 = save_buf2;
      img_load_buffer(in_img,num_sec*tenth_lines,0,rest_lines,samples,0,
                      buf2,samples,(unsigned char *)"\0");
+     for (r=0; ovr != NULL && iband == 0 && r < rest_lines; r++) {
+        ovr_row = buf2 + r*samples;
+        if (add_overview_row(ovr, &ovr_row) != 0)
+           exit(1);
+     }
      for (i=0 ; i < rest_lines*samples ; i++)
         fwrite(buf2++,sizeof(unsigned char),1,out_img);
    }
-   delete [] buf2;
+   delete [] save_buf2;
 
    img_closefile(in_img);
    fclose(out_img);
+   if (ovr != NULL && close_overviews(ovr) != 0)
+      exit(1);
 
    cout << "...Conversion 100% Done\n";
    
@@ -506,7 +538,10 @@ void main(int argc,char *argv[])
                             x_realspacing,
                             y_realspacing,
                             ulcenter_Xlon,
-                            ulcenter_Ylat);
-                            
+                            ulcenter_Ylat,
+                            0,   // no confidence cube for orthos
+                            0);  // standard ortho cube is made by map2map
+
+   return(0);
 } // END MAIN
 
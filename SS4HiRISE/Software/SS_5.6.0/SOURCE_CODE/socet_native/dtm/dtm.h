@@ -0,0 +1,2 @@
+// SOCET SET DEV_KIT header dtm/dtm.h, native Linux version (see socet_native.h)
+#include <socet_native.h>
@@ -0,0 +1,276 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title DTM_NATIVE native DtmHeader/DtmGrid reader for SOCET grid DTMs
+//
+//_Desc  Reads the .dth header and the elevation and FOM posts of a grid DTM
+//       (see socet_native.h for the layout) through the DEV_KIT DtmHeader
+//       and DtmGrid block-read calls, so dem2isis3 reads DTMs the same way
+//       on Linux as it does through the SOCET runtime.
+//
+//       The layout is checked against socet_native.h and the synthetic
+//       DTMs of bench_exporters only; no SOCET-written DTM and Windows
+//       dem2isis3 export of it were at hand to compare with, so the reader
+//       is experimental: DtmHeader::load refuses every DTM unless
+//       SS_NATIVE_DTM_EXPERIMENTAL=1 is set in the environment.
+//
+//_Hist Oct 18 2026      Orig Version
+//      Oct 19 2026      openDtm rejects a .dtm that is not exactly the size
+//                       the header gives (a longer file is another DTM or
+//                       not a grid), and closes it when out of memory.
+//      Oct 19 2026      Opt-in through SS_NATIVE_DTM_EXPERIMENTAL until
+//                       the layout is checked against a SOCET DTM.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "socet_native.h"
+#include <sys/types.h>
+
+/**************  host_is_msb  **********************
+*                                                  *
+*  1 on a big-endian machine                       *
+*                                                  *
+****************************************************/
+static int host_is_msb()
+{
+   union { int i; unsigned char c[sizeof(int)]; } u;
+
+   u.i = 1;
+   return(u.c[0] == 0);
+}
+
+/**************  native_dtm_enabled  ***************
+*                                                  *
+*  1 if NATIVE_DTM_OPT_IN is set to 1, else tells  *
+*  (once) why DTMs are refused and returns 0       *
+*                                                  *
+****************************************************/
+static int native_dtm_enabled()
+{
+   static int told = 0;
+   const char *opt = getenv(NATIVE_DTM_OPT_IN);
+
+   if (opt != NULL && strcmp(opt, "1") == 0)
+      return(1);
+   if (!told) {
+      printf("\nThe Linux DTM reader is experimental: its .dth/.dtm layout has\n");
+      printf("not been checked against a SOCET SET DTM and a Windows dem2isis3\n");
+      printf("export of it.  Use the Windows build, or set %s=1\n",
+             NATIVE_DTM_OPT_IN);
+      printf("to read the DTM anyway and check the results yourself.\n");
+      told = 1;
+   }
+   return(0);
+}
+
+DtmHeader::DtmHeader(img_proj_struct_ptr proj)
+{
+   format = 0;
+   nx = ny = 0;
+   dx = dy = 0.0;
+   memset(&ll, 0, sizeof(ll));
+   memset(&ur, 0, sizeof(ur));
+   swap = 0;
+}
+
+/**************  DtmHeader::load  *****************
+*                                                  *
+*  Reads <fname>.dth.  Returns 0, or -1 if it      *
+*  can't be read or misses a required keyword, or  *
+*  if the native reader isn't enabled (see         *
+*  native_dtm_enabled)                             *
+*                                                  *
+****************************************************/
+int DtmHeader::load(const char *fname)
+{
+   char dth[NATIVE_PATHLEN];
+   char line[NATIVE_PATHLEN];
+   char key[NATIVE_PATHLEN];
+   char value[NATIVE_PATHLEN];
+   int found = 0;     // bits: format, x posts, y posts, ll, ur
+   FILE *fp;
+
+   format = 0;
+   dx = dy = 0.0;
+   swap = 0;
+
+   if (!native_dtm_enabled()) {
+      nx = ny = 0;
+      return(-1);
+   }
+
+   snprintf(dth, sizeof(dth), "%s.dth", fname);
+   fp = fopen(dth, "r");
+   if (fp == NULL)
+      return(-1);
+
+   while (fgets(line, sizeof(line), fp) != NULL) {
+      if (sscanf(line, "%511s %511s", key, value) != 2)
+         continue;
+      if (strcmp(key, "DTM_FORMAT") == 0) {
+         if (strcmp(value, "GRID") == 0 || strcmp(value, "DTM_GRID") == 0)
+            format = DTM_GRID;
+         found |= 1;
+      }
+      else if (strcmp(key, "NUM_X_POSTS") == 0) {
+         nx = atoi(value);
+         found |= 2;
+      }
+      else if (strcmp(key, "NUM_Y_POSTS") == 0) {
+         ny = atoi(value);
+         found |= 4;
+      }
+      else if (strcmp(key, "LOWER_LEFT_XYZ") == 0) {
+         if (sscanf(line, "%*s %lf %lf %lf", &ll.x, &ll.y, &ll.z) == 3)
+            found |= 8;
+      }
+      else if (strcmp(key, "UPPER_RIGHT_XYZ") == 0) {
+         if (sscanf(line, "%*s %lf %lf %lf", &ur.x, &ur.y, &ur.z) == 3)
+            found |= 16;
+      }
+      else if (strcmp(key, "X_SPACING") == 0)
+         dx = atof(value);
+      else if (strcmp(key, "Y_SPACING") == 0)
+         dy = atof(value);
+      else if (strcmp(key, "BYTE_ORDER") == 0)
+         swap = ((value[0] == 'M' || value[0] == 'm') != host_is_msb());
+   }
+   fclose(fp);
+
+   if (found != 31 || nx < 1 || ny < 1)
+      return(-1);
+
+   // spacing from the corner posts unless the header gives it
+   if (dx == 0.0 && nx > 1)
+      dx = (ur.x - ll.x) / (nx - 1);
+   if (dy == 0.0 && ny > 1)
+      dy = (ur.y - ll.y) / (ny - 1);
+   return(0);
+}
+
+DtmGrid::DtmGrid(DtmHeader *header)
+{
+   hdr = header;
+   fp = NULL;
+   row = -1;
+   buf = NULL;
+}
+
+DtmGrid::~DtmGrid()
+{
+   if (fp != NULL)
+      fclose(fp);
+   free(buf);
+}
+
+/**************  DtmGrid::openDtm  ****************
+*                                                  *
+*  Opens <fname>.dtm read only (the DTM can't be   *
+*  edited here).  Returns 0, 1 if the header       *
+*  isn't loaded, 2 if the posts can't be opened    *
+*  or the file is not NUM_X_POSTS x NUM_Y_POSTS    *
+*  posts of 5 bytes, 3 if out of memory            *
+*                                                  *
+****************************************************/
+int DtmGrid::openDtm(const char *fname, int edit, int mode, int create, int lock)
+{
+   char dtm[NATIVE_PATHLEN];
+   off_t need;
+
+   if (hdr->numXPosts() < 1 || hdr->numYPosts() < 1)
+      return(1);
+
+   snprintf(dtm, sizeof(dtm), "%s.dtm", fname);
+   fp = fopen(dtm, "rb");
+   if (fp == NULL)
+      return(2);
+
+   need = (off_t) hdr->numXPosts() * 5 * hdr->numYPosts();
+   if (fseeko(fp, 0, SEEK_END) != 0 || ftello(fp) != need) {
+      fclose(fp);
+      fp = NULL;
+      return(2);
+   }
+
+   buf = (unsigned char *) malloc((size_t) hdr->numXPosts() * 5);
+   if (buf == NULL) {
+      fclose(fp);
+      fp = NULL;
+      return(3);
+   }
+   row = -1;
+   return(0);
+}
+
+/**************  DtmGrid::readRow  ****************
+*                                                  *
+*  Reads row y into buf (in this machine's byte    *
+*  order) unless it is already there               *
+*                                                  *
+****************************************************/
+int DtmGrid::readRow(int y)
+{
+   size_t rowbytes = (size_t) hdr->numXPosts() * 5;
+   unsigned char *p, t;
+   int x;
+
+   if (y == row)
+      return(0);
+   if (fp == NULL || y < 0 || y >= hdr->numYPosts())
+      return(1);
+   if (fseeko(fp, (off_t) y * rowbytes, SEEK_SET) != 0 ||
+       fread(buf, 1, rowbytes, fp) != rowbytes) {
+      row = -1;
+      return(1);
+   }
+   if (hdr->swapBytes()) {
+      for (x = 0, p = buf; x < hdr->numXPosts(); x++, p += 4) {
+         t = p[0];  p[0] = p[3];  p[3] = t;
+         t = p[1];  p[1] = p[2];  p[2] = t;
+      }
+   }
+   row = y;
+   return(0);
+}
+
+/**************  DtmGrid::getElevationBlock  ******
+*                                                  *
+*  Posts x0-x1 of rows y0-y1 into z, row after     *
+*  row.  Returns 0, or 1 for a block outside the   *
+*  DTM or a read error                             *
+*                                                  *
+****************************************************/
+int DtmGrid::getElevationBlock(int x0, int y0, int x1, int y1, float *z)
+{
+   int y, n = x1 - x0 + 1;
+
+   if (x0 < 0 || x1 >= hdr->numXPosts() || n < 1)
+      return(1);
+   for (y = y0; y <= y1; y++) {
+      if (readRow(y) != 0)
+         return(1);
+      memcpy(z, buf + (size_t) x0 * sizeof(float), n * sizeof(float));
+      z += n;
+   }
+   return(0);
+}
+
+/**************  DtmGrid::getFomBlock  ************
+*                                                  *
+*  FOM of posts x0-x1 of rows y0-y1 into fom, as   *
+*  getElevationBlock                               *
+*                                                  *
+****************************************************/
+int DtmGrid::getFomBlock(int x0, int y0, int x1, int y1, char *fom)
+{
+   int y, n = x1 - x0 + 1;
+
+   if (x0 < 0 || x1 >= hdr->numXPosts() || n < 1)
+      return(1);
+   for (y = y0; y <= y1; y++) {
+      if (readRow(y) != 0)
+         return(1);
+      memcpy(fom, buf + (size_t) hdr->numXPosts() * sizeof(float) + x0, n);
+      fom += n;
+   }
+   return(0);
+}
@@ -0,0 +1,428 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title IMG_NATIVE native img_* calls for SOCET tiled TIFF images
+//
+//_Desc  Opens uncompressed 8-bit TIFF and BigTIFF images, tiled or in
+//       strips, pixel interleaved or band sequential, and serves the
+//       DEV_KIT img_load_buffer strip reads from them (see socet_native.h).
+//       A strip image is handled as an image of one tile across, a strip
+//       high.  The tile row of the band last read is kept, so reading an
+//       image top to bottom reads each tile once.
+//
+//_Hist Oct 18 2026      Orig Version
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "socet_native.h"
+#include <sys/types.h>
+
+#define NATIVE_MAX_IMAGES 8
+
+// TIFF tags and field types used
+#define TIFF_IMAGE_WIDTH        256
+#define TIFF_IMAGE_LENGTH       257
+#define TIFF_BITS_PER_SAMPLE    258
+#define TIFF_COMPRESSION        259
+#define TIFF_STRIP_OFFSETS      273
+#define TIFF_SAMPLES_PER_PIXEL  277
+#define TIFF_ROWS_PER_STRIP     278
+#define TIFF_STRIP_BYTE_COUNTS  279
+#define TIFF_PLANAR_CONFIG      284
+#define TIFF_TILE_WIDTH         322
+#define TIFF_TILE_LENGTH        323
+#define TIFF_TILE_OFFSETS       324
+#define TIFF_TILE_BYTE_COUNTS   325
+
+#define TIFF_BYTE   1
+#define TIFF_SHORT  3
+#define TIFF_LONG   4
+#define TIFF_LONG8 16
+
+typedef unsigned long long tiff_uint;
+
+struct native_image {
+   FILE *fp;
+   int msb, big;                 // byte order, BigTIFF
+   int lines, samples, bands;
+   int tile_w, tile_h;
+   int tiles_across, tiles_down;
+   int planar;                   // 1 pixel interleaved, 2 band sequential
+   tiff_uint *offsets, *counts;  // of each tile (of each band if planar)
+   int ntiles;
+   int cache_band, cache_row;    // tile row held in cache, -1 for none
+   unsigned char *cache;         // one band of a tile row, tile_h rows of
+                                 // tiles_across * tile_w pixels
+   unsigned char *tile;          // one tile as stored
+};
+static native_image images[NATIVE_MAX_IMAGES];
+
+/**************  tiff_get  ************************
+*                                                  *
+*  Unsigned value of n (1, 2, 4, 8) bytes at p in  *
+*  the image's byte order                          *
+*                                                  *
+****************************************************/
+static tiff_uint tiff_get(native_image *im, const unsigned char *p, int n)
+{
+   tiff_uint v = 0;
+   int i;
+
+   for (i = 0; i < n; i++)
+      v |= (tiff_uint) p[im->msb ? n - 1 - i : i] << (8 * i);
+   return(v);
+}
+
+static int tiff_type_size(int type)
+{
+   switch (type) {
+      case TIFF_BYTE:  return(1);
+      case TIFF_SHORT: return(2);
+      case TIFF_LONG:  return(4);
+      case TIFF_LONG8: return(8);
+   }
+   return(0);
+}
+
+/**************  tiff_values  *********************
+*                                                  *
+*  The n values of an IFD entry into a new array   *
+*  (in the entry if they fit, else at its offset). *
+*  Returns NULL for an unsupported field type or   *
+*  a read error                                    *
+*                                                  *
+****************************************************/
+static tiff_uint *tiff_values(native_image *im, const unsigned char *entry,
+                              tiff_uint *n)
+{
+   int type = (int) tiff_get(im, entry + 2, 2);
+   int size = tiff_type_size(type);
+   int field = im->big ? 8 : 4;
+   unsigned char *raw;
+   tiff_uint *vals;
+   tiff_uint i;
+
+   *n = tiff_get(im, entry + 4, field);
+   if (size == 0 || *n == 0 || *n > 0x10000000)
+      return(NULL);
+
+   raw = (unsigned char *) malloc(*n * size);
+   vals = (tiff_uint *) malloc(*n * sizeof(tiff_uint));
+   if (raw == NULL || vals == NULL) {
+      free(raw);
+      free(vals);
+      return(NULL);
+   }
+
+   if (*n * size <= (tiff_uint) field)
+      memcpy(raw, entry + 4 + field, *n * size);
+   else if (fseeko(im->fp, (off_t) tiff_get(im, entry + 4 + field, field),
+                   SEEK_SET) != 0 ||
+            fread(raw, size, *n, im->fp) != *n) {
+      free(raw);
+      free(vals);
+      return(NULL);
+   }
+
+   for (i = 0; i < *n; i++)
+      vals[i] = tiff_get(im, raw + i * size, size);
+   free(raw);
+   return(vals);
+}
+
+/**************  tiff_open  ***********************
+*                                                  *
+*  Reads the first IFD of the TIFF in im->fp into  *
+*  im.  Returns 0, or -1 if it isn't a TIFF this   *
+*  reader handles                                  *
+*                                                  *
+****************************************************/
+static int tiff_open(native_image *im)
+{
+   unsigned char head[16];
+   unsigned char *ifd = NULL;
+   tiff_uint ifd_off, nentries, n, i;
+   tiff_uint *vals;
+   tiff_uint rows_per_strip = 0;
+   int entry_size, count_size;
+   int bits = 8, compression = 1, tiled = 0;
+   int e, tag, ret = -1;
+
+   if (fread(head, 1, 16, im->fp) < 8)
+      return(-1);
+   if (head[0] == 'I' && head[1] == 'I')
+      im->msb = 0;
+   else if (head[0] == 'M' && head[1] == 'M')
+      im->msb = 1;
+   else
+      return(-1);
+
+   switch (tiff_get(im, head + 2, 2)) {
+      case 42:
+         im->big = 0;
+         ifd_off = tiff_get(im, head + 4, 4);
+         break;
+      case 43:
+         im->big = 1;
+         if (tiff_get(im, head + 4, 2) != 8)
+            return(-1);
+         ifd_off = tiff_get(im, head + 8, 8);
+         break;
+      default:
+         return(-1);
+   }
+   count_size = im->big ? 8 : 2;
+   entry_size = im->big ? 20 : 12;
+
+   if (fseeko(im->fp, (off_t) ifd_off, SEEK_SET) != 0 ||
+       fread(head, 1, count_size, im->fp) != (size_t) count_size)
+      return(-1);
+   nentries = tiff_get(im, head, count_size);
+   if (nentries == 0 || nentries > 4096)
+      return(-1);
+   ifd = (unsigned char *) malloc(nentries * entry_size);
+   if (ifd == NULL ||
+       fread(ifd, entry_size, nentries, im->fp) != nentries) {
+      free(ifd);
+      return(-1);
+   }
+
+   im->bands = 1;
+   im->planar = 1;
+   for (e = 0; e < (int) nentries; e++) {
+      tag = (int) tiff_get(im, ifd + e * entry_size, 2);
+      if (tag != TIFF_IMAGE_WIDTH && tag != TIFF_IMAGE_LENGTH &&
+          tag != TIFF_BITS_PER_SAMPLE && tag != TIFF_COMPRESSION &&
+          tag != TIFF_SAMPLES_PER_PIXEL && tag != TIFF_ROWS_PER_STRIP &&
+          tag != TIFF_PLANAR_CONFIG && tag != TIFF_TILE_WIDTH &&
+          tag != TIFF_TILE_LENGTH && tag != TIFF_STRIP_OFFSETS &&
+          tag != TIFF_STRIP_BYTE_COUNTS && tag != TIFF_TILE_OFFSETS &&
+          tag != TIFF_TILE_BYTE_COUNTS)
+         continue;
+
+      vals = tiff_values(im, ifd + e * entry_size, &n);
+      if (vals == NULL)
+         goto done;
+
+      switch (tag) {
+         case TIFF_IMAGE_WIDTH:       im->samples = (int) vals[0];  break;
+         case TIFF_IMAGE_LENGTH:      im->lines = (int) vals[0];    break;
+         case TIFF_COMPRESSION:       compression = (int) vals[0];  break;
+         case TIFF_SAMPLES_PER_PIXEL: im->bands = (int) vals[0];    break;
+         case TIFF_ROWS_PER_STRIP:    rows_per_strip = vals[0];     break;
+         case TIFF_PLANAR_CONFIG:     im->planar = (int) vals[0];   break;
+         case TIFF_TILE_WIDTH:        im->tile_w = (int) vals[0];   break;
+         case TIFF_TILE_LENGTH:       im->tile_h = (int) vals[0];   break;
+         case TIFF_BITS_PER_SAMPLE:
+            for (i = 0; i < n; i++)
+               if (vals[i] != 8)
+                  bits = (int) vals[i];
+            break;
+         case TIFF_TILE_OFFSETS:
+            tiled = 1;
+            // fall through
+         case TIFF_STRIP_OFFSETS:
+            free(im->offsets);
+            im->offsets = vals;
+            im->ntiles = (int) n;
+            vals = NULL;
+            break;
+         case TIFF_TILE_BYTE_COUNTS:
+         case TIFF_STRIP_BYTE_COUNTS:
+            free(im->counts);
+            im->counts = vals;
+            vals = NULL;
+            break;
+      }
+      free(vals);
+   }
+
+   if (bits != 8 || compression != 1 || im->lines <= 0 ||
+       im->samples <= 0 || im->bands <= 0 ||
+       (im->planar != 1 && im->planar != 2) ||
+       im->offsets == NULL || im->counts == NULL)
+      goto done;
+
+   // strips are tiles of one across
+   if (!tiled) {
+      im->tile_w = im->samples;
+      im->tile_h = (rows_per_strip == 0 || rows_per_strip > (tiff_uint) im->lines)
+                   ? im->lines : (int) rows_per_strip;
+   }
+   if (im->tile_w <= 0 || im->tile_h <= 0)
+      goto done;
+   im->tiles_across = (im->samples + im->tile_w - 1) / im->tile_w;
+   im->tiles_down = (im->lines + im->tile_h - 1) / im->tile_h;
+   if (im->ntiles < im->tiles_across * im->tiles_down *
+                    (im->planar == 2 ? im->bands : 1))
+      goto done;
+
+   im->cache = (unsigned char *) malloc((size_t) im->tiles_across *
+                                        im->tile_w * im->tile_h);
+   im->tile = (unsigned char *) malloc((size_t) im->tile_w * im->tile_h *
+                                       (im->planar == 1 ? im->bands : 1));
+   if (im->cache != NULL && im->tile != NULL)
+      ret = 0;
+
+done:
+   free(ifd);
+   return(ret);
+}
+
+/**************  load_tile_row  *******************
+*                                                  *
+*  Reads band of tile row ty into the cache        *
+*  unless it is already there.  Returns 0 or -1    *
+*                                                  *
+****************************************************/
+static int load_tile_row(native_image *im, int band, int ty)
+{
+   size_t tile_bytes = (size_t) im->tile_w * im->tile_h *
+                       (im->planar == 1 ? im->bands : 1);
+   size_t width = (size_t) im->tiles_across * im->tile_w;
+   size_t n, i;
+   unsigned char *src, *dst;
+   int tx, idx, r, x;
+
+   if (band == im->cache_band && ty == im->cache_row)
+      return(0);
+   im->cache_band = im->cache_row = -1;
+
+   for (tx = 0; tx < im->tiles_across; tx++) {
+      idx = ty * im->tiles_across + tx;
+      if (im->planar == 2)
+         idx += band * im->tiles_across * im->tiles_down;
+
+      // the last strip may be short
+      n = (im->counts[idx] < tile_bytes) ? (size_t) im->counts[idx] : tile_bytes;
+      if (fseeko(im->fp, (off_t) im->offsets[idx], SEEK_SET) != 0 ||
+          fread(im->tile, 1, n, im->fp) != n)
+         return(-1);
+      memset(im->tile + n, 0, tile_bytes - n);
+
+      for (r = 0; r < im->tile_h; r++) {
+         dst = im->cache + r * width + (size_t) tx * im->tile_w;
+         if (im->planar == 2 || im->bands == 1)
+            memcpy(dst, im->tile + (size_t) r * im->tile_w, im->tile_w);
+         else {
+            src = im->tile + (size_t) r * im->tile_w * im->bands + band;
+            for (x = 0, i = 0; x < im->tile_w; x++, i += im->bands)
+               dst[x] = src[i];
+         }
+      }
+   }
+
+   im->cache_band = band;
+   im->cache_row = ty;
+   return(0);
+}
+
+static void close_image(native_image *im)
+{
+   if (im->fp != NULL)
+      fclose(im->fp);
+   free(im->offsets);
+   free(im->counts);
+   free(im->cache);
+   free(im->tile);
+   memset(im, 0, sizeof(native_image));
+}
+
+/**************  img_openfile  ********************
+*                                                  *
+*  Returns the image handle, or -1 if the file     *
+*  can't be opened or read or too many images are  *
+*  open                                            *
+*                                                  *
+****************************************************/
+int img_openfile(const char *file, int mode)
+{
+   native_image *im;
+   int img;
+
+   for (img = 0; img < NATIVE_MAX_IMAGES && images[img].fp != NULL; img++)
+      ;
+   if (img == NATIVE_MAX_IMAGES)
+      return(-1);
+   im = &images[img];
+
+   memset(im, 0, sizeof(native_image));
+   im->fp = fopen(file, "rb");
+   if (im->fp == NULL)
+      return(-1);
+   if (tiff_open(im) != 0) {
+      close_image(im);
+      return(-1);
+   }
+   im->cache_band = im->cache_row = -1;
+   return(img);
+}
+
+int img_closefile(int img)
+{
+   if (img < 0 || img >= NATIVE_MAX_IMAGES || images[img].fp == NULL)
+      return(-1);
+   close_image(&images[img]);
+   return(0);
+}
+
+int img_query_num_bands(int img)
+{
+   return(images[img].bands);
+}
+
+void img_query_dimension(int img, int *lines, int *samples)
+{
+   *lines = images[img].lines;
+   *samples = images[img].samples;
+}
+
+void img_query_tile_size(int img, int *tile_x, int *tile_y)
+{
+   *tile_x = images[img].tile_w;
+   *tile_y = images[img].tile_h;
+}
+
+/**************  img_load_buffer  *****************
+*                                                  *
+*  Reads nlines by nsamples pixels of band from    *
+*  (line, sample) into buf, stride bytes a line.   *
+*  Pixels outside the image are set to *fill.      *
+*  Returns 0, or -1 on a bad handle or read error  *
+*                                                  *
+****************************************************/
+int img_load_buffer(int img, int line, int sample, int nlines, int nsamples,
+                    int band, unsigned char *buf, int stride,
+                    unsigned char *fill)
+{
+   native_image *im;
+   size_t width;
+   int r, y, x0, x1;
+
+   if (img < 0 || img >= NATIVE_MAX_IMAGES || images[img].fp == NULL)
+      return(-1);
+   im = &images[img];
+   if (band < 0 || band >= im->bands)
+      return(-1);
+   width = (size_t) im->tiles_across * im->tile_w;
+
+   // the part of each line inside the image
+   x0 = (sample < 0) ? 0 : sample;
+   x1 = (sample + nsamples > im->samples) ? im->samples : sample + nsamples;
+
+   for (r = 0; r < nlines; r++, buf += stride) {
+      y = line + r;
+      if (y < 0 || y >= im->lines || x0 >= x1) {
+         memset(buf, *fill, nsamples);
+         continue;
+      }
+      if (load_tile_row(im, band, y / im->tile_h) != 0)
+         return(-1);
+      if (x0 > sample)
+         memset(buf, *fill, x0 - sample);
+      memcpy(buf + (x0 - sample),
+             im->cache + (size_t) (y % im->tile_h) * width + x0, x1 - x0);
+      if (x1 < sample + nsamples)
+         memset(buf + (x1 - sample), *fill, sample + nsamples - x1);
+   }
+   return(0);
+}
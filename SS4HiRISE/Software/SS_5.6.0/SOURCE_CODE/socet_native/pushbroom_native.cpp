@@ -0,0 +1,868 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title PUSHBROOM_NATIVE native pushbroom sensor model of SOCET support files
+//
+//_Desc  Reads the USGSAstroLineScanner support files import_pushbroom
+//       writes into a PushbroomSensorModel (see socet_native.h for the
+//       keywords used) and maps image points to ground points and back, so
+//       footprints, orthos and GPF checks of pushbroom images can be done
+//       on a Linux node without SOCET.
+//
+//       The model is the ISIS line scan camera the keywords are taken from
+//       (see create_pushbroom_keywords):  image line L is exposed at
+//
+//              t = T_CENTER + (L - TOTAL_LINES / 2) * INT_TIME
+//
+//       seconds from the center of the image, sample S is detector sample
+//       (S - 1) * DETECTOR_SAMPLE_SUMMING + STARTING_SAMPLE, and the
+//       detector line and sample, less their origins, are ITRANSL/ITRANSS
+//       of the distorted focal plane x/y (mm).  The undistorted x/y (less
+//       the radial OPTICAL_DIST_COEF terms) and FOCAL * ISIS_Z_DIRECTION
+//       give the look in the camera frame, which the MOUNTING_ANGLES and the
+//       quaternion of t turn into the body fixed frame, from the ephemeris
+//       position of t.
+//
+//       The ephemeris and quaternions are 8 point Lagrange interpolated,
+//       once per image line (of the span they cover) into a table of
+//       positions and rotations when the file is read; positions and
+//       rotations between lines are linear in the table (two values a step
+//       with SSE2), and outside it are interpolated directly.  Ground to image is the search for the
+//       line at which the point is on the detector line: secant steps on
+//       the point's detector line offset, from the last point's line (so
+//       arrays of nearby points take two or three steps a point).
+//
+//       Image to ground intersects the look with the ellipsoid raised by
+//       the height, then steps along the look to the ographic height, with
+//       the height of each step from Bowring's formula (no trig).
+//
+//       The array calls split the points into blocks of PUSHBROOM_BLOCK,
+//       which worker threads (Windows or POSIX) take in turn.
+//
+//_Hist Oct 18 2026      Orig Version
+//      Oct 19 2026      Array calls run in threads, a block of points at a
+//                       time; state table interpolation with SSE2; the
+//                       image to ground height steps take Bowring's height
+//                       rather than iterating on the latitude.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "socet_native.h"
+#include <ctype.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PUSHBROOM_SSE2
+#endif
+
+#define LAGRANGE_ORDER 8         // points interpolated
+#define MAX_TABLE_NODES 1048576  // sensor state table size limit
+#define MAX_SEARCH_STEPS 30      // ground to image line search
+#define LINE_TOLERANCE 1.0e-6    // lines
+#define HEIGHT_TOLERANCE 1.0e-4  // meters, image to ground
+#define MAX_PUSHBROOM_THREADS 16 // array calls
+
+// An array call, shared by the threads taking its blocks of points
+struct pushbroom_batch {
+   PushbroomSensorModel *sup;
+   int n, nblocks;
+   const double *line, *sample, *height;   // image to ground, or
+   const ground_point_struct *gp_in;       // ground to image (not NULL)
+   ground_point_struct *gp;
+   double *line_out, *sample_out;
+   double start;                           // line each block's search starts from
+   volatile long next_block;
+   volatile long failed;
+};
+
+/**************  read_values  **********************
+*                                                  *
+*  Reads n numbers of a keyword.  Returns 0, or    *
+*  -1 if there are fewer                           *
+*                                                  *
+****************************************************/
+static int read_values(FILE *fp, int n, double *v)
+{
+   int i;
+
+   for (i = 0; i < n; i++)
+      if (fscanf(fp, "%lf", &v[i]) != 1)
+         return(-1);
+   return(0);
+}
+
+/**************  read_pushbroom_support_file  *****
+*                                                  *
+*  Returns a new PushbroomSensorModel for          *
+*  sup_file, or NULL if it can't be read, is not   *
+*  a USGSAstroLineScanner support file or is       *
+*  missing keywords                                *
+*                                                  *
+****************************************************/
+PushbroomSensorModel *read_pushbroom_support_file(const char *sup_file)
+{
+   PushbroomSensorModel *sup;
+   char key[NATIVE_PATHLEN];
+   char value[NATIVE_PATHLEN];
+   const char *slash;
+   double v[3];
+   int have = 0, err = 0, is_line_scanner = 0;
+   FILE *fp;
+
+   fp = fopen(sup_file, "r");
+   if (fp == NULL)
+      return(NULL);
+
+   sup = new PushbroomSensorModel;
+
+   // Values are read for the keywords used; the rest (numbers, and the
+   // words of other keywords) are passed over
+   while (!err && fscanf(fp, "%511s", key) == 1) {
+      if (!isalpha((unsigned char) key[0]))
+         continue;
+      upper_case(key);
+      if (strcmp(key, "IMAGE_FILENAME") == 0) {
+         if (fscanf(fp, "%511s", value) != 1)
+            break;
+         // relative to the support file's directory
+         slash = strrchr(sup_file, '/');
+         if (value[0] == '/' || slash == NULL)
+            snprintf(sup->image_file_name[0], NATIVE_PATHLEN, "%s", value);
+         else
+            snprintf(sup->image_file_name[0], NATIVE_PATHLEN, "%.*s/%s",
+                     (int) (slash - sup_file), sup_file, value);
+      }
+      else if (strcmp(key, "SENSOR_TYPE") == 0) {
+         if (fscanf(fp, "%511s", value) != 1)
+            break;
+         upper_case(value);
+         is_line_scanner = (strstr(value, "LINESCANNER") != NULL);
+      }
+      else if (strcmp(key, "TOTAL_LINES") == 0) {
+         err = read_values(fp, 1, v);
+         sup->total_lines = (int) v[0];
+         have |= 0x1;
+      }
+      else if (strcmp(key, "TOTAL_SAMPLES") == 0) {
+         err = read_values(fp, 1, v);
+         sup->total_samples = (int) v[0];
+      }
+      else if (strcmp(key, "INT_TIME") == 0) {
+         err = read_values(fp, 1, &sup->int_time);
+         have |= 0x2;
+      }
+      else if (strcmp(key, "T_CENTER") == 0)
+         err = read_values(fp, 1, &sup->t_center);
+      else if (strcmp(key, "FOCAL") == 0) {
+         err = read_values(fp, 1, &sup->focal);
+         have |= 0x4;
+      }
+      else if (strcmp(key, "ISIS_Z_DIRECTION") == 0)
+         err = read_values(fp, 1, &sup->z_direction);
+      else if (strcmp(key, "OPTICAL_DIST_COEF") == 0)
+         err = read_values(fp, 3, sup->dist_coef);
+      else if (strcmp(key, "ITRANSS") == 0) {
+         err = read_values(fp, 3, sup->itranss);
+         have |= 0x8;
+      }
+      else if (strcmp(key, "ITRANSL") == 0) {
+         err = read_values(fp, 3, sup->itransl);
+         have |= 0x10;
+      }
+      else if (strcmp(key, "DETECTOR_SAMPLE_ORIGIN") == 0)
+         err = read_values(fp, 1, &sup->det_sample_origin);
+      else if (strcmp(key, "DETECTOR_LINE_ORIGIN") == 0)
+         err = read_values(fp, 1, &sup->det_line_origin);
+      else if (strcmp(key, "DETECTOR_LINE_OFFSET") == 0)
+         err = read_values(fp, 1, &sup->det_line_offset);
+      else if (strcmp(key, "DETECTOR_SAMPLE_SUMMING") == 0)
+         err = read_values(fp, 1, &sup->det_sample_summing);
+      else if (strcmp(key, "STARTING_SAMPLE") == 0)
+         err = read_values(fp, 1, &sup->starting_sample);
+      else if (strcmp(key, "MOUNTING_ANGLES") == 0)
+         err = read_values(fp, 3, sup->mounting_angles);
+      else if (strcmp(key, "SEMI_MAJOR_AXIS") == 0) {
+         err = read_values(fp, 1, &sup->semi_major_axis);
+         have |= 0x20;
+      }
+      else if (strcmp(key, "ECCENTRICITY") == 0)
+         err = read_values(fp, 1, &sup->eccentricity);
+      else if (strcmp(key, "DT_EPHEM") == 0)
+         err = read_values(fp, 1, &sup->dt_ephem);
+      else if (strcmp(key, "T0_EPHEM") == 0)
+         err = read_values(fp, 1, &sup->t0_ephem);
+      else if (strcmp(key, "NUMBER_OF_EPHEM") == 0) {
+         err = read_values(fp, 1, v);
+         sup->nephem = (int) v[0];
+      }
+      else if (strcmp(key, "EPHEM_PTS") == 0 && sup->nephem > 0 &&
+               sup->ephem_pts == NULL) {
+         sup->ephem_pts = new double [3 * sup->nephem];
+         err = read_values(fp, 3 * sup->nephem, sup->ephem_pts);
+         have |= 0x40;
+      }
+      else if (strcmp(key, "DT_QUAT") == 0)
+         err = read_values(fp, 1, &sup->dt_quat);
+      else if (strcmp(key, "T0_QUAT") == 0)
+         err = read_values(fp, 1, &sup->t0_quat);
+      else if (strcmp(key, "NUMBER_OF_QUATERNIONS") == 0) {
+         err = read_values(fp, 1, v);
+         sup->nquat = (int) v[0];
+      }
+      else if (strcmp(key, "QUATERNIONS") == 0 && sup->nquat > 0 &&
+               sup->quats == NULL) {
+         sup->quats = new double [4 * sup->nquat];
+         err = read_values(fp, 4 * sup->nquat, sup->quats);
+         have |= 0x80;
+      }
+   }
+   fclose(fp);
+
+   if (err || !is_line_scanner || have != 0xff || sup->setup() != 0) {
+      delete sup;
+      return(NULL);
+   }
+   return(sup);
+}
+
+/**************  PushbroomSensorModel  ************/
+PushbroomSensorModel::PushbroomSensorModel()
+{
+   memset(image_file_name, 0, sizeof(image_file_name));
+   total_lines = total_samples = 0;
+   int_time = t_center = 0.0;
+   focal = 0.0;
+   z_direction = 1.0;
+   dist_coef[0] = dist_coef[1] = dist_coef[2] = 0.0;
+   memset(itranss, 0, sizeof(itranss));
+   memset(itransl, 0, sizeof(itransl));
+   det_sample_origin = det_line_origin = det_line_offset = 0.0;
+   det_sample_summing = starting_sample = 1.0;
+   mounting_angles[0] = mounting_angles[1] = mounting_angles[2] = 0.0;
+   semi_major_axis = eccentricity = 0.0;
+   nephem = nquat = 0;
+   t0_ephem = dt_ephem = t0_quat = dt_quat = 0.0;
+   ephem_pts = quats = NULL;
+   nodes = NULL;
+   nnodes = 0;
+   first_line = step = 0.0;
+   line_rate = 0.0;
+   last_line = 0.0;
+}
+
+PushbroomSensorModel::~PushbroomSensorModel()
+{
+   delete [] ephem_pts;
+   delete [] quats;
+   delete [] nodes;
+}
+
+/**************  lagrange_weights  ****************
+*                                                  *
+*  Weights of the (up to) 8 nodes about time t of  *
+*  n nodes t0 + k * dt.  Returns the first node    *
+*  and sets *m to the number of weights            *
+*                                                  *
+****************************************************/
+static int lagrange_weights(double t, double t0, double dt, int n, double *w,
+                            int *m)
+{
+   int first, j, k;
+   double u;
+
+   *m = (n < LAGRANGE_ORDER) ? n : LAGRANGE_ORDER;
+   u = (t - t0) / dt;
+   first = (int) floor(u) - (*m / 2 - 1);
+   if (first < 0)
+      first = 0;
+   if (first > n - *m)
+      first = n - *m;
+
+   for (j = 0; j < *m; j++) {
+      w[j] = 1.0;
+      for (k = 0; k < *m; k++)
+         if (k != j)
+            w[j] *= (u - (first + k)) / (double) (j - k);
+   }
+   return(first);
+}
+
+/**************  exactState  **********************
+*                                                  *
+*  Sensor position (body fixed m) and camera to    *
+*  body rotation (row major) at time t, from the   *
+*  ephemeris and quaternions                       *
+*                                                  *
+****************************************************/
+void PushbroomSensorModel::exactState(double t, double *pos, double *rot)
+{
+   double w[LAGRANGE_ORDER], q[4], r[9], s;
+   int first, m, j, k, l;
+
+   first = lagrange_weights(t, t0_ephem, dt_ephem, nephem, w, &m);
+   pos[0] = pos[1] = pos[2] = 0.0;
+   for (j = 0; j < m; j++)
+      for (k = 0; k < 3; k++)
+         pos[k] += w[j] * ephem_pts[3 * (first + j) + k];
+
+   first = lagrange_weights(t, t0_quat, dt_quat, nquat, w, &m);
+   q[0] = q[1] = q[2] = q[3] = 0.0;
+   for (j = 0; j < m; j++)
+      for (k = 0; k < 4; k++)
+         q[k] += w[j] * quats[4 * (first + j) + k];
+   s = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+   for (k = 0; k < 4; k++)
+      q[k] /= s;
+
+   // x y z w, as SPICE q2m of the camera to body matrix
+   r[0] = 1.0 - 2.0 * (q[1] * q[1] + q[2] * q[2]);
+   r[1] = 2.0 * (q[0] * q[1] - q[3] * q[2]);
+   r[2] = 2.0 * (q[0] * q[2] + q[3] * q[1]);
+   r[3] = 2.0 * (q[0] * q[1] + q[3] * q[2]);
+   r[4] = 1.0 - 2.0 * (q[0] * q[0] + q[2] * q[2]);
+   r[5] = 2.0 * (q[1] * q[2] - q[3] * q[0]);
+   r[6] = 2.0 * (q[0] * q[2] - q[3] * q[1]);
+   r[7] = 2.0 * (q[1] * q[2] + q[3] * q[0]);
+   r[8] = 1.0 - 2.0 * (q[0] * q[0] + q[1] * q[1]);
+
+   // then the mounting
+   for (j = 0; j < 3; j++)
+      for (k = 0; k < 3; k++) {
+         rot[3 * j + k] = 0.0;
+         for (l = 0; l < 3; l++)
+            rot[3 * j + k] += r[3 * j + l] * mount[3 * l + k];
+      }
+}
+
+/**************  state  ***************************
+*                                                  *
+*  Position (st[0..2]) and rotation (st[3..11]) at *
+*  image line, from the table where it covers the  *
+*  line                                            *
+*                                                  *
+****************************************************/
+void PushbroomSensorModel::state(double line, double *st)
+{
+   double u, f, *a, *b;
+   int k, i;
+#ifdef PUSHBROOM_SSE2
+   __m128d vf, va;
+#endif
+
+   u = (line - first_line) / step;
+   if (!(u >= 0.0 && u <= nnodes - 1)) {
+      exactState(t_center + (line - 0.5 * total_lines) * int_time, st, st + 3);
+      return;
+   }
+   k = (int) u;
+   if (k > nnodes - 2)
+      k = nnodes - 2;
+   f = u - k;
+   a = nodes + 12 * k;
+   b = a + 12;
+#ifdef PUSHBROOM_SSE2
+   vf = _mm_set1_pd(f);
+   for (i = 0; i < 12; i += 2) {
+      va = _mm_loadu_pd(a + i);
+      _mm_storeu_pd(st + i, _mm_add_pd(va, _mm_mul_pd(vf, _mm_sub_pd(_mm_loadu_pd(b + i), va))));
+   }
+#else
+   for (i = 0; i < 12; i++)
+      st[i] = a[i] + f * (b[i] - a[i]);
+#endif
+}
+
+/**************  setup  ***************************
+*                                                  *
+*  Checks the keywords, keeps the quaternions on   *
+*  one hemisphere, builds the mounting rotation    *
+*  and the state table, and finds the rate the     *
+*  detector line offset of a point changes with    *
+*  image line.  Returns 0, or -1 if the keywords   *
+*  don't give a model                              *
+*                                                  *
+****************************************************/
+int PushbroomSensorModel::setup()
+{
+   double co, so, cp, sp, ck, sk, det, t0, t1, l0, l1, dot;
+   double X[3], cs;
+   ground_point_struct gp;
+   int i, k;
+
+   if (total_lines <= 0 || int_time <= 0.0 || focal <= 0.0 ||
+       semi_major_axis <= 0.0 || eccentricity < 0.0 || eccentricity >= 1.0 ||
+       nephem < 2 || nquat < 2 || dt_ephem <= 0.0 || dt_quat <= 0.0 ||
+       det_sample_summing <= 0.0)
+      return(-1);
+
+   det = itranss[1] * itransl[2] - itranss[2] * itransl[1];
+   if (det == 0.0)
+      return(-1);
+   inv[0] = itransl[2] / det;
+   inv[1] = -itranss[2] / det;
+   inv[2] = -itransl[1] / det;
+   inv[3] = itranss[1] / det;
+
+   for (i = 1; i < nquat; i++) {
+      dot = 0.0;
+      for (k = 0; k < 4; k++)
+         dot += quats[4 * i + k] * quats[4 * (i - 1) + k];
+      if (dot < 0.0)
+         for (k = 0; k < 4; k++)
+            quats[4 * i + k] = -quats[4 * i + k];
+   }
+
+   // camera to mounting frame, rotated by kappa, phi then omega
+   co = cos(mounting_angles[0]);  so = sin(mounting_angles[0]);
+   cp = cos(mounting_angles[1]);  sp = sin(mounting_angles[1]);
+   ck = cos(mounting_angles[2]);  sk = sin(mounting_angles[2]);
+   mount[0] = cp * ck;
+   mount[1] = -cp * sk;
+   mount[2] = sp;
+   mount[3] = co * sk + so * sp * ck;
+   mount[4] = co * ck - so * sp * sk;
+   mount[5] = -so * cp;
+   mount[6] = so * sk - co * sp * ck;
+   mount[7] = so * ck + co * sp * sk;
+   mount[8] = co * cp;
+
+   // a node a line over the span of both the ephemeris and quaternions
+   t0 = (t0_ephem > t0_quat) ? t0_ephem : t0_quat;
+   t1 = t0_ephem + (nephem - 1) * dt_ephem;
+   if (t0_quat + (nquat - 1) * dt_quat < t1)
+      t1 = t0_quat + (nquat - 1) * dt_quat;
+   l0 = 0.5 * total_lines + (t0 - t_center) / int_time;
+   l1 = 0.5 * total_lines + (t1 - t_center) / int_time;
+   delete [] nodes;
+   nodes = NULL;
+   nnodes = 0;
+   if (l1 - l0 >= 1.0) {
+      first_line = ceil(l0);
+      step = 1.0;
+      while ((l1 - first_line) / step + 1.0 > MAX_TABLE_NODES)
+         step *= 2.0;
+      nnodes = (int) floor((l1 - first_line) / step) + 1;
+      if (nnodes >= 2) {
+         nodes = new double [12 * (size_t) nnodes];
+         for (k = 0; k < nnodes; k++)
+            exactState(t_center + (first_line + k * step - 0.5 * total_lines) *
+                       int_time, nodes + 12 * k, nodes + 12 * k + 3);
+      }
+      else
+         nnodes = 0;
+   }
+
+   // detector lines per image line, at the center of the image
+   last_line = 0.5 * total_lines;
+   line_rate = 0.0;
+   if (imageToGround(last_line, 0.5 * (total_samples + 1), 0.0, &gp) == 0) {
+      groundToBody(&gp, X);
+      if (residual(last_line, X, &l0, &cs) == 0 &&
+          residual(last_line + 1.0, X, &l1, &cs) == 0)
+         line_rate = l1 - l0;
+   }
+   return(0);
+}
+
+/**************  groundToBody  ********************
+*                                                  *
+*  Ground point (lon, ographic lat, height) to     *
+*  body fixed x/y/z, m                             *
+*                                                  *
+****************************************************/
+void PushbroomSensorModel::groundToBody(const ground_point_struct *gp,
+                                        double *X)
+{
+   double e2 = eccentricity * eccentricity;
+   double sl = sin(gp->y), cl = cos(gp->y), N;
+
+   N = semi_major_axis / sqrt(1.0 - e2 * sl * sl);
+   X[0] = (N + gp->z) * cl * cos(gp->x);
+   X[1] = (N + gp->z) * cl * sin(gp->x);
+   X[2] = (N * (1.0 - e2) + gp->z) * sl;
+}
+
+/**************  bodyHeight  **********************
+*                                                  *
+*  Ographic height of body fixed x/y/z, and the    *
+*  ellipsoid normal there (n), by Bowring's        *
+*  formula: no trig, and within a micrometer of    *
+*  the exact height tens of km from the surface    *
+*                                                  *
+****************************************************/
+double PushbroomSensorModel::bodyHeight(const double *X, double *n)
+{
+   double a = semi_major_axis, e2 = eccentricity * eccentricity;
+   double b = a * sqrt(1.0 - e2);
+   double p, r, cu, su, cl, sl, N;
+
+   p = sqrt(X[0] * X[0] + X[1] * X[1]);
+
+   // parametric latitude u, then the ographic latitude
+   r = sqrt(p * b * p * b + X[2] * a * X[2] * a);
+   if (r == 0.0) {
+      n[0] = n[1] = 0.0;
+      n[2] = 1.0;
+      return(-b);
+   }
+   cu = p * b / r;
+   su = X[2] * a / r;
+   sl = X[2] + e2 / (1.0 - e2) * b * su * su * su;
+   cl = p - e2 * a * cu * cu * cu;
+   r = sqrt(sl * sl + cl * cl);
+   sl /= r;
+   cl /= r;
+
+   n[0] = (p > 0.0) ? cl * X[0] / p : 0.0;
+   n[1] = (p > 0.0) ? cl * X[1] / p : 0.0;
+   n[2] = sl;
+   N = a / sqrt(1.0 - e2 * sl * sl);
+   return(p * cl + X[2] * sl - a * a / N);
+}
+
+/**************  imageToGround  *******************
+*                                                  *
+*  Ground point at height of image line/sample.    *
+*  Returns 0, or -1 if the look misses the body    *
+*                                                  *
+****************************************************/
+int PushbroomSensorModel::imageToGround(double line, double sample,
+                                        double height, ground_point_struct *gp)
+{
+   double st[12], *pos = st, *rot = st + 3, look[3], d[3], X[3], n[3];
+   double cs, cl, x, y, r2, dr, a, b, s, B, C, disc, dh, dn, len;
+   int i;
+
+   state(line, st);
+
+   // detector to distorted, then undistorted, focal plane
+   cs = (sample - 1.0) * det_sample_summing + starting_sample -
+        det_sample_origin - itranss[0];
+   cl = det_line_offset - det_line_origin - itransl[0];
+   x = inv[0] * cs + inv[1] * cl;
+   y = inv[2] * cs + inv[3] * cl;
+   r2 = x * x + y * y;
+   dr = dist_coef[0] + r2 * (dist_coef[1] + r2 * dist_coef[2]);
+   look[0] = x - dr * x;
+   look[1] = y - dr * y;
+   look[2] = z_direction * focal;
+
+   for (i = 0; i < 3; i++)
+      d[i] = rot[3 * i] * look[0] + rot[3 * i + 1] * look[1] +
+             rot[3 * i + 2] * look[2];
+   len = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+   for (i = 0; i < 3; i++)
+      d[i] /= len;
+
+   // the ellipsoid raised by height, scaled to a sphere in z
+   a = semi_major_axis + height;
+   b = semi_major_axis * sqrt(1.0 - eccentricity * eccentricity) + height;
+   s = a / b;
+   B = pos[0] * d[0] + pos[1] * d[1] + pos[2] * s * d[2] * s;
+   C = pos[0] * pos[0] + pos[1] * pos[1] + pos[2] * s * pos[2] * s - a * a;
+   len = d[0] * d[0] + d[1] * d[1] + d[2] * s * d[2] * s;
+   disc = B * B - len * C;
+   if (disc < 0.0 || a <= 0.0 || b <= 0.0) {
+      gp->x = gp->y = gp->z = NAN;
+      return(-1);
+   }
+   s = (-B - sqrt(disc)) / len;
+   if (s < 0.0)
+      s = (-B + sqrt(disc)) / len;
+   if (s < 0.0) {
+      gp->x = gp->y = gp->z = NAN;
+      return(-1);
+   }
+   for (i = 0; i < 3; i++)
+      X[i] = pos[i] + s * d[i];
+
+   // along the look to the ographic height
+   for (i = 0; i < 10; i++) {
+      dh = bodyHeight(X, n) - height;
+      if (fabs(dh) < HEIGHT_TOLERANCE)
+         break;
+      dn = d[0] * n[0] + d[1] * n[1] + d[2] * n[2];
+      if (fabs(dn) < 1.0e-12)
+         break;
+      X[0] -= dh / dn * d[0];
+      X[1] -= dh / dn * d[1];
+      X[2] -= dh / dn * d[2];
+   }
+   // latitude: one fixed point step from Bowring's, which takes its error
+   // (well under a micrometer) down by a factor of about e^2
+   s = eccentricity * eccentricity;
+   len = semi_major_axis / sqrt(1.0 - s * n[2] * n[2]);
+   gp->x = atan2(X[1], X[0]);
+   gp->y = atan2(X[2] + s * len * n[2], sqrt(X[0] * X[0] + X[1] * X[1]));
+   gp->z = height;
+   return(0);
+}
+
+/**************  residual  ************************
+*                                                  *
+*  Detector line offset (*dl) and centered         *
+*  detector sample (*cs) of body fixed point X     *
+*  seen from image line.  Returns 0, or -1 if X   *
+*  is behind the camera                            *
+*                                                  *
+****************************************************/
+int PushbroomSensorModel::residual(double line, const double *X, double *dl,
+                                   double *cs)
+{
+   double st[12], *pos = st, *rot = st + 3, v[3], c[3], ux, uy, x, y, r2, dr;
+   int i;
+
+   state(line, st);
+   for (i = 0; i < 3; i++)
+      v[i] = X[i] - pos[i];
+   for (i = 0; i < 3; i++)
+      c[i] = rot[i] * v[0] + rot[3 + i] * v[1] + rot[6 + i] * v[2];
+   if (c[2] * z_direction <= 0.0)
+      return(-1);
+   ux = z_direction * focal * c[0] / c[2];
+   uy = z_direction * focal * c[1] / c[2];
+
+   // distort: x - dr(x) x = ux
+   x = ux;
+   y = uy;
+   if (dist_coef[0] != 0.0 || dist_coef[1] != 0.0 || dist_coef[2] != 0.0)
+      for (i = 0; i < 20; i++) {
+         r2 = x * x + y * y;
+         dr = dist_coef[0] + r2 * (dist_coef[1] + r2 * dist_coef[2]);
+         x = ux / (1.0 - dr);
+         y = uy / (1.0 - dr);
+      }
+
+   *dl = itransl[0] + itransl[1] * x + itransl[2] * y -
+         (det_line_offset - det_line_origin);
+   *cs = itranss[0] + itranss[1] * x + itranss[2] * y;
+   return(0);
+}
+
+/**************  groundToImage  *******************
+*                                                  *
+*  Image line/sample of a ground point, searching  *
+*  from the last solution.  Returns 0, or -1 if    *
+*  the line search fails                           *
+*                                                  *
+****************************************************/
+int PushbroomSensorModel::groundToImage(const ground_point_struct *gp,
+                                        double *line, double *sample)
+{
+   if (groundToImage(gp, last_line, line, sample) != 0)
+      return(-1);
+   last_line = *line;
+   return(0);
+}
+
+/**************  groundToImage (from a line)  *****
+*                                                  *
+*  Image line/sample of a ground point, searching  *
+*  from image line start (the image center if it   *
+*  is NAN).  Returns 0, or -1 if the line search   *
+*  fails                                           *
+*                                                  *
+****************************************************/
+int PushbroomSensorModel::groundToImage(const ground_point_struct *gp,
+                                        double start, double *line,
+                                        double *sample)
+{
+   double X[3], l0, l1, r0, r1, cs, dl, rate;
+   int i;
+
+   groundToBody(gp, X);
+
+   l0 = (start == start) ? start : 0.5 * total_lines;
+   if (residual(l0, X, &r0, &cs) != 0) {
+      l0 = 0.5 * total_lines;
+      if (residual(l0, X, &r0, &cs) != 0) {
+         *line = *sample = NAN;
+         return(-1);
+      }
+   }
+
+   // Newton's step with the rate at the image center, then secant steps
+   rate = line_rate;
+   if (rate == 0.0) {
+      if (residual(l0 + 1.0, X, &r1, &cs) != 0 || r1 == r0) {
+         *line = *sample = NAN;
+         return(-1);
+      }
+      rate = r1 - r0;
+   }
+   for (i = 0; i < MAX_SEARCH_STEPS; i++) {
+      dl = -r0 / rate;
+      l1 = l0 + dl;
+      if (residual(l1, X, &r1, &cs) != 0)
+         break;
+      if (fabs(dl) < LINE_TOLERANCE) {
+         *line = l1;
+         *sample = (cs + det_sample_origin - starting_sample) /
+                   det_sample_summing + 1.0;
+         return(0);
+      }
+      if (r1 != r0)
+         rate = (r1 - r0) / (l1 - l0);
+      l0 = l1;
+      r0 = r1;
+   }
+   *line = *sample = NAN;
+   return(-1);
+}
+
+/**************  batch_blocks  ********************
+*                                                  *
+*  Takes blocks of points of an array call until   *
+*  none are left                                   *
+*                                                  *
+****************************************************/
+static void batch_blocks(pushbroom_batch *b)
+{
+   double start;
+   long blk, failed = 0;
+   int i, i0, i1;
+
+#ifdef _WIN32
+   while ((blk = InterlockedIncrement(&b->next_block) - 1) < b->nblocks) {
+#else
+   while ((blk = __sync_fetch_and_add(&b->next_block, 1)) < b->nblocks) {
+#endif
+      i0 = (int) blk * PUSHBROOM_BLOCK;
+      i1 = (i0 + PUSHBROOM_BLOCK < b->n) ? i0 + PUSHBROOM_BLOCK : b->n;
+      if (b->gp_in == NULL) {
+         for (i = i0; i < i1; i++)
+            if (b->sup->imageToGround(b->line[i], b->sample[i], b->height[i],
+                                      &b->gp[i]) != 0)
+               failed++;
+      }
+      else {
+         start = b->start;
+         for (i = i0; i < i1; i++)
+            if (b->sup->groundToImage(&b->gp_in[i], start, &b->line_out[i],
+                                      &b->sample_out[i]) != 0)
+               failed++;
+            else
+               start = b->line_out[i];
+      }
+   }
+
+#ifdef _WIN32
+   InterlockedExchangeAdd(&b->failed, failed);
+#else
+   __sync_fetch_and_add(&b->failed, failed);
+#endif
+}
+
+/**************  batch_worker  ********************/
+#ifdef _WIN32
+static DWORD WINAPI batch_worker(LPVOID arg)
+#else
+static void *batch_worker(void *arg)
+#endif
+{
+   batch_blocks((pushbroom_batch *) arg);
+   return(0);
+}
+
+/**************  run_batch  ***********************
+*                                                  *
+*  Runs an array call in a thread a processor (up  *
+*  to MAX_PUSHBROOM_THREADS and one a block), or   *
+*  here if there is one block or no thread starts. *
+*  Returns the number of points that failed        *
+*                                                  *
+****************************************************/
+static int run_batch(pushbroom_batch *b)
+{
+   int i, nthreads, started;
+
+   b->nblocks = (b->n + PUSHBROOM_BLOCK - 1) / PUSHBROOM_BLOCK;
+   b->next_block = 0;
+   b->failed = 0;
+
+#ifdef _WIN32
+   HANDLE threads[MAX_PUSHBROOM_THREADS];
+   SYSTEM_INFO sysinfo;
+   GetSystemInfo(&sysinfo);
+   nthreads = sysinfo.dwNumberOfProcessors;
+#else
+   pthread_t threads[MAX_PUSHBROOM_THREADS];
+   nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+   if (nthreads > MAX_PUSHBROOM_THREADS) nthreads = MAX_PUSHBROOM_THREADS;
+   if (nthreads > b->nblocks) nthreads = b->nblocks;
+
+   started = 0;
+   if (nthreads > 1) {
+#ifdef _WIN32
+      for (; started < nthreads; started++)
+         if ((threads[started] = CreateThread(NULL, 0, batch_worker, b, 0, NULL)) == NULL)
+            break;
+      if (started > 0)
+         WaitForMultipleObjects(started, threads, TRUE, INFINITE);
+      for (i = 0; i < started; i++)
+         CloseHandle(threads[i]);
+#else
+      for (; started < nthreads; started++)
+         if (pthread_create(&threads[started], NULL, batch_worker, b) != 0)
+            break;
+      for (i = 0; i < started; i++)
+         pthread_join(threads[i], NULL);
+#endif
+   }
+   if (started == 0)
+      batch_blocks(b);
+   return((int) b->failed);
+}
+
+/**************  imageToGround (arrays)  **********/
+int PushbroomSensorModel::imageToGround(int n, const double *line,
+            const double *sample, const double *height, ground_point_struct *gp)
+{
+   pushbroom_batch b;
+
+   memset(&b, 0, sizeof(b));
+   b.sup = this;
+   b.n = n;
+   b.line = line;
+   b.sample = sample;
+   b.height = height;
+   b.gp = gp;
+   return(run_batch(&b));
+}
+
+/**************  groundToImage (arrays)  **********
+*                                                  *
+*  Each point's search starts from the line of the *
+*  point before it in its block, and the first of  *
+*  a block from the last solution before the call  *
+*                                                  *
+****************************************************/
+int PushbroomSensorModel::groundToImage(int n, const ground_point_struct *gp,
+            double *line, double *sample)
+{
+   pushbroom_batch b;
+   int i, failed;
+
+   memset(&b, 0, sizeof(b));
+   b.sup = this;
+   b.n = n;
+   b.gp_in = gp;
+   b.line_out = line;
+   b.sample_out = sample;
+   b.start = last_line;
+   failed = run_batch(&b);
+
+   for (i = n - 1; i >= 0; i--)
+      if (line[i] == line[i]) {
+         last_line = line[i];
+         break;
+      }
+   return(failed);
+}
@@ -0,0 +1,76 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title SENS_NATIVE native read_support_file for SOCET ortho support files
+//
+//_Desc  Reads an ortho support file (see socet_native.h for the keywords)
+//       into an OrthoSensorModel, as the DEV_KIT read_support_file does for
+//       ortho2isis3.
+//
+//_Hist Oct 18 2026      Orig Version (from the bench_exporters stand-in)
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "socet_native.h"
+
+/**************  read_support_file  ***************
+*                                                  *
+*  Returns a new OrthoSensorModel for sup_file,    *
+*  or NULL if it can't be read, has no image file  *
+*  name or is not an ortho support file            *
+*                                                  *
+****************************************************/
+SensorModel *read_support_file(const char *sup_file)
+{
+   OrthoSensorModel *sup;
+   char line[2 * NATIVE_PATHLEN];
+   char key[NATIVE_PATHLEN];
+   char value[NATIVE_PATHLEN];
+   char type[NATIVE_PATHLEN];
+   const char *slash;
+   int found = 0;
+   FILE *fp;
+
+   fp = fopen(sup_file, "r");
+   if (fp == NULL)
+      return(NULL);
+
+   sup = new OrthoSensorModel;
+   memset(sup->image_file_name, 0, sizeof(sup->image_file_name));
+   sup->lat_ref_pt = sup->lon_ref_pt = 0.0;
+   sup->interline_dist = sup->interpixel_dist = 0.0;
+   strcpy(type, "ORTHO");
+
+   while (fgets(line, sizeof(line), fp) != NULL) {
+      if (sscanf(line, "%511s %511s", key, value) != 2)
+         continue;
+      upper_case(key);
+      if (strcmp(key, "IMAGE_FILENAME") == 0) {
+         // relative to the support file's directory
+         slash = strrchr(sup_file, '/');
+         if (value[0] == '/' || slash == NULL)
+            snprintf(sup->image_file_name[0], NATIVE_PATHLEN, "%s", value);
+         else
+            snprintf(sup->image_file_name[0], NATIVE_PATHLEN, "%.*s/%s",
+                     (int) (slash - sup_file), sup_file, value);
+         found = 1;
+      }
+      else if (strcmp(key, "SENSOR_TYPE") == 0)
+         strcpy(type, value);
+      else if (strcmp(key, "LAT_REF_PT") == 0)
+         sup->lat_ref_pt = atof(value);
+      else if (strcmp(key, "LON_REF_PT") == 0)
+         sup->lon_ref_pt = atof(value);
+      else if (strcmp(key, "INTERLINE_DIST") == 0)
+         sup->interline_dist = atof(value);
+      else if (strcmp(key, "INTERPIXEL_DIST") == 0)
+         sup->interpixel_dist = atof(value);
+   }
+   fclose(fp);
+
+   upper_case(type);
+   if (!found || strstr(type, "ORTHO") == NULL) {
+      delete sup;
+      return(NULL);
+   }
+   return(sup);
+}
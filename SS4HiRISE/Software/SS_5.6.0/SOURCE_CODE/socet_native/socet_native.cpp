@@ -0,0 +1,146 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title SOCET_NATIVE native project and util routines of the SOCET SET DEV_KIT
+//
+//_Desc  Implements the project and string/file utilities declared in
+//       socet_native.h (the DTM reader is in dtm_native.cpp).  Errors are
+//       reported as the DEV_KIT reports them: a non-zero return or a NULL
+//       pointer.
+//
+//_Hist Oct 18 2026      Orig Version (from the bench_exporters stand-in)
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#include "socet_native.h"
+#include <ctype.h>
+#include <unistd.h>
+
+static img_proj_struct current_project;
+
+/////////////////////////////////////////////////////////////////////////////
+// Project
+/////////////////////////////////////////////////////////////////////////////
+
+/**************  img_proj_struct::read  ***********
+*                                                  *
+*  Finds <project>.prj in $SOCET_PROJECTS, else    *
+*  the current directory.  Returns 0, or -1 if     *
+*  the project file can't be read                  *
+*                                                  *
+****************************************************/
+int img_proj_struct::read(const char *project_file)
+{
+   char dir[NATIVE_PATHLEN];
+   char prj[2 * NATIVE_PATHLEN];
+   const char *env;
+   FILE *fp;
+
+   env = getenv("SOCET_PROJECTS");
+   if (project_file[0] == '/')
+      strcpy(dir, "");
+   else if (env != NULL && env[0] != '\0')
+      snprintf(dir, sizeof(dir), "%s", env);
+   else if (getcwd(dir, sizeof(dir)) == NULL)
+      strcpy(dir, ".");
+
+   if (dir[0] == '\0')
+      snprintf(prj, sizeof(prj), "%s", project_file);
+   else
+      snprintf(prj, sizeof(prj), "%s/%s", dir, project_file);
+
+   fp = fopen(prj, "r");
+   if (fp == NULL)
+      return(-1);
+   fclose(fp);
+
+   // <dir>/<project>.prj has its data in <dir>/<project>
+   snprintf(project_data_path, sizeof(project_data_path), "%s", prj);
+   StripFileExt(project_data_path);
+   return(0);
+}
+
+void setCurrentProj(img_proj_struct &project)
+{
+   current_project = project;
+}
+
+img_proj_struct_ptr getCurrentProjStruct()
+{
+   img_proj_struct_ptr proj;
+
+   // the exporters free() the returned structure
+   proj = (img_proj_struct_ptr) malloc(sizeof(img_proj_struct));
+   if (proj != NULL)
+      *proj = current_project;
+   return(proj);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Application and string utilities
+/////////////////////////////////////////////////////////////////////////////
+
+void init_socet_app(char *name, int argc, char **argv)
+{
+}
+
+int file_exists(const char *file)
+{
+   return(access(file, F_OK) == 0);
+}
+
+int file_remove(const char *file)
+{
+   return(remove(file));
+}
+
+char *ReturnFileName(const char *path)
+{
+   static char name[NATIVE_PATHLEN];
+   const char *p;
+
+   p = strrchr(path, '/');
+   strncpy(name, p ? p + 1 : path, NATIVE_PATHLEN - 1);
+   name[NATIVE_PATHLEN - 1] = '\0';
+   return(name);
+}
+
+void StripFileExt(char *file)
+{
+   char *dot, *slash;
+
+   dot = strrchr(file, '.');
+   slash = strrchr(file, '/');
+   if (dot != NULL && (slash == NULL || dot > slash))
+      *dot = '\0';
+}
+
+char *concat(const char *a, const char *b)
+{
+   static char buf[2 * NATIVE_PATHLEN];
+
+   snprintf(buf, sizeof(buf), "%s%s", a, b);
+   return(buf);
+}
+
+void build_file_name(char *out, const char *path, const char *name,
+                     const char *ext)
+{
+   sprintf(out, "%s/%s%s", path, name, ext);
+}
+
+void upper_case(char *s)
+{
+   for (; *s; s++)
+      *s = toupper((unsigned char) *s);
+}
+
+// $NAME is replaced by the value of the environment variable; an unset
+// variable is left as it is, which is how the exporters detect it
+void str_decode_env_path(const char *in, char *out)
+{
+   const char *val = NULL;
+
+   if (in[0] == '$')
+      val = getenv(in + 1);
+   strcpy(out, val ? val : in);
+}
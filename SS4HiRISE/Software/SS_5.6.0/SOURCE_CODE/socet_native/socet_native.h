@@ -0,0 +1,267 @@
+////////////////////////////////////////////////////////////////////////////////
+//
+//_Title SOCET_NATIVE native Linux versions of the SOCET SET DEV_KIT calls used
+//       by the exporters
+//
+//_Desc  Declares the part of the SOCET SET DEV_KIT dem2isis3, ortho2isis3
+//       and the export subroutines use - the project structure,
+//       DtmHeader/DtmGrid, read_support_file/OrthoSensorModel, the img_*
+//       image calls and the util string routines - implemented natively so
+//       the exporters build and run on a Linux (ISIS cluster) node with no
+//       SOCET runtime or licence.  Each DEV_KIT include path the exporters use is a one-line
+//       header in this directory that includes this file, so the exporter
+//       sources are built unchanged with -I<this directory> in place of
+//       the DEV_KIT include directory.
+//
+//       Projects:  project.read("<project>.prj") looks for the project file
+//       in $SOCET_PROJECTS if set, else in the current directory.  As in
+//       SOCET, <dir>/<project>.prj keeps its data in <dir>/<project>/, and
+//       project_data_path is <dir>/<project>.
+//
+//       Grid DTMs:  <name>.dth is the DTM header, "KEYWORD value..." lines:
+//
+//              DTM_FORMAT      GRID (or DTM_GRID)
+//              NUM_X_POSTS     posts per row
+//              NUM_Y_POSTS     rows
+//              LOWER_LEFT_XYZ  x y z of the lower left post
+//              UPPER_RIGHT_XYZ x y z of the upper right post
+//              X_SPACING       optional, default from the corners and
+//              Y_SPACING          the number of posts
+//              BYTE_ORDER      optional, LSB or MSB (default: the order of
+//                              this machine)
+//
+//       and <name>.dtm holds the posts a row at a time from the southmost
+//       row (y = 0) up, each row NUM_X_POSTS 4-byte float elevations
+//       followed by NUM_X_POSTS FOM bytes.  Blocks are read a row at a time
+//       and the last row read is kept, so the elevation and FOM of a row
+//       cost one read.
+//
+//       The grid DTM layout above has not been checked against a DTM
+//       written by SOCET SET, so DtmHeader::load refuses DTMs unless
+//       NATIVE_DTM_OPT_IN (SS_NATIVE_DTM_EXPERIMENTAL) is 1.
+//
+//       Ortho support files:  <name>.sup is read as "KEYWORD value..."
+//       lines for IMAGE_FILENAME (relative names are taken relative to the
+//       support file's directory), LAT_REF_PT, LON_REF_PT, INTERLINE_DIST
+//       and INTERPIXEL_DIST.  A SENSOR_TYPE other than an ortho one is
+//       refused here; pushbroom support files have their own reader.
+//
+//       Pushbroom support files:  read_pushbroom_support_file reads the
+//       USGSAstroLineScanner support files import_pushbroom writes (see
+//       create_pushbroom_sup there) into a PushbroomSensorModel, from the
+//       ISIS camera keywords of the file: TOTAL_LINES, INT_TIME, T_CENTER,
+//       FOCAL, ISIS_Z_DIRECTION, OPTICAL_DIST_COEF, ITRANSS, ITRANSL,
+//       DETECTOR_SAMPLE_ORIGIN, DETECTOR_LINE_ORIGIN, DETECTOR_LINE_OFFSET,
+//       DETECTOR_SAMPLE_SUMMING, STARTING_SAMPLE, MOUNTING_ANGLES,
+//       SEMI_MAJOR_AXIS, ECCENTRICITY and the ephemeris (EPHEM_PTS, body
+//       fixed meters) and camera to body quaternions (QUATERNIONS, x y z w)
+//       with their times relative to the center of the image.  The SOCET
+//       generic pushbroom terms (IOCOEF_*, RECTIFICATION_TERMS, ...) are
+//       not used.  Image points are full resolution line/sample with the
+//       center of the upper left pixel at 1.0,1.0, as in ISIS; ground
+//       points are x = longitude, y = ographic latitude (radians, on the
+//       SEMI_MAJOR_AXIS/ECCENTRICITY ellipsoid) and z = height (meters).
+//       The array calls take blocks of PUSHBROOM_BLOCK points in parallel
+//       threads.  See pushbroom_native.cpp for the model.
+//
+//       Images:  img_openfile reads uncompressed 8-bit TIFF and BigTIFF,
+//       tiled or in strips, with any number of bands stored pixel
+//       interleaved or band sequential (PlanarConfiguration 1 or 2), which
+//       covers SOCET's tiled TIFF image type.  img_load_buffer reads a tile
+//       row at a time and keeps the last one read, so the strips ortho2isis3
+//       asks for are read with one pass over the file.
+//
+//       Errors are reported as the DEV_KIT reports them: a non-zero return,
+//       a NULL pointer or a negative image handle.
+//
+//_Hist Oct 18 2026      Orig Version (project, DtmHeader/DtmGrid and util
+//                       routines, from the bench_exporters stand-in)
+//      Oct 18 2026      Ortho support files and TIFF images, for ortho2isis3
+//      Oct 18 2026      Pushbroom (USGSAstroLineScanner) support files and
+//                       their image to ground and ground to image model
+//      Oct 19 2026      Pushbroom arrays are taken a block at a time in
+//                       threads; groundToImage from a given start line
+//      Oct 19 2026      Grid DTMs are read only with NATIVE_DTM_OPT_IN set
+//
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef SOCET_NATIVE_H
+#define SOCET_NATIVE_H
+
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+
+using namespace std;
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#define NATIVE_PATHLEN 512
+
+// Project
+struct img_proj_struct {
+   char project_data_path[NATIVE_PATHLEN];
+   int read(const char *project_file);
+};
+typedef img_proj_struct *img_proj_struct_ptr;
+
+void setCurrentProj(img_proj_struct &project);
+img_proj_struct_ptr getCurrentProjStruct();
+
+// Ground points
+struct ground_point_struct {
+   double x, y, z;
+};
+
+// DTMs
+#define DTM_GRID 1
+#define NATIVE_DTM_OPT_IN "SS_NATIVE_DTM_EXPERIMENTAL"
+
+class DtmHeader {
+public:
+   DtmHeader(img_proj_struct_ptr proj);
+   int load(const char *fname);
+   int dtmFormat() { return format; }
+   int numXPosts() { return nx; }
+   int numYPosts() { return ny; }
+   double xRealSpacing() { return dx; }
+   double yRealSpacing() { return dy; }
+   ground_point_struct llCorner() { return ll; }
+   ground_point_struct urCorner() { return ur; }
+   int swapBytes() { return swap; }
+private:
+   int format, nx, ny;
+   double dx, dy;
+   ground_point_struct ll, ur;
+   int swap;            // posts are in the other byte order
+};
+
+class DtmGrid {
+public:
+   DtmGrid(DtmHeader *header);
+   ~DtmGrid();
+   int openDtm(const char *fname, int edit, int mode, int create, int lock);
+   int getElevationBlock(int x0, int y0, int x1, int y1, float *z);
+   int getFomBlock(int x0, int y0, int x1, int y1, char *fom);
+private:
+   int readRow(int y);
+   DtmHeader *hdr;
+   FILE *fp;
+   int row;             // row held in buf, -1 for none
+   unsigned char *buf;  // one row: floats then FOM bytes
+};
+
+// Support files
+#define NATIVE_MAX_SUP_IMAGES 4
+
+class SensorModel {
+public:
+   virtual ~SensorModel() {}
+   char image_file_name[NATIVE_MAX_SUP_IMAGES][NATIVE_PATHLEN];
+};
+
+class OrthoSensorModel : public SensorModel {
+public:
+   double lat_ref_pt, lon_ref_pt;
+   double interline_dist, interpixel_dist;
+};
+
+SensorModel *read_support_file(const char *sup_file);
+
+class PushbroomSensorModel : public SensorModel {
+public:
+   PushbroomSensorModel();
+   ~PushbroomSensorModel();
+
+   // Single points: 0, or -1 if the ray misses the body (image to ground)
+   // or the search for the line doesn't converge (ground to image)
+   int imageToGround(double line, double sample, double height,
+                     ground_point_struct *gp);
+   int groundToImage(const ground_point_struct *gp, double *line,
+                     double *sample);
+
+   // Ground to image with the line search from image line start.  Unlike
+   // the call above, it doesn't keep the solution to start the next from,
+   // so threads can share the model.
+   int groundToImage(const ground_point_struct *gp, double start,
+                     double *line, double *sample);
+
+   // Arrays of n points: returns the number of points that failed, whose
+   // results are NAN.  Blocks of PUSHBROOM_BLOCK points are taken in
+   // parallel threads; in ground to image each point's search starts from
+   // the point before it in its block, so the results don't depend on the
+   // number of threads.
+   int imageToGround(int n, const double *line, const double *sample,
+                     const double *height, ground_point_struct *gp);
+   int groundToImage(int n, const ground_point_struct *gp, double *line,
+                     double *sample);
+
+   // Sets up the sensor state table, once the keywords are read.
+   // Returns 0, or -1 if the keywords don't give a model
+   int setup();
+
+   int total_lines, total_samples;
+   double int_time, t_center;           // seconds
+   double focal, z_direction;           // mm
+   double dist_coef[3];
+   double itranss[3], itransl[3];       // focal plane (mm) to detector
+   double det_sample_origin, det_line_origin, det_line_offset;
+   double det_sample_summing, starting_sample;
+   double mounting_angles[3];           // omega, phi, kappa (radians)
+   double semi_major_axis, eccentricity;
+   int nephem, nquat;
+   double t0_ephem, dt_ephem, t0_quat, dt_quat;
+   double *ephem_pts;                   // 3 per point
+   double *quats;                       // 4 per point
+
+private:
+   void exactState(double t, double *pos, double *rot);
+   void state(double line, double *st);
+   int residual(double line, const double *X, double *dl, double *cs);
+   void groundToBody(const ground_point_struct *gp, double *X);
+   double bodyHeight(const double *X, double *n);
+
+   double mount[9];                     // camera to mounting frame
+   double inv[4];                       // detector to focal plane (ITRANS^-1)
+   double first_line, step;             // state table: node k at line
+   int nnodes;                          //    first_line + k * step
+   double *nodes;                       // position and rotation, 12 a node
+   double line_rate;                    // detector lines per image line
+   double last_line;                    // last solution, to start from
+};
+
+#define PUSHBROOM_BLOCK 1024
+
+PushbroomSensorModel *read_pushbroom_support_file(const char *sup_file);
+
+// Images
+int img_openfile(const char *file, int mode);
+int img_closefile(int img);
+int img_query_num_bands(int img);
+void img_query_dimension(int img, int *lines, int *samples);
+void img_query_tile_size(int img, int *tile_x, int *tile_y);
+int img_load_buffer(int img, int line, int sample, int nlines, int nsamples,
+                    int band, unsigned char *buf, int stride,
+                    unsigned char *fill);
+
+// Application and string utilities
+void init_socet_app(char *name, int argc, char **argv);
+int file_exists(const char *file);
+int file_remove(const char *file);
+char *ReturnFileName(const char *path);
+void StripFileExt(char *file);
+char *concat(const char *a, const char *b);
+void build_file_name(char *out, const char *path, const char *name,
+                     const char *ext);
+void upper_case(char *s);
+void str_decode_env_path(const char *in, char *out);
+
+#endif
@@ -0,0 +1,2 @@
+// SOCET SET DEV_KIT header util/init_socet_app.h, native Linux version (see socet_native.h)
+#include <socet_native.h>